@@ -1,9 +1,14 @@
 #ifndef COS_API_H
 #define COS_API_H
 
+#include "op/bucket_object_iterator.h"
 #include "op/bucket_op.h"
+#include "op/bulk_deleter.h"
 #include "op/cos_result.h"
+#include "op/directory_uploader.h"
 #include "op/object_op.h"
+#include "op/parallel_bucket_lister.h"
+#include "op/prefix_downloader.h"
 #include "op/service_op.h"
 #include "util/simple_mutex.h"
 
@@ -70,6 +75,36 @@ public:
     /// \return 返回HTTP请求的状态码及错误信息
     CosResult GetBucket(const GetBucketReq& request, GetBucketResp* response);
 
+    /// \brief 列出Object, 记录以紧凑的列存储(key连续存放, ETag/存储类型等驻留)保存,
+    ///        多次调用可以通过CompactGetBucketResp::SetObjectList追加到同一个列表中
+    ///
+    /// \param request   GetBucket请求
+    /// \param response  GetBucket返回
+    ///
+    /// \return 返回HTTP请求的状态码及错误信息
+    CosResult GetBucket(const GetBucketReq& request, CompactGetBucketResp* response);
+
+    /// \brief 创建按marker自动翻页的Object列表迭代器, 处理当前页时后台预取后续的页
+    ///
+    /// \param request        首页GetBucket请求, 可设置prefix/delimiter/max-keys等
+    /// \param prefetch_depth 预取的页数, 0表示不预取
+    ///
+    /// \return 列表迭代器
+    SharedBucketObjectIterator GetBucketObjectIterator(const GetBucketReq& request,
+            unsigned prefetch_depth = kDefaultListPrefetchDepth);
+
+    /// \brief 把key空间切分为多个分片并发列出Object, 适合列出海量Object.
+    ///        分片边界由调用方指定, 或者以定界符列出的Common Prefix自动发现
+    ///
+    /// \param request  ParallelListObjects请求
+    /// \param handler  记录回调, 无序模式下会被并发调用
+    /// \param response ParallelListObjects返回
+    ///
+    /// \return 返回HTTP请求的状态码及错误信息
+    CosResult ParallelListObjects(const ParallelListObjectsReq& request,
+                                  ListObjectsHandler* handler,
+                                  ParallelListObjectsResp* response);
+
     /// \brief 删除Bucket
     ///        详见: https://cloud.tencent.com/document/product/436/7732
     ///
@@ -208,6 +243,39 @@ public:
     /// \return 返回HTTP请求的状态码及错误信息
     CosResult HeadObject(const HeadObjectReq& request, HeadObjectResp* response);
 
+    /// \brief 并发获取一批Object的meta信息, 结果与请求中的Object顺序一致.
+    ///        开启CosSysConfig::SetKeepAlive后各请求复用长连接
+    ///
+    /// \param request   BatchHeadObject请求
+    /// \param response  BatchHeadObject返回
+    ///
+    /// \return 所有Object都得到结果时返回成功, 否则返回第一个非404的错误
+    CosResult BatchHeadObject(const BatchHeadObjectReq& request, BatchHeadObjectResp* response);
+
+    /// \brief 获取Object元数据缓存的命中统计, 通过CosConfig::SetMetaCachePolicy开启缓存
+    ObjectMetaCacheStat GetObjectMetaCacheStat() const;
+
+    /// \brief 获取GetObject磁盘缓存的统计, 通过CosConfig::SetDiskCachePolicy开启缓存
+    DiskCacheStat GetDiskCacheStat() const;
+
+    /// \brief 获取相同读请求合并的统计, 通过CosConfig::SetSingleFlightPolicy开启合并
+    SingleFlightStat GetSingleFlightStat() const;
+
+    /// \brief 在流量到来前并行建立n_connections个长连接放入连接池, 避免启动或切换后的
+    ///        首批请求串行等待DNS解析、TCP和TLS握手. 需要开启CosSysConfig::SetKeepAlive
+    ///
+    /// \param bucket_or_host 含'.'时作为域名, 否则作为bucket名
+    /// \param n_connections  预热的连接数, 不超过每个host的空闲连接上限
+    /// \param is_https       是否预热https连接
+    ///
+    /// \return 成功建立的连接数
+    unsigned WarmUp(const std::string& bucket_or_host, unsigned n_connections,
+                    bool is_https = false);
+
+    /// \brief 由后台线程保持至少min_idle个空闲长连接, 定期关闭已被服务端断开的连接并补足,
+    ///        检查间隔通过HttpSessionPool::SetKeepWarmIntervalInms设置. min_idle为0时取消
+    void KeepWarm(const std::string& bucket_or_host, unsigned min_idle, bool is_https = false);
+
     /// \brief 下载Bucket中的一个文件至流中
     ///        详见: https://www.qcloud.com/document/product/436/7753
     ///
@@ -235,6 +303,26 @@ public:
     /// \return 返回HTTP请求的状态码及错误信息
     CosResult GetObject(const MultiGetObjectReq& request, MultiGetObjectResp* response);
 
+    /// \brief 把前缀下的所有Object下载到本地目录. 列出与下载并行进行, 小Object整体下载,
+    ///        大Object分片并发下载, 同时下载的Object数和预估内存受request的限制.
+    ///        每个Object先写入临时文件, 成功后重命名为目标文件
+    ///
+    /// \param request   DownloadPrefix请求
+    /// \param response  DownloadPrefix返回, 包含汇总的Object数、字节数和每个失败Object的原因
+    ///
+    /// \return 本地目录无法创建、列出失败或被取消时返回失败, 单个Object失败不影响返回值
+    CosResult DownloadPrefix(const DownloadPrefixReq& request, DownloadPrefixResp* response);
+
+    /// \brief 把前缀下的所有Object下载到本地目录, 每个Object结束后调用handler报告进度
+    ///
+    /// \param request   DownloadPrefix请求
+    /// \param handler   进度回调, 会在多个线程中并发调用
+    /// \param response  DownloadPrefix返回
+    ///
+    /// \return 本地目录无法创建、列出失败或被取消时返回失败, 单个Object失败不影响返回值
+    CosResult DownloadPrefix(const DownloadPrefixReq& request, DownloadPrefixHandler* handler,
+                             DownloadPrefixResp* response);
+
     /// \brief 将本地的文件上传至指定Bucket中
     ///        详见: https://www.qcloud.com/document/product/436/7749
     ///
@@ -270,6 +358,35 @@ public:
     /// \return 本次请求的调用情况(如状态码等)
     CosResult DeleteObjects(const DeleteObjectsReq& request, DeleteObjectsResp* response);
 
+    /// \brief 批量删除request中添加的Object, 不受单次1000个的限制.
+    ///        按批次拆分为多个DeleteObjects请求并发执行, 汇总每个Object的删除错误
+    ///
+    /// \param request   BulkDelete请求, 可设置并发数和每批的Object数
+    /// \param response  BulkDelete返回
+    ///
+    /// \return 返回HTTP请求的状态码及错误信息
+    CosResult BulkDelete(const BulkDeleteReq& request, BulkDeleteResp* response);
+
+    /// \brief 批量删除keys返回的Object, 边读取边删除, 适合待删除的key无法一次性放入内存的场景
+    ///
+    /// \param request   BulkDelete请求
+    /// \param keys      待删除Object的来源
+    /// \param response  BulkDelete返回
+    ///
+    /// \return 返回HTTP请求的状态码及错误信息
+    CosResult BulkDelete(const BulkDeleteReq& request, DeleteKeyIterator* keys,
+                         BulkDeleteResp* response);
+
+    /// \brief 删除指定前缀下的所有Object, 列出的结果直接流入删除批次, 列出与删除并行进行
+    ///
+    /// \param request   BulkDelete请求
+    /// \param prefix    Object前缀, 不能为空
+    /// \param response  BulkDelete返回
+    ///
+    /// \return 返回HTTP请求的状态码及错误信息
+    CosResult DeleteObjectsByPrefix(const BulkDeleteReq& request, const std::string& prefix,
+                                    BulkDeleteResp* response);
+
     /// \brief 请求实现初始化分片上传,成功执行此请求以后会返回UploadId用于后续的Upload Part请求
     ///        详见: https://www.qcloud.com/document/product/436/7746
     ///
@@ -317,6 +434,25 @@ public:
     CosResult MultiUploadObject(const MultiUploadObjectReq& request,
                                 MultiUploadObjectResp* response);
 
+    /// \brief 上传本地目录下的所有文件, 并发扫描子目录, 小文件简单上传, 大文件分块上传,
+    ///        同时上传的文件数和预估内存受request的限制, 分块与其他传输共享执行器
+    ///
+    /// \param request   UploadDirectory请求
+    /// \param response  UploadDirectory返回, 包含汇总的文件数、字节数和每个失败文件的原因
+    ///
+    /// \return 根目录无法打开或被取消时返回失败, 单个文件失败不影响返回值
+    CosResult UploadDirectory(const UploadDirectoryReq& request, UploadDirectoryResp* response);
+
+    /// \brief 上传本地目录下的所有文件, 每个文件结束后调用handler报告进度
+    ///
+    /// \param request   UploadDirectory请求
+    /// \param handler   进度回调, 会在多个线程中并发调用
+    /// \param response  UploadDirectory返回
+    ///
+    /// \return 根目录无法打开或被取消时返回失败, 单个文件失败不影响返回值
+    CosResult UploadDirectory(const UploadDirectoryReq& request, UploadDirectoryHandler* handler,
+                              UploadDirectoryResp* response);
+
     /// \brief 舍弃一个分块上传并删除已上传的块
     ///        详见: https://www.qcloud.com/document/product/436/7740
     ///
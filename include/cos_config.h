@@ -5,6 +5,14 @@
 
 #include <string>
 
+#include "util/client_settings.h"
+#include "util/disk_cache_policy.h"
+#include "util/hedge_policy.h"
+#include "util/meta_cache_policy.h"
+#include "util/retry_policy.h"
+#include "util/single_flight_policy.h"
+#include "util/stall_policy.h"
+
 namespace qcloud_cos{
 
 class CosConfig{
@@ -51,6 +59,13 @@ public:
         m_secret_key = config.m_secret_key;
         m_region = config.m_region;
         m_tmp_token = config.m_tmp_token;
+        m_retry_policy = config.m_retry_policy;
+        m_hedge_policy = config.m_hedge_policy;
+        m_stall_policy = config.m_stall_policy;
+        m_meta_cache_policy = config.m_meta_cache_policy;
+        m_disk_cache_policy = config.m_disk_cache_policy;
+        m_single_flight_policy = config.m_single_flight_policy;
+        m_client_settings = config.m_client_settings;
     }
 
     /// \brief CosConfig赋值构造函数
@@ -62,6 +77,13 @@ public:
         m_secret_key = config.m_secret_key;
         m_region = config.m_region;
         m_tmp_token = config.m_tmp_token;
+        m_retry_policy = config.m_retry_policy;
+        m_hedge_policy = config.m_hedge_policy;
+        m_stall_policy = config.m_stall_policy;
+        m_meta_cache_policy = config.m_meta_cache_policy;
+        m_disk_cache_policy = config.m_disk_cache_policy;
+        m_single_flight_policy = config.m_single_flight_policy;
+        m_client_settings = config.m_client_settings;
         return *this;
     }
 
@@ -112,12 +134,61 @@ public:
     /// \brief 设置临时密钥
     void SetTmpToken(const std::string& tmp_token) { m_tmp_token = tmp_token; }
 
+    /// \brief 获取重试策略, 所有Op及分块上传/下载/复制任务共享该策略
+    const RetryPolicy& GetRetryPolicy() const { return m_retry_policy; }
+
+    /// \brief 设置重试策略
+    void SetRetryPolicy(const RetryPolicy& retry_policy) { m_retry_policy = retry_policy; }
+
+    /// \brief 获取HEAD/GET对象请求的对冲策略
+    const HedgePolicy& GetHedgePolicy() const { return m_hedge_policy; }
+
+    /// \brief 设置对冲策略
+    void SetHedgePolicy(const HedgePolicy& hedge_policy) { m_hedge_policy = hedge_policy; }
+
+    /// \brief 获取分块上传/下载的低速检测策略
+    const StallPolicy& GetStallPolicy() const { return m_stall_policy; }
+
+    /// \brief 设置低速检测策略
+    void SetStallPolicy(const StallPolicy& stall_policy) { m_stall_policy = stall_policy; }
+
+    /// \brief 获取Object元数据缓存策略
+    const MetaCachePolicy& GetMetaCachePolicy() const { return m_meta_cache_policy; }
+
+    /// \brief 设置元数据缓存策略, 在创建CosAPI之前设置才生效
+    void SetMetaCachePolicy(const MetaCachePolicy& policy) { m_meta_cache_policy = policy; }
+
+    /// \brief 获取GetObject本地磁盘缓存策略
+    const DiskCachePolicy& GetDiskCachePolicy() const { return m_disk_cache_policy; }
+
+    /// \brief 设置磁盘缓存策略, 在创建CosAPI之前设置才生效
+    void SetDiskCachePolicy(const DiskCachePolicy& policy) { m_disk_cache_policy = policy; }
+
+    /// \brief 获取相同读请求合并策略
+    const SingleFlightPolicy& GetSingleFlightPolicy() const { return m_single_flight_policy; }
+
+    /// \brief 设置相同读请求合并策略, 在创建CosAPI之前设置才生效
+    void SetSingleFlightPolicy(const SingleFlightPolicy& policy) { m_single_flight_policy = policy; }
+
+    /// \brief 获取实例级别的超时、分块大小等配置, 未设置的项使用CosSysConfig的全局配置
+    const ClientSettings& GetClientSettings() const { return m_client_settings; }
+
+    /// \brief 设置实例级别的配置, 在创建CosAPI之前设置才生效, 不影响其它CosAPI
+    void SetClientSettings(const ClientSettings& settings) { m_client_settings = settings; }
+
 private:
     uint64_t m_app_id;
     std::string m_access_key;
     std::string m_secret_key;
     std::string m_region;
     std::string m_tmp_token;
+    RetryPolicy m_retry_policy;
+    HedgePolicy m_hedge_policy;
+    StallPolicy m_stall_policy;
+    MetaCachePolicy m_meta_cache_policy;
+    DiskCachePolicy m_disk_cache_policy;
+    SingleFlightPolicy m_single_flight_policy;
+    ClientSettings m_client_settings;
 };
 
 } // namespace qcloud_cos
@@ -27,6 +27,45 @@ const int kMaxThreadPoolSizeUploadPart = 100;
 /// 分块上传的线程池最小数目
 const int kMinThreadPoolSizeUploadPart = 1;
 
+/// 并发列出Object的默认线程数
+const unsigned kDefaultParallelListThreadNum = 8;
+/// 并发列出Object时自动发现的分片边界数上限
+const unsigned kDefaultParallelListMaxShards = 256;
+/// 有序并发列出时每个分片最多缓存的记录数
+const unsigned kDefaultParallelListBufferedEntries = 10000;
+
+/// 单个DeleteObjects请求最多删除的Object数
+const unsigned kMaxDeleteObjectsBatchSize = 1000;
+/// 批量删除时同时进行的DeleteObjects请求数
+const unsigned kDefaultBulkDeleteThreadNum = 8;
+/// 按前缀批量删除时列表迭代器预取的页数
+const unsigned kDefaultBulkDeleteListPrefetchDepth = 2;
+
+/// 批量HeadObject时的默认并发数
+const unsigned kDefaultBatchHeadThreadNum = 16;
+/// 不存在的Object缓存的最大条数
+const size_t kMaxNegativeCacheEntries = 100000;
+
+/// 上传目录时同时上传的文件数
+const unsigned kDefaultUploadDirectoryThreadNum = 16;
+/// 上传目录时同时扫描的子目录数
+const unsigned kDefaultUploadDirectoryWalkThreadNum = 4;
+/// 上传目录时不小于该大小的文件使用分块上传
+const uint64_t kDefaultUploadDirectoryMultipartThreshold = 64 * 1024 * 1024;
+/// 上传目录时所有在途文件预估占用的内存上限
+const uint64_t kDefaultUploadDirectoryMemoryBudget = 256 * 1024 * 1024;
+/// 开启跳过已存在文件时, 分块上传的Object在该自定义元数据(x-cos-meta-md5)中记录文件MD5
+const std::string kTransferMd5MetaKey = "md5";
+
+/// 按前缀下载时同时下载的Object数
+const unsigned kDefaultDownloadPrefixThreadNum = 16;
+/// 按前缀下载时不小于该大小的Object使用分片并发下载
+const uint64_t kDefaultDownloadPrefixMultiGetThreshold = 64 * 1024 * 1024;
+/// 按前缀下载时所有在途Object预估占用的内存上限
+const uint64_t kDefaultDownloadPrefixMemoryBudget = 256 * 1024 * 1024;
+/// 按前缀下载时列表迭代器预取的页数
+const unsigned kDefaultDownloadPrefixListPrefetchDepth = 2;
+
 /// 分块大小1M
 const uint64_t kPartSize1M = 1 * 1024 * 1024;
 /// 分块大小5G
@@ -82,14 +121,31 @@ typedef enum cos_log_level {
 #define MAX(a, b) ((a) > (b) ? (a) : (b))
 
 struct Content {
+    Content() : m_last_modified_time(0), m_size(0) {}
+
     std::string m_key; // Object 的 Key
     std::string m_last_modified; // Object 最后被修改时间
+    uint64_t m_last_modified_time; // Object 最后被修改时间, Unix时间戳, 单位秒
     std::string m_etag; // 文件的 MD-5 算法校验值
-    std::string m_size; // 文件大小，单位是 Byte
+    uint64_t m_size; // 文件大小，单位是 Byte
     std::vector<std::string> m_owner_ids; // Bucket 持有者信息
     std::string m_storage_class; // Object 的存储级别，枚举值：STANDARD，STANDARD_IA
 };
 
+/// \brief 批量HeadObject中单个Object的结果
+struct HeadObjectResult {
+    HeadObjectResult() : m_exists(false), m_http_status(0), m_size(0), m_last_modified_time(0) {}
+
+    bool m_exists;
+    int m_http_status; // 0表示命中了不存在缓存, -1表示网络错误
+    uint64_t m_size;
+    uint64_t m_last_modified_time; // Unix时间戳, 单位秒
+    std::string m_etag;
+
+    /// \brief 既不是存在也不是不存在(404)的结果, 如鉴权失败或网络错误
+    bool IsError() const { return !m_exists && m_http_status != 404 && m_http_status != 0; }
+};
+
 struct ReplicationRule {
     bool m_is_enable;
     std::string m_id; // 非必须
@@ -537,6 +593,9 @@ struct ErrorInfo {
 };
 
 struct COSVersionSummary {
+    COSVersionSummary()
+        : m_is_delete_marker(false), m_size(0), m_is_latest(false), m_last_modified_time(0) {}
+
     bool m_is_delete_marker;
     std::string m_etag;
     uint64_t m_size;
@@ -544,9 +603,26 @@ struct COSVersionSummary {
     bool m_is_latest;
     std::string m_key;
     std::string m_last_modified;
+    uint64_t m_last_modified_time; // Unix时间戳, 单位秒
     Owner m_owner;
     std::string m_version_id;
 };
 
+/// \brief 列表迭代器返回的一条记录. 迭代器覆盖写入调用方传入的记录,
+///        循环中复用同一条记录时字符串的内存也会被复用
+struct BucketObjectEntry {
+    BucketObjectEntry()
+        : m_is_common_prefix(false), m_size(0), m_last_modified_time(0) {}
+
+    // 为true时表示设置了delimiter后归并的Common Prefix, 只有m_key有效
+    bool m_is_common_prefix;
+    std::string m_key;
+    std::string m_etag;
+    std::string m_storage_class;
+    std::string m_owner_id;
+    uint64_t m_size;
+    uint64_t m_last_modified_time; // Unix时间戳, 单位秒
+};
+
 } // namespace qcloud_cos
 #endif
@@ -42,6 +42,7 @@ const std::string kReqHeaderDate = "Date";
 const std::string kReqHeaderServer = "Server";
 const std::string kReqHeaderXCosReqId = "x-cos-request-id";
 const std::string kReqHeaderXCosTraceId = "x-cos-trace-id";
+const std::string kReqHeaderXCosTrafficLimit = "x-cos-traffic-limit";
 
 // Response Header
 const std::string kRespHeaderLastModified = "Last-Modified";
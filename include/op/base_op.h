@@ -8,11 +8,15 @@
 
 #include "cos_config.h"
 #include "op/cos_result.h"
+#include "util/cancel_token.h"
+#include "util/header_list.h"
+#include "util/rate_limiter.h"
 
 namespace qcloud_cos{
 
 class BaseReq;
 class BaseResp;
+class XmlSaxHandler;
 
 class BaseOp {
 public:
@@ -85,13 +89,30 @@ public:
     /// \param req      http请求
     /// \param resp     http返回
     /// \param os       输出流
+    /// \param is_hedgeable 开启对冲时是否以对冲方式发送, 只用于GetObject
     ///
     /// \return http调用情况(状态码等)
     CosResult DownloadAction(const std::string& host,
                              const std::string& path,
                              const BaseReq& req,
                              BaseResp* resp,
-                             std::ostream& os);
+                             std::ostream& os,
+                             bool is_hedgeable = false);
+
+    /// \brief 边接收边解析xml响应体, 解析结果通过handler回调输出, 不保留原始响应体
+    ///
+    /// \param host     目标主机, 以http://开头
+    /// \param path     http path
+    /// \param req      http请求
+    /// \param resp     http返回
+    /// \param handler  SAX回调, 请求重试时会先回调OnReset
+    ///
+    /// \return http调用情况(状态码等), 响应体格式错误时返回失败
+    CosResult SaxParseAction(const std::string& host,
+                             const std::string& path,
+                             const BaseReq& req,
+                             BaseResp* resp,
+                             XmlSaxHandler* handler);
 
     /// \brief 支持从stream中读入数据并上传
     ///
@@ -116,9 +137,62 @@ public:
                            const std::string& path,
                            bool is_https);
 
+    /// \brief 获取请求的连接/接收超时时间, 请求未设置时使用CosAPI的配置
+    uint64_t GetConnTimeoutInms(const BaseReq& req) const;
+    uint64_t GetRecvTimeoutInms(const BaseReq& req) const;
+
+    /// \brief 计算请求的签名, 签名有效期使用CosAPI的配置
+    std::string Sign(const std::string& http_method,
+                     const std::string& in_uri,
+                     const std::map<std::string, std::string>& headers,
+                     const std::map<std::string, std::string>& params) const;
+    std::string Sign(const std::string& http_method,
+                     const std::string& in_uri,
+                     const HeaderList& headers,
+                     const std::map<std::string, std::string>& params) const;
+
+    /// \brief 请求体不小于CosAPI配置的阈值时添加Expect: 100-continue请求头, 在签名之后调用
+    void AddExpectContinue(uint64_t body_len, std::map<std::string, std::string>* headers) const;
+    void AddExpectContinue(uint64_t body_len, HeaderList* headers) const;
+
+    /// \brief 生成发送时使用的请求头: 请求自身的头部、additional_headers中尚不存在的头部、
+    ///        临时密钥的token和Host, 不含签名
+    void BuildReqHeaders(const std::string& host,
+                         const BaseReq& req,
+                         const std::map<std::string, std::string>& additional_headers,
+                         HeaderList* req_headers) const;
+
+    /// \brief 根据请求的取消句柄和截止时间生成一次调用使用的取消句柄,
+    ///        两者都未设置时返回空
+    static SharedCancelToken CreateCancelToken(const BaseReq& req);
+
+    /// \brief 设置CosAPI实例级别的上传/下载限速器, 未设置时使用进程级别的限速器
+    void SetRateLimiters(const SharedRateLimiter& upload_limiter,
+                         const SharedRateLimiter& download_limiter) {
+        m_upload_limiter = upload_limiter;
+        m_download_limiter = download_limiter;
+    }
+
+    /// \brief 根据请求的限速生成一次调用使用的限速器, 以实例级别的限速器为父限速器.
+    ///        各级都不限速时返回空
+    SharedRateLimiter CreateRateLimiter(const BaseReq& req, bool is_upload) const;
+
+    /// \brief 预热bucket_or_host对应域名的长连接, 参数中含'.'时作为域名, 否则作为bucket名
+    ///
+    /// \return 成功建立的连接数
+    unsigned WarmUp(const std::string& bucket_or_host, unsigned n_connections, bool is_https);
+
+    /// \brief 由后台线程保持bucket_or_host对应域名至少min_idle个空闲长连接, 0表示取消
+    void KeepWarm(const std::string& bucket_or_host, unsigned min_idle, bool is_https);
+
+private:
+    // 获取预热连接使用的url
+    std::string GetWarmUpUrl(const std::string& bucket_or_host, bool is_https);
 
 protected:
     CosConfig m_config;
+    SharedRateLimiter m_upload_limiter;
+    SharedRateLimiter m_download_limiter;
 };
 
 } // namespace qcloud_cos
@@ -0,0 +1,89 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: 自动翻页并预取的Object列表迭代器
+
+#ifndef BUCKET_OBJECT_ITERATOR_H
+#define BUCKET_OBJECT_ITERATOR_H
+#pragma once
+
+#include <stdint.h>
+
+#include <deque>
+#include <string>
+
+#include "boost/shared_ptr.hpp"
+#include "boost/thread/condition_variable.hpp"
+#include "boost/thread/mutex.hpp"
+#include "boost/thread/thread.hpp"
+
+#include "op/bucket_op.h"
+#include "op/cos_result.h"
+#include "request/bucket_req.h"
+#include "response/bucket_resp.h"
+#include "util/cancel_token.h"
+#include "util/noncopyable.h"
+
+namespace qcloud_cos {
+
+/// \brief 按marker自动翻页的Object列表迭代器.
+///        prefetch_depth大于0时由后台线程提前拉取并解析后续的页, 最多缓存prefetch_depth页,
+///        调用方处理当前页时下一页的请求已经在进行中.
+///        迭代器析构时会取消后台正在进行的请求并等待后台线程退出
+class BucketObjectIterator : private NonCopyable {
+public:
+    /// \param op             用于发送请求, 迭代器持有一份拷贝
+    /// \param req            首页请求, 可以设置prefix/delimiter/max-keys/marker,
+    ///                       翻页时marker会被替换. 请求的取消句柄和截止时间作用于整个迭代过程
+    /// \param prefetch_depth 预取的页数, 0表示不预取, 在Next()中同步拉取
+    BucketObjectIterator(const BucketOp& op, const GetBucketReq& req,
+                         unsigned prefetch_depth = kDefaultListPrefetchDepth);
+    ~BucketObjectIterator();
+
+    /// \brief 读取下一条记录, Common Prefix与Object按key的顺序合并返回.
+    ///        列表结束或出错时返回false, 通过IsError()区分
+    bool Next(BucketObjectEntry* entry);
+
+    /// \brief 拉取某一页失败. 失败之前已预取的页仍会被返回, 因此应在Next()返回false后检查
+    bool IsError() const;
+
+    /// \brief 失败时为失败请求的结果, 否则为最后一页请求的结果
+    CosResult GetResult() const;
+
+    /// \brief 已经拉取成功的页数
+    uint64_t GetPageCount() const;
+
+private:
+    typedef boost::shared_ptr<CompactGetBucketResp> SharedPage;
+
+    // 请求m_marker之后的一页, 成功时更新m_marker, is_last表示是否为最后一页
+    CosResult FetchPage(SharedPage* page, bool* is_last);
+    // 后台线程
+    void PrefetchLoop();
+    // 取出下一页, 没有更多页时返回false
+    bool PopPage();
+
+private:
+    BucketOp m_op;
+    GetBucketReq m_req;
+    unsigned m_prefetch_depth;
+    SharedCancelToken m_cancel_token;
+
+    mutable boost::mutex m_mutex;
+    boost::condition_variable m_cond;
+    std::deque<SharedPage> m_pages;
+    std::string m_marker; // 只由拉取页的线程访问
+    bool m_is_done;      // 所有页都已拉取或拉取失败
+    bool m_is_stopped;   // 迭代器析构
+    CosResult m_result;
+    uint64_t m_page_count;
+    boost::shared_ptr<boost::thread> m_thread;
+
+    // 只由调用Next()的线程访问
+    SharedPage m_cur_page;
+    size_t m_content_idx;
+    size_t m_prefix_idx;
+};
+
+} // namespace qcloud_cos
+#endif // BUCKET_OBJECT_ITERATOR_H
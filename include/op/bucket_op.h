@@ -9,6 +9,8 @@
 #define BUCKETOP_H
 #pragma once
 
+#include "boost/shared_ptr.hpp"
+
 #include "cos_sys_config.h"
 #include "op/base_op.h"
 #include "op/cos_result.h"
@@ -17,6 +19,13 @@
 
 namespace qcloud_cos {
 
+class BucketObjectIterator;
+class ListObjectsHandler;
+typedef boost::shared_ptr<BucketObjectIterator> SharedBucketObjectIterator;
+
+/// 列表迭代器默认预取的页数
+const unsigned kDefaultListPrefetchDepth = 2;
+
 /// \brief 封装了Bucket相关的操作
 class BucketOp : public BaseOp {
 public:
@@ -52,6 +61,34 @@ public:
     /// \return 本次请求的调用情况(如状态码等)
     CosResult GetBucket(const GetBucketReq& req, GetBucketResp* resp);
 
+    /// \brief 列出Object, 记录以紧凑的列存储追加到resp的列表中
+    ///
+    /// \param req  GetBucket请求
+    /// \param resp GetBucket返回
+    ///
+    /// \return 本次请求的调用情况(如状态码等)
+    CosResult GetBucket(const GetBucketReq& req, CompactGetBucketResp* resp);
+
+    /// \brief 创建按marker自动翻页的Object列表迭代器, 后台预取后续的页
+    ///
+    /// \param req            首页GetBucket请求
+    /// \param prefetch_depth 预取的页数, 0表示不预取
+    ///
+    /// \return 列表迭代器
+    SharedBucketObjectIterator GetBucketObjectIterator(const GetBucketReq& req,
+            unsigned prefetch_depth = kDefaultListPrefetchDepth);
+
+    /// \brief 把key空间切分为多个分片并发列出Object, 记录通过handler回调输出
+    ///
+    /// \param req     ParallelListObjects请求
+    /// \param handler 记录回调, 无序模式下会被并发调用
+    /// \param resp    ParallelListObjects返回
+    ///
+    /// \return 本次请求的调用情况, 任一分片失败时返回该分片的错误
+    CosResult ParallelListObjects(const ParallelListObjectsReq& req,
+                                  ListObjectsHandler* handler,
+                                  ParallelListObjectsResp* resp);
+
     /// \brief 删除Bucket
     ///
     /// \param req  DeleteBucket请求
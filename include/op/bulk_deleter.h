@@ -0,0 +1,111 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: 按批次并发执行DeleteObjects的批量删除
+
+#ifndef BULK_DELETER_H
+#define BULK_DELETER_H
+#pragma once
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "boost/shared_ptr.hpp"
+#include "boost/thread/condition_variable.hpp"
+#include "boost/thread/mutex.hpp"
+
+#include "cos_defines.h"
+#include "op/bucket_object_iterator.h"
+#include "op/cos_result.h"
+#include "op/object_op.h"
+#include "request/object_req.h"
+#include "response/object_resp.h"
+#include "util/noncopyable.h"
+
+namespace qcloud_cos {
+
+/// \brief 批量删除的key来源, 只在调用BulkDelete的线程中使用
+class DeleteKeyIterator {
+public:
+    virtual ~DeleteKeyIterator() {}
+
+    /// \brief 读取下一个待删除的Object, 结束或出错时返回false
+    virtual bool Next(ObjectVersionPair* key) = 0;
+
+    /// \brief Next()返回false后调用, key来源出错时返回失败
+    virtual CosResult GetResult() const {
+        CosResult result;
+        result.SetSucc();
+        return result;
+    }
+};
+
+/// \brief 依次返回数组中的key, 数组的生命周期由调用方保证
+class VectorDeleteKeyIterator : public DeleteKeyIterator {
+public:
+    explicit VectorDeleteKeyIterator(const std::vector<ObjectVersionPair>& keys)
+        : m_keys(keys), m_idx(0) {}
+    virtual ~VectorDeleteKeyIterator() {}
+
+    virtual bool Next(ObjectVersionPair* key);
+
+private:
+    const std::vector<ObjectVersionPair>& m_keys;
+    size_t m_idx;
+};
+
+/// \brief 以BucketObjectIterator列出前缀下的Object作为key来源, 跳过Common Prefix.
+///        列表在后台预取, 删除当前批次时下一页已经在列出
+class PrefixDeleteKeyIterator : public DeleteKeyIterator {
+public:
+    PrefixDeleteKeyIterator(const BucketOp& op, const GetBucketReq& req,
+                            unsigned prefetch_depth = kDefaultListPrefetchDepth)
+        : m_iter(op, req, prefetch_depth) {}
+    virtual ~PrefixDeleteKeyIterator() {}
+
+    virtual bool Next(ObjectVersionPair* key);
+    virtual CosResult GetResult() const;
+
+private:
+    BucketObjectIterator m_iter;
+    BucketObjectEntry m_entry;
+};
+
+/// \brief 一次批量删除的执行过程, 由ObjectOp::BulkDelete使用.
+///        调用线程从key来源读取并按批次切分, 最多GetThreadNum()个批次同时在删除中,
+///        因此按前缀删除时列出与删除是流水线进行的. 某个批次整体失败后不再发出新的批次
+class BulkDeleter : private NonCopyable {
+public:
+    BulkDeleter(const ObjectOp& op, const BulkDeleteReq& req);
+
+    /// \brief 阻塞直到所有批次结束. 批次整体失败、key来源出错或被取消时返回失败,
+    ///        单个Object删除失败不影响返回值, 通过resp->GetErrorInfos()获取
+    CosResult Run(DeleteKeyIterator* keys, BulkDeleteResp* resp);
+
+private:
+    typedef boost::shared_ptr<std::vector<ObjectVersionPair> > SharedBatch;
+
+    // 等待空闲的并发名额, 已停止时返回false
+    bool AcquireSlot();
+    void RunBatch(SharedBatch batch);
+    bool IsStopped() const;
+
+private:
+    ObjectOp m_op;
+    const BulkDeleteReq& m_req;
+
+    mutable boost::mutex m_mutex;
+    boost::condition_variable m_cond;
+    unsigned m_in_flight;
+    bool m_is_stopped;
+    CosResult m_err_result;
+    uint64_t m_deleted_count;
+    uint64_t m_batch_count;
+    uint64_t m_failed_batch_count;
+    std::vector<ErrorInfo> m_error_infos;
+};
+
+} // namespace qcloud_cos
+#endif // BULK_DELETER_H
@@ -0,0 +1,122 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: 并发扫描本地目录并上传其中的文件
+
+#ifndef DIRECTORY_UPLOADER_H
+#define DIRECTORY_UPLOADER_H
+#pragma once
+
+#include <stdint.h>
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "boost/thread/condition_variable.hpp"
+#include "boost/thread/mutex.hpp"
+
+#include "op/cos_result.h"
+#include "op/object_op.h"
+#include "request/object_req.h"
+#include "response/object_resp.h"
+#include "util/noncopyable.h"
+
+namespace qcloud_cos {
+
+/// \brief 目录上传的汇总进度
+struct UploadDirectoryProgress {
+    UploadDirectoryProgress()
+        : m_file_count(0), m_total_bytes(0), m_done_count(0), m_done_bytes(0),
+          m_skipped_count(0), m_failed_count(0), m_is_walk_done(false) {}
+
+    uint64_t m_file_count;    // 已扫描到的文件数
+    uint64_t m_total_bytes;   // 已扫描到的文件总大小
+    uint64_t m_done_count;    // 已结束的文件数, 包括跳过和失败的文件
+    uint64_t m_done_bytes;    // 已结束的文件总大小
+    uint64_t m_skipped_count; // 跳过的文件数
+    uint64_t m_failed_count;  // 失败的文件数
+    bool m_is_walk_done;      // 目录是否已扫描完, 扫描完之后文件数和总大小不再增加
+};
+
+/// \brief 目录上传的回调, 会在多个工作线程中并发调用, 需自行保证线程安全
+class UploadDirectoryHandler {
+public:
+    virtual ~UploadDirectoryHandler() {}
+
+    /// \brief 每个文件上传成功、跳过或失败后调用
+    virtual void OnFileDone(const std::string& local_path, const std::string& object_name,
+                            const CosResult& result, bool is_skipped,
+                            const UploadDirectoryProgress& progress) = 0;
+};
+
+/// \brief 一次目录上传的执行过程, 由ObjectOp::UploadDirectory使用.
+///        调用线程负责调度: 扫描子目录的任务和上传文件的任务都提交到共享执行器,
+///        待上传文件积压过多时暂停扫描, 在途文件占用的连接数和预估内存不超过请求的限制.
+///        简单上传占一个连接, 分块上传占分块并发数个连接, 两者共享ThreadNum个连接.
+///        单个文件失败不影响其他文件
+class DirectoryUploader : private NonCopyable {
+public:
+    DirectoryUploader(const ObjectOp& op, const UploadDirectoryReq& req,
+                      UploadDirectoryHandler* handler);
+
+    /// \brief 阻塞直到所有文件结束. 根目录无法打开或被取消时返回失败,
+    ///        单个文件失败不影响返回值, 通过resp->GetErrorInfos()获取
+    CosResult Run(UploadDirectoryResp* resp);
+
+private:
+    struct FileEntry {
+        FileEntry() : m_size(0) {}
+
+        std::string m_local_path;
+        std::string m_object_name;
+        uint64_t m_size;
+    };
+
+    // 扫描rel_dir下的一层目录项, rel_dir为相对local_dir的路径, 根目录为空串
+    void ScanDir(const std::string& rel_dir);
+
+    void UploadFile(const FileEntry& file);
+
+    // 远端Object与本地文件大小和MD5一致时返回true, local_md5返回计算过的本地MD5
+    bool IsSameAsRemote(const FileEntry& file, std::string* local_md5);
+
+    CosResult PutFile(const FileEntry& file, const std::string& local_md5);
+
+    // 按请求的设置估算文件上传期间占用的内存
+    uint64_t GetMemoryCost(const FileEntry& file) const;
+
+    // 文件上传期间最多同时使用的连接数
+    unsigned GetConnCost(const FileEntry& file) const;
+
+    bool IsCancelled() const;
+
+    // 把请求的超时、截止时间、取消句柄等设置复制到单个文件的请求
+    void CopySettings(BaseReq* req) const;
+
+private:
+    ObjectOp m_op;
+    const UploadDirectoryReq& m_req;
+    UploadDirectoryHandler* m_handler;
+    std::string m_root;
+    unsigned m_thread_num;
+    uint64_t m_part_size;
+    unsigned m_part_thread_num;
+
+    boost::mutex m_mutex;
+    boost::condition_variable m_cond;
+    // 待扫描的子目录
+    std::vector<std::string> m_pending_dirs;
+    // 待上传的文件
+    std::deque<FileEntry> m_files;
+    unsigned m_scanning;
+    unsigned m_uploading;
+    unsigned m_conns_in_use;
+    uint64_t m_memory_in_use;
+    UploadDirectoryProgress m_progress;
+    uint64_t m_uploaded_bytes;
+    std::vector<ErrorInfo> m_error_infos;
+};
+
+} // namespace qcloud_cos
+#endif // DIRECTORY_UPLOADER_H
@@ -14,6 +14,8 @@
 #include "util/codec_util.h"
 #include "util/file_util.h"
 #include "util/http_sender.h"
+#include "util/cancel_token.h"
+#include "util/retry_policy.h"
 #include "util/string_util.h"
 
 namespace qcloud_cos {
@@ -48,6 +50,16 @@ public:
 
     std::string GetLastModified() const { return m_last_modified; }
 
+    void SetRetryPolicy(const RetryPolicy& retry_policy) { m_retry_policy = retry_policy; }
+
+    /// \brief 取消正在执行的任务, 可从其他线程调用
+    void Cancel() { m_cancel_token.Cancel(); }
+
+    /// \brief 关联调用方的取消句柄, 调用方取消或超过截止时间时任务随之结束
+    void SetParentCancelToken(const SharedCancelToken& cancel_token) {
+        m_cancel_token.SetParent(cancel_token);
+    }
+
 private:
     std::string m_full_url;
     std::map<std::string, std::string> m_headers;
@@ -61,6 +73,8 @@ private:
     std::string m_err_msg;
     std::string m_etag;
     std::string m_last_modified;
+    RetryPolicy m_retry_policy;
+    CancelToken m_cancel_token;
 };
 
 }
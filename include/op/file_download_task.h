@@ -21,7 +21,10 @@
 #include "util/codec_util.h"
 #include "util/file_util.h"
 #include "util/http_sender.h"
+#include "util/cancel_token.h"
+#include "util/retry_policy.h"
 #include "util/string_util.h"
+#include "util/transfer_progress.h"
 
 namespace qcloud_cos {
 
@@ -56,6 +59,25 @@ public:
 
     std::string GetErrMsg() const { return m_err_msg; }
 
+    void SetRetryPolicy(const RetryPolicy& retry_policy) { m_retry_policy = retry_policy; }
+
+    /// \brief 传输进度, 供调度方检测低速分块
+    const TransferProgress& GetProgress() const { return m_progress; }
+
+    /// \brief 取消正在执行的任务, 可从其他线程调用
+    void Cancel() { m_cancel_token.Cancel(); }
+
+    /// \brief 关联调用方的取消句柄, 调用方取消或超过截止时间时任务随之结束
+    void SetParentCancelToken(const SharedCancelToken& cancel_token) {
+        m_cancel_token.SetParent(cancel_token);
+    }
+
+    /// \brief 设置限速器, 同一次调用的所有分块共享, 为空表示不限速
+    void SetRateLimiter(const SharedRateLimiter& rate_limiter) { m_rate_limiter = rate_limiter; }
+
+    /// \brief 设置分块请求的优先级, 同一次调用的所有分块相同
+    void SetPriority(REQUEST_PRIORITY priority) { m_priority = priority; }
+
 private:
     std::string m_full_url;
     std::map<std::string, std::string> m_headers;
@@ -71,6 +93,11 @@ private:
     int m_http_status;
     std::map<std::string, std::string> m_resp_headers;
     std::string m_err_msg;
+    RetryPolicy m_retry_policy;
+    TransferProgress m_progress;
+    CancelToken m_cancel_token;
+    SharedRateLimiter m_rate_limiter;
+    REQUEST_PRIORITY m_priority;
 };
 
 } // namespace qcloud_cos
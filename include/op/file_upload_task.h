@@ -14,7 +14,10 @@
 #include "util/codec_util.h"
 #include "util/file_util.h"
 #include "util/http_sender.h"
+#include "util/cancel_token.h"
+#include "util/retry_policy.h"
 #include "util/string_util.h"
+#include "util/transfer_progress.h"
 
 namespace qcloud_cos{
 
@@ -42,6 +45,10 @@ public:
 
     void SetUploadBuf(unsigned char* pdatabuf, size_t data_len);
 
+    /// \brief 直接上传本地文件[offset, offset + data_len)范围的数据, 不经过分块缓冲区,
+    ///        非TLS连接上由HttpSender用sendfile发送
+    void SetUploadFileRange(const std::string& file_path, uint64_t offset, size_t data_len);
+
     std::string GetTaskResp() const;
 
     bool IsTaskSuccess() const;
@@ -56,6 +63,28 @@ public:
 
     std::string GetErrMsg() const { return m_err_msg; }
 
+    void SetRetryPolicy(const RetryPolicy& retry_policy) { m_retry_policy = retry_policy; }
+
+    /// \brief 传输进度, 供调度方检测低速分块
+    const TransferProgress& GetProgress() const { return m_progress; }
+
+    /// \brief 取消正在执行的任务, 可从其他线程调用
+    void Cancel() { m_cancel_token.Cancel(); }
+
+    /// \brief 关联调用方的取消句柄, 调用方取消或超过截止时间时任务随之结束
+    void SetParentCancelToken(const SharedCancelToken& cancel_token) {
+        m_cancel_token.SetParent(cancel_token);
+    }
+
+    /// \brief 设置限速器, 同一次调用的所有分块共享, 为空表示不限速
+    void SetRateLimiter(const SharedRateLimiter& rate_limiter) { m_rate_limiter = rate_limiter; }
+
+    /// \brief 设置分块请求的优先级, 同一次调用的所有分块相同
+    void SetPriority(REQUEST_PRIORITY priority) { m_priority = priority; }
+
+    /// \brief 设置x-cos-traffic-limit请求头的值, 为空表示不设置
+    void SetTrafficLimit(const std::string& traffic_limit) { m_traffic_limit = traffic_limit; }
+
 private:
     std::string m_full_url;
     std::map<std::string, std::string> m_headers;
@@ -64,11 +93,19 @@ private:
     uint64_t m_recv_timeout_in_ms;
     unsigned char*  m_data_buf_ptr;
     size_t m_data_len;
+    std::string m_file_path;
+    uint64_t m_file_offset;
     std::string m_resp;
     bool m_is_task_success;
     int m_http_status;
     std::map<std::string, std::string> m_resp_headers;
     std::string m_err_msg;
+    RetryPolicy m_retry_policy;
+    TransferProgress m_progress;
+    CancelToken m_cancel_token;
+    SharedRateLimiter m_rate_limiter;
+    REQUEST_PRIORITY m_priority;
+    std::string m_traffic_limit;
 };
 
 }
@@ -11,14 +11,25 @@
 
 #include "op/base_op.h"
 
+#include "boost/shared_ptr.hpp"
+
 #include "op/cos_result.h"
 #include "request/object_req.h"
 #include "response/object_resp.h"
+#include "util/disk_cache.h"
+#include "util/noncopyable.h"
+#include "util/object_meta_cache.h"
+#include "util/single_flight.h"
 
 namespace qcloud_cos {
 
 class FileUploadTask;
 class FileCopyTask;
+class DeleteKeyIterator;
+class UploadDirectoryHandler;
+class DownloadPrefixHandler;
+class NegativeCache;
+class CacheGeneration;
 
 /// \brief 封装了Object相关的操作
 class ObjectOp : public BaseOp {
@@ -26,8 +37,8 @@ public:
     /// \brief BucketOp构造函数
     ///
     /// \param cos_conf Cos配置
-    explicit ObjectOp(CosConfig& config) : BaseOp(config) {}
-    ObjectOp() {}
+    explicit ObjectOp(CosConfig& config);
+    ObjectOp();
 
     /// \brief ObjectOP析构函数
     virtual ~ObjectOp() {}
@@ -35,7 +46,7 @@ public:
     /// \brief 判断object是否存在
     bool IsObjectExist(const std::string& bucket_name, const std::string& object_name);
 
-    /// \brief 获取对应Object的meta信息数据
+    /// \brief 获取对应Object的meta信息数据. 开启元数据缓存时在有效期内直接返回缓存
     ///
     /// \param request   HeadObject请求
     /// \param response  HeadObject返回
@@ -43,6 +54,24 @@ public:
     /// \return 返回HTTP请求的状态码及错误信息
     CosResult HeadObject(const HeadObjectReq& req, HeadObjectResp* resp);
 
+    /// \brief 并发获取一批Object的meta信息, 结果与req中的Object顺序一致.
+    ///        单个Object不存在时不影响返回值
+    ///
+    /// \param request   BatchHeadObject请求
+    /// \param response  BatchHeadObject返回
+    ///
+    /// \return 所有Object都得到结果时返回成功, 否则返回第一个非404的错误
+    CosResult BatchHeadObject(const BatchHeadObjectReq& req, BatchHeadObjectResp* resp);
+
+    /// \brief 获取元数据缓存的命中统计, 未开启缓存时返回全0
+    ObjectMetaCacheStat GetMetaCacheStat() const;
+
+    /// \brief 获取磁盘缓存的统计, 未开启缓存时返回全0
+    DiskCacheStat GetDiskCacheStat() const;
+
+    /// \brief 获取相同读请求合并的统计, 未开启合并时返回全0
+    SingleFlightStat GetSingleFlightStat() const;
+
     /// \brief 下载Bucket中的一个文件至流中
     ///
     /// \param request   GetObjectByStream请求
@@ -67,6 +96,16 @@ public:
     /// \return 返回HTTP请求的状态码及错误信息
     CosResult GetObject(const MultiGetObjectReq& req, MultiGetObjectResp* resp);
 
+    /// \brief 把前缀下的所有Object下载到本地目录, 小Object整体下载, 大Object分片并发下载
+    ///
+    /// \param req     DownloadPrefix请求
+    /// \param handler 进度回调, 可以为NULL
+    /// \param resp    DownloadPrefix返回
+    ///
+    /// \return 本地目录无法创建、列出失败或被取消时返回失败, 单个Object失败不影响返回值
+    CosResult DownloadPrefix(const DownloadPrefixReq& req, DownloadPrefixHandler* handler,
+                             DownloadPrefixResp* resp);
+
     /// \brief 将本地的文件上传至指定Bucket中
     ///
     /// \param request   PutObjectByFile请求
@@ -99,6 +138,34 @@ public:
     /// \return 本次请求的调用情况(如状态码等)
     CosResult DeleteObjects(const DeleteObjectsReq& req, DeleteObjectsResp* resp);
 
+    /// \brief 批量删除req中添加的Object, 按每批最多1000个拆分为多个DeleteObjects请求并发执行
+    ///
+    /// \param req  BulkDelete请求
+    /// \param resp BulkDelete返回
+    ///
+    /// \return 本次请求的调用情况(如状态码等)
+    CosResult BulkDelete(const BulkDeleteReq& req, BulkDeleteResp* resp);
+
+    /// \brief 批量删除keys返回的Object, 边读取边删除, req中添加的Object被忽略
+    ///
+    /// \param req  BulkDelete请求
+    /// \param keys 待删除Object的来源
+    /// \param resp BulkDelete返回
+    ///
+    /// \return 本次请求的调用情况(如状态码等)
+    CosResult BulkDelete(const BulkDeleteReq& req, DeleteKeyIterator* keys,
+                         BulkDeleteResp* resp);
+
+    /// \brief 删除指定前缀下的所有Object, 列出与删除流水线进行. prefix不能为空
+    ///
+    /// \param req    BulkDelete请求
+    /// \param prefix Object前缀
+    /// \param resp   BulkDelete返回
+    ///
+    /// \return 本次请求的调用情况(如状态码等)
+    CosResult DeleteObjectsByPrefix(const BulkDeleteReq& req, const std::string& prefix,
+                                    BulkDeleteResp* resp);
+
     /// \brief 请求实现初始化分片上传,成功执行此请求以后会返回UploadId用于后续的Upload Part请求
     ///
     /// \param request   InitMultiUpload请求
@@ -142,6 +209,16 @@ public:
     /// \return 返回HTTP请求的状态码及错误信息
     CosResult MultiUploadObject(const MultiUploadObjectReq& req, MultiUploadObjectResp* resp);
 
+    /// \brief 上传本地目录下的所有文件, 小文件简单上传, 大文件分块上传
+    ///
+    /// \param req     UploadDirectory请求
+    /// \param handler 进度回调, 可以为NULL
+    /// \param resp    UploadDirectory返回
+    ///
+    /// \return 根目录无法打开或被取消时返回失败, 单个文件失败不影响返回值
+    CosResult UploadDirectory(const UploadDirectoryReq& req, UploadDirectoryHandler* handler,
+                              UploadDirectoryResp* resp);
+
     /// \brief 舍弃一个分块上传并删除已上传的块
     ///
     /// \param req  AbortMultiUpload请求
@@ -206,6 +283,59 @@ public:
     std::string GeneratePresignedUrl(const GeneratePresignedUrlReq& req);
 
 private:
+    // 写入或删除Object期间持有. 构造和析构时各删除一次缓存中的记录并增加写入计数,
+    // 写入期间开始的读取不会把旧数据留在缓存中
+    class CacheWriteGuard : private NonCopyable {
+    public:
+        CacheWriteGuard(ObjectOp* op, const std::string& bucket_name);
+        CacheWriteGuard(ObjectOp* op, const std::string& bucket_name,
+                        const std::string& object_name);
+        ~CacheWriteGuard();
+
+        void Add(const std::string& object_name);
+
+    private:
+        ObjectOp* m_op;
+        std::string m_bucket_name;
+        std::vector<std::string> m_object_names;
+    };
+
+    // 增加写入计数并删除缓存中的记录
+    void InvalidateCache(const std::string& bucket_name, const std::string& object_name);
+
+    // 用请求结果更新元数据缓存. if_none_match非空且服务端返回304时,
+    // ETag与缓存一致则延长有效期并用缓存的响应头填充resp.
+    // write_generation为发出请求前的写入计数, 请求期间有写入时不保留更新的记录
+    bool UpdateMetaCache(const std::string& bucket_name, const std::string& object_name,
+                         const std::string& if_none_match, uint64_t write_generation,
+                         const CosResult& result, BaseResp* resp);
+
+    // GET请求携带的If-None-Match与有效期内的缓存一致时, 不发出请求直接返回304
+    bool GetNotModifiedFromCache(const ObjectReq& req, BaseResp* resp, CosResult* result);
+
+    // 经过磁盘缓存下载Object, 写入os或local_path. 未开启缓存或请求不可缓存时返回false,
+    // 由调用方直接下载
+    bool GetObjectByDiskCache(const GetObjectReq& req, bool is_multi, std::ostream* os,
+                              const std::string& local_path, GetObjectResp* resp,
+                              CosResult* result);
+
+    // 下载Object到临时文件并加入磁盘缓存, cached_etag非空时先重新验证.
+    // 成功时entry为可读取的文件, is_temp为true表示文件未能加入缓存, 读取后需删除.
+    // 下载期间有写入时(写入计数与write_generation不同)文件不加入缓存
+    CosResult FillDiskCache(const GetObjectReq& req, bool is_multi,
+                            const std::string& cached_etag, uint64_t write_generation,
+                            GetObjectResp* resp, DiskCacheEntry* entry, bool* is_revalidated,
+                            bool* is_temp);
+
+    // 发出HeadObject请求, 开启合并时与同时进行的相同请求共用一次请求
+    CosResult SingleFlightHead(const std::string& host, const std::string& path,
+                               const HeadObjectReq& req, HeadObjectResp* resp);
+
+    // 下载Object写入os, 开启合并时与同时进行的相同请求共用一次下载
+    CosResult SingleFlightDownload(const std::string& host, const std::string& path,
+                                   const GetObjectReq& req, GetObjectResp* resp,
+                                   std::ostream& os);
+
     // 生成request body所需的xml字符串
     bool GenerateCompleteMultiUploadReqBody(const CompleteMultiUploadReq& req,
                                             std::string* req_body);
@@ -227,12 +357,30 @@ private:
                         uint64_t len, uint64_t part_number,
                         FileUploadTask* task_ptr);
 
+    // 分块任务直接读取本地文件[file_offset, file_offset + len)的数据
+    void FillUploadFileTask(const std::string& upload_id, const std::string& host,
+                            const std::string& path, const std::string& local_file_path,
+                            uint64_t file_offset, uint64_t len, uint64_t part_number,
+                            FileUploadTask* task_ptr);
+
     void FillCopyTask(const std::string& upload_id, const std::string& host,
                       const std::string& path, uint64_t part_number,
                       const std::string& range,
                       const std::map<std::string, std::string>& headers,
                       const std::map<std::string, std::string>& params,
                       FileCopyTask* task);
+
+private:
+    // 拷贝的ObjectOp共享同一个缓存
+    boost::shared_ptr<NegativeCache> m_negative_cache;
+    // 各Object的写入计数, 与缓存一样由拷贝的ObjectOp共享
+    boost::shared_ptr<CacheGeneration> m_cache_generation;
+    // 未开启元数据缓存时为空
+    boost::shared_ptr<ObjectMetaCache> m_meta_cache;
+    // 未开启磁盘缓存时为空, 相同缓存目录的ObjectOp共享同一个实例
+    boost::shared_ptr<DiskCache> m_disk_cache;
+    // 未开启相同读请求合并时为空
+    boost::shared_ptr<SingleFlight> m_single_flight;
 };
 
 } // namespace qcloud_cos
@@ -0,0 +1,94 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: 按key空间分片并发列出Object
+
+#ifndef PARALLEL_BUCKET_LISTER_H
+#define PARALLEL_BUCKET_LISTER_H
+#pragma once
+
+#include <stdint.h>
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "boost/shared_ptr.hpp"
+#include "boost/thread/condition_variable.hpp"
+#include "boost/thread/mutex.hpp"
+
+#include "op/bucket_object_iterator.h"
+#include "op/bucket_op.h"
+#include "op/cos_result.h"
+#include "request/bucket_req.h"
+#include "response/bucket_resp.h"
+#include "util/cancel_token.h"
+#include "util/noncopyable.h"
+
+namespace qcloud_cos {
+
+/// \brief 并发列出Object的回调. 无序模式下会在多个工作线程中并发调用, 需自行保证线程安全
+class ListObjectsHandler {
+public:
+    virtual ~ListObjectsHandler() {}
+
+    /// \brief 返回false时停止列出, ParallelListObjects仍返回成功
+    virtual bool OnEntry(const BucketObjectEntry& entry) = 0;
+};
+
+/// \brief 一次并发列出的执行过程, 由BucketOp::ParallelListObjects使用
+class ParallelBucketLister : private NonCopyable {
+public:
+    ParallelBucketLister(const BucketOp& op, const ParallelListObjectsReq& req,
+                         ListObjectsHandler* handler);
+
+    /// \brief 切分分片并列出, 阻塞直到所有分片结束、出错或回调要求停止
+    CosResult Run(ParallelListObjectsResp* resp);
+
+    /// \brief 由调用方指定的边界和自动发现的边界得到有序去重的分片边界,
+    ///        只保留大于marker的边界
+    static std::vector<std::string> MergeSplitPoints(const std::vector<std::string>& split_points,
+                                                     const std::vector<std::string>& discovered,
+                                                     const std::string& marker);
+
+private:
+    // 左开右闭的key区间, m_upper为空表示没有上界
+    struct Shard {
+        Shard() : m_is_done(false) {}
+
+        std::string m_lower;
+        std::string m_upper;
+        std::deque<BucketObjectEntry> m_entries;
+        bool m_is_done;
+    };
+    typedef boost::shared_ptr<Shard> SharedShard;
+
+    // 以m_discover_delimiter列出Common Prefix
+    CosResult Discover(std::vector<std::string>* prefixes);
+    void RunShard(SharedShard shard);
+    // 有序模式下把工作线程的一批记录交给调用线程, 缓存满时等待
+    void DeliverBatch(Shard* shard, std::vector<BucketObjectEntry>* batch);
+    // 在调用线程中按分片顺序回调
+    void ConsumeOrdered();
+    bool Emit(const BucketObjectEntry& entry);
+    // err为NULL表示回调要求停止
+    void Stop(const CosResult* err);
+    bool IsStopped() const;
+
+private:
+    BucketOp m_op;
+    const ParallelListObjectsReq& m_req;
+    ListObjectsHandler* m_handler;
+    SharedCancelToken m_cancel_token;
+    std::vector<SharedShard> m_shards;
+
+    mutable boost::mutex m_mutex;
+    boost::condition_variable m_cond;
+    bool m_is_stopped;
+    bool m_is_error;
+    CosResult m_err_result;
+    uint64_t m_entry_count;
+};
+
+} // namespace qcloud_cos
+#endif // PARALLEL_BUCKET_LISTER_H
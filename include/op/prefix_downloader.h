@@ -0,0 +1,125 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: 列出前缀下的Object并发下载到本地目录
+
+#ifndef PREFIX_DOWNLOADER_H
+#define PREFIX_DOWNLOADER_H
+#pragma once
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "boost/thread/condition_variable.hpp"
+#include "boost/thread/mutex.hpp"
+
+#include "op/bucket_object_iterator.h"
+#include "op/cos_result.h"
+#include "op/object_op.h"
+#include "request/object_req.h"
+#include "response/object_resp.h"
+#include "util/noncopyable.h"
+
+namespace qcloud_cos {
+
+/// \brief 按前缀下载的汇总进度
+struct DownloadPrefixProgress {
+    DownloadPrefixProgress()
+        : m_object_count(0), m_total_bytes(0), m_done_count(0), m_done_bytes(0),
+          m_skipped_count(0), m_failed_count(0), m_is_list_done(false) {}
+
+    uint64_t m_object_count;  // 已列出的Object数
+    uint64_t m_total_bytes;   // 已列出的Object总大小
+    uint64_t m_done_count;    // 已结束的Object数, 包括跳过和失败的Object
+    uint64_t m_done_bytes;    // 已结束的Object总大小
+    uint64_t m_skipped_count; // 跳过的Object数
+    uint64_t m_failed_count;  // 失败的Object数
+    bool m_is_list_done;      // 是否已列出全部Object, 之后Object数和总大小不再增加
+};
+
+/// \brief 按前缀下载的回调, 会在多个工作线程中并发调用, 需自行保证线程安全
+class DownloadPrefixHandler {
+public:
+    virtual ~DownloadPrefixHandler() {}
+
+    /// \brief 每个Object下载成功、跳过或失败后调用
+    virtual void OnObjectDone(const std::string& object_name, const std::string& local_path,
+                              const CosResult& result, bool is_skipped,
+                              const DownloadPrefixProgress& progress) = 0;
+};
+
+/// \brief 一次按前缀下载的执行过程, 由ObjectOp::DownloadPrefix使用.
+///        调用线程从预取的列表迭代器读取Object并分发到共享执行器, 列出与下载并行进行;
+///        在途Object占用的连接数和预估内存不超过请求的限制. 整体下载占一个连接, 分片下载占
+///        分片并发数个连接, 两者共享ThreadNum个连接. 单个Object失败不影响其他Object
+class PrefixDownloader : private NonCopyable {
+public:
+    PrefixDownloader(const ObjectOp& op, const DownloadPrefixReq& req,
+                     DownloadPrefixHandler* handler);
+
+    /// \brief 阻塞直到所有Object结束. 本地目录无法创建、列出失败或被取消时返回失败,
+    ///        单个Object失败不影响返回值, 通过resp->GetErrorInfos()获取
+    CosResult Run(DownloadPrefixResp* resp);
+
+    /// \brief 由Object名得到相对local_dir的路径, 去掉prefix和prefix后的一个'/'.
+    ///        路径为空或含有空段、"."、".."时返回false, 避免写到目标目录之外或与其他Object冲突
+    static bool GetRelativePath(const std::string& prefix, const std::string& object_name,
+                                std::string* rel_path);
+
+private:
+    struct ObjectEntry {
+        ObjectEntry() : m_size(0) {}
+
+        std::string m_object_name;
+        std::string m_etag;
+        std::string m_local_path;
+        uint64_t m_size;
+    };
+
+    // 等待连接数和内存预算允许下载大小为size的Object, 被取消时返回false
+    bool AcquireSlot(uint64_t size);
+
+    void DownloadObject(const ObjectEntry& entry);
+
+    // 本地文件与远端Object大小和MD5一致时返回true
+    bool IsSameAsLocal(const ObjectEntry& entry);
+
+    CosResult GetObjectToFile(const ObjectEntry& entry, const std::string& local_path);
+
+    // 按请求的设置估算Object下载期间占用的内存
+    uint64_t GetMemoryCost(uint64_t size) const;
+
+    // Object下载期间最多同时使用的连接数
+    unsigned GetConnCost(uint64_t size) const;
+
+    bool IsCancelled() const;
+
+    // 把请求的超时、截止时间、取消句柄等设置复制到单个Object的请求
+    void CopySettings(BaseReq* req) const;
+
+    // 更新汇总进度并回调, 在Object结束后调用
+    void FinishObject(const ObjectEntry& entry, const CosResult& result, bool is_skipped);
+
+private:
+    ObjectOp m_op;
+    const DownloadPrefixReq& m_req;
+    DownloadPrefixHandler* m_handler;
+    std::string m_root;
+    unsigned m_thread_num;
+    uint64_t m_slice_size;
+    unsigned m_slice_thread_num;
+
+    boost::mutex m_mutex;
+    boost::condition_variable m_cond;
+    unsigned m_downloading;
+    unsigned m_conns_in_use;
+    uint64_t m_memory_in_use;
+    DownloadPrefixProgress m_progress;
+    uint64_t m_downloaded_bytes;
+    std::vector<ErrorInfo> m_error_infos;
+};
+
+} // namespace qcloud_cos
+#endif // PREFIX_DOWNLOADER_H
@@ -15,6 +15,8 @@
 #include <string>
 
 #include "cos_defines.h"
+#include "util/cancel_token.h"
+#include "util/request_scheduler.h"
 #include "util/string_util.h"
 
 namespace qcloud_cos {
@@ -69,6 +71,7 @@ public:
     /// \brief 设置Path
     void SetPath(const std::string& path) { m_path = path; }
 
+    /// \brief 设置连接超时时间, 单位:毫秒. 默认为0, 表示使用CosAPI的配置
     void SetConnTimeoutInms(uint64_t conn_timeout_in_ms) {
         m_conn_timeout_in_ms = conn_timeout_in_ms;
     }
@@ -77,6 +80,7 @@ public:
         return m_conn_timeout_in_ms;
     }
 
+    /// \brief 设置接收超时时间, 单位:毫秒. 默认为0, 表示使用CosAPI的配置
     void SetRecvTimeoutInms(uint64_t recv_timeout_in_ms) {
         m_recv_timeout_in_ms = recv_timeout_in_ms;
     }
@@ -85,6 +89,49 @@ public:
         return m_recv_timeout_in_ms;
     }
 
+    /// \brief 设置取消句柄, 句柄被取消后请求尽快结束, 包括重试和分块上传/下载/复制的所有分块,
+    ///        正在使用的连接会被立即关闭
+    void SetCancelToken(const SharedCancelToken& cancel_token) {
+        m_cancel_token = cancel_token;
+    }
+
+    const SharedCancelToken& GetCancelToken() const {
+        return m_cancel_token;
+    }
+
+    /// \brief 设置请求的截止时间(毫秒时间戳), 0表示不限制.
+    ///        与conn_timeout/recv_timeout不同, 截止时间限制的是整个调用的耗时
+    void SetDeadlineInms(uint64_t deadline_in_ms) {
+        m_deadline_in_ms = deadline_in_ms;
+    }
+
+    uint64_t GetDeadlineInms() const {
+        return m_deadline_in_ms;
+    }
+
+    /// \brief 设置整个调用的超时时间, 截止时间为当前时间加上timeout_in_ms
+    void SetTotalTimeoutInms(uint64_t timeout_in_ms);
+
+    /// \brief 设置本次调用在客户端的限速, 单位:字节/秒, 默认为0, 表示只受CosAPI和全局限速的限制.
+    ///        分块上传/下载的所有分块共享该限速
+    void SetRateLimit(uint64_t rate_in_bytes_per_s) {
+        m_rate_limit = rate_in_bytes_per_s;
+    }
+
+    uint64_t GetRateLimit() const {
+        return m_rate_limit;
+    }
+
+    /// \brief 设置本次调用的优先级, 默认为PRIORITY_NORMAL. 设置了RequestScheduler的并发上限时,
+    ///        排队的请求按优先级的权重获得执行许可, 分块上传/下载的所有分块使用该优先级
+    void SetPriority(REQUEST_PRIORITY priority) {
+        m_priority = priority;
+    }
+
+    REQUEST_PRIORITY GetPriority() const {
+        return m_priority;
+    }
+
     /// \brief 设置当前请求是否使用https
     void SetHttps() { m_is_https = true; }
     bool IsHttps() const { return m_is_https; }
@@ -107,6 +154,10 @@ protected:
 
     uint64_t m_conn_timeout_in_ms;
     uint64_t m_recv_timeout_in_ms;
+    uint64_t m_deadline_in_ms;
+    uint64_t m_rate_limit;
+    REQUEST_PRIORITY m_priority;
+    SharedCancelToken m_cancel_token;
     bool m_is_https;
 };
 
@@ -9,6 +9,8 @@
 #define BUCKET_REQ_H
 #pragma once
 
+#include <vector>
+
 #include "cos_defines.h"
 #include "request/base_req.h"
 #include "util/string_util.h"
@@ -103,6 +105,68 @@ public:
     }
 };
 
+/// \brief 并发列出Object的请求. 先按分片边界把key空间切分为若干个左开右闭的区间,
+///        各区间在线程池中并发地按marker翻页列出, 结果可以按key的顺序或者无序地回调
+class ParallelListObjectsReq : public GetBucketReq {
+public:
+    ParallelListObjectsReq(const std::string& bucket_name)
+        : GetBucketReq(bucket_name), m_thread_num(kDefaultParallelListThreadNum),
+          m_discover_delimiter("/"), m_max_shards(kDefaultParallelListMaxShards),
+          m_is_ordered(true), m_prefetch_depth(1),
+          m_max_buffered_entries(kDefaultParallelListBufferedEntries) {
+    }
+
+    virtual ~ParallelListObjectsReq() {}
+
+    /// \brief 并发列出的线程数
+    void SetThreadNum(unsigned thread_num) { m_thread_num = thread_num; }
+    unsigned GetThreadNum() const { return m_thread_num; }
+
+    /// \brief 添加分片边界, 相邻边界a < b之间的分片包含(a, b]内的key.
+    ///        调用方了解key的分布时(如按日期或哈希前缀命名)可直接指定边界
+    void AddSplitPoint(const std::string& split_point) {
+        m_split_points.push_back(split_point);
+    }
+    void SetSplitPoints(const std::vector<std::string>& split_points) {
+        m_split_points = split_points;
+    }
+    const std::vector<std::string>& GetSplitPoints() const { return m_split_points; }
+
+    /// \brief 非空时先以该定界符列出prefix下的Common Prefix, 并作为分片边界,
+    ///        为空时只使用调用方指定的边界. 默认为"/"
+    void SetDiscoverDelimiter(const std::string& delimiter) {
+        m_discover_delimiter = delimiter;
+    }
+    const std::string& GetDiscoverDelimiter() const { return m_discover_delimiter; }
+
+    /// \brief 自动发现的分片边界数上限, 达到上限后剩余的key空间作为最后一个分片
+    void SetMaxShards(unsigned max_shards) { m_max_shards = max_shards; }
+    unsigned GetMaxShards() const { return m_max_shards; }
+
+    /// \brief true时在调用线程中按key的顺序回调, false时在工作线程中并发回调
+    void SetOrdered(bool is_ordered) { m_is_ordered = is_ordered; }
+    bool IsOrdered() const { return m_is_ordered; }
+
+    /// \brief 每个分片预取的页数
+    void SetPrefetchDepth(unsigned prefetch_depth) { m_prefetch_depth = prefetch_depth; }
+    unsigned GetPrefetchDepth() const { return m_prefetch_depth; }
+
+    /// \brief 有序模式下每个分片最多缓存的记录数, 超过时该分片暂停列出
+    void SetMaxBufferedEntries(unsigned max_buffered_entries) {
+        m_max_buffered_entries = max_buffered_entries;
+    }
+    unsigned GetMaxBufferedEntries() const { return m_max_buffered_entries; }
+
+private:
+    unsigned m_thread_num;
+    std::vector<std::string> m_split_points;
+    std::string m_discover_delimiter;
+    unsigned m_max_shards;
+    bool m_is_ordered;
+    unsigned m_prefetch_depth;
+    unsigned m_max_buffered_entries;
+};
+
 class DeleteBucketReq : public BucketReq {
 public:
     DeleteBucketReq(const std::string& bucket_name)
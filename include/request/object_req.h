@@ -15,6 +15,7 @@
 #include <sstream>
 
 #include "cos_defines.h"
+#include "cos_params.h"
 #include "cos_sys_config.h"
 #include "json/json.h"
 
@@ -79,6 +80,12 @@ public:
         AddParam("response-content-disposition", str);
     }
 
+    /// \brief 设置服务端对本次下载的限速(x-cos-traffic-limit), 单位:bit/s,
+    ///        取值范围819200-838860800, 即100KB/s-100MB/s
+    void SetTrafficLimit(uint64_t limit_in_bits_per_s) {
+        AddHeader(kReqHeaderXCosTrafficLimit, StringUtil::Uint64ToString(limit_in_bits_per_s));
+    }
+
 protected:
     GetObjectReq(const std::string& bucket_name,
                  const std::string& object_name)
@@ -134,9 +141,9 @@ public:
     MultiGetObjectReq(const std::string& bucket_name, const std::string& object_name,
                       const std::string& local_file_path = "")
         : GetObjectReq(bucket_name, object_name) {
-        // 默认使用配置文件配置的分块大小和线程池大小
-        m_slice_size = CosSysConfig::GetDownSliceSize();
-        m_thread_pool_size = CosSysConfig::GetDownThreadPoolMaxSize();
+        // 0表示使用CosAPI配置的分块大小和线程池大小
+        m_slice_size = 0;
+        m_thread_pool_size = 0;
 
         if (local_file_path.empty()) {
             m_local_file_path = "./" + object_name;
@@ -159,7 +166,7 @@ public:
          m_slice_size = bytes;
     }
 
-    /// \brief 获取分片大小
+    /// \brief 获取分片大小, 未设置时返回0
     uint64_t GetSliceSize() const { return m_slice_size; }
 
     /// \brief 设置线程池大小
@@ -177,6 +184,73 @@ private:
     int m_thread_pool_size;
 };
 
+/// \brief 把prefix下的所有Object下载到本地目录, 本地路径为local_dir加上Object名去掉prefix后的部分.
+///        小于分片阈值的Object整体下载, 其余分片并发下载. 每个Object先写入临时文件,
+///        下载成功后再重命名为目标文件. 每个Object的请求使用本请求的超时、截止时间、
+///        取消句柄、优先级和https设置; 本请求的客户端限速不生效, 下载受CosAPI和全局限速的限制.
+///        Object名中含有空段、"."或".."时无法映射到本地路径, 记为InvalidLocalPath失败
+class DownloadPrefixReq : public BaseReq {
+public:
+    DownloadPrefixReq(const std::string& bucket_name, const std::string& prefix,
+                      const std::string& local_dir)
+        : m_bucket_name(bucket_name), m_prefix(prefix), m_local_dir(local_dir),
+          m_thread_num(kDefaultDownloadPrefixThreadNum),
+          m_multi_get_threshold(kDefaultDownloadPrefixMultiGetThreshold),
+          m_slice_size(0), m_slice_thread_num(0),
+          m_memory_budget(kDefaultDownloadPrefixMemoryBudget), m_is_skip_existing(false),
+          m_list_prefetch_depth(kDefaultDownloadPrefixListPrefetchDepth) {
+        SetMethod("GET");
+    }
+
+    virtual ~DownloadPrefixReq() {}
+
+    std::string GetBucketName() const { return m_bucket_name; }
+    std::string GetPrefix() const { return m_prefix; }
+    std::string GetLocalDir() const { return m_local_dir; }
+
+    /// \brief 同时使用的连接数上限. 整体下载的Object占一个连接, 分片下载的Object占
+    ///        SliceThreadNum个连接, 两者共享该上限
+    void SetThreadNum(unsigned thread_num) { m_thread_num = thread_num; }
+    unsigned GetThreadNum() const { return m_thread_num; }
+
+    /// \brief 不小于该大小的Object使用分片并发下载
+    void SetMultiGetThreshold(uint64_t bytes) { m_multi_get_threshold = bytes; }
+    uint64_t GetMultiGetThreshold() const { return m_multi_get_threshold; }
+
+    /// \brief 分片下载的分片大小和每个Object的分片并发数, 0表示使用CosAPI的配置.
+    ///        分片并发数超过ThreadNum时按ThreadNum计
+    void SetSliceSize(uint64_t bytes) { m_slice_size = bytes; }
+    uint64_t GetSliceSize() const { return m_slice_size; }
+    void SetSliceThreadNum(unsigned thread_num) { m_slice_thread_num = thread_num; }
+    unsigned GetSliceThreadNum() const { return m_slice_thread_num; }
+
+    /// \brief 所有在途Object预估占用的内存上限. 整体下载按Object大小、分片下载按分片大小乘以
+    ///        分片并发数估算; 单个Object超过上限时等其他Object结束后单独下载
+    void SetMemoryBudget(uint64_t bytes) { m_memory_budget = bytes; }
+    uint64_t GetMemoryBudget() const { return m_memory_budget; }
+
+    /// \brief 本地文件的大小和MD5与远端Object一致时跳过下载. 分块上传的Object的ETag不是MD5,
+    ///        此时与Object的x-cos-meta-md5比较, 没有该元数据时重新下载
+    void SetSkipExisting(bool is_skip_existing) { m_is_skip_existing = is_skip_existing; }
+    bool IsSkipExisting() const { return m_is_skip_existing; }
+
+    /// \brief 列表迭代器预取的页数
+    void SetListPrefetchDepth(unsigned depth) { m_list_prefetch_depth = depth; }
+    unsigned GetListPrefetchDepth() const { return m_list_prefetch_depth; }
+
+private:
+    std::string m_bucket_name;
+    std::string m_prefix;
+    std::string m_local_dir;
+    unsigned m_thread_num;
+    uint64_t m_multi_get_threshold;
+    uint64_t m_slice_size;
+    unsigned m_slice_thread_num;
+    uint64_t m_memory_budget;
+    bool m_is_skip_existing;
+    unsigned m_list_prefetch_depth;
+};
+
 class ImageProcessRule{
 public:
     ImageProcessRule() {
@@ -302,6 +376,12 @@ public:
         AddHeader("Pic-Operations", image_rule.GetImageRulesJson());
     }
 
+    /// \brief 设置服务端对本次上传的限速(x-cos-traffic-limit), 单位:bit/s,
+    ///        取值范围819200-838860800, 即100KB/s-100MB/s
+    void SetTrafficLimit(uint64_t limit_in_bits_per_s) {
+        AddHeader(kReqHeaderXCosTrafficLimit, StringUtil::Uint64ToString(limit_in_bits_per_s));
+    }
+
     void SetIsCheckMd5(bool is_check_md5) {
         m_is_check_md5 = is_check_md5;
     }
@@ -422,10 +502,14 @@ public:
         m_bucket_name = bucket_name;
     }
 
-    std::vector<ObjectVersionPair> GetObjectVersions() const {
+    const std::vector<ObjectVersionPair>& GetObjectVersions() const {
         return m_objvers;
     }
 
+    bool IsQuiet() const {
+        return m_is_quiet;
+    }
+
     uint32_t GetObjectVerionsSize() const {
         return m_objvers.size();
     }
@@ -444,12 +528,61 @@ public:
         m_objvers.push_back(pair);
     }
 
+    void ClearObjectVersions() {
+        m_objvers.clear();
+    }
+
+    /// \brief 复制除待删除Object外的请求头、参数、超时、取消句柄等设置, 用于按批次拆分请求,
+    ///        开销与待删除的Object数无关
+    DeleteObjectsReq CloneWithoutObjects() const {
+        DeleteObjectsReq req(m_bucket_name);
+        static_cast<BaseReq&>(req) = *this;
+        req.m_is_quiet = m_is_quiet;
+        return req;
+    }
+
 private:
     bool m_is_quiet;
     std::string m_bucket_name;
     std::vector<ObjectVersionPair> m_objvers;
 };
 
+/// \brief 批量删除请求. 待删除的Object按批次拆分为多个DeleteObjects请求并发执行,
+///        每个批次的请求头、超时、取消句柄等与本请求相同. 默认使用Quiet模式, 只返回删除失败的Object
+class BulkDeleteReq : public DeleteObjectsReq {
+public:
+    explicit BulkDeleteReq(const std::string& bucket_name)
+        : DeleteObjectsReq(bucket_name), m_thread_num(kDefaultBulkDeleteThreadNum),
+          m_batch_size(kMaxDeleteObjectsBatchSize),
+          m_list_prefetch_depth(kDefaultBulkDeleteListPrefetchDepth) {
+        SetQuiet();
+    }
+
+    virtual ~BulkDeleteReq() {}
+
+    /// \brief 同时进行的DeleteObjects请求数上限
+    void SetThreadNum(unsigned thread_num) { m_thread_num = thread_num; }
+    unsigned GetThreadNum() const { return m_thread_num; }
+
+    /// \brief 每个DeleteObjects请求删除的Object数, 取值范围[1, 1000]
+    void SetBatchSize(unsigned batch_size) { m_batch_size = batch_size; }
+    unsigned GetBatchSize() const {
+        if (m_batch_size == 0) {
+            return 1;
+        }
+        return m_batch_size < kMaxDeleteObjectsBatchSize ? m_batch_size : kMaxDeleteObjectsBatchSize;
+    }
+
+    /// \brief 按前缀删除时列表迭代器预取的页数
+    void SetListPrefetchDepth(unsigned depth) { m_list_prefetch_depth = depth; }
+    unsigned GetListPrefetchDepth() const { return m_list_prefetch_depth; }
+
+private:
+    unsigned m_thread_num;
+    unsigned m_batch_size;
+    unsigned m_list_prefetch_depth;
+};
+
 class HeadObjectReq : public ObjectReq {
 public:
     HeadObjectReq(const std::string& bucket_name,
@@ -461,6 +594,45 @@ public:
     virtual ~HeadObjectReq() {}
 };
 
+/// \brief 并发检查一批Object是否存在并获取元信息. 每个Object的HeadObject请求
+///        使用本请求的超时、截止时间和取消句柄
+class BatchHeadObjectReq : public BaseReq {
+public:
+    explicit BatchHeadObjectReq(const std::string& bucket_name)
+        : m_bucket_name(bucket_name), m_thread_num(kDefaultBatchHeadThreadNum),
+          m_negative_cache_ttl_in_ms(0) {
+        SetMethod("HEAD");
+    }
+
+    BatchHeadObjectReq(const std::string& bucket_name, const std::vector<std::string>& objects)
+        : m_bucket_name(bucket_name), m_objects(objects), m_thread_num(kDefaultBatchHeadThreadNum),
+          m_negative_cache_ttl_in_ms(0) {
+        SetMethod("HEAD");
+    }
+
+    virtual ~BatchHeadObjectReq() {}
+
+    std::string GetBucketName() const { return m_bucket_name; }
+
+    void AddObject(const std::string& object) { m_objects.push_back(object); }
+    const std::vector<std::string>& GetObjects() const { return m_objects; }
+
+    /// \brief 同时进行的HeadObject请求数
+    void SetThreadNum(unsigned thread_num) { m_thread_num = thread_num; }
+    unsigned GetThreadNum() const { return m_thread_num; }
+
+    /// \brief 返回404的Object在ttl_in_ms内再次检查时直接返回不存在, 0表示不缓存.
+    ///        通过同一个CosAPI写入该Object时缓存失效
+    void SetNegativeCacheTtlInms(uint64_t ttl_in_ms) { m_negative_cache_ttl_in_ms = ttl_in_ms; }
+    uint64_t GetNegativeCacheTtlInms() const { return m_negative_cache_ttl_in_ms; }
+
+private:
+    std::string m_bucket_name;
+    std::vector<std::string> m_objects;
+    unsigned m_thread_num;
+    uint64_t m_negative_cache_ttl_in_ms;
+};
+
 class InitMultiUploadReq : public ObjectReq {
 public:
     InitMultiUploadReq(const std::string& bucket_name,
@@ -562,6 +734,12 @@ public:
 
     std::istream& GetStream() const { return m_in_stream; }
 
+    /// \brief 设置服务端对本次分块上传的限速(x-cos-traffic-limit), 单位:bit/s,
+    ///        取值范围819200-838860800, 即100KB/s-100MB/s
+    void SetTrafficLimit(uint64_t limit_in_bits_per_s) {
+        AddHeader(kReqHeaderXCosTrafficLimit, StringUtil::Uint64ToString(limit_in_bits_per_s));
+    }
+
 private:
     std::istream& m_in_stream;
     std::string m_upload_id;
@@ -688,9 +866,9 @@ public:
     MultiUploadObjectReq(const std::string& bucket_name,
                    const std::string& object_name, const std::string& local_file_path = "")
         : ObjectReq(bucket_name, object_name) {
-        // 默认使用配置文件配置的分块大小和线程池大小
-        m_part_size = CosSysConfig::GetUploadPartSize();
-        m_thread_pool_size = CosSysConfig::GetUploadThreadPoolSize();
+        // 0表示使用CosAPI配置的分块大小和线程池大小
+        m_part_size = 0;
+        m_thread_pool_size = 0;
 
         // 默认打开当前路径下object的同名文件
         if (local_file_path.empty()) {
@@ -718,7 +896,7 @@ public:
         }
     }
 
-    // 获取分块大小
+    // 获取分块大小, 未设置时返回0
     uint64_t GetPartSize() const { return m_part_size; }
 
     void SetThreadPoolSize(int size) {
@@ -738,12 +916,91 @@ public:
         AddHeader("Pic-Operations", image_rule.GetImageRulesJson());
     }
 
+    /// 允许用户自定义的头部信息, 在初始化分块上传时设置, 将作为 Object 元数据返回.大小限制2K
+    void SetXCosMeta(const std::string& key, const std::string& value) {
+        AddHeader(kXCosMetaPrefix + key, value);
+    }
+
+    /// \brief 设置服务端对每个分块的限速(x-cos-traffic-limit), 单位:bit/s,
+    ///        取值范围819200-838860800, 即100KB/s-100MB/s
+    void SetTrafficLimit(uint64_t limit_in_bits_per_s) {
+        AddHeader(kReqHeaderXCosTrafficLimit, StringUtil::Uint64ToString(limit_in_bits_per_s));
+    }
+
 private:
     std::string m_local_file_path;
     uint64_t m_part_size;
     int m_thread_pool_size;
 };
 
+/// \brief 把本地目录下的所有文件上传到prefix下, Object名为prefix加上文件相对local_dir的路径.
+///        小于分块阈值的文件使用简单上传, 其余使用分块上传. 每个文件的请求使用本请求的
+///        超时、截止时间、取消句柄、优先级和https设置; 本请求的客户端限速不生效,
+///        上传受CosAPI和全局限速的限制
+class UploadDirectoryReq : public BaseReq {
+public:
+    UploadDirectoryReq(const std::string& bucket_name, const std::string& local_dir,
+                       const std::string& prefix = "")
+        : m_bucket_name(bucket_name), m_local_dir(local_dir), m_prefix(prefix),
+          m_thread_num(kDefaultUploadDirectoryThreadNum),
+          m_walk_thread_num(kDefaultUploadDirectoryWalkThreadNum),
+          m_multipart_threshold(kDefaultUploadDirectoryMultipartThreshold),
+          m_part_size(0), m_part_thread_num(0),
+          m_memory_budget(kDefaultUploadDirectoryMemoryBudget), m_is_skip_existing(false) {
+        SetMethod("PUT");
+    }
+
+    virtual ~UploadDirectoryReq() {}
+
+    std::string GetBucketName() const { return m_bucket_name; }
+    std::string GetLocalDir() const { return m_local_dir; }
+
+    /// \brief Object名前缀, 原样拼接在相对路径之前, 需要目录层级时以'/'结尾
+    std::string GetPrefix() const { return m_prefix; }
+
+    /// \brief 同时使用的连接数上限. 简单上传的文件占一个连接, 分块上传的文件占
+    ///        PartThreadNum个连接, 两者共享该上限
+    void SetThreadNum(unsigned thread_num) { m_thread_num = thread_num; }
+    unsigned GetThreadNum() const { return m_thread_num; }
+
+    /// \brief 同时扫描的子目录数上限
+    void SetWalkThreadNum(unsigned thread_num) { m_walk_thread_num = thread_num; }
+    unsigned GetWalkThreadNum() const { return m_walk_thread_num; }
+
+    /// \brief 不小于该大小的文件使用分块上传
+    void SetMultipartThreshold(uint64_t bytes) { m_multipart_threshold = bytes; }
+    uint64_t GetMultipartThreshold() const { return m_multipart_threshold; }
+
+    /// \brief 分块上传的分块大小和每个文件的分块并发数, 0表示使用CosAPI的配置.
+    ///        分块并发数超过ThreadNum时按ThreadNum计
+    void SetPartSize(uint64_t bytes) { m_part_size = bytes; }
+    uint64_t GetPartSize() const { return m_part_size; }
+    void SetPartThreadNum(unsigned thread_num) { m_part_thread_num = thread_num; }
+    unsigned GetPartThreadNum() const { return m_part_thread_num; }
+
+    /// \brief 所有在途文件预估占用的内存上限. 简单上传按文件大小、分块上传按分块大小乘以
+    ///        分块并发数估算; 单个文件超过上限时等其他文件结束后单独上传
+    void SetMemoryBudget(uint64_t bytes) { m_memory_budget = bytes; }
+    uint64_t GetMemoryBudget() const { return m_memory_budget; }
+
+    /// \brief 远端Object的大小和MD5与本地文件一致时跳过上传. 分块上传的Object的ETag不是MD5,
+    ///        开启后分块上传时把文件MD5写入x-cos-meta-md5, 用于之后的比较
+    void SetSkipExisting(bool is_skip_existing) { m_is_skip_existing = is_skip_existing; }
+    bool IsSkipExisting() const { return m_is_skip_existing; }
+
+private:
+    std::string m_bucket_name;
+    std::string m_local_dir;
+    std::string m_prefix;
+    unsigned m_thread_num;
+    unsigned m_walk_thread_num;
+    uint64_t m_multipart_threshold;
+    uint64_t m_part_size;
+    unsigned m_part_thread_num;
+    uint64_t m_memory_budget;
+    bool m_is_skip_existing;
+};
+
 class AbortMultiUploadReq : public ObjectReq {
 public:
     AbortMultiUploadReq(const std::string& bucket_name,
@@ -967,9 +1224,9 @@ public:
     CopyReq(const std::string& bucket_name,
             const std::string& object_name)
         : ObjectReq(bucket_name, object_name) {
-        // 默认使用配置文件配置的分块大小和线程池大小
-        m_part_size = CosSysConfig::GetUploadCopyPartSize();
-        m_thread_pool_size = CosSysConfig::GetUploadThreadPoolSize();
+        // 0表示使用CosAPI配置的分块大小和线程池大小
+        m_part_size = 0;
+        m_thread_pool_size = 0;
     }
 
     virtual ~CopyReq() {}
@@ -1063,7 +1320,7 @@ public:
         }
     }
 
-    // 获取分块大小
+    // 获取分块大小, 未设置时返回0
     uint64_t GetPartSize() const { return m_part_size; }
 
     void SetThreadPoolSize(int size) {
@@ -44,6 +44,11 @@ public:
 
     // ==========================头部相关==============================
     virtual void ParseFromHeaders(const std::map<std::string, std::string>& headers);
+    /// \brief 把headers交换到响应中再解析, 调用方之后不再使用headers时可省去一次map复制
+    void SwapAndParseHeaders(std::map<std::string, std::string>* headers) {
+        m_headers.swap(*headers);
+        ParseFromHeaders(m_headers);
+    }
     uint64_t GetContentLength() const { return m_content_length; }
     std::string GetContentType() const { return m_content_type; }
     std::string GetEtag() const { return m_etag; }
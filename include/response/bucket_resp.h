@@ -14,6 +14,8 @@
 #include "cos_config.h"
 #include "cos_defines.h"
 #include "response/base_resp.h"
+#include "response/compact_object_list.h"
+#include "util/xml_sax_parser.h"
 
 namespace qcloud_cos {
 
@@ -23,15 +25,21 @@ public:
     virtual ~PutBucketResp() {}
 };
 
-class GetBucketResp : public BaseResp {
+/// \brief 列出Object的结果. BucketOp边接收响应体边通过SAX回调解析, 不保留原始响应体
+class GetBucketResp : public BaseResp, public XmlSaxHandler {
 public:
-    GetBucketResp() {}
+    GetBucketResp();
     virtual ~GetBucketResp() {}
 
     virtual bool ParseFromXmlString(const std::string& body);
 
+    virtual void OnStartElement(const std::string& name);
+    virtual void OnEndElement(const std::string& name, const std::string& text);
+    virtual void OnReset();
+    virtual bool OnEndDocument();
+
     /// \brief 获取Bucket中Object对应的元信息
-    std::vector<Content> GetContents() const { return m_contents; }
+    const std::vector<Content>& GetContents() const { return m_contents; }
 
     /// \brief Bucket名称
     std::string GetName() const { return m_name; }
@@ -58,9 +66,15 @@ public:
     std::string GetNextMarker() const { return m_next_marker; }
 
     /// \brief 将 Prefix 到 delimiter 之间的相同路径归为一类，定义为 Common Prefix
-    std::vector<std::string> GetCommonPrefixes() const { return m_common_prefixes; }
+    const std::vector<std::string>& GetCommonPrefixes() const { return m_common_prefixes; }
 
 private:
+    // SAX解析状态, 根节点深度为1
+    int m_xml_depth;
+    bool m_has_root;
+    bool m_in_contents;
+    bool m_in_common_prefixes;
+
     std::vector<Content> m_contents;
     std::string m_name;
     std::string m_encoding_type;
@@ -73,6 +87,87 @@ private:
     std::vector<std::string> m_common_prefixes;
 };
 
+/// \brief 以紧凑的列存储保存Object记录的列出结果, 适合在内存中累积海量记录.
+///        可以通过SetObjectList指定外部的列表, 多次列出的记录会追加到同一个列表中
+class CompactGetBucketResp : public BaseResp, public XmlSaxHandler {
+public:
+    CompactGetBucketResp();
+    virtual ~CompactGetBucketResp() {}
+
+    virtual bool ParseFromXmlString(const std::string& body);
+
+    virtual void OnStartElement(const std::string& name);
+    virtual void OnEndElement(const std::string& name, const std::string& text);
+    virtual void OnReset();
+    virtual bool OnEndDocument();
+
+    /// \brief 记录追加到list中, 由调用方保证list的生命周期. 为NULL时使用内部的列表
+    void SetObjectList(CompactObjectList* list);
+
+    /// \brief 本次及之前追加的所有记录
+    const CompactObjectList& GetObjectList() const { return *m_list; }
+
+    /// \brief 本次列出的第一条记录在列表中的位置
+    size_t GetFirstIndex() const { return m_first_idx; }
+
+    /// \brief 本次列出的记录数
+    size_t GetObjectCount() const { return m_list->Size() - m_first_idx; }
+
+    std::string GetName() const { return m_name; }
+    std::string GetPrefix() const { return m_prefix; }
+    std::string GetMarker() const { return m_marker; }
+    uint64_t GetMaxKeys() const { return m_max_keys; }
+    bool IsTruncated() const { return m_is_truncated; }
+    std::string GetNextMarker() const { return m_next_marker; }
+    const std::vector<std::string>& GetCommonPrefixes() const { return m_common_prefixes; }
+
+private:
+    int m_xml_depth;
+    bool m_has_root;
+    bool m_in_contents;
+    bool m_in_common_prefixes;
+
+    // 当前Contents节点的字段, 在节点结束时追加到列表, 复用内存
+    std::string m_cur_key;
+    std::string m_cur_etag;
+    std::string m_cur_storage_class;
+    std::string m_cur_owner_id;
+    uint64_t m_cur_size;
+    uint64_t m_cur_mtime;
+
+    CompactObjectList m_own_list;
+    CompactObjectList* m_list;
+    // 重试时截断到本次列出之前的大小
+    size_t m_first_idx;
+
+    std::string m_name;
+    std::string m_prefix;
+    std::string m_marker;
+    uint64_t m_max_keys;
+    bool m_is_truncated;
+    std::string m_next_marker;
+    std::vector<std::string> m_common_prefixes;
+};
+
+/// \brief 并发列出Object的统计信息, 记录本身通过ListObjectsHandler回调输出
+class ParallelListObjectsResp : public BaseResp {
+public:
+    ParallelListObjectsResp() : m_shard_count(0), m_entry_count(0) {}
+    virtual ~ParallelListObjectsResp() {}
+
+    /// \brief 实际切分的分片数
+    uint64_t GetShardCount() const { return m_shard_count; }
+    void SetShardCount(uint64_t shard_count) { m_shard_count = shard_count; }
+
+    /// \brief 回调的记录数
+    uint64_t GetEntryCount() const { return m_entry_count; }
+    void SetEntryCount(uint64_t entry_count) { m_entry_count = entry_count; }
+
+private:
+    uint64_t m_shard_count;
+    uint64_t m_entry_count;
+};
+
 class DeleteBucketResp : public BaseResp {
 public:
     DeleteBucketResp() {}
@@ -214,9 +309,10 @@ private:
     std::string m_location;
 };
 
-class GetBucketObjectVersionsResp : public BaseResp {
+/// \brief 列出Object版本的结果, 与GetBucketResp一样边接收边解析
+class GetBucketObjectVersionsResp : public BaseResp, public XmlSaxHandler {
 public:
-    GetBucketObjectVersionsResp() {}
+    GetBucketObjectVersionsResp();
     virtual ~GetBucketObjectVersionsResp() {}
 
     /// \brief 编码格式
@@ -240,11 +336,21 @@ public:
 
     std::string GetVersionIdMarker() const { return m_version_id_marker; }
 
-    std::vector<COSVersionSummary> GetVersionSummary() const { return m_summaries; }
+    const std::vector<COSVersionSummary>& GetVersionSummary() const { return m_summaries; }
 
     virtual bool ParseFromXmlString(const std::string& body);
 
+    virtual void OnStartElement(const std::string& name);
+    virtual void OnEndElement(const std::string& name, const std::string& text);
+    virtual void OnReset();
+    virtual bool OnEndDocument();
+
 private:
+    // SAX解析状态, 根节点深度为1
+    int m_xml_depth;
+    bool m_has_root;
+    bool m_in_summary;
+
     std::vector<COSVersionSummary> m_summaries;
     std::string m_encoding_type;
     bool m_is_truncated;
@@ -0,0 +1,146 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: 按列存储的紧凑Object列表, 用于在内存中保存海量的列表结果
+
+#ifndef COMPACT_OBJECT_LIST_H
+#define COMPACT_OBJECT_LIST_H
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "cos_defines.h"
+
+namespace qcloud_cos {
+
+/// \brief 字符串驻留池, 相同的字符串只保存一份, 通过编号引用. 编号0固定为空串
+class StringInterner {
+public:
+    StringInterner();
+
+    /// \brief 返回字符串的编号, 不存在时加入驻留池
+    uint32_t Intern(const std::string& str);
+
+    const std::string& Get(uint32_t id) const { return m_strings[id]; }
+
+    /// \brief 不同字符串的个数(包括空串)
+    size_t Size() const { return m_strings.size(); }
+
+    void Clear();
+
+private:
+    std::vector<std::string> m_strings;
+    std::map<std::string, uint32_t> m_ids;
+};
+
+class CompactObjectList;
+
+/// \brief 列表中一条记录的只读视图, 所属的列表修改后失效
+class CompactObjectRef {
+public:
+    CompactObjectRef() : m_list(NULL), m_idx(0) {}
+    CompactObjectRef(const CompactObjectList* list, size_t idx) : m_list(list), m_idx(idx) {}
+
+    /// \brief key在列表内部连续存储, 不以'\0'结尾
+    const char* GetKeyData() const;
+    size_t GetKeySize() const;
+    std::string GetKey() const;
+
+    uint64_t GetSize() const;
+    uint64_t GetLastModifiedTime() const;
+    std::string GetETag() const;
+    const std::string& GetStorageClass() const;
+    const std::string& GetOwnerId() const;
+
+    size_t GetIndex() const { return m_idx; }
+
+private:
+    const CompactObjectList* m_list;
+    size_t m_idx;
+};
+
+/// \brief 按列存储的Object列表. key连续存放在一块内存中并以偏移量索引,
+///        大小和修改时间以整数存储, ETag的MD5部分以16字节二进制存储,
+///        分块上传ETag的"-N"后缀、存储类型和Owner在驻留池中只保存一份.
+///        每条记录除key本身外约占48字节, 且追加记录时基本不产生小块的内存分配
+class CompactObjectList {
+public:
+    /// \brief 只读的前向迭代器
+    class ConstIterator {
+    public:
+        ConstIterator() : m_list(NULL), m_idx(0) {}
+        ConstIterator(const CompactObjectList* list, size_t idx)
+            : m_list(list), m_idx(idx), m_ref(list, idx) {}
+
+        const CompactObjectRef& operator*() const { return m_ref; }
+        const CompactObjectRef* operator->() const { return &m_ref; }
+
+        ConstIterator& operator++() {
+            m_ref = CompactObjectRef(m_list, ++m_idx);
+            return *this;
+        }
+
+        bool operator==(const ConstIterator& other) const {
+            return m_list == other.m_list && m_idx == other.m_idx;
+        }
+        bool operator!=(const ConstIterator& other) const { return !(*this == other); }
+
+    private:
+        const CompactObjectList* m_list;
+        size_t m_idx;
+        CompactObjectRef m_ref;
+    };
+
+    CompactObjectList();
+
+    /// \brief 追加一条记录, last_modified_time为Unix时间戳(秒)
+    void Append(const std::string& key, uint64_t size, uint64_t last_modified_time,
+                const std::string& etag, const std::string& storage_class,
+                const std::string& owner_id);
+
+    size_t Size() const { return m_sizes.size(); }
+    bool Empty() const { return m_sizes.empty(); }
+
+    CompactObjectRef At(size_t idx) const { return CompactObjectRef(this, idx); }
+    ConstIterator Begin() const { return ConstIterator(this, 0); }
+    ConstIterator End() const { return ConstIterator(this, Size()); }
+
+    /// \brief 把第idx条记录写入entry, 复用entry中字符串的内存
+    void GetEntry(size_t idx, BucketObjectEntry* entry) const;
+
+    /// \brief 只保留前size条记录, 驻留池不回收
+    void Truncate(size_t size);
+
+    void Clear();
+
+    /// \brief 预留记录数和key的总字节数
+    void Reserve(size_t entry_num, size_t key_bytes);
+
+    /// \brief 各列占用的内存(按容量计算), 单位字节
+    uint64_t GetMemoryUsage() const;
+
+private:
+    friend class CompactObjectRef;
+
+    // ETag不是"32位小写hex[-N]"格式时, m_etag_ids的最高位置1, 编号指向驻留池中的完整ETag
+    static const uint32_t kRawETagFlag = 0x80000000u;
+    static const size_t kMd5Bytes = 16;
+
+    std::string m_key_arena;
+    std::vector<uint64_t> m_key_ends;
+    std::vector<uint64_t> m_sizes;
+    std::vector<uint32_t> m_mtimes;
+    std::string m_etag_md5s;
+    std::vector<uint32_t> m_etag_ids;
+    std::vector<uint32_t> m_storage_class_ids;
+    std::vector<uint32_t> m_owner_ids;
+    StringInterner m_interner;
+};
+
+} // namespace qcloud_cos
+#endif // COMPACT_OBJECT_LIST_H
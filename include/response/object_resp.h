@@ -258,6 +258,131 @@ private:
     std::vector<ErrorInfo> m_error_infos;
 };
 
+/// \brief 批量删除的结果, 汇总所有批次中删除失败的Object
+class BulkDeleteResp : public BaseResp {
+public:
+    BulkDeleteResp() : m_deleted_count(0), m_batch_count(0), m_failed_batch_count(0) {}
+    virtual ~BulkDeleteResp() {}
+
+    /// \brief 删除成功的Object数
+    uint64_t GetDeletedCount() const { return m_deleted_count; }
+    void SetDeletedCount(uint64_t count) { m_deleted_count = count; }
+
+    /// \brief 发出的DeleteObjects请求数
+    uint64_t GetBatchCount() const { return m_batch_count; }
+    void SetBatchCount(uint64_t count) { m_batch_count = count; }
+
+    /// \brief 整批失败(如网络错误)的DeleteObjects请求数, 其中的Object也计入GetErrorInfos
+    uint64_t GetFailedBatchCount() const { return m_failed_batch_count; }
+    void SetFailedBatchCount(uint64_t count) { m_failed_batch_count = count; }
+
+    /// \brief 删除失败的Object及原因
+    const std::vector<ErrorInfo>& GetErrorInfos() const { return m_error_infos; }
+    void AddErrorInfos(const std::vector<ErrorInfo>& infos) {
+        m_error_infos.insert(m_error_infos.end(), infos.begin(), infos.end());
+    }
+
+private:
+    uint64_t m_deleted_count;
+    uint64_t m_batch_count;
+    uint64_t m_failed_batch_count;
+    std::vector<ErrorInfo> m_error_infos;
+};
+
+class UploadDirectoryResp : public BaseResp {
+public:
+    UploadDirectoryResp()
+        : m_file_count(0), m_uploaded_count(0), m_skipped_count(0), m_failed_count(0),
+          m_total_bytes(0), m_uploaded_bytes(0) {}
+    virtual ~UploadDirectoryResp() {}
+
+    /// \brief 扫描到的文件数
+    uint64_t GetFileCount() const { return m_file_count; }
+    void SetFileCount(uint64_t count) { m_file_count = count; }
+
+    /// \brief 上传成功的文件数
+    uint64_t GetUploadedCount() const { return m_uploaded_count; }
+    void SetUploadedCount(uint64_t count) { m_uploaded_count = count; }
+
+    /// \brief 远端已存在相同内容而跳过的文件数
+    uint64_t GetSkippedCount() const { return m_skipped_count; }
+    void SetSkippedCount(uint64_t count) { m_skipped_count = count; }
+
+    /// \brief 上传失败的文件数, 失败原因通过GetErrorInfos获取
+    uint64_t GetFailedCount() const { return m_failed_count; }
+    void SetFailedCount(uint64_t count) { m_failed_count = count; }
+
+    /// \brief 扫描到的文件总大小
+    uint64_t GetTotalBytes() const { return m_total_bytes; }
+    void SetTotalBytes(uint64_t bytes) { m_total_bytes = bytes; }
+
+    /// \brief 上传成功的文件总大小, 不含跳过的文件
+    uint64_t GetUploadedBytes() const { return m_uploaded_bytes; }
+    void SetUploadedBytes(uint64_t bytes) { m_uploaded_bytes = bytes; }
+
+    /// \brief 上传失败的文件及原因, m_key为Object名. 扫描子目录失败时m_key为该目录对应的前缀
+    const std::vector<ErrorInfo>& GetErrorInfos() const { return m_error_infos; }
+    void AddErrorInfos(const std::vector<ErrorInfo>& infos) {
+        m_error_infos.insert(m_error_infos.end(), infos.begin(), infos.end());
+    }
+
+private:
+    uint64_t m_file_count;
+    uint64_t m_uploaded_count;
+    uint64_t m_skipped_count;
+    uint64_t m_failed_count;
+    uint64_t m_total_bytes;
+    uint64_t m_uploaded_bytes;
+    std::vector<ErrorInfo> m_error_infos;
+};
+
+class DownloadPrefixResp : public BaseResp {
+public:
+    DownloadPrefixResp()
+        : m_object_count(0), m_downloaded_count(0), m_skipped_count(0), m_failed_count(0),
+          m_total_bytes(0), m_downloaded_bytes(0) {}
+    virtual ~DownloadPrefixResp() {}
+
+    /// \brief 列出的Object数, 不含以'/'结尾的目录占位Object
+    uint64_t GetObjectCount() const { return m_object_count; }
+    void SetObjectCount(uint64_t count) { m_object_count = count; }
+
+    /// \brief 下载成功的Object数
+    uint64_t GetDownloadedCount() const { return m_downloaded_count; }
+    void SetDownloadedCount(uint64_t count) { m_downloaded_count = count; }
+
+    /// \brief 本地已存在相同内容而跳过的Object数
+    uint64_t GetSkippedCount() const { return m_skipped_count; }
+    void SetSkippedCount(uint64_t count) { m_skipped_count = count; }
+
+    /// \brief 下载失败的Object数, 失败原因通过GetErrorInfos获取
+    uint64_t GetFailedCount() const { return m_failed_count; }
+    void SetFailedCount(uint64_t count) { m_failed_count = count; }
+
+    /// \brief 列出的Object总大小
+    uint64_t GetTotalBytes() const { return m_total_bytes; }
+    void SetTotalBytes(uint64_t bytes) { m_total_bytes = bytes; }
+
+    /// \brief 下载成功的Object总大小, 不含跳过的Object
+    uint64_t GetDownloadedBytes() const { return m_downloaded_bytes; }
+    void SetDownloadedBytes(uint64_t bytes) { m_downloaded_bytes = bytes; }
+
+    /// \brief 下载失败的Object及原因
+    const std::vector<ErrorInfo>& GetErrorInfos() const { return m_error_infos; }
+    void AddErrorInfos(const std::vector<ErrorInfo>& infos) {
+        m_error_infos.insert(m_error_infos.end(), infos.begin(), infos.end());
+    }
+
+private:
+    uint64_t m_object_count;
+    uint64_t m_downloaded_count;
+    uint64_t m_skipped_count;
+    uint64_t m_failed_count;
+    uint64_t m_total_bytes;
+    uint64_t m_downloaded_bytes;
+    std::vector<ErrorInfo> m_error_infos;
+};
+
 class HeadObjectResp : public BaseResp {
 public:
     HeadObjectResp() : m_x_cos_storage_class(kStorageClassStandard) {}
@@ -404,6 +529,24 @@ private:
     ImagResp    m_image_resp;
 };
 
+/// \brief 批量HeadObject的结果, 与请求中的Object一一对应
+class BatchHeadObjectResp : public BaseResp {
+public:
+    BatchHeadObjectResp() : m_cache_hit_count(0) {}
+    virtual ~BatchHeadObjectResp() {}
+
+    const std::vector<HeadObjectResult>& GetResults() const { return m_results; }
+    std::vector<HeadObjectResult>* GetResultsPtr() { return &m_results; }
+
+    /// \brief 命中不存在缓存的Object数
+    uint64_t GetCacheHitCount() const { return m_cache_hit_count; }
+    void SetCacheHitCount(uint64_t count) { m_cache_hit_count = count; }
+
+private:
+    std::vector<HeadObjectResult> m_results;
+    uint64_t m_cache_hit_count;
+};
+
 class MultiUploadObjectResp : public BaseResp {
 public:
     MultiUploadObjectResp() {}
@@ -8,6 +8,7 @@
 #include <vector>
 
 #include "request/base_req.h"
+#include "util/header_list.h"
 #include "util/noncopyable.h"
 
 namespace qcloud_cos {
@@ -50,7 +51,27 @@ public:
                             uint64_t start_time_in_s,
                             uint64_t end_time_in_s);
 
+    /// \brief ͬ, headersΪʱʹõHeaderList, ǩʱٸһmap
+    static std::string Sign(const std::string& secret_id,
+                            const std::string& secret_key,
+                            const std::string& http_method,
+                            const std::string& in_uri,
+                            const HeaderList& headers,
+                            const std::map<std::string, std::string>& params,
+                            uint64_t start_time_in_s,
+                            uint64_t end_time_in_s);
+
 private:
+    /// \brief ǩ, filted_req_headersΪɸѡҪȨͷ, ʱԭתСд
+    static std::string SignFiltered(const std::string& secret_id,
+                                    const std::string& secret_key,
+                                    const std::string& http_method,
+                                    const std::string& in_uri,
+                                    HeaderList* filted_req_headers,
+                                    const std::map<std::string, std::string>& params,
+                                    uint64_t start_time_in_s,
+                                    uint64_t end_time_in_s);
+
     /// \brief paramsеݣתСд,keyparam_list key=valueparam_value_list
     /// \param params 
     /// \param key_encode keyǷuri
@@ -66,12 +87,25 @@ private:
                         std::string* param_list,
                         std::string* param_value_list);
 
+    /// \brief ͬFillMap, ֱparamsתСд, ٸһmap
+    static void FillList(HeaderList* params,
+                         bool key_encode,
+                         bool value_encode,
+                         bool value_lower,
+                         std::string* param_list,
+                         std::string* param_value_list);
+
     /// \brief ҳҪȨͷ,Ŀǰhost conent-type xͷĶҪȨ
     /// \param hedaers ͷkv
     /// \param filted_req_headers ҪȨͷ
     /// \retval 
     static void FilterAndSetSignHeader(const std::map<std::string,std::string>& headers,
-                                       std::map<std::string, std::string>* filted_req_headers);
+                                       HeaderList* filted_req_headers);
+    static void FilterAndSetSignHeader(const HeaderList& headers,
+                                       HeaderList* filted_req_headers);
+
+    /// \brief ͷǷҪȨ
+    static bool IsSignHeader(const std::string& name);
 };
 
 } // namespace qcloud_cos
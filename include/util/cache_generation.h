@@ -0,0 +1,51 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: 按Object统计写入次数, 避免与写入并发的读取把旧数据放回缓存
+
+#ifndef CACHE_GENERATION_H
+#define CACHE_GENERATION_H
+#pragma once
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "util/noncopyable.h"
+#include "util/simple_mutex.h"
+
+namespace qcloud_cos {
+
+/// 写入计数的槽数, Object名散列到其中一个槽上
+const size_t kCacheGenerationSlots = 1024;
+
+/// \brief 线程安全的写入计数. 写入开始和结束时各调用一次Bump;
+///        读取方在发出请求前调用Get, 把结果放入缓存后再次比较, 不同说明请求期间有写入,
+///        读到的可能是旧数据, 需要删除刚放入的记录.
+///        不同Object可能共用一个槽, 只会导致多余的缓存删除
+class CacheGeneration : private NonCopyable {
+public:
+    CacheGeneration() : m_generations(kCacheGenerationSlots, 0) {}
+    ~CacheGeneration() {}
+
+    uint64_t Get(const std::string& bucket_name, const std::string& object_name) const;
+
+    void Bump(const std::string& bucket_name, const std::string& object_name);
+
+    /// \brief Get返回generation之后是否有过写入
+    bool IsChanged(const std::string& bucket_name, const std::string& object_name,
+                   uint64_t generation) const {
+        return Get(bucket_name, object_name) != generation;
+    }
+
+private:
+    static size_t GetSlot(const std::string& bucket_name, const std::string& object_name);
+
+private:
+    mutable SimpleMutex m_mutex;
+    std::vector<uint64_t> m_generations;
+};
+
+} // namespace qcloud_cos
+#endif // CACHE_GENERATION_H
@@ -0,0 +1,101 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: 请求的取消句柄, 取消时关闭正在使用的连接, 使阻塞的收发立即返回
+
+#ifndef CANCEL_TOKEN_H
+#define CANCEL_TOKEN_H
+#pragma once
+
+#include <stdint.h>
+
+#include <set>
+#include <string>
+
+#include "boost/shared_ptr.hpp"
+
+#include "util/noncopyable.h"
+#include "util/simple_mutex.h"
+
+namespace Poco {
+namespace Net {
+class HTTPClientSession;
+}
+}
+
+namespace qcloud_cos {
+
+/// 请求被取消时HttpSender返回的错误信息
+const std::string kRequestCancelledErrMsg = "CancelledException:request is cancelled";
+/// 请求超过截止时间时HttpSender返回的错误信息
+const std::string kRequestDeadlineExceededErrMsg = "CancelledException:request deadline exceeded";
+
+class CancelToken;
+typedef boost::shared_ptr<CancelToken> SharedCancelToken;
+
+/// \brief 取消句柄. HttpSender在发送请求时把连接注册到句柄上,
+///        Cancel()会shutdown所有已注册的连接, 唤醒阻塞在connect/recv/send上的线程.
+///        句柄可以设置截止时间, 超过截止时间后视为已取消; 可以设置父句柄,
+///        父句柄取消时子句柄随之取消, 用于把一次调用的取消传递到各个分块任务.
+class CancelToken : private NonCopyable {
+public:
+    CancelToken();
+    virtual ~CancelToken();
+
+    /// \brief 取消请求, 可从任意线程调用, 重复调用无副作用
+    void Cancel();
+
+    /// \brief 自身或父句柄被取消, 或已超过截止时间时返回true
+    bool IsCancelled() const;
+
+    /// \brief 是否已超过截止时间
+    bool IsDeadlineExceeded() const;
+
+    /// \brief 恢复为未取消状态以便复用, 调用方需保证此时没有请求在使用该句柄.
+    ///        父句柄的取消状态和截止时间不受影响
+    void Reset();
+
+    /// \brief 设置截止时间(毫秒时间戳), 0表示不限制
+    void SetDeadlineInms(uint64_t deadline_in_ms);
+
+    /// \brief 获取生效的截止时间, 即自身和父句柄中较早的一个, 0表示不限制
+    uint64_t GetDeadlineInms() const;
+
+    /// \brief 按截止时间的剩余时间收紧超时, 未设置截止时间时原样返回, 最小返回1ms
+    uint64_t ClampTimeoutInms(uint64_t timeout_in_ms) const;
+
+    /// \brief 休眠指定时间, 被取消时提前返回. 返回false表示已取消
+    bool SleepInms(uint64_t sleep_in_ms) const;
+
+    /// \brief 设置父句柄, parent为空时解除关联. 子句柄持有父句柄的引用
+    void SetParent(const SharedCancelToken& parent);
+
+    /// \brief 取消原因对应的错误信息
+    std::string GetErrMsg() const;
+
+    /// \brief HttpSender收到响应头之后、读取响应体之前回调,
+    ///        返回false表示放弃本次响应, HttpSender按取消处理
+    virtual bool OnResponseHeader();
+
+    /// \brief 注册连接, 句柄已取消时返回false
+    bool AttachSession(Poco::Net::HTTPClientSession* session);
+
+    /// \brief 注销连接, 必须在连接析构之前调用
+    void DetachSession(Poco::Net::HTTPClientSession* session);
+
+private:
+    // 加锁顺序总是先父后子: 父句柄持锁取消子句柄, 子句柄不持锁访问父句柄
+    void AddChild(CancelToken* child);
+    void RemoveChild(CancelToken* child);
+
+private:
+    mutable SimpleMutex m_mutex;
+    bool m_is_cancelled;
+    uint64_t m_deadline_in_ms;
+    SharedCancelToken m_parent;
+    std::set<Poco::Net::HTTPClientSession*> m_sessions;
+    std::set<CancelToken*> m_children;
+};
+
+} // namespace qcloud_cos
+#endif // CANCEL_TOKEN_H
@@ -0,0 +1,106 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: CosAPI实例级别的配置, 未设置的项使用CosSysConfig的全局配置
+
+#ifndef CLIENT_SETTINGS_H
+#define CLIENT_SETTINGS_H
+#pragma once
+
+#include <stdint.h>
+
+#include <string>
+
+namespace qcloud_cos {
+
+/// 默认请求体不小于该大小的上传请求使用Expect: 100-continue
+const uint64_t kDefaultExpectContinueThreshold = 16 * 1024 * 1024;
+
+/// \brief CosAPI实例级别的配置. 同一进程内的多个CosAPI可以使用不同的超时、分块大小等配置,
+///        未设置(或设置为0)的项在读取时使用CosSysConfig的全局配置.
+///        CosAPI创建时复制一份, 之后只读, 多线程读取无需加锁
+class ClientSettings {
+public:
+    ClientSettings()
+        : m_conn_timeout_in_ms(0), m_recv_timeout_in_ms(0), m_auth_expired_time_in_s(0),
+          m_upload_part_size(0), m_upload_copy_part_size(0), m_upload_thread_pool_size(0),
+          m_down_slice_size(0), m_down_thread_pool_max_size(0), m_check_md5(-1),
+          m_is_dest_domain_set(false),
+          m_expect_continue_threshold(kDefaultExpectContinueThreshold),
+          m_upload_rate_limit(0), m_download_rate_limit(0) {}
+
+    /// \brief 连接超时时间, 单位:毫秒
+    void SetConnTimeoutInms(uint64_t time) { m_conn_timeout_in_ms = time; }
+    uint64_t GetConnTimeoutInms() const;
+
+    /// \brief 接收超时时间, 单位:毫秒
+    void SetRecvTimeoutInms(uint64_t time) { m_recv_timeout_in_ms = time; }
+    uint64_t GetRecvTimeoutInms() const;
+
+    /// \brief 签名超时时间, 单位:秒
+    void SetAuthExpiredTime(uint64_t time) { m_auth_expired_time_in_s = time; }
+    uint64_t GetAuthExpiredTime() const;
+
+    /// \brief 分块上传的分块大小, 单位:字节
+    void SetUploadPartSize(uint64_t part_size) { m_upload_part_size = part_size; }
+    uint64_t GetUploadPartSize() const;
+
+    /// \brief 分块复制的分块大小, 单位:字节
+    void SetUploadCopyPartSize(uint64_t part_size) { m_upload_copy_part_size = part_size; }
+    uint64_t GetUploadCopyPartSize() const;
+
+    /// \brief 单文件分块上传/复制的线程池大小
+    void SetUploadThreadPoolSize(unsigned size) { m_upload_thread_pool_size = size; }
+    unsigned GetUploadThreadPoolSize() const;
+
+    /// \brief 多线程下载的分片大小, 单位:字节
+    void SetDownSliceSize(uint64_t slice_size) { m_down_slice_size = slice_size; }
+    uint64_t GetDownSliceSize() const;
+
+    /// \brief 多线程下载的线程池大小
+    void SetDownThreadPoolMaxSize(unsigned size) { m_down_thread_pool_max_size = size; }
+    unsigned GetDownThreadPoolMaxSize() const;
+
+    /// \brief 下载过程中是否检查MD5
+    void SetCheckMd5(bool is_check_md5) { m_check_md5 = is_check_md5 ? 1 : 0; }
+    bool IsCheckMd5() const;
+
+    /// \brief 自定义的请求域名, 设置为空表示使用bucket默认域名(即使全局配置了自定义域名)
+    void SetDestDomain(const std::string& dest_domain) {
+        m_dest_domain = dest_domain;
+        m_is_dest_domain_set = true;
+    }
+    std::string GetDestDomain() const;
+
+    /// \brief 请求体不小于该大小的PutObject/UploadPartData/分块上传请求使用Expect: 100-continue,
+    ///        服务端确认后才发送请求体, 签名或权限错误时不浪费上传带宽. 0表示不使用
+    void SetExpectContinueThreshold(uint64_t bytes) { m_expect_continue_threshold = bytes; }
+    uint64_t GetExpectContinueThreshold() const { return m_expect_continue_threshold; }
+
+    /// \brief CosAPI实例所有上传/下载请求合计的客户端限速, 单位:字节/秒, 0表示不限速.
+    ///        同时受进程级别限速(RateLimiter::GlobalUploadLimiter/GlobalDownloadLimiter)的限制
+    void SetUploadRateLimit(uint64_t rate_in_bytes_per_s) { m_upload_rate_limit = rate_in_bytes_per_s; }
+    uint64_t GetUploadRateLimit() const { return m_upload_rate_limit; }
+    void SetDownloadRateLimit(uint64_t rate_in_bytes_per_s) { m_download_rate_limit = rate_in_bytes_per_s; }
+    uint64_t GetDownloadRateLimit() const { return m_download_rate_limit; }
+
+private:
+    uint64_t m_conn_timeout_in_ms;
+    uint64_t m_recv_timeout_in_ms;
+    uint64_t m_auth_expired_time_in_s;
+    uint64_t m_upload_part_size;
+    uint64_t m_upload_copy_part_size;
+    unsigned m_upload_thread_pool_size;
+    uint64_t m_down_slice_size;
+    unsigned m_down_thread_pool_max_size;
+    // -1表示未设置
+    int m_check_md5;
+    std::string m_dest_domain;
+    bool m_is_dest_domain_set;
+    uint64_t m_expect_continue_threshold;
+    uint64_t m_upload_rate_limit;
+    uint64_t m_download_rate_limit;
+};
+
+} // namespace qcloud_cos
+#endif // CLIENT_SETTINGS_H
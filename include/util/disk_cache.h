@@ -0,0 +1,160 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: GetObject的本地磁盘读穿缓存, LRU索引保存在mmap的定长记录文件中
+
+#ifndef DISK_CACHE_H
+#define DISK_CACHE_H
+#pragma once
+
+#include <stdint.h>
+
+#include <fstream>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "boost/shared_ptr.hpp"
+#include "boost/thread/condition_variable.hpp"
+#include "boost/thread/mutex.hpp"
+
+#include "util/cancel_token.h"
+#include "util/disk_cache_policy.h"
+#include "util/noncopyable.h"
+
+namespace qcloud_cos {
+
+/// \brief 磁盘缓存的统计
+struct DiskCacheStat {
+    DiskCacheStat()
+        : m_hits(0), m_revalidations(0), m_misses(0), m_fill_waits(0), m_evictions(0),
+          m_entries(0), m_bytes(0) {}
+
+    uint64_t m_hits;          // 新鲜期内直接读取本地文件的次数
+    uint64_t m_revalidations; // 重新验证未修改后读取本地文件的次数
+    uint64_t m_misses;        // 下载Object填充缓存的次数
+    uint64_t m_fill_waits;    // 等待其它线程填充同一个Object的次数
+    uint64_t m_evictions;     // 超过容量被淘汰的Object数
+    uint64_t m_entries;       // 当前缓存的Object数
+    uint64_t m_bytes;         // 当前缓存的总字节数
+};
+
+/// \brief 查找缓存的结果
+struct DiskCacheEntry {
+    DiskCacheEntry() : m_size(0), m_is_fresh(false) {}
+
+    std::string m_path; // 缓存文件路径, 只有前m_size字节是Object的内容
+    // 持有缓存锁时打开的缓存文件, 之后该记录被淘汰或替换也不影响读取
+    boost::shared_ptr<std::ifstream> m_file;
+    std::string m_etag;
+    uint64_t m_size;
+    bool m_is_fresh;    // 是否在新鲜期内
+    std::map<std::string, std::string> m_headers; // 填充时的响应头
+};
+
+/// \brief 线程安全的磁盘缓存. 缓存文件以bucket/object的64位哈希命名, 文件末尾记录响应头和完整的bucket/object,
+///        查找和加载时校验, 哈希冲突时不会返回其它Object的内容. 索引文件是定长记录数组,
+///        通过mmap读写, 进程重启后保留. 同一个Object同时只有一个线程在下载填充, 其它线程等待结果
+class DiskCache : private NonCopyable {
+public:
+    /// \brief 获取缓存目录对应的缓存, 同一进程内使用相同目录的CosAPI共享一个实例,
+    ///        以第一次打开时的策略为准. 首次打开时创建目录并加载索引, 失败时返回空指针
+    static boost::shared_ptr<DiskCache> Open(const DiskCachePolicy& policy);
+
+    ~DiskCache();
+
+    /// \brief 查找缓存, 命中时打开缓存文件并更新最近访问顺序. 缓存文件被外部删除时删除该记录并返回false
+    bool Lookup(const std::string& bucket_name, const std::string& object_name,
+                DiskCacheEntry* entry);
+
+    /// \brief 开始填充Object. 没有其它线程在填充时返回true, 调用方下载完成后必须调用EndFill;
+    ///        否则等待填充结束后返回false, is_filled输出该次填充是否成功, 成功时可直接读取缓存.
+    ///        deadline_in_ms为0时一直等待, 超过截止时间或cancel_token被取消时提前返回false,
+    ///        is_filled为false, 调用方应直接下载
+    bool BeginFill(const std::string& bucket_name, const std::string& object_name,
+                   uint64_t deadline_in_ms, const SharedCancelToken& cancel_token,
+                   bool* is_filled);
+    void EndFill(const std::string& bucket_name, const std::string& object_name, bool is_filled);
+
+    /// \brief 获取填充用的临时文件路径
+    std::string GetTempPath(const std::string& bucket_name, const std::string& object_name) const;
+
+    /// \brief 把下载完成的临时文件加入缓存并打开, 必要时按LRU淘汰. headers为下载的响应头, 命中时原样返回.
+    ///        超过容量上限等原因无法缓存时返回false, 临时文件由调用方读取后删除
+    bool Commit(const std::string& bucket_name, const std::string& object_name,
+                const std::string& temp_path, const std::string& etag, uint64_t size,
+                const std::map<std::string, std::string>& headers, DiskCacheEntry* entry);
+
+    /// \brief 重新验证未修改时调用, 重新开始新鲜期
+    void Refresh(const std::string& bucket_name, const std::string& object_name);
+
+    /// \brief 删除Object的缓存
+    void Invalidate(const std::string& bucket_name, const std::string& object_name);
+
+    /// \brief 记录一次命中, is_revalidated表示经过了重新验证
+    void AddHit(bool is_revalidated);
+
+    DiskCacheStat GetStat() const;
+
+private:
+    struct IndexHeader;
+    struct IndexSlot;
+
+    explicit DiskCache(const DiskCachePolicy& policy);
+
+    // 创建缓存目录并加载索引, 清理索引中不存在的缓存文件
+    bool Init();
+
+    struct FillState {
+        FillState() : m_is_done(false), m_is_filled(false) {}
+        bool m_is_done;
+        bool m_is_filled;
+        boost::condition_variable m_cond;
+    };
+    typedef boost::shared_ptr<FillState> SharedFillState;
+
+    static std::string GetKey(const std::string& bucket_name, const std::string& object_name);
+    static uint64_t HashKey(const std::string& key);
+
+    std::string GetDataPath(uint64_t key_hash) const;
+
+    // 读取缓存文件末尾记录的key和响应头, 文件大小与size不符或格式错误时返回false
+    bool ReadDataFooter(uint64_t key_hash, uint64_t size, std::string* key,
+                        std::map<std::string, std::string>* headers) const;
+
+    bool LoadIndex();
+    void ResetIndex();
+    void LoadSlots();
+    void RemoveOrphanFiles();
+
+    // 以下函数调用时需持有m_mutex
+    IndexSlot* GetSlot(uint32_t slot_idx) const;
+    void RemoveSlot(uint32_t slot_idx, bool is_evict);
+    void TouchSlot(uint32_t slot_idx);
+
+private:
+    DiskCachePolicy m_policy;
+    std::string m_data_dir;
+    int m_index_fd;
+    void* m_index_addr;
+    size_t m_index_len;
+
+    mutable boost::mutex m_mutex;
+    // 以下为索引文件在内存中的视图
+    std::map<uint64_t, uint32_t> m_slot_by_hash;
+    // 每条记录对应的完整key和响应头
+    std::vector<std::string> m_slot_keys;
+    std::vector<std::map<std::string, std::string> > m_slot_headers;
+    // (访问序号, 记录下标), 序号最小的为最久未使用
+    std::set<std::pair<uint64_t, uint32_t> > m_lru;
+    std::vector<uint32_t> m_free_slots;
+    uint64_t m_total_bytes;
+
+    std::map<uint64_t, SharedFillState> m_fills;
+    DiskCacheStat m_stat;
+};
+
+} // namespace qcloud_cos
+#endif // DISK_CACHE_H
@@ -0,0 +1,53 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: GetObject本地磁盘缓存策略
+
+#ifndef DISK_CACHE_POLICY_H
+#define DISK_CACHE_POLICY_H
+#pragma once
+
+#include <stdint.h>
+
+#include <string>
+
+namespace qcloud_cos {
+
+/// 默认磁盘缓存的总大小上限, 单位:字节
+const uint64_t kDefaultDiskCacheMaxBytes = 1024 * 1024 * 1024;
+/// 默认磁盘缓存最多缓存的Object数, 决定索引文件的大小
+const uint32_t kDefaultDiskCacheMaxEntries = 65536;
+
+/// \brief GetObject本地磁盘缓存策略. 开启后完整下载的Object保存在缓存目录中,
+///        新鲜期内直接从本地读取, 过期后携带If-None-Match重新验证, 未修改时不再下载
+class DiskCachePolicy {
+public:
+    DiskCachePolicy()
+        : m_max_bytes(kDefaultDiskCacheMaxBytes), m_max_entries(kDefaultDiskCacheMaxEntries),
+          m_fresh_in_ms(0) {}
+
+    /// \brief 设置缓存目录, 为空表示关闭缓存(默认). 同一目录只能由一个进程使用
+    void SetCacheDir(const std::string& cache_dir) { m_cache_dir = cache_dir; }
+    const std::string& GetCacheDir() const { return m_cache_dir; }
+
+    void SetMaxBytes(uint64_t max_bytes) { m_max_bytes = max_bytes; }
+    uint64_t GetMaxBytes() const { return m_max_bytes; }
+
+    void SetMaxEntries(uint32_t max_entries) { m_max_entries = max_entries; }
+    uint32_t GetMaxEntries() const { return m_max_entries; }
+
+    /// \brief 设置新鲜期, 单位:毫秒. 新鲜期内不发出请求, 0表示每次都重新验证(默认)
+    void SetFreshInms(uint64_t fresh_in_ms) { m_fresh_in_ms = fresh_in_ms; }
+    uint64_t GetFreshInms() const { return m_fresh_in_ms; }
+
+    bool IsEnable() const { return !m_cache_dir.empty(); }
+
+private:
+    std::string m_cache_dir;
+    uint64_t m_max_bytes;
+    uint32_t m_max_entries;
+    uint64_t m_fresh_in_ms;
+};
+
+} // namespace qcloud_cos
+#endif // DISK_CACHE_POLICY_H
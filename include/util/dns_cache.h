@@ -0,0 +1,103 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: 域名解析缓存, 新建连接在解析到的多个地址间轮询
+
+#ifndef DNS_CACHE_H
+#define DNS_CACHE_H
+#pragma once
+
+#include <stdint.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "boost/thread/mutex.hpp"
+
+#include "util/noncopyable.h"
+
+namespace qcloud_cos {
+
+/// 默认连接失败的地址被剔除的时长, 单位:毫秒
+const uint64_t kDefaultDnsEjectInms = 30 * 1000;
+
+/// \brief 域名解析缓存的统计
+struct DnsCacheStat {
+    DnsCacheStat() : m_hits(0), m_misses(0), m_refreshes(0), m_resolve_fails(0), m_ejections(0) {}
+
+    uint64_t m_hits;          // 使用缓存地址的次数
+    uint64_t m_misses;        // 在请求路径上同步解析的次数
+    uint64_t m_refreshes;     // 过期后在后台重新解析的次数
+    uint64_t m_resolve_fails; // 解析失败的次数
+    uint64_t m_ejections;     // 连接失败剔除地址的次数
+};
+
+/// \brief 进程内共享的域名解析缓存. 开启后(SetTtlInms大于0)新建的http连接直接连接解析到的地址,
+///        在多个地址间轮询; 缓存过期后继续使用旧地址并在后台重新解析, 不阻塞请求.
+///        连接失败的地址在一段时间内不再选择, 所有地址都被剔除时仍然轮询全部地址
+class DnsCache : private NonCopyable {
+public:
+    /// \brief 解析函数, 输出host对应的所有地址
+    typedef bool (*ResolveFunc)(const std::string& host, std::vector<std::string>* addresses);
+
+    static DnsCache& Instance();
+
+    /// \brief 选择host的一个地址. 未开启缓存、host本身是IP或解析失败时返回false,
+    ///        调用方直接使用host建立连接
+    bool PickAddress(const std::string& host, std::string* address);
+
+    /// \brief 连接address失败时调用, 该地址在剔除时长内不再被选择
+    void ReportFailure(const std::string& host, const std::string& address);
+
+    /// \brief 缓存有效期, 0表示关闭缓存(默认)
+    void SetTtlInms(uint64_t ttl_in_ms);
+    uint64_t GetTtlInms() const;
+
+    void SetEjectInms(uint64_t eject_in_ms);
+
+    /// \brief 替换解析函数, 传入NULL时恢复为getaddrinfo, 用于测试
+    void SetResolver(ResolveFunc resolver);
+
+    /// \brief 清空缓存
+    void Clear();
+
+    DnsCacheStat GetStat() const;
+
+    /// \brief 通过getaddrinfo解析host
+    static bool ResolveByGetAddrInfo(const std::string& host, std::vector<std::string>* addresses);
+
+private:
+    struct Address {
+        Address() : m_eject_until_in_ms(0) {}
+        std::string m_ip;
+        uint64_t m_eject_until_in_ms;
+    };
+
+    struct Entry {
+        Entry() : m_expire_in_ms(0), m_next(0), m_is_refreshing(false) {}
+        std::vector<Address> m_addresses;
+        uint64_t m_expire_in_ms;
+        size_t m_next;
+        bool m_is_refreshing;
+    };
+
+    DnsCache();
+
+    // 在共享执行器中重新解析, 失败时保留旧地址
+    void Refresh(const std::string& host);
+
+    // 用新的解析结果替换地址, 保留仍然存在的地址的剔除状态. 调用时需持有m_mutex
+    void UpdateEntry(const std::vector<std::string>& ips, uint64_t now_in_ms, Entry* entry);
+
+private:
+    mutable boost::mutex m_mutex;
+    std::map<std::string, Entry> m_entries;
+    ResolveFunc m_resolver;
+    uint64_t m_ttl_in_ms;
+    uint64_t m_eject_in_ms;
+    DnsCacheStat m_stat;
+};
+
+} // namespace qcloud_cos
+#endif // DNS_CACHE_H
@@ -0,0 +1,158 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: 进程内共享的work-stealing执行器, 以及按调用限制并发的任务组
+
+#ifndef EXECUTOR_H
+#define EXECUTOR_H
+#pragma once
+
+#include <stdint.h>
+
+#include <deque>
+#include <map>
+#include <vector>
+
+#include "boost/function.hpp"
+#include "boost/thread/condition_variable.hpp"
+#include "boost/thread/mutex.hpp"
+#include "boost/thread/thread.hpp"
+#include "boost/thread/thread_time.hpp"
+#include "boost/thread/tss.hpp"
+
+#include "util/noncopyable.h"
+
+namespace qcloud_cos {
+
+/// 执行器的默认线程数. 任务大多阻塞在网络IO上, 线程数决定进程内同时执行的分块任务数上限
+const unsigned kDefaultExecutorThreadNum = 32;
+
+typedef boost::function<void()> ExecutorTask;
+
+/// \brief 执行器的统计
+struct ExecutorStat {
+    ExecutorStat() : m_submitted(0), m_executed(0), m_stolen(0) {}
+
+    uint64_t m_submitted; // 提交的任务数
+    uint64_t m_executed;  // 执行完成的任务数
+    uint64_t m_stolen;    // 从其他工作线程窃取的任务数
+};
+
+/// \brief 固定线程数的work-stealing执行器. 每个工作线程有自己的任务队列,
+///        工作线程提交的任务放入自己的队列并按后进先出执行, 其他线程提交的任务放入公共队列;
+///        自己的队列为空时依次从公共队列和其他工作线程队列的头部领取任务.
+///        线程在第一次提交任务时启动, 析构时执行完排队的任务后退出
+class Executor : private NonCopyable {
+public:
+    explicit Executor(unsigned thread_num = kDefaultExecutorThreadNum);
+    ~Executor();
+
+    /// \brief 所有分块上传、下载、复制和批量操作共享的执行器, 不析构
+    static Executor& Instance();
+
+    /// \brief 设置线程数, 只在第一次提交任务之前生效
+    void SetThreadNum(unsigned thread_num);
+    unsigned GetThreadNum() const;
+
+    void Submit(const ExecutorTask& task);
+
+    /// \brief 到达due_time时把任务放入公共队列, 等待期间不占用工作线程.
+    ///        所有延迟任务由一个定时线程管理, 该线程在第一次提交延迟任务时启动;
+    ///        析构时尚未到期的延迟任务不再执行
+    void SubmitAt(const boost::system_time& due_time, const ExecutorTask& task);
+
+    /// \brief 当前线程是否为该执行器的工作线程
+    bool IsWorkerThread() const;
+
+    /// \brief 在当前工作线程上执行一个排队的任务, 没有可执行的任务或不是工作线程时返回false.
+    ///        供在工作线程上等待其他任务的调用方使用, 避免所有工作线程都在等待时死锁
+    bool RunOne();
+
+    ExecutorStat GetStat() const;
+
+private:
+    struct Worker {
+        Worker() : m_executed(0), m_stolen(0) {}
+
+        boost::mutex m_mutex;
+        std::deque<ExecutorTask> m_tasks;
+        uint64_t m_executed;
+        uint64_t m_stolen;
+    };
+
+    // Worker由执行器持有, 工作线程退出时不释放
+    static void KeepWorker(Worker* /* worker */) {}
+
+    // 启动工作线程, 调用时需持有m_mutex
+    void Start();
+
+    void WorkerLoop(Worker* worker);
+
+    // 按到期时间依次提交延迟任务
+    void TimerLoop();
+
+    // 依次从自己的队列尾部、公共队列和其他线程队列的头部领取任务
+    bool PopTask(Worker* worker, ExecutorTask* task);
+
+    bool HasTask();
+
+    void RunTask(Worker* worker, const ExecutorTask& task);
+
+private:
+    mutable boost::mutex m_mutex;
+    boost::condition_variable m_cond;
+    unsigned m_thread_num;
+    bool m_is_started;
+    bool m_is_stopped;
+    unsigned m_idle_num;
+    uint64_t m_submitted;
+    // 非工作线程提交的任务
+    std::deque<ExecutorTask> m_injected;
+    // 启动后不再修改, 窃取时无需加锁访问
+    std::vector<Worker*> m_workers;
+    boost::thread_specific_ptr<Worker> m_current_worker;
+    boost::thread_group m_threads;
+    // 延迟任务按到期时间排序, 由m_mutex保护
+    std::multimap<boost::system_time, ExecutorTask> m_timed_tasks;
+    boost::condition_variable m_timer_cond;
+    bool m_is_timer_started;
+};
+
+/// \brief 一次调用提交到执行器的一组任务. 同时在执行器中执行的任务数不超过max_concurrency,
+///        其余任务在组内按提交顺序排队, 组内任务完成后依次补充.
+///        替代按调用创建的线程池: 并发按调用限制, 线程由所有调用共享
+class TaskGroup : private NonCopyable {
+public:
+    explicit TaskGroup(unsigned max_concurrency, Executor* executor = &Executor::Instance());
+
+    /// \brief 析构前等待所有任务结束
+    ~TaskGroup();
+
+    void Schedule(const ExecutorTask& task);
+
+    /// \brief 等待已提交的任务全部结束. 在工作线程上等待时同时执行执行器中排队的任务
+    void Wait();
+
+    /// \brief 最多等待timeout_in_ms, 任务全部结束时返回true
+    bool TimedWait(uint64_t timeout_in_ms);
+
+private:
+    // deadline为空时一直等待
+    bool WaitUntil(const boost::system_time* deadline);
+
+    // 在并发上限内把排队的任务提交到执行器, 调用时需持有m_mutex
+    void Dispatch();
+
+    void RunTask(const ExecutorTask& task);
+
+private:
+    Executor* m_executor;
+    unsigned m_max_concurrency;
+    boost::mutex m_mutex;
+    boost::condition_variable m_cond;
+    std::deque<ExecutorTask> m_pending;
+    unsigned m_running;
+};
+
+} // namespace qcloud_cos
+#endif // EXECUTOR_H
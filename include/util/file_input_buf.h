@@ -0,0 +1,64 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: 读取本地文件中一段数据的流缓冲区, 供HttpSender零拷贝发送
+
+#ifndef FILE_INPUT_BUF_H
+#define FILE_INPUT_BUF_H
+#pragma once
+
+#include <stdint.h>
+
+#include <streambuf>
+#include <string>
+
+#include "util/noncopyable.h"
+#include "util/transfer_progress.h"
+
+namespace qcloud_cos {
+
+/// \brief 读取本地文件[offset, offset + len)的流缓冲区, 支持seek, 读取的字节数计入progress.
+///        通过pread按块读入内部缓冲区, 多个缓冲区可以并发读取同一个文件的不同范围.
+///        HttpSender在非TLS连接上识别该缓冲区, 用sendfile直接从页缓存发送剩余数据
+class FileInputBuf : public std::streambuf, private NonCopyable {
+public:
+    /// \brief 打开文件, 范围超出文件大小时截断到文件末尾
+    FileInputBuf(const std::string& file_path, uint64_t offset, uint64_t len,
+                 TransferProgress* progress = NULL);
+    virtual ~FileInputBuf();
+
+    bool IsOpen() const { return m_fd >= 0; }
+
+    int GetFd() const { return m_fd; }
+
+    /// \brief 下一个未读字节在文件中的偏移
+    uint64_t GetFileOffset() const;
+
+    /// \brief 剩余未读的字节数
+    uint64_t GetRemainBytes() const;
+
+    /// \brief 跳过n个字节并计入progress, 用于数据绕过缓冲区发送后更新读位置
+    void Consume(uint64_t n);
+
+protected:
+    virtual int_type underflow();
+    virtual pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+                             std::ios_base::openmode which = std::ios_base::in);
+    virtual pos_type seekpos(pos_type pos,
+                             std::ios_base::openmode which = std::ios_base::in);
+
+private:
+    // 丢弃缓冲区中的数据, 下一次读取从文件偏移file_offset开始
+    void ResetBuffer(uint64_t file_offset);
+
+private:
+    int m_fd;
+    uint64_t m_begin;      // 范围起始的文件偏移
+    uint64_t m_end;        // 范围结束的文件偏移
+    uint64_t m_buf_offset; // 缓冲区起始字节的文件偏移
+    char* m_buf;
+    TransferProgress* m_progress;
+};
+
+} // namespace qcloud_cos
+#endif // FILE_INPUT_BUF_H
@@ -16,6 +16,12 @@ class FileUtil
 
     //返回文件大小
     static uint64_t GetFileLen(const std::string& path);
+
+    //返回文件内容MD5的十六进制串, 打开文件失败时返回空串
+    static std::string GetFileMd5(const std::string& path);
+
+    //逐级创建目录, 目录已存在时返回true
+    static bool MakeDirs(const std::string& path);
 };
 
 }
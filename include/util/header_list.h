@@ -0,0 +1,86 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: 请求热路径上使用的扁平header/param列表
+
+#ifndef HEADER_LIST_H
+#define HEADER_LIST_H
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace qcloud_cos {
+
+/// 预留的条目数和字符区字节数, 常见请求不超过该规模时只有两次内存分配
+const size_t kHeaderListReserveEntries = 16;
+const size_t kHeaderListReserveBytes = 1024;
+
+/// \brief 扁平的名字/值列表. 所有名字和值依次追加到同一块字符区中, 条目只记录偏移和长度,
+///        替代按条目分配节点的std::map. 名字按大小写不敏感比较, 条目按插入顺序保存,
+///        调用SortByName后按名字排序
+class HeaderList {
+public:
+    HeaderList();
+
+    /// \brief 追加一个条目, 不检查名字是否重复
+    void Add(const std::string& name, const std::string& value);
+
+    /// \brief 按顺序追加kvs中的所有条目, 不检查名字是否重复
+    void AddAll(const std::map<std::string, std::string>& kvs);
+
+    /// \brief 追加kvs中名字尚不存在的条目, 已存在的名字保留原值, 同std::map::insert
+    void Merge(const std::map<std::string, std::string>& kvs);
+
+    /// \brief 设置名字对应的值, 名字已存在时替换最后一个同名条目的值, 否则追加
+    void Set(const std::string& name, const std::string& value);
+
+    /// \brief 查找名字对应的值, 有多个同名条目时返回最后一个
+    bool Find(const std::string& name, std::string* value) const;
+
+    /// \brief 把所有名字转为小写
+    void LowerNames();
+
+    /// \brief 按名字(大小写不敏感)稳定排序, 同名条目只保留最后插入的一个
+    void SortByName();
+
+    size_t Size() const { return m_entries.size(); }
+    bool Empty() const { return m_entries.empty(); }
+
+    std::string GetName(size_t idx) const;
+    std::string GetValue(size_t idx) const;
+
+    /// \brief 把第idx个条目的名字/值追加到out, 不产生临时字符串
+    void AppendName(size_t idx, std::string* out) const;
+    void AppendValue(size_t idx, std::string* out) const;
+
+    void Clear();
+
+private:
+    struct Entry {
+        uint32_t m_name_pos;
+        uint32_t m_name_len;
+        uint32_t m_value_pos;
+        uint32_t m_value_len;
+    };
+
+    class NameLess;
+
+    // 返回最后一个同名条目的下标, 不存在时返回-1
+    int FindIndex(const std::string& name) const;
+
+    uint32_t AppendToArena(const std::string& str);
+
+    int CompareName(const Entry& lhs, const Entry& rhs) const;
+
+private:
+    std::string m_arena;
+    std::vector<Entry> m_entries;
+};
+
+} // namespace qcloud_cos
+#endif // HEADER_LIST_H
@@ -0,0 +1,110 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: 对冲请求策略, 根据首字节延迟分布决定何时发出对冲请求
+
+#ifndef HEDGE_POLICY_H
+#define HEDGE_POLICY_H
+#pragma once
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "boost/shared_ptr.hpp"
+
+#include "util/simple_mutex.h"
+
+namespace qcloud_cos {
+
+/// 默认对冲延迟取首字节延迟的p95
+const double kDefaultHedgePercentile = 0.95;
+/// 默认对冲延迟下限, 单位:毫秒
+const uint64_t kDefaultHedgeMinDelayInms = 10;
+/// 默认对冲延迟上限, 样本不足时也使用该值, 单位:毫秒
+const uint64_t kDefaultHedgeMaxDelayInms = 1000;
+/// 默认对冲请求最多占总请求数的比例
+const double kDefaultHedgeBudgetRatio = 0.05;
+/// 对冲预算最多累积的令牌数
+const double kHedgeBudgetCapacity = 10.0;
+/// 延迟直方图样本数少于该值时不做估计
+const uint64_t kHedgeMinSamples = 20;
+
+/// \brief 按指数分桶的延迟直方图. 样本数超过窗口大小后所有桶计数减半,
+///        使估计值随近期延迟变化
+class LatencyHistogram {
+public:
+    explicit LatencyHistogram(uint64_t window_size = 1000);
+
+    void Record(uint64_t latency_in_ms);
+
+    /// \brief 返回percentile(0~1)分位所在桶的上界, 无样本时返回0
+    uint64_t GetPercentile(double percentile) const;
+
+    /// \brief 当前(衰减后)的样本数
+    uint64_t GetCount() const;
+
+private:
+    uint64_t m_window_size;
+    double m_total;
+    std::vector<uint64_t> m_bounds;
+    std::vector<double> m_counts;
+};
+
+/// \brief 对冲请求策略. 主请求发出后超过GetHedgeDelayInms()仍未收到响应头,
+///        且对冲预算充足时, 发出一个相同的对冲请求. 策略拷贝之间共享延迟直方图和预算.
+class HedgePolicy {
+public:
+    HedgePolicy();
+
+    /// \brief 是否开启对冲, 默认关闭
+    void SetEnable(bool is_enable) { m_is_enable = is_enable; }
+    bool IsEnable() const { return m_is_enable; }
+
+    /// \brief 设置对冲延迟所取的分位, 取值(0, 1)
+    void SetPercentile(double percentile) { m_percentile = percentile; }
+    double GetPercentile() const { return m_percentile; }
+
+    void SetMinDelayInms(uint64_t delay) { m_min_delay_in_ms = delay; }
+    uint64_t GetMinDelayInms() const { return m_min_delay_in_ms; }
+
+    void SetMaxDelayInms(uint64_t delay) { m_max_delay_in_ms = delay; }
+    uint64_t GetMaxDelayInms() const { return m_max_delay_in_ms; }
+
+    /// \brief 设置对冲请求最多占总请求数的比例
+    void SetBudgetRatio(double ratio) { m_budget_ratio = ratio; }
+    double GetBudgetRatio() const { return m_budget_ratio; }
+
+    /// \brief 根据该http方法的首字节延迟分布计算对冲延迟
+    uint64_t GetHedgeDelayInms(const std::string& http_method) const;
+
+    /// \brief 记录一次请求的首字节延迟
+    void RecordLatency(const std::string& http_method, uint64_t latency_in_ms) const;
+
+    /// \brief 每发出一个主请求调用一次, 按比例补充对冲预算
+    void OnRequest() const;
+
+    /// \brief 尝试消耗一次对冲预算
+    bool TryAcquireHedge() const;
+
+private:
+    struct State {
+        State() : m_budget_tokens(kHedgeBudgetCapacity) {}
+
+        SimpleMutex m_mutex;
+        LatencyHistogram m_head_histogram;
+        LatencyHistogram m_get_histogram;
+        double m_budget_tokens;
+    };
+
+    bool m_is_enable;
+    double m_percentile;
+    uint64_t m_min_delay_in_ms;
+    uint64_t m_max_delay_in_ms;
+    double m_budget_ratio;
+    boost::shared_ptr<State> m_state;
+};
+
+} // namespace qcloud_cos
+#endif // HEDGE_POLICY_H
@@ -0,0 +1,49 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: 对冲请求发送, 用于降低小对象GET/HEAD请求的长尾延迟
+
+#ifndef HEDGED_SENDER_H
+#define HEDGED_SENDER_H
+#pragma once
+
+#include <stdint.h>
+
+#include <map>
+#include <string>
+
+#include "util/cancel_token.h"
+#include "util/header_list.h"
+#include "util/hedge_policy.h"
+#include "util/rate_limiter.h"
+#include "util/request_scheduler.h"
+
+namespace qcloud_cos {
+
+class HedgedSender {
+public:
+    /// \brief 以对冲的方式发送请求, 参数和返回值与HttpSender::SendRequest相同.
+    ///        主请求在调用线程上发送; 超过对冲延迟仍未收到响应头时, 由共享执行器在新的连接上
+    ///        发出相同的请求, 先收到响应头的请求胜出并写入resp_stream, 其余请求被取消.
+    ///        只适用于GET/HEAD等幂等且无请求体的请求.
+    ///        cancel_token被取消时所有尝试都被取消; 落败的对冲请求可能在返回后才结束,
+    ///        因此以shared_ptr传入, rate_limiter同理.
+    static int SendRequest(const HedgePolicy& hedge_policy,
+                           const std::string& http_method,
+                           const std::string& url_str,
+                           const std::map<std::string, std::string>& req_params,
+                           const HeaderList& req_headers,
+                           uint64_t conn_timeout_in_ms,
+                           uint64_t recv_timeout_in_ms,
+                           std::map<std::string, std::string>* resp_headers,
+                           std::string* xml_err_str,
+                           std::ostream& resp_stream,
+                           std::string* err_msg,
+                           bool is_check_md5 = false,
+                           const SharedCancelToken& cancel_token = SharedCancelToken(),
+                           const SharedRateLimiter& rate_limiter = SharedRateLimiter(),
+                           REQUEST_PRIORITY priority = PRIORITY_NORMAL);
+};
+
+} // namespace qcloud_cos
+#endif // HEDGED_SENDER_H
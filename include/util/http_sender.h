@@ -16,9 +16,19 @@
 
 #include "request/base_req.h"
 #include "response/base_resp.h"
+#include "util/cancel_token.h"
+#include "util/header_list.h"
+#include "util/request_scheduler.h"
 
 namespace qcloud_cos {
 
+class RateLimiter;
+
+/// cancel_token不为NULL时, 请求期间连接注册在该句柄上, 句柄被取消后请求返回-1,
+/// err_msg为kRequestCancelledErrMsg; 句柄设置了截止时间时, 连接和收发超时按剩余时间收紧,
+/// 超过截止时间后返回-1, err_msg为kRequestDeadlineExceededErrMsg.
+/// rate_limiter不为NULL时, 请求体和响应体按限速器的速率分块收发.
+/// 取连接之前按priority向RequestScheduler申请执行许可, 排队期间被取消时返回-1
 class HttpSender {
 public:
     static int SendRequest(const std::string& http_method,
@@ -31,7 +41,10 @@ public:
                            std::map<std::string, std::string>* resp_headers,
                            std::string* resp_body,
                            std::string* err_msg,
-                           bool is_check_md5 = false);
+                           bool is_check_md5 = false,
+                           CancelToken* cancel_token = NULL,
+                           RateLimiter* rate_limiter = NULL,
+                           REQUEST_PRIORITY priority = PRIORITY_NORMAL);
 
     static int SendRequest(const std::string& http_method,
                            const std::string& url_str,
@@ -43,7 +56,10 @@ public:
                            std::map<std::string, std::string>* resp_headers,
                            std::ostream& resp_stream,
                            std::string* err_msg,
-                           bool is_check_md5 = false);
+                           bool is_check_md5 = false,
+                           CancelToken* cancel_token = NULL,
+                           RateLimiter* rate_limiter = NULL,
+                           REQUEST_PRIORITY priority = PRIORITY_NORMAL);
 
     static int SendRequest(const std::string& http_method,
                            const std::string& url_str,
@@ -55,7 +71,10 @@ public:
                            std::map<std::string, std::string>* resp_headers,
                            std::string* resp_body,
                            std::string* err_msg,
-                           bool is_check_md5 = false);
+                           bool is_check_md5 = false,
+                           CancelToken* cancel_token = NULL,
+                           RateLimiter* rate_limiter = NULL,
+                           REQUEST_PRIORITY priority = PRIORITY_NORMAL);
 
     static int SendRequest(const std::string& http_method,
                            const std::string& url_str,
@@ -67,7 +86,10 @@ public:
                            std::map<std::string, std::string>* resp_headers,
                            std::ostream& resp_stream,
                            std::string* err_msg,
-                           bool is_check_md5 = false);
+                           bool is_check_md5 = false,
+                           CancelToken* cancel_token = NULL,
+                           RateLimiter* rate_limiter = NULL,
+                           REQUEST_PRIORITY priority = PRIORITY_NORMAL);
 
     static int SendRequest(const std::string& http_method,
                            const std::string& url_str,
@@ -80,7 +102,42 @@ public:
                            std::string* xml_err_str,
                            std::ostream& resp_stream,
                            std::string* err_msg,
-                           bool is_check_md5 = false);
+                           bool is_check_md5 = false,
+                           CancelToken* cancel_token = NULL,
+                           RateLimiter* rate_limiter = NULL,
+                           REQUEST_PRIORITY priority = PRIORITY_NORMAL);
+
+    /// \brief 同上, 请求头使用签名时生成的HeaderList, 供BaseOp直接传入, 不再转换为map
+    static int SendRequest(const std::string& http_method,
+                           const std::string& url_str,
+                           const std::map<std::string, std::string>& req_params,
+                           const HeaderList& req_headers,
+                           std::istream& is,
+                           uint64_t conn_timeout_in_ms,
+                           uint64_t recv_timeout_in_ms,
+                           std::map<std::string, std::string>* resp_headers,
+                           std::ostream& resp_stream,
+                           std::string* err_msg,
+                           bool is_check_md5 = false,
+                           CancelToken* cancel_token = NULL,
+                           RateLimiter* rate_limiter = NULL,
+                           REQUEST_PRIORITY priority = PRIORITY_NORMAL);
+
+    static int SendRequest(const std::string& http_method,
+                           const std::string& url_str,
+                           const std::map<std::string, std::string>& req_params,
+                           const HeaderList& req_headers,
+                           const std::string& req_body,
+                           uint64_t conn_timeout_in_ms,
+                           uint64_t recv_timeout_in_ms,
+                           std::map<std::string, std::string>* resp_headers,
+                           std::string* xml_err_str,
+                           std::ostream& resp_stream,
+                           std::string* err_msg,
+                           bool is_check_md5 = false,
+                           CancelToken* cancel_token = NULL,
+                           RateLimiter* rate_limiter = NULL,
+                           REQUEST_PRIORITY priority = PRIORITY_NORMAL);
 
     // TODO(sevenyou) 挪走
     static uint64_t GetTimeStampInUs();
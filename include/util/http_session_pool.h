@@ -0,0 +1,178 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: HTTP长连接池, 按scheme://host:port缓存空闲连接
+
+#ifndef HTTP_SESSION_POOL_H
+#define HTTP_SESSION_POOL_H
+#pragma once
+
+#include <stdint.h>
+
+#include <deque>
+#include <map>
+#include <string>
+
+#include "boost/thread/condition_variable.hpp"
+#include "boost/thread/mutex.hpp"
+#include "boost/thread/thread.hpp"
+#include "boost/thread/tss.hpp"
+#include "Poco/Net/HTTPClientSession.h"
+
+#include "util/noncopyable.h"
+#include "util/simple_mutex.h"
+
+namespace qcloud_cos {
+
+/// 每个host最多缓存的空闲连接数
+const unsigned kDefaultMaxIdleSessionsPerHost = 64;
+
+/// 后台保温线程的默认检查间隔, 单位:毫秒
+const uint64_t kDefaultKeepWarmIntervalInms = 5 * 1000;
+
+/// \brief 连接池的统计
+struct HttpSessionPoolStat {
+    HttpSessionPoolStat()
+        : m_created(0), m_reused(0), m_idle(0), m_warmed(0), m_warm_fails(0), m_unhealthy(0),
+          m_stale(0) {}
+
+    uint64_t m_created;    // 新建的连接数
+    uint64_t m_reused;     // 复用空闲连接的次数
+    uint64_t m_idle;       // 当前空闲的连接数
+    uint64_t m_warmed;     // 预热建立的连接数
+    uint64_t m_warm_fails; // 预热建立连接失败的次数
+    uint64_t m_unhealthy;  // 健康检查发现已被服务端关闭的空闲连接数
+    uint64_t m_stale;      // 复用时发现已被服务端关闭, 在新连接上重新发送请求的次数
+};
+
+/// \brief 进程内共享的HTTP长连接池. 只有CosSysConfig::GetKeepAlive()为true时才会复用连接,
+///        空闲超过CosSysConfig::GetKeepIdle()秒的连接被关闭
+class HttpSessionPool : private NonCopyable {
+public:
+    static HttpSessionPool& Instance();
+
+    ~HttpSessionPool();
+
+    /// \brief 取出url对应host的空闲连接, 没有时新建. 返回的连接由调用方负责归还或删除
+    ///
+    /// \param url_str   请求的url, 以https开头时建立https连接
+    /// \param key       输出连接池的key, 归还时使用
+    /// \param is_reused 输出是否为复用的连接
+    Poco::Net::HTTPClientSession* Acquire(const std::string& url_str, std::string* key,
+                                          bool* is_reused);
+
+    /// \brief 归还可复用的连接, 空闲连接已满时直接删除
+    void Release(const std::string& key, Poco::Net::HTTPClientSession* session);
+
+    /// \brief 并行建立n_connections个连接(包括DNS解析、TCP和TLS握手)放入连接池,
+    ///        连接数不超过每个host的空闲连接上限. 未开启长连接时不预热
+    ///
+    /// \return 成功建立的连接数
+    unsigned WarmUp(const std::string& url_str, unsigned n_connections,
+                    uint64_t conn_timeout_in_ms);
+
+    /// \brief 由后台线程保持url对应host至少min_idle个空闲连接, 定期关闭已被服务端断开的
+    ///        空闲连接并补足. min_idle为0时取消该host的保温
+    void KeepWarm(const std::string& url_str, unsigned min_idle, uint64_t conn_timeout_in_ms);
+
+    /// \brief 后台保温线程的检查间隔
+    void SetKeepWarmIntervalInms(uint64_t interval_in_ms);
+
+    /// \brief 取消所有host的保温并停止后台线程
+    void StopKeepWarm();
+
+    /// \brief 关闭所有空闲连接
+    void Clear();
+
+    void SetMaxIdlePerHost(unsigned max_idle);
+
+    HttpSessionPoolStat GetStat() const;
+
+    /// \brief 复用的连接已被服务端关闭, 在新连接上重新发送请求时调用, 只用于统计
+    void ReportStale();
+
+    /// \brief 新建连接, 不经过连接池. http连接在开启域名解析缓存时直接连接缓存的地址
+    static Poco::Net::HTTPClientSession* CreateSession(const std::string& url_str);
+
+private:
+    struct IdleSession {
+        Poco::Net::HTTPClientSession* m_session;
+        uint64_t m_release_time_in_ms;
+    };
+
+    struct KeepWarmTarget {
+        std::string m_url;
+        unsigned m_min_idle;
+        uint64_t m_conn_timeout_in_ms;
+    };
+
+    HttpSessionPool();
+
+    void KeepWarmLoop();
+
+    // 关闭key对应的空闲超时或已被服务端断开的连接, 返回剩余的空闲连接数
+    unsigned CheckIdleSessions(const std::string& key);
+
+private:
+    mutable SimpleMutex m_mutex;
+    std::map<std::string, std::deque<IdleSession> > m_idle_sessions;
+    unsigned m_max_idle_per_host;
+    HttpSessionPoolStat m_stat;
+
+    // 以下为后台保温相关, 由m_keeper_mutex保护
+    boost::mutex m_keeper_mutex;
+    boost::condition_variable m_keeper_cond;
+    std::map<std::string, KeepWarmTarget> m_keep_warm_targets;
+    uint64_t m_keep_warm_interval_in_ms;
+    boost::thread* m_keeper;
+    bool m_is_keeper_stop;
+};
+
+/// \brief 作用域内当前线程发送的请求复用连接池中的长连接, 不受CosSysConfig::GetKeepAlive()
+///        的限制. 用于BatchHeadObject等由大量短请求组成的批量操作, 可以嵌套
+class KeepAliveScope : private NonCopyable {
+public:
+    /// \param is_enable 为false时不生效, 便于按条件开启
+    explicit KeepAliveScope(bool is_enable = true);
+    ~KeepAliveScope();
+
+    /// \brief 当前线程是否在生效的KeepAliveScope内
+    static bool IsActive();
+
+private:
+    bool m_is_enable;
+};
+
+/// \brief 在一次请求期间持有连接. 调用MarkReusable后析构时把连接归还连接池, 否则关闭连接
+class PooledSession : private NonCopyable {
+public:
+    explicit PooledSession(const std::string& url_str);
+    ~PooledSession();
+
+    Poco::Net::HTTPClientSession* get() const { return m_session; }
+    Poco::Net::HTTPClientSession* operator->() const { return m_session; }
+
+    /// \brief 是否为连接池中复用的连接
+    bool IsReused() const { return m_is_reused; }
+
+    /// \brief 响应体已完整读取且服务端未要求关闭连接时调用
+    void MarkReusable() { m_is_reusable = true; }
+
+    /// \brief 新建的连接发送请求失败时调用, 把连接的地址报告给域名解析缓存
+    void ReportConnectFail();
+
+    /// \brief 复用的连接在收到响应前被服务端关闭时调用. 关闭socket, 下一次发送请求时
+    ///        重新建立连接, 之后该连接视为新建的连接
+    void Reconnect();
+
+private:
+    Poco::Net::HTTPClientSession* m_session;
+    std::string m_host;
+    std::string m_key;
+    bool m_is_keep_alive;
+    bool m_is_reused;
+    bool m_is_reusable;
+};
+
+} // namespace qcloud_cos
+#endif // HTTP_SESSION_POOL_H
@@ -0,0 +1,46 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: Object元数据缓存策略
+
+#ifndef META_CACHE_POLICY_H
+#define META_CACHE_POLICY_H
+#pragma once
+
+#include <stdint.h>
+
+namespace qcloud_cos {
+
+/// 默认元数据缓存的有效期, 单位:毫秒
+const uint64_t kDefaultMetaCacheTtlInms = 5000;
+/// 默认元数据缓存的分片数, 各分片独立加锁
+const unsigned kDefaultMetaCacheShardNum = 16;
+
+/// \brief Object元数据缓存策略. 开启后HeadObject在有效期内直接返回缓存的元数据,
+///        过期后携带If-None-Match重新验证, 服务端返回304时继续使用缓存
+class MetaCachePolicy {
+public:
+    MetaCachePolicy()
+        : m_capacity(0), m_ttl_in_ms(kDefaultMetaCacheTtlInms),
+          m_shard_num(kDefaultMetaCacheShardNum) {}
+
+    /// \brief 设置最多缓存的Object数, 0表示关闭缓存(默认)
+    void SetCapacity(uint64_t capacity) { m_capacity = capacity; }
+    uint64_t GetCapacity() const { return m_capacity; }
+
+    void SetTtlInms(uint64_t ttl_in_ms) { m_ttl_in_ms = ttl_in_ms; }
+    uint64_t GetTtlInms() const { return m_ttl_in_ms; }
+
+    void SetShardNum(unsigned shard_num) { m_shard_num = shard_num; }
+    unsigned GetShardNum() const { return m_shard_num; }
+
+    bool IsEnable() const { return m_capacity > 0; }
+
+private:
+    uint64_t m_capacity;
+    uint64_t m_ttl_in_ms;
+    unsigned m_shard_num;
+};
+
+} // namespace qcloud_cos
+#endif // META_CACHE_POLICY_H
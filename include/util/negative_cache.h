@@ -0,0 +1,63 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: 记录近期确认不存在的Object, 在有效期内避免重复的HeadObject请求
+
+#ifndef NEGATIVE_CACHE_H
+#define NEGATIVE_CACHE_H
+#pragma once
+
+#include <stdint.h>
+
+#include <deque>
+#include <map>
+#include <string>
+
+#include "cos_defines.h"
+#include "util/noncopyable.h"
+#include "util/simple_mutex.h"
+
+namespace qcloud_cos {
+
+/// \brief 线程安全的不存在缓存, 以bucket/object为key. 超过容量时淘汰最早加入的记录
+class NegativeCache : private NonCopyable {
+public:
+    explicit NegativeCache(size_t max_entries = kMaxNegativeCacheEntries)
+        : m_max_entries(max_entries), m_next_seq(0) {}
+    ~NegativeCache() {}
+
+    /// \brief 记录Object不存在, 在ttl_in_ms毫秒内有效
+    void Add(const std::string& bucket_name, const std::string& object_name,
+             uint64_t ttl_in_ms);
+
+    /// \brief Object是否在有效期内被记录为不存在
+    bool Contains(const std::string& bucket_name, const std::string& object_name);
+
+    /// \brief Object被写入后删除对应记录
+    void Invalidate(const std::string& bucket_name, const std::string& object_name);
+
+    void Clear();
+
+    size_t Size() const;
+
+private:
+    struct Entry {
+        uint64_t m_expire_time_in_ms;
+        uint64_t m_seq; // 加入序号, 用于识别加入顺序队列中已被覆盖的记录
+    };
+
+    static std::string GetKey(const std::string& bucket_name, const std::string& object_name) {
+        return bucket_name + "/" + object_name;
+    }
+
+private:
+    mutable SimpleMutex m_mutex;
+    size_t m_max_entries;
+    uint64_t m_next_seq;
+    std::map<std::string, Entry> m_entries;
+    // 按加入顺序记录key及加入序号, 可能包含已失效的记录, 淘汰时跳过
+    std::deque<std::pair<std::string, uint64_t> > m_insert_order;
+};
+
+} // namespace qcloud_cos
+#endif // NEGATIVE_CACHE_H
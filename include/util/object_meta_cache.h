@@ -0,0 +1,111 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: 按bucket/object分片的Object元数据LRU缓存
+
+#ifndef OBJECT_META_CACHE_H
+#define OBJECT_META_CACHE_H
+#pragma once
+
+#include <stdint.h>
+
+#include <list>
+#include <map>
+#include <string>
+
+#include "boost/scoped_array.hpp"
+
+#include "util/meta_cache_policy.h"
+#include "util/noncopyable.h"
+#include "util/simple_mutex.h"
+
+namespace qcloud_cos {
+
+/// \brief 元数据缓存的统计
+struct ObjectMetaCacheStat {
+    ObjectMetaCacheStat()
+        : m_hits(0), m_misses(0), m_revalidations(0), m_evictions(0), m_entries(0) {}
+
+    /// \brief 命中率, 304重新验证成功也算作命中
+    double GetHitRate() const {
+        uint64_t total = m_hits + m_misses;
+        return total == 0 ? 0.0 : static_cast<double>(m_hits + m_revalidations) / total;
+    }
+
+    uint64_t m_hits;          // 在有效期内直接返回的次数
+    uint64_t m_misses;        // 未缓存或已过期的次数
+    uint64_t m_revalidations; // 过期后服务端返回304, 继续使用缓存的次数
+    uint64_t m_evictions;     // 超过容量被淘汰的记录数
+    uint64_t m_entries;       // 当前缓存的记录数
+};
+
+enum META_CACHE_STATE {
+    META_CACHE_MISS = 0, // 未缓存
+    META_CACHE_FRESH,    // 在有效期内
+    META_CACHE_STALE     // 已过期, 可用ETag重新验证
+};
+
+/// \brief 线程安全的Object元数据缓存, 缓存HeadObject/GetObject返回的响应头.
+///        按key的哈希分片, 每个分片独立加锁并按LRU淘汰
+class ObjectMetaCache : private NonCopyable {
+public:
+    explicit ObjectMetaCache(const MetaCachePolicy& policy);
+    ~ObjectMetaCache() {}
+
+    /// \brief 查找缓存, 命中或过期时输出缓存的响应头和ETag
+    META_CACHE_STATE Lookup(const std::string& bucket_name, const std::string& object_name,
+                            std::map<std::string, std::string>* headers, std::string* etag);
+
+    /// \brief 写入请求成功返回的响应头
+    void Put(const std::string& bucket_name, const std::string& object_name,
+             const std::string& etag, const std::map<std::string, std::string>& headers);
+
+    /// \brief 服务端返回304时调用, etag为请求的If-None-Match, 可带引号、"W/"前缀或为逗号分隔的列表.
+    ///        与缓存的ETag匹配则延长有效期并输出缓存的响应头
+    bool Revalidate(const std::string& bucket_name, const std::string& object_name,
+                    const std::string& etag, std::map<std::string, std::string>* headers);
+
+    void Invalidate(const std::string& bucket_name, const std::string& object_name);
+
+    void Clear();
+
+    ObjectMetaCacheStat GetStat() const;
+
+private:
+    struct Entry {
+        std::string m_key;
+        std::string m_etag;
+        std::map<std::string, std::string> m_headers;
+        uint64_t m_expire_time_in_ms;
+    };
+
+    typedef std::list<Entry> EntryList;
+
+    struct Shard {
+        Shard() : m_hits(0), m_misses(0), m_revalidations(0), m_evictions(0) {}
+
+        SimpleMutex m_mutex;
+        // 表头为最近使用的记录
+        EntryList m_lru;
+        std::map<std::string, EntryList::iterator> m_index;
+        uint64_t m_hits;
+        uint64_t m_misses;
+        uint64_t m_revalidations;
+        uint64_t m_evictions;
+    };
+
+    static std::string GetKey(const std::string& bucket_name, const std::string& object_name) {
+        return bucket_name + "/" + object_name;
+    }
+
+    Shard& GetShard(const std::string& key);
+
+private:
+    uint64_t m_ttl_in_ms;
+    unsigned m_shard_num;
+    uint64_t m_shard_capacity;
+    boost::scoped_array<Shard> m_shards;
+};
+
+} // namespace qcloud_cos
+#endif // OBJECT_META_CACHE_H
@@ -0,0 +1,88 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: 客户端上传/下载带宽限速, 分为进程、CosAPI实例和请求三级
+
+#ifndef RATE_LIMITER_H
+#define RATE_LIMITER_H
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "boost/shared_ptr.hpp"
+
+#include "util/cancel_token.h"
+#include "util/noncopyable.h"
+#include "util/simple_mutex.h"
+
+namespace qcloud_cos {
+
+/// 空闲之后允许立即收发的时长, 单位:毫秒. 取值较小, 使限速后的流量平滑而不是突发
+const uint64_t kRateLimitBurstInms = 20;
+
+/// 限速时每次收发的块大小范围, 单位:字节
+const size_t kRateLimitMinChunkSize = 4 * 1024;
+const size_t kRateLimitMaxChunkSize = 4 * 1024 * 1024;
+
+class RateLimiter;
+typedef boost::shared_ptr<RateLimiter> SharedRateLimiter;
+
+/// \brief 限速器的统计
+struct RateLimiterStat {
+    RateLimiterStat() : m_bytes(0), m_throttled_us(0) {}
+
+    uint64_t m_bytes;        // 经过该限速器的字节数
+    uint64_t m_throttled_us; // 因限速等待的总时长, 单位:微秒
+};
+
+/// \brief 分层的令牌桶限速器. 每次收发之后调用Acquire, 按自身及所有祖先限速器中
+///        最晚可用的时间等待, 因此子限速器的速率不会超过父限速器.
+///        令牌按申请顺序分配, 共享同一限速器的多个分块按到达顺序轮流获得带宽.
+///        速率为0表示该层不限速
+class RateLimiter : private NonCopyable {
+public:
+    explicit RateLimiter(uint64_t rate_in_bytes_per_s = 0);
+
+    /// \brief 创建以parent为父限速器的限速器
+    static SharedRateLimiter Create(uint64_t rate_in_bytes_per_s,
+                                    const SharedRateLimiter& parent);
+
+    /// \brief 进程级别的上传/下载限速器, 是所有CosAPI实例限速器的父限速器
+    static const SharedRateLimiter& GlobalUploadLimiter();
+    static const SharedRateLimiter& GlobalDownloadLimiter();
+
+    /// \brief 设置速率, 单位:字节/秒, 0表示不限速. 可在收发过程中修改
+    void SetRate(uint64_t rate_in_bytes_per_s);
+    uint64_t GetRate() const;
+
+    /// \brief 设置父限速器, 必须在开始使用之前调用
+    void SetParent(const SharedRateLimiter& parent) { m_parent = parent; }
+
+    /// \brief 自身或任一祖先限速器是否限速
+    bool IsLimited() const;
+
+    /// \brief 每次收发的建议块大小, 为限速链中最低速率在突发时长内可发送的字节数
+    size_t GetChunkSize() const;
+
+    /// \brief 记录已收发bytes字节, 超出速率时休眠到令牌足够为止.
+    ///        等待期间被取消时提前返回false
+    bool Acquire(uint64_t bytes, const CancelToken* cancel_token);
+
+    RateLimiterStat GetStat() const;
+
+private:
+    // 占用bytes字节的令牌, 返回需要等待的时长, 单位:微秒
+    uint64_t Reserve(uint64_t bytes);
+
+private:
+    mutable SimpleMutex m_mutex;
+    uint64_t m_rate_in_bytes_per_s;
+    // 已分配令牌全部可用的理论时间, 单位:微秒
+    uint64_t m_ready_us;
+    SharedRateLimiter m_parent;
+    RateLimiterStat m_stat;
+};
+
+} // namespace qcloud_cos
+#endif // RATE_LIMITER_H
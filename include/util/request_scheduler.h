@@ -0,0 +1,122 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: 按优先级调度进程内并发的HTTP请求
+
+#ifndef REQUEST_SCHEDULER_H
+#define REQUEST_SCHEDULER_H
+#pragma once
+
+#include <stdint.h>
+
+#include <deque>
+
+#include "boost/thread/condition_variable.hpp"
+#include "boost/thread/mutex.hpp"
+
+#include "util/cancel_token.h"
+#include "util/noncopyable.h"
+
+namespace qcloud_cos {
+
+typedef enum request_priority {
+    PRIORITY_INTERACTIVE = 0, // 延迟敏感的小请求, 如前端的元数据读取
+    PRIORITY_NORMAL,          // 默认优先级
+    PRIORITY_BULK             // 大批量传输, 如备份上传
+} REQUEST_PRIORITY;
+
+const unsigned kRequestPriorityNum = 3;
+
+/// 各优先级的默认权重, 排队时按权重比例分配空闲的执行许可
+const unsigned kDefaultInteractiveWeight = 16;
+const unsigned kDefaultNormalWeight = 4;
+const unsigned kDefaultBulkWeight = 1;
+
+/// \brief 调度器的统计, 数组按REQUEST_PRIORITY下标
+struct RequestSchedulerStat {
+    RequestSchedulerStat() : m_running(0), m_waiting(0) {
+        for (unsigned i = 0; i < kRequestPriorityNum; ++i) {
+            m_admitted[i] = 0;
+            m_queued[i] = 0;
+            m_wait_us[i] = 0;
+        }
+    }
+
+    uint64_t m_admitted[kRequestPriorityNum]; // 获得执行许可的请求数
+    uint64_t m_queued[kRequestPriorityNum];   // 其中需要排队的请求数
+    uint64_t m_wait_us[kRequestPriorityNum];  // 排队的总时长, 单位:微秒
+    uint64_t m_running;                       // 当前执行中的请求数
+    uint64_t m_waiting;                       // 当前排队的请求数
+};
+
+/// \brief 进程内共享的请求调度器. HttpSender在取连接之前为每个请求获取执行许可,
+///        执行中的请求数达到上限后, 新请求按优先级排队; 许可空闲时按加权公平排队(stride调度)
+///        选择下一个优先级, 高优先级请求优先获得许可, 低优先级请求按权重比例仍能推进.
+///        上限为0(默认)时不排队
+class RequestScheduler : private NonCopyable {
+public:
+    static RequestScheduler& Instance();
+
+    /// \brief 同时执行的请求数上限, 0表示不限制
+    void SetMaxConcurrency(unsigned max_concurrency);
+    unsigned GetMaxConcurrency() const;
+
+    /// \brief 设置优先级的权重, 最小为1
+    void SetWeight(REQUEST_PRIORITY priority, unsigned weight);
+
+    /// \brief 获取执行许可, 需要时排队等待. 排队期间被取消时返回false
+    bool Acquire(REQUEST_PRIORITY priority, const CancelToken* cancel_token);
+
+    /// \brief 归还执行许可
+    void Release();
+
+    RequestSchedulerStat GetStat() const;
+
+private:
+    struct Waiter {
+        Waiter() : m_is_granted(false) {}
+        bool m_is_granted;
+    };
+
+    RequestScheduler();
+
+    // 许可有空闲时按stride调度把许可分配给排队的请求, 调用时需持有m_mutex
+    void GrantWaiters();
+
+    // 记录一次许可分配, 推进该优先级的pass, 调用时需持有m_mutex
+    void Admit(unsigned idx);
+
+private:
+    mutable boost::mutex m_mutex;
+    boost::condition_variable m_cond;
+    unsigned m_max_concurrency;
+    unsigned m_running;
+    std::deque<Waiter*> m_queues[kRequestPriorityNum];
+    unsigned m_weights[kRequestPriorityNum];
+    // stride调度: 每个优先级的pass, 分配许可后增加kStride / weight
+    uint64_t m_passes[kRequestPriorityNum];
+    // 最近一次分配许可的pass, 空闲后重新排队的优先级从该值开始, 不积累空闲期间的份额
+    uint64_t m_global_pass;
+    RequestSchedulerStat m_stat;
+};
+
+/// \brief 在作用域内持有执行许可
+class RequestSlot : private NonCopyable {
+public:
+    RequestSlot(REQUEST_PRIORITY priority, const CancelToken* cancel_token)
+        : m_is_acquired(RequestScheduler::Instance().Acquire(priority, cancel_token)) {}
+
+    ~RequestSlot() {
+        if (m_is_acquired) {
+            RequestScheduler::Instance().Release();
+        }
+    }
+
+    bool IsAcquired() const { return m_is_acquired; }
+
+private:
+    bool m_is_acquired;
+};
+
+} // namespace qcloud_cos
+#endif // REQUEST_SCHEDULER_H
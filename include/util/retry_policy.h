@@ -0,0 +1,109 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: 请求失败后的重试策略, 包括错误分类、指数退避和重试预算
+
+#ifndef RETRY_POLICY_H
+#define RETRY_POLICY_H
+#pragma once
+
+#include <stdint.h>
+
+#include <string>
+
+#include "boost/shared_ptr.hpp"
+
+#include "util/simple_mutex.h"
+
+namespace qcloud_cos {
+
+class CancelToken;
+
+/// 默认最大重试次数
+const unsigned kDefaultMaxRetryTimes = 3;
+/// 默认退避基数, 单位:毫秒
+const uint64_t kDefaultRetryBaseDelayInms = 100;
+/// 默认单次退避上限, 单位:毫秒
+const uint64_t kDefaultRetryMaxDelayInms = 3000;
+/// 默认重试预算容量(令牌数)
+const unsigned kDefaultRetryBudgetCapacity = 100;
+/// 默认重试预算每秒补充的令牌数
+const unsigned kDefaultRetryBudgetRefillPerSec = 10;
+
+typedef enum retry_error_type {
+    RETRY_ERR_NONE = 0,     // 不可重试的错误, 如4xx
+    RETRY_ERR_TIMEOUT,      // 连接/接收超时
+    RETRY_ERR_NETWORK,      // 连接被重置等网络错误
+    RETRY_ERR_SERVER,       // 5xx
+    RETRY_ERR_SLOW_DOWN     // 503 SlowDown, 服务端限流
+} RETRY_ERROR_TYPE;
+
+/// \brief 令牌桶实现的重试预算, 每次重试消耗一个令牌, 令牌按时间匀速补充,
+///        避免服务端故障时所有请求同时重试造成重试风暴
+class RetryBudget {
+public:
+    RetryBudget(unsigned capacity, unsigned refill_per_sec);
+
+    /// \brief 尝试获取一个令牌, 获取失败说明预算耗尽, 不应再重试
+    bool TryAcquire();
+
+    unsigned GetCapacity() const { return m_capacity; }
+    unsigned GetRefillPerSec() const { return m_refill_per_sec; }
+
+private:
+    SimpleMutex m_mutex;
+    unsigned m_capacity;
+    unsigned m_refill_per_sec;
+    double m_tokens;
+    uint64_t m_last_refill_us;
+};
+
+/// \brief 重试策略. 对超时、连接重置、5xx和503 SlowDown等错误, 按照
+///        "指数退避 + 全随机抖动"的方式重试幂等请求. 策略拷贝之间共享同一个重试预算.
+class RetryPolicy {
+public:
+    RetryPolicy();
+
+    /// \brief 设置最大重试次数, 0表示不重试
+    void SetMaxRetryTimes(unsigned times) { m_max_retry_times = times; }
+    unsigned GetMaxRetryTimes() const { return m_max_retry_times; }
+
+    /// \brief 设置退避基数, 第n次重试前最多等待 base * 2^(n-1) 毫秒
+    void SetBaseDelayInms(uint64_t delay) { m_base_delay_in_ms = delay; }
+    uint64_t GetBaseDelayInms() const { return m_base_delay_in_ms; }
+
+    /// \brief 设置单次退避的上限
+    void SetMaxDelayInms(uint64_t delay) { m_max_delay_in_ms = delay; }
+    uint64_t GetMaxDelayInms() const { return m_max_delay_in_ms; }
+
+    /// \brief 设置重试预算, capacity为0表示不限制
+    void SetRetryBudget(unsigned capacity, unsigned refill_per_sec);
+
+    /// \brief 根据http状态码和错误信息对错误分类
+    ///
+    /// \param http_status HttpSender返回的状态码, -1表示网络错误
+    /// \param err_msg     HttpSender返回的错误信息
+    static RETRY_ERROR_TYPE ClassifyError(int http_status, const std::string& err_msg);
+
+    /// \brief 判断http方法是否幂等, 非幂等的请求(POST)不做重试
+    static bool IsIdempotentMethod(const std::string& method);
+
+    /// \brief 第attempt次(从1开始)请求失败后, 判断是否需要重试. 返回true时已扣减预算
+    bool ShouldRetry(unsigned attempt, RETRY_ERROR_TYPE err_type) const;
+
+    /// \brief 计算第attempt次重试前的退避时间, 单位:毫秒
+    uint64_t GetBackoffInms(unsigned attempt, RETRY_ERROR_TYPE err_type) const;
+
+    /// \brief 按退避时间休眠, cancel_token非空时被取消或到达截止时间会提前返回
+    void Backoff(unsigned attempt, RETRY_ERROR_TYPE err_type,
+                 const CancelToken* cancel_token = NULL) const;
+
+private:
+    unsigned m_max_retry_times;
+    uint64_t m_base_delay_in_ms;
+    uint64_t m_max_delay_in_ms;
+    boost::shared_ptr<RetryBudget> m_budget;
+};
+
+} // namespace qcloud_cos
+#endif // RETRY_POLICY_H
@@ -0,0 +1,114 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: 合并同时发出的相同读请求
+
+#ifndef SINGLE_FLIGHT_H
+#define SINGLE_FLIGHT_H
+#pragma once
+
+#include <stdint.h>
+
+#include <map>
+#include <ostream>
+#include <streambuf>
+#include <string>
+
+#include "boost/function.hpp"
+#include "boost/shared_ptr.hpp"
+#include "boost/thread/condition_variable.hpp"
+#include "boost/thread/mutex.hpp"
+
+#include "op/cos_result.h"
+#include "util/cancel_token.h"
+#include "util/noncopyable.h"
+
+namespace qcloud_cos {
+
+/// \brief 请求合并的统计
+struct SingleFlightStat {
+    SingleFlightStat() : m_leaders(0), m_shared(0), m_fallbacks(0) {}
+
+    uint64_t m_leaders;   // 实际发出的请求数
+    uint64_t m_shared;    // 直接使用其它请求结果的次数
+    uint64_t m_fallbacks; // 等待后结果不可用, 自行发出请求的次数
+};
+
+/// \brief 一次合并的请求. 发起方在SingleFlight::End之前填写结果, 之后只读
+struct SingleFlightCall {
+    SingleFlightCall() : m_is_done(false), m_is_shared(false) {}
+
+    bool m_is_done;
+    bool m_is_shared; // 结果是否可供等待方使用
+    CosResult m_result;
+    std::map<std::string, std::string> m_resp_headers;
+    std::string m_body;
+    boost::condition_variable m_cond;
+};
+typedef boost::shared_ptr<SingleFlightCall> SharedFlightCall;
+
+/// \brief 按key合并同时进行的相同请求. 第一个调用方发出请求, 其它调用方等待并复用其结果
+class SingleFlight : private NonCopyable {
+public:
+    SingleFlight() {}
+
+    /// \brief 开始一次请求. 没有相同请求在进行时返回true, 调用方发出请求后必须调用End;
+    ///        否则返回false, call为进行中的请求, 调用方通过Wait等待其结果
+    bool Begin(const std::string& key, SharedFlightCall* call);
+
+    /// \brief 结束请求并唤醒等待方, 调用前需填写call中的结果
+    void End(const std::string& key, const SharedFlightCall& call);
+
+    /// \brief 发起方确定结果不可分发时(如响应体超过暂存上限)提前唤醒等待方,
+    ///        之后的相同请求不再合并到call上. 发起方仍需在请求结束后调用End
+    void Abandon(const std::string& key, const SharedFlightCall& call);
+
+    /// \brief 等待请求结束, deadline_in_ms为0时一直等待, cancel_token被取消时提前返回.
+    ///        结果可用时返回true, 超时、取消或结果不可用时返回false, 调用方应自行发出请求
+    bool Wait(const SharedFlightCall& call, uint64_t deadline_in_ms,
+              const SharedCancelToken& cancel_token = SharedCancelToken());
+
+    SingleFlightStat GetStat() const;
+
+private:
+    mutable boost::mutex m_mutex;
+    std::map<std::string, SharedFlightCall> m_calls;
+    SingleFlightStat m_stat;
+};
+
+/// \brief 把写入的数据同时写到目标流并暂存在内存中, 用于把下载的内容分发给等待方.
+///        暂存超过max_bytes后放弃暂存, 不影响写入目标流. 目标流可回退时支持回退到写入起点之后.
+///        第一次超过上限时调用on_overflow
+class TeeStreamBuf : public std::streambuf {
+public:
+    TeeStreamBuf(std::ostream* os, uint64_t max_bytes,
+                 const boost::function<void()>& on_overflow = boost::function<void()>());
+
+    /// \brief 暂存的数据是否完整
+    bool IsComplete() const { return !m_is_overflow; }
+    /// \brief 是否曾经超过上限, 回退到写入起点后仍保持为true
+    bool HasOverflowed() const { return m_has_overflowed; }
+    const std::string& GetBytes() const { return m_bytes; }
+
+protected:
+    virtual std::streamsize xsputn(const char* s, std::streamsize n);
+    virtual int_type overflow(int_type c);
+    virtual int sync();
+    virtual pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+                             std::ios_base::openmode which);
+    virtual pos_type seekpos(pos_type pos, std::ios_base::openmode which);
+
+private:
+    void SetOverflow();
+
+    std::ostream* m_os;
+    uint64_t m_max_bytes;
+    std::streampos m_start_pos;
+    bool m_is_overflow;
+    bool m_has_overflowed;
+    boost::function<void()> m_on_overflow;
+    std::string m_bytes;
+};
+
+} // namespace qcloud_cos
+#endif // SINGLE_FLIGHT_H
@@ -0,0 +1,37 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: 相同读请求合并策略
+
+#ifndef SINGLE_FLIGHT_POLICY_H
+#define SINGLE_FLIGHT_POLICY_H
+#pragma once
+
+#include <stdint.h>
+
+namespace qcloud_cos {
+
+/// 默认最多在内存中暂存并分发给等待方的GetObject响应体大小, 单位:字节
+const uint64_t kDefaultSingleFlightMaxSharedBytes = 8 * 1024 * 1024;
+
+/// \brief 相同读请求合并策略. 开启后同一个CosAPI上同时发出的相同HeadObject/GetObject
+///        (bucket, object, 参数和请求头均相同)只发出一次请求, 结果分发给所有调用方
+class SingleFlightPolicy {
+public:
+    SingleFlightPolicy()
+        : m_is_enable(false), m_max_shared_bytes(kDefaultSingleFlightMaxSharedBytes) {}
+
+    void SetEnable(bool is_enable) { m_is_enable = is_enable; }
+    bool IsEnable() const { return m_is_enable; }
+
+    /// \brief GetObject响应体超过该大小时不再分发, 等待方各自重新下载
+    void SetMaxSharedBytes(uint64_t max_shared_bytes) { m_max_shared_bytes = max_shared_bytes; }
+    uint64_t GetMaxSharedBytes() const { return m_max_shared_bytes; }
+
+private:
+    bool m_is_enable;
+    uint64_t m_max_shared_bytes;
+};
+
+} // namespace qcloud_cos
+#endif // SINGLE_FLIGHT_POLICY_H
@@ -0,0 +1,49 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: 分块传输的低速检测策略, 用于对长尾分块发起推测执行
+
+#ifndef STALL_POLICY_H
+#define STALL_POLICY_H
+#pragma once
+
+#include <stdint.h>
+
+#include "util/transfer_progress.h"
+
+namespace qcloud_cos {
+
+/// 默认分块开始传输后观察多久才判断是否低速, 单位:毫秒
+const uint64_t kDefaultStallGracePeriodInms = 3000;
+/// 默认检查分块进度的间隔, 单位:毫秒
+const uint64_t kDefaultStallCheckIntervalInms = 100;
+
+/// \brief 分块低速检测策略. 分块传输超过观察期后平均吞吐仍低于阈值时判定为低速,
+///        调度方会在新连接上发起一个相同的推测任务, 先完成的任务胜出.
+class StallPolicy {
+public:
+    StallPolicy();
+
+    /// \brief 设置最低吞吐, 单位:字节/秒, 0表示关闭低速检测(默认)
+    void SetMinRateBytesPerSec(uint64_t rate) { m_min_rate_bytes_per_sec = rate; }
+    uint64_t GetMinRateBytesPerSec() const { return m_min_rate_bytes_per_sec; }
+
+    void SetGracePeriodInms(uint64_t period) { m_grace_period_in_ms = period; }
+    uint64_t GetGracePeriodInms() const { return m_grace_period_in_ms; }
+
+    void SetCheckIntervalInms(uint64_t interval) { m_check_interval_in_ms = interval; }
+    uint64_t GetCheckIntervalInms() const { return m_check_interval_in_ms; }
+
+    bool IsEnable() const { return m_min_rate_bytes_per_sec > 0; }
+
+    /// \brief 判断正在执行的分块是否低速
+    bool IsStalled(const TransferProgress& progress) const;
+
+private:
+    uint64_t m_min_rate_bytes_per_sec;
+    uint64_t m_grace_period_in_ms;
+    uint64_t m_check_interval_in_ms;
+};
+
+} // namespace qcloud_cos
+#endif // STALL_POLICY_H
@@ -221,6 +221,48 @@ public:
 
     static bool IsV4ETag(const std::string& etag);
     static bool IsMultipartUploadETag(const std::string& etag);
+
+    /**
+     * @brief 去掉ETag两端的空格、弱校验前缀"W/"和双引号, 得到可比较的ETag值
+     */
+    static std::string NormalizeETag(const std::string& etag);
+
+    /**
+     * @brief 判断If-None-Match请求头是否匹配etag. 请求头可以是逗号分隔的多个ETag或"*",
+     *        比较前两边都按NormalizeETag处理
+     */
+    static bool ETagMatches(const std::string& if_none_match, const std::string& etag);
+
+    /**
+     * @brief 返回带双引号的ETag, 用于If-None-Match等请求头
+     */
+    static std::string QuoteETag(const std::string& etag);
+
+    /**
+     * @brief 将ISO8601格式的UTC时间(如2017-06-23T12:33:27.000Z)转为Unix时间戳
+     *
+     * @param time_str string类型
+     *
+     * @return 时间戳, 单位秒; 格式错误时返回0
+     */
+    static uint64_t Iso8601ToTimestamp(const std::string& time_str);
+
+    /**
+     * @brief 将HTTP头部的GMT时间(如Wed, 28 Oct 2014 20:30:00 GMT)转为Unix时间戳
+     *
+     * @param time_str string类型
+     *
+     * @return 时间戳, 单位秒; 格式错误时返回0
+     */
+    static uint64_t HttpDateToTimestamp(const std::string& time_str);
+
+    /**
+     * @brief 转义XML文本中的特殊字符(&<>"'), 结果追加到out之后
+     *
+     * @param str 原始文本
+     * @param out 输出
+     */
+    static void AppendXmlEscaped(const std::string& str, std::string* out);
 };
 
 }
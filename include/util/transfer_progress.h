@@ -0,0 +1,94 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: 分块传输的进度统计, 以及直接读写分块内存的流缓冲区
+
+#ifndef TRANSFER_PROGRESS_H
+#define TRANSFER_PROGRESS_H
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <streambuf>
+
+#include "util/noncopyable.h"
+#include "util/simple_mutex.h"
+
+namespace qcloud_cos {
+
+/// \brief 单个分块任务的传输进度, 由执行任务的线程更新, 调度线程读取
+class TransferProgress : private NonCopyable {
+public:
+    TransferProgress();
+
+    /// \brief 清空进度, 任务被重新调度前调用
+    void Reset();
+
+    /// \brief 任务开始执行
+    void Start();
+
+    /// \brief 任务执行结束, 无论成功与否
+    void Finish();
+
+    void AddBytes(uint64_t bytes);
+
+    bool IsStarted() const;
+    bool IsFinished() const;
+    uint64_t GetBytes() const;
+
+    /// \brief 任务开始执行至今(或至结束)的耗时, 未开始时返回0
+    uint64_t GetElapsedInms() const;
+
+private:
+    mutable SimpleMutex m_mutex;
+    bool m_is_started;
+    bool m_is_finished;
+    uint64_t m_bytes;
+    uint64_t m_start_us;
+    uint64_t m_finish_us;
+};
+
+/// \brief 从一段内存中读取数据的流缓冲区, 支持seek, 读取的字节数计入progress
+class MemoryInputBuf : public std::streambuf {
+public:
+    MemoryInputBuf(const unsigned char* data, size_t len, TransferProgress* progress = NULL);
+
+protected:
+    virtual std::streamsize xsgetn(char* s, std::streamsize n);
+    virtual int_type underflow();
+    virtual int_type uflow();
+    virtual pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+                             std::ios_base::openmode which = std::ios_base::in);
+    virtual pos_type seekpos(pos_type pos,
+                             std::ios_base::openmode which = std::ios_base::in);
+
+private:
+    char* m_begin;
+    char* m_end;
+    TransferProgress* m_progress;
+};
+
+/// \brief 向一段定长内存写入数据的流缓冲区, 超出容量时写入失败, 写入的字节数计入progress
+class MemoryOutputBuf : public std::streambuf {
+public:
+    MemoryOutputBuf(unsigned char* data, size_t capacity, TransferProgress* progress = NULL);
+
+    /// \brief 已写入的字节数
+    size_t GetSize() const;
+
+protected:
+    virtual std::streamsize xsputn(const char* s, std::streamsize n);
+    virtual int_type overflow(int_type c);
+    virtual pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+                             std::ios_base::openmode which = std::ios_base::out);
+    virtual pos_type seekpos(pos_type pos,
+                             std::ios_base::openmode which = std::ios_base::out);
+
+private:
+    char* m_begin;
+    TransferProgress* m_progress;
+};
+
+} // namespace qcloud_cos
+#endif // TRANSFER_PROGRESS_H
@@ -0,0 +1,103 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: 增量SAX方式的XML解析器, 用于边接收边解析较大的响应体
+
+#ifndef XML_SAX_PARSER_H
+#define XML_SAX_PARSER_H
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#include "util/noncopyable.h"
+
+namespace qcloud_cos {
+
+/// \brief SAX事件回调
+class XmlSaxHandler {
+public:
+    virtual ~XmlSaxHandler() {}
+
+    /// \brief 遇到开始标签, 自闭合标签会依次回调OnStartElement和OnEndElement
+    virtual void OnStartElement(const std::string& name) = 0;
+
+    /// \brief 遇到结束标签, text为该元素直接包含的文本(实体已解码).
+    ///        包含子元素的元素, text只是子元素之间的空白
+    virtual void OnEndElement(const std::string& name, const std::string& text) = 0;
+
+    /// \brief 解析器被重置, 例如请求重试时, 需要丢弃已解析的结果
+    virtual void OnReset() {}
+
+    /// \brief 文档完整结束时回调, 返回false表示内容不符合预期(如根节点错误)
+    virtual bool OnEndDocument() { return true; }
+};
+
+/// \brief 增量XML解析器, 数据可以按任意边界分块输入, 不构建DOM, 也不保留原始数据.
+///        支持COS响应用到的XML子集: 元素、文本、预定义实体和字符引用、CDATA;
+///        XML声明、处理指令、注释、DOCTYPE和属性会被忽略
+class XmlSaxParser : private NonCopyable {
+public:
+    explicit XmlSaxParser(XmlSaxHandler* handler);
+
+    /// \brief 输入一段数据, 返回false表示格式错误, 之后的输入都会被忽略
+    bool Feed(const char* data, size_t len);
+
+    /// \brief 输入结束, 文档不完整或OnEndDocument返回false时返回false
+    bool Finish();
+
+    /// \brief 清空解析状态并回调OnReset
+    void Reset();
+
+    bool IsError() const { return !m_err_msg.empty(); }
+    const std::string& GetErrMsg() const { return m_err_msg; }
+
+    /// \brief 已输入的字节数
+    uint64_t GetFedBytes() const { return m_fed_bytes; }
+
+private:
+    bool HandleTag();
+    bool SetError(const std::string& err_msg);
+
+    /// \brief 解码实体, 结果追加到out中
+    static bool DecodeText(const std::string& raw, std::string* out);
+
+private:
+    XmlSaxHandler* m_handler;
+    bool m_in_tag;
+    char m_quote;
+    bool m_has_root;
+    // 当前标签'<'和'>'之间的内容
+    std::string m_tag;
+    // 上一个标签之后尚未解码的文本
+    std::string m_raw_text;
+    // 当前元素已解码的文本
+    std::string m_text;
+    std::vector<std::string> m_stack;
+    std::string m_err_msg;
+    uint64_t m_fed_bytes;
+};
+
+/// \brief 把写入的数据交给XmlSaxParser解析的流缓冲区, 用作HttpSender的输出流.
+///        只支持回退到起始位置, 回退时重置解析器, 以便请求重试
+class XmlSaxOutputBuf : public std::streambuf {
+public:
+    explicit XmlSaxOutputBuf(XmlSaxParser* parser) : m_parser(parser) {}
+
+protected:
+    virtual std::streamsize xsputn(const char* s, std::streamsize n);
+    virtual int_type overflow(int_type c);
+    virtual pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+                             std::ios_base::openmode which);
+    virtual pos_type seekpos(pos_type pos, std::ios_base::openmode which);
+
+private:
+    XmlSaxParser* m_parser;
+};
+
+} // namespace qcloud_cos
+#endif // XML_SAX_PARSER_H
@@ -2,12 +2,12 @@
 
 #include <pthread.h>
 
-#include "threadpool/boost/threadpool.hpp"
 #include "Poco/Net/HTTPStreamFactory.h"
 #include "Poco/Net/HTTPSStreamFactory.h"
 #include "Poco/Net/SSLManager.h"
 
 #include "cos_sys_config.h"
+#include "util/rate_limiter.h"
 #include "util/string_util.h"
 
 namespace qcloud_cos {
@@ -16,10 +16,18 @@ bool CosAPI::s_init = false;
 bool CosAPI::s_poco_init = false;
 int CosAPI::s_cos_obj_num = 0;
 SimpleMutex CosAPI::s_init_mutex = SimpleMutex();
-boost::threadpool::pool* g_threadpool = NULL;
 
 CosAPI::CosAPI(CosConfig& config)
     : m_object_op(config), m_bucket_op(config), m_service_op(config) {
+    // 同一CosAPI的所有请求共享实例级别的限速器
+    const ClientSettings& settings = config.GetClientSettings();
+    SharedRateLimiter upload_limiter = RateLimiter::Create(settings.GetUploadRateLimit(),
+                                                           RateLimiter::GlobalUploadLimiter());
+    SharedRateLimiter download_limiter = RateLimiter::Create(settings.GetDownloadRateLimit(),
+                                                             RateLimiter::GlobalDownloadLimiter());
+    m_object_op.SetRateLimiters(upload_limiter, download_limiter);
+    m_bucket_op.SetRateLimiters(upload_limiter, download_limiter);
+    m_service_op.SetRateLimiters(upload_limiter, download_limiter);
     CosInit();
 }
 
@@ -38,7 +46,6 @@ int CosAPI::CosInit() {
             s_poco_init = true;
         }
 
-        g_threadpool = new boost::threadpool::pool(CosSysConfig::GetAsynThreadPoolSize());
         s_init = true;
     }
 
@@ -49,12 +56,6 @@ void CosAPI::CosUInit() {
     SimpleMutexLocker locker(&s_init_mutex);
     --s_cos_obj_num;
     if (s_init && s_cos_obj_num == 0) {
-        if (g_threadpool){
-            g_threadpool->wait();
-            delete g_threadpool;
-            g_threadpool = NULL;
-        }
-
         s_init = false;
     }
 }
@@ -106,6 +107,21 @@ CosResult CosAPI::GetBucket(const GetBucketReq& request, GetBucketResp* response
     return m_bucket_op.GetBucket(request, response);
 }
 
+CosResult CosAPI::GetBucket(const GetBucketReq& request, CompactGetBucketResp* response) {
+    return m_bucket_op.GetBucket(request, response);
+}
+
+SharedBucketObjectIterator CosAPI::GetBucketObjectIterator(const GetBucketReq& request,
+                                                           unsigned prefetch_depth) {
+    return m_bucket_op.GetBucketObjectIterator(request, prefetch_depth);
+}
+
+CosResult CosAPI::ParallelListObjects(const ParallelListObjectsReq& request,
+                                      ListObjectsHandler* handler,
+                                      ParallelListObjectsResp* response) {
+    return m_bucket_op.ParallelListObjects(request, handler, response);
+}
+
 CosResult CosAPI::DeleteBucket(const DeleteBucketReq& request, DeleteBucketResp* response) {
     return m_bucket_op.DeleteBucket(request, response);
 }
@@ -205,6 +221,17 @@ CosResult CosAPI::GetObject(const MultiGetObjectReq& request,
     return m_object_op.GetObject(request, response);
 }
 
+CosResult CosAPI::DownloadPrefix(const DownloadPrefixReq& request,
+                                 DownloadPrefixResp* response) {
+    return m_object_op.DownloadPrefix(request, NULL, response);
+}
+
+CosResult CosAPI::DownloadPrefix(const DownloadPrefixReq& request,
+                                 DownloadPrefixHandler* handler,
+                                 DownloadPrefixResp* response) {
+    return m_object_op.DownloadPrefix(request, handler, response);
+}
+
 CosResult CosAPI::DeleteObject(const DeleteObjectReq& request,
                                DeleteObjectResp* response) {
     return m_object_op.DeleteObject(request, response);
@@ -215,11 +242,51 @@ CosResult CosAPI::DeleteObjects(const DeleteObjectsReq& request,
     return m_object_op.DeleteObjects(request, response);
 }
 
+CosResult CosAPI::BulkDelete(const BulkDeleteReq& request, BulkDeleteResp* response) {
+    return m_object_op.BulkDelete(request, response);
+}
+
+CosResult CosAPI::BulkDelete(const BulkDeleteReq& request, DeleteKeyIterator* keys,
+                             BulkDeleteResp* response) {
+    return m_object_op.BulkDelete(request, keys, response);
+}
+
+CosResult CosAPI::DeleteObjectsByPrefix(const BulkDeleteReq& request, const std::string& prefix,
+                                        BulkDeleteResp* response) {
+    return m_object_op.DeleteObjectsByPrefix(request, prefix, response);
+}
+
 CosResult CosAPI::HeadObject(const HeadObjectReq& request,
                              HeadObjectResp* response) {
     return m_object_op.HeadObject(request, response);
 }
 
+CosResult CosAPI::BatchHeadObject(const BatchHeadObjectReq& request,
+                                  BatchHeadObjectResp* response) {
+    return m_object_op.BatchHeadObject(request, response);
+}
+
+ObjectMetaCacheStat CosAPI::GetObjectMetaCacheStat() const {
+    return m_object_op.GetMetaCacheStat();
+}
+
+DiskCacheStat CosAPI::GetDiskCacheStat() const {
+    return m_object_op.GetDiskCacheStat();
+}
+
+SingleFlightStat CosAPI::GetSingleFlightStat() const {
+    return m_object_op.GetSingleFlightStat();
+}
+
+unsigned CosAPI::WarmUp(const std::string& bucket_or_host, unsigned n_connections,
+                        bool is_https) {
+    return m_object_op.WarmUp(bucket_or_host, n_connections, is_https);
+}
+
+void CosAPI::KeepWarm(const std::string& bucket_or_host, unsigned min_idle, bool is_https) {
+    m_object_op.KeepWarm(bucket_or_host, min_idle, is_https);
+}
+
 CosResult CosAPI::InitMultiUpload(const InitMultiUploadReq& request,
                                   InitMultiUploadResp* response) {
     return m_object_op.InitMultiUpload(request, response);
@@ -245,6 +312,17 @@ CosResult CosAPI::MultiUploadObject(const MultiUploadObjectReq& request,
     return m_object_op.MultiUploadObject(request, response);
 }
 
+CosResult CosAPI::UploadDirectory(const UploadDirectoryReq& request,
+                                  UploadDirectoryResp* response) {
+    return m_object_op.UploadDirectory(request, NULL, response);
+}
+
+CosResult CosAPI::UploadDirectory(const UploadDirectoryReq& request,
+                                  UploadDirectoryHandler* handler,
+                                  UploadDirectoryResp* response) {
+    return m_object_op.UploadDirectory(request, handler, response);
+}
+
 CosResult CosAPI::AbortMultiUpload(const AbortMultiUploadReq& request,
                                    AbortMultiUploadResp* response) {
     return m_object_op.AbortMultiUpload(request, response);
@@ -7,6 +7,11 @@
 #include "json/json.h"
 
 #include "cos_sys_config.h"
+#include "util/dns_cache.h"
+#include "util/executor.h"
+#include "util/http_session_pool.h"
+#include "util/rate_limiter.h"
+#include "util/request_scheduler.h"
 
 namespace qcloud_cos {
 
@@ -53,41 +58,77 @@ bool CosConfig::InitConf(const std::string& config_file) {
         m_region = root["Region"].asString();
     }
 
+    // 以下超时、分块大小等配置只对使用该CosConfig创建的CosAPI生效, 不修改CosSysConfig
     //设置签名超时时间,单位:秒
     if (root.isMember("SignExpiredTime")) {
-        CosSysConfig::SetAuthExpiredTime(root["SignExpiredTime"].asInt64());
+        m_client_settings.SetAuthExpiredTime(root["SignExpiredTime"].asInt64());
     }
 
     //设置连接超时时间,单位:豪秒
     if (root.isMember("ConnectTimeoutInms")) {
-        CosSysConfig::SetConnTimeoutInms(root["ConnectTimeoutInms"].asInt64());
+        m_client_settings.SetConnTimeoutInms(root["ConnectTimeoutInms"].asInt64());
     }
 
     //设置超时时间,单位:豪秒
     if (root.isMember("ReceiveTimeoutInms")) {
-        CosSysConfig::SetRecvTimeoutInms(root["ReceiveTimeoutInms"].asInt64());
+        m_client_settings.SetRecvTimeoutInms(root["ReceiveTimeoutInms"].asInt64());
     }
 
     //设置上传分片大小,默认:10M
     if (root.isMember("UploadPartSize")) {
-        CosSysConfig::SetUploadPartSize(root["UploadPartSize"].asInt64());
+        m_client_settings.SetUploadPartSize(root["UploadPartSize"].asInt64());
     }
 
     //设置上传分片大小,默认:20M
     if (root.isMember("UploadCopyPartSize")) {
-        CosSysConfig::SetUploadCopyPartSize(root["UploadCopyPartSize"].asInt64());
+        m_client_settings.SetUploadCopyPartSize(root["UploadCopyPartSize"].asInt64());
     }
 
     //设置单文件分片并发上传的线程池大小
     if (root.isMember("UploadThreadPoolSize")) {
-        CosSysConfig::SetUploadThreadPoolSize(root["UploadThreadPoolSize"].asInt());
+        m_client_settings.SetUploadThreadPoolSize(root["UploadThreadPoolSize"].asInt());
     }
 
+    if (root.isMember("down_thread_pool_max_size")) {
+        m_client_settings.SetDownThreadPoolMaxSize(root["down_thread_pool_max_size"].asUInt());
+    }
+
+    if (root.isMember("down_slice_size")) {
+        m_client_settings.SetDownSliceSize(root["down_slice_size"].asUInt());
+    }
+
+    if (root.isMember("IsCheckMd5")) {
+        m_client_settings.SetCheckMd5(root["IsCheckMd5"].asBool());
+    }
+
+    // 自定义请求域名
+    if (root.isMember("DestDomain")) {
+        m_client_settings.SetDestDomain(root["DestDomain"].asString());
+    }
+    if (root.isMember("ExpectContinueThreshold")) {
+        m_client_settings.SetExpectContinueThreshold(root["ExpectContinueThreshold"].asUInt64());
+    }
+
+    // 客户端限速, 单位:字节/秒
+    if (root.isMember("UploadRateLimit")) {
+        m_client_settings.SetUploadRateLimit(root["UploadRateLimit"].asUInt64());
+    }
+    if (root.isMember("DownloadRateLimit")) {
+        m_client_settings.SetDownloadRateLimit(root["DownloadRateLimit"].asUInt64());
+    }
+
+    // 以下为进程级别的配置(日志、异步线程池、长连接池), 修改CosSysConfig
+
     //异步上传下载的线程池大小
     if (root.isMember("AsynThreadPoolSize")) {
         CosSysConfig::SetAsynThreadPoolSize(root["AsynThreadPoolSize"].asInt());
     }
 
+    // 分块传输共享的执行器线程数, 只在执行器启动之前生效
+    if (root.isMember("ExecutorThreadNum")) {
+        Executor::Instance().SetThreadNum(root["ExecutorThreadNum"].asUInt());
+    }
+
     //设置log输出,0:不输出, 1:屏幕,2:syslog,,默认:0
     if (root.isMember("LogoutType")) {
         CosSysConfig::SetLogOutType((LOG_OUT_TYPE)(root["LogoutType"].asInt64()));
@@ -98,14 +139,6 @@ bool CosConfig::InitConf(const std::string& config_file) {
         CosSysConfig::SetLogLevel((LOG_LEVEL)(root["LogLevel"].asInt64()));
     }
 
-    if (root.isMember("down_thread_pool_max_size")) {
-        CosSysConfig::SetDownThreadPoolMaxSize((root["down_thread_pool_max_size"].asUInt()));
-    }
-
-    if (root.isMember("down_slice_size")) {
-        CosSysConfig::SetDownSliceSize((root["down_slice_size"].asUInt()));
-    }
-
     // 长连接相关
     if (root.isMember("keepalive_mode")) {
         bool keepalive_mode = (root["keepalive_mode"].asInt() == 0 ? false : true);
@@ -117,9 +150,115 @@ bool CosConfig::InitConf(const std::string& config_file) {
     if (root.isMember("keepalive_interval_time")) {
         CosSysConfig::SetKeepIntvl(root["keepalive_interval_time"].asInt());
     }
+    if (root.isMember("KeepWarmIntervalInms")) {
+        HttpSessionPool::Instance().SetKeepWarmIntervalInms(
+            root["KeepWarmIntervalInms"].asUInt64());
+    }
 
-    if (root.isMember("IsCheckMd5")) {
-        CosSysConfig::SetCheckMd5(root["IsCheckMd5"].asBool());
+    // 域名解析缓存相关
+    if (root.isMember("DnsCacheTtlInms")) {
+        DnsCache::Instance().SetTtlInms(root["DnsCacheTtlInms"].asUInt64());
+    }
+    if (root.isMember("DnsCacheEjectInms")) {
+        DnsCache::Instance().SetEjectInms(root["DnsCacheEjectInms"].asUInt64());
+    }
+
+    // 进程级别的客户端限速, 单位:字节/秒
+    if (root.isMember("GlobalUploadRateLimit")) {
+        RateLimiter::GlobalUploadLimiter()->SetRate(root["GlobalUploadRateLimit"].asUInt64());
+    }
+    if (root.isMember("GlobalDownloadRateLimit")) {
+        RateLimiter::GlobalDownloadLimiter()->SetRate(root["GlobalDownloadRateLimit"].asUInt64());
+    }
+
+    // 进程级别的请求调度, 并发上限为0时不排队
+    if (root.isMember("MaxConcurrentRequests")) {
+        RequestScheduler::Instance().SetMaxConcurrency(root["MaxConcurrentRequests"].asUInt());
+    }
+    if (root.isMember("InteractivePriorityWeight")) {
+        RequestScheduler::Instance().SetWeight(PRIORITY_INTERACTIVE,
+                                               root["InteractivePriorityWeight"].asUInt());
+    }
+    if (root.isMember("NormalPriorityWeight")) {
+        RequestScheduler::Instance().SetWeight(PRIORITY_NORMAL,
+                                               root["NormalPriorityWeight"].asUInt());
+    }
+    if (root.isMember("BulkPriorityWeight")) {
+        RequestScheduler::Instance().SetWeight(PRIORITY_BULK, root["BulkPriorityWeight"].asUInt());
+    }
+
+    // 重试策略相关
+    if (root.isMember("MaxRetryTimes")) {
+        m_retry_policy.SetMaxRetryTimes(root["MaxRetryTimes"].asUInt());
+    }
+    if (root.isMember("RetryBaseDelayInms")) {
+        m_retry_policy.SetBaseDelayInms(root["RetryBaseDelayInms"].asUInt64());
+    }
+    if (root.isMember("RetryMaxDelayInms")) {
+        m_retry_policy.SetMaxDelayInms(root["RetryMaxDelayInms"].asUInt64());
+    }
+    if (root.isMember("RetryBudgetCapacity") || root.isMember("RetryBudgetRefillPerSec")) {
+        unsigned capacity = kDefaultRetryBudgetCapacity;
+        unsigned refill_per_sec = kDefaultRetryBudgetRefillPerSec;
+        if (root.isMember("RetryBudgetCapacity")) {
+            capacity = root["RetryBudgetCapacity"].asUInt();
+        }
+        if (root.isMember("RetryBudgetRefillPerSec")) {
+            refill_per_sec = root["RetryBudgetRefillPerSec"].asUInt();
+        }
+        m_retry_policy.SetRetryBudget(capacity, refill_per_sec);
+    }
+
+    // 对冲请求相关
+    if (root.isMember("IsEnableHedge")) {
+        m_hedge_policy.SetEnable(root["IsEnableHedge"].asBool());
+    }
+    if (root.isMember("HedgePercentile")) {
+        m_hedge_policy.SetPercentile(root["HedgePercentile"].asDouble());
+    }
+    if (root.isMember("HedgeMinDelayInms")) {
+        m_hedge_policy.SetMinDelayInms(root["HedgeMinDelayInms"].asUInt64());
+    }
+    if (root.isMember("HedgeMaxDelayInms")) {
+        m_hedge_policy.SetMaxDelayInms(root["HedgeMaxDelayInms"].asUInt64());
+    }
+    if (root.isMember("HedgeBudgetRatio")) {
+        m_hedge_policy.SetBudgetRatio(root["HedgeBudgetRatio"].asDouble());
+    }
+
+    // 分块低速检测相关
+    if (root.isMember("PartMinRateBytesPerSec")) {
+        m_stall_policy.SetMinRateBytesPerSec(root["PartMinRateBytesPerSec"].asUInt64());
+    }
+    if (root.isMember("PartStallGracePeriodInms")) {
+        m_stall_policy.SetGracePeriodInms(root["PartStallGracePeriodInms"].asUInt64());
+    }
+
+    // Object元数据缓存相关
+    if (root.isMember("ObjectMetaCacheCapacity")) {
+        m_meta_cache_policy.SetCapacity(root["ObjectMetaCacheCapacity"].asUInt64());
+    }
+    if (root.isMember("ObjectMetaCacheTtlInms")) {
+        m_meta_cache_policy.SetTtlInms(root["ObjectMetaCacheTtlInms"].asUInt64());
+    }
+
+    // GetObject磁盘缓存相关
+    if (root.isMember("DiskCacheDir")) {
+        m_disk_cache_policy.SetCacheDir(root["DiskCacheDir"].asString());
+    }
+    if (root.isMember("DiskCacheMaxBytes")) {
+        m_disk_cache_policy.SetMaxBytes(root["DiskCacheMaxBytes"].asUInt64());
+    }
+    if (root.isMember("DiskCacheFreshInms")) {
+        m_disk_cache_policy.SetFreshInms(root["DiskCacheFreshInms"].asUInt64());
+    }
+
+    // 相同读请求合并相关
+    if (root.isMember("IsEnableSingleFlight")) {
+        m_single_flight_policy.SetEnable(root["IsEnableSingleFlight"].asBool());
+    }
+    if (root.isMember("SingleFlightMaxSharedBytes")) {
+        m_single_flight_policy.SetMaxSharedBytes(root["SingleFlightMaxSharedBytes"].asUInt64());
     }
 
     CosSysConfig::PrintValue();
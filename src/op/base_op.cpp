@@ -8,6 +8,7 @@
 #include "op/base_op.h"
 
 #include <iostream>
+#include <sstream>
 
 #include "cos_sys_config.h"
 #include "request/base_req.h"
@@ -15,9 +16,30 @@
 #include "util/auth_tool.h"
 #include "util/http_sender.h"
 #include "util/codec_util.h"
+#include "util/hedged_sender.h"
+#include "util/http_session_pool.h"
+#include "util/retry_policy.h"
+#include "util/xml_sax_parser.h"
 
 namespace qcloud_cos{
 
+namespace {
+
+// 没有附加参数时直接返回请求中的参数, 否则合并到merged_params中返回, 请求中已有的参数优先
+const std::map<std::string, std::string>& MergeParams(
+        const BaseReq& req,
+        const std::map<std::string, std::string>& additional_params,
+        std::map<std::string, std::string>* merged_params) {
+    if (additional_params.empty()) {
+        return req.GetParams();
+    }
+    *merged_params = req.GetParams();
+    merged_params->insert(additional_params.begin(), additional_params.end());
+    return *merged_params;
+}
+
+} // namespace
+
 CosConfig BaseOp::GetCosConfig() const {
     return m_config;
 }
@@ -34,6 +56,30 @@ std::string BaseOp::GetSecretKey() const {
     return m_config.GetSecretKey();
 }
 
+SharedCancelToken BaseOp::CreateCancelToken(const BaseReq& req) {
+    if (!req.GetCancelToken() && req.GetDeadlineInms() == 0) {
+        return SharedCancelToken();
+    }
+
+    SharedCancelToken cancel_token(new CancelToken());
+    cancel_token->SetParent(req.GetCancelToken());
+    cancel_token->SetDeadlineInms(req.GetDeadlineInms());
+    return cancel_token;
+}
+
+SharedRateLimiter BaseOp::CreateRateLimiter(const BaseReq& req, bool is_upload) const {
+    SharedRateLimiter parent = is_upload ? m_upload_limiter : m_download_limiter;
+    if (!parent) {
+        parent = is_upload ? RateLimiter::GlobalUploadLimiter()
+            : RateLimiter::GlobalDownloadLimiter();
+    }
+
+    if (req.GetRateLimit() != 0) {
+        return RateLimiter::Create(req.GetRateLimit(), parent);
+    }
+    return parent->IsLimited() ? parent : SharedRateLimiter();
+}
+
 CosResult BaseOp::NormalAction(const std::string& host,
                                const std::string& path,
                                const BaseReq& req,
@@ -55,27 +101,20 @@ CosResult BaseOp::NormalAction(const std::string& host,
                                bool check_body,
                                BaseResp* resp) {
     CosResult result;
-    std::map<std::string, std::string> req_headers = req.GetHeaders();
-    std::map<std::string, std::string> req_params = req.GetParams();
-    req_headers.insert(additional_headers.begin(), additional_headers.end());
-    req_params.insert(additional_params.begin(), additional_params.end());
-    const std::string& tmp_token = m_config.GetTmpToken();
-    if (!tmp_token.empty()) {
-        req_headers["x-cos-security-token"] = tmp_token;
-    }
-
-    // 1. 获取host
-    req_headers["Host"] = host;
+    // 1. 生成请求头和参数, 没有附加参数时直接使用请求中的参数
+    HeaderList req_headers;
+    BuildReqHeaders(host, req, additional_headers, &req_headers);
+    std::map<std::string, std::string> merged_params;
+    const std::map<std::string, std::string>& req_params
+        = MergeParams(req, additional_params, &merged_params);
 
     // 2. 计算签名
-    std::string auth_str = AuthTool::Sign(GetAccessKey(), GetSecretKey(),
-                                          req.GetMethod(), req.GetPath(),
-                                          req_headers, req_params);
+    std::string auth_str = Sign(req.GetMethod(), req.GetPath(), req_headers, req_params);
     if (auth_str.empty()) {
         result.SetErrorInfo("Generate auth str fail, check your access_key/secret_key.");
         return result;
     }
-    req_headers["Authorization"] = auth_str;
+    req_headers.Set("Authorization", auth_str);
 
     // 3. 发送请求
     std::map<std::string, std::string> resp_headers;
@@ -83,9 +122,46 @@ CosResult BaseOp::NormalAction(const std::string& host,
 
     std::string dest_url = GetRealUrl(host, path, req.IsHttps());
     std::string err_msg = "";
-    int http_code = HttpSender::SendRequest(req.GetMethod(), dest_url, req_params, req_headers,
-                                    req_body, req.GetConnTimeoutInms(), req.GetRecvTimeoutInms(),
-                                    &resp_headers, &resp_body, &err_msg);
+    const RetryPolicy& retry_policy = m_config.GetRetryPolicy();
+    bool is_idempotent = RetryPolicy::IsIdempotentMethod(req.GetMethod());
+    // HEAD请求没有请求体和响应体, 开启对冲时以对冲方式发送
+    const HedgePolicy& hedge_policy = m_config.GetHedgePolicy();
+    bool is_hedge = hedge_policy.IsEnable() && req.GetMethod() == "HEAD";
+    SharedCancelToken cancel_token = CreateCancelToken(req);
+    int http_code = -1;
+    for (unsigned attempt = 1; ; ++attempt) {
+        resp_headers.clear();
+        resp_body.clear();
+        err_msg.clear();
+        if (is_hedge) {
+            std::ostringstream oss;
+            http_code = HedgedSender::SendRequest(hedge_policy, req.GetMethod(), dest_url,
+                                                  req_params, req_headers,
+                                                  GetConnTimeoutInms(req), GetRecvTimeoutInms(req),
+                                                  &resp_headers, &resp_body, oss, &err_msg,
+                                                  false, cancel_token, SharedRateLimiter(),
+                                                  req.GetPriority());
+            if (http_code >= 200 && http_code <= 299) {
+                resp_body = oss.str();
+            }
+        } else {
+            std::istringstream is(req_body);
+            std::ostringstream oss;
+            http_code = HttpSender::SendRequest(req.GetMethod(), dest_url, req_params, req_headers,
+                                            is, GetConnTimeoutInms(req), GetRecvTimeoutInms(req),
+                                            &resp_headers, oss, &err_msg,
+                                            false, cancel_token.get(), NULL, req.GetPriority());
+            resp_body = oss.str();
+        }
+        RETRY_ERROR_TYPE err_type = RetryPolicy::ClassifyError(http_code, err_msg);
+        if (!is_idempotent || !retry_policy.ShouldRetry(attempt, err_type)) {
+            break;
+        }
+        SDK_LOG_WARN("Request fail, http_code=%d, err_msg=%s, url=%s, retry.",
+                     http_code, err_msg.c_str(), dest_url.c_str());
+        retry_policy.Backoff(attempt, err_type, cancel_token.get());
+    }
+
     if (http_code == -1) {
         result.SetErrorInfo(err_msg);
         return result;
@@ -107,7 +183,7 @@ CosResult BaseOp::NormalAction(const std::string& host,
 
         result.SetSucc();
         resp->ParseFromXmlString(resp_body);
-        resp->ParseFromHeaders(resp_headers);
+        resp->SwapAndParseHeaders(&resp_headers);
         resp->SetBody(resp_body);
         // resp requestid to result
         result.SetXCosRequestId(resp->GetXCosRequestId());
@@ -120,27 +196,21 @@ CosResult BaseOp::DownloadAction(const std::string& host,
                                  const std::string& path,
                                  const BaseReq& req,
                                  BaseResp* resp,
-                                 std::ostream& os) {
+                                 std::ostream& os,
+                                 bool is_hedgeable) {
     CosResult result;
-    std::map<std::string, std::string> req_headers = req.GetHeaders();
-    std::map<std::string, std::string> req_params = req.GetParams();
-    const std::string& tmp_token = m_config.GetTmpToken();
-    if (!tmp_token.empty()) {
-        req_headers["x-cos-security-token"] = tmp_token;
-    }
-
-    // 1. 获取host
-    req_headers["Host"] = host;
+    // 1. 生成请求头, 参数直接使用请求中的参数
+    HeaderList req_headers;
+    BuildReqHeaders(host, req, std::map<std::string, std::string>(), &req_headers);
+    const std::map<std::string, std::string>& req_params = req.GetParams();
 
     // 2. 计算签名
-    std::string auth_str = AuthTool::Sign(GetAccessKey(), GetSecretKey(),
-                                          req.GetMethod(), req.GetPath(),
-                                          req_headers, req_params);
+    std::string auth_str = Sign(req.GetMethod(), req.GetPath(), req_headers, req_params);
     if (auth_str.empty()) {
         result.SetErrorInfo("Generate auth str fail, check your access_key/secret_key.");
         return result;
     }
-    req_headers["Authorization"] = auth_str;
+    req_headers.Set("Authorization", auth_str);
 
     // 3. 发送请求
     std::map<std::string, std::string> resp_headers;
@@ -148,10 +218,50 @@ CosResult BaseOp::DownloadAction(const std::string& host,
 
     std::string dest_url = GetRealUrl(host, path, req.IsHttps());
     std::string err_msg = "";
-    int http_code = HttpSender::SendRequest(req.GetMethod(), dest_url, req_params, req_headers,
-                                            "", req.GetConnTimeoutInms(), req.GetRecvTimeoutInms(),
-                                            &resp_headers, &xml_err_str, os, &err_msg,
-                                            CosSysConfig::IsCheckMd5());
+    // 只有输出流可以回退时才能安全重试, 否则重试会在流中写入重复的数据
+    const RetryPolicy& retry_policy = m_config.GetRetryPolicy();
+    std::streampos os_pos = os.tellp();
+    // 只对冲GetObject, 只有先收到响应头的请求会写入输出流
+    const HedgePolicy& hedge_policy = m_config.GetHedgePolicy();
+    bool is_hedge = is_hedgeable && hedge_policy.IsEnable();
+    SharedCancelToken cancel_token = CreateCancelToken(req);
+    SharedRateLimiter rate_limiter = CreateRateLimiter(req, false);
+    int http_code = -1;
+    for (unsigned attempt = 1; ; ++attempt) {
+        resp_headers.clear();
+        xml_err_str.clear();
+        err_msg.clear();
+        if (is_hedge) {
+            http_code = HedgedSender::SendRequest(hedge_policy, req.GetMethod(), dest_url,
+                                                  req_params, req_headers,
+                                                  GetConnTimeoutInms(req), GetRecvTimeoutInms(req),
+                                                  &resp_headers, &xml_err_str, os, &err_msg,
+                                                  m_config.GetClientSettings().IsCheckMd5(), cancel_token,
+                                                  rate_limiter, req.GetPriority());
+        } else {
+            http_code = HttpSender::SendRequest(req.GetMethod(), dest_url, req_params, req_headers,
+                                                "", GetConnTimeoutInms(req), GetRecvTimeoutInms(req),
+                                                &resp_headers, &xml_err_str, os, &err_msg,
+                                                m_config.GetClientSettings().IsCheckMd5(), cancel_token.get(),
+                                                rate_limiter.get(), req.GetPriority());
+        }
+        RETRY_ERROR_TYPE err_type = RetryPolicy::ClassifyError(http_code, err_msg);
+        // 5xx时响应体写入xml_err_str, 输出流未被写入
+        bool is_os_dirty = (http_code == -1);
+        if (is_os_dirty && os_pos == std::streampos(-1)) {
+            break;
+        }
+        if (!retry_policy.ShouldRetry(attempt, err_type)) {
+            break;
+        }
+        SDK_LOG_WARN("Download fail, http_code=%d, err_msg=%s, url=%s, retry.",
+                     http_code, err_msg.c_str(), dest_url.c_str());
+        if (is_os_dirty) {
+            os.clear();
+            os.seekp(os_pos);
+        }
+        retry_policy.Backoff(attempt, err_type, cancel_token.get());
+    }
 
     if (http_code == -1) {
         result.SetErrorInfo(err_msg);
@@ -167,7 +277,7 @@ CosResult BaseOp::DownloadAction(const std::string& host,
         }
     } else {
         result.SetSucc();
-        resp->ParseFromHeaders(resp_headers);
+        resp->SwapAndParseHeaders(&resp_headers);
         // resp requestid to result
         result.SetXCosRequestId(resp->GetXCosRequestId());
     }
@@ -175,6 +285,25 @@ CosResult BaseOp::DownloadAction(const std::string& host,
     return result;
 }
 
+CosResult BaseOp::SaxParseAction(const std::string& host,
+                                 const std::string& path,
+                                 const BaseReq& req,
+                                 BaseResp* resp,
+                                 XmlSaxHandler* handler) {
+    XmlSaxParser parser(handler);
+    parser.Reset();
+    XmlSaxOutputBuf parse_buf(&parser);
+    std::ostream os(&parse_buf);
+    CosResult result = DownloadAction(host, path, req, resp, os);
+    if (result.IsSucc() && !parser.Finish()) {
+        SDK_LOG_ERR("Parse response body fail, err_msg=%s, path=%s",
+                    parser.GetErrMsg().c_str(), path.c_str());
+        result.SetFail();
+        result.SetErrorInfo("Parse response body fail, " + parser.GetErrMsg());
+    }
+    return result;
+}
+
 // TODO(sevenyou) 冗余代码
 CosResult BaseOp::UploadAction(const std::string& host,
                                const std::string& path,
@@ -184,27 +313,20 @@ CosResult BaseOp::UploadAction(const std::string& host,
                                std::istream& is,
                                BaseResp* resp) {
     CosResult result;
-    std::map<std::string, std::string> req_headers = req.GetHeaders();
-    std::map<std::string, std::string> req_params = req.GetParams();
-    req_headers.insert(additional_headers.begin(), additional_headers.end());
-    req_params.insert(additional_params.begin(), additional_params.end());
-    const std::string& tmp_token = m_config.GetTmpToken();
-    if (!tmp_token.empty()) {
-        req_headers["x-cos-security-token"] = tmp_token;
-    }
-
-    // 1. 获取host
-    req_headers["Host"] = host;
+    // 1. 生成请求头和参数, 没有附加参数时直接使用请求中的参数
+    HeaderList req_headers;
+    BuildReqHeaders(host, req, additional_headers, &req_headers);
+    std::map<std::string, std::string> merged_params;
+    const std::map<std::string, std::string>& req_params
+        = MergeParams(req, additional_params, &merged_params);
 
     // 2. 计算签名
-    std::string auth_str = AuthTool::Sign(GetAccessKey(), GetSecretKey(),
-                                          req.GetMethod(), req.GetPath(),
-                                          req_headers, req_params);
+    std::string auth_str = Sign(req.GetMethod(), req.GetPath(), req_headers, req_params);
     if (auth_str.empty()) {
         result.SetErrorInfo("Generate auth str fail, check your access_key/secret_key.");
         return result;
     }
-    req_headers["Authorization"] = auth_str;
+    req_headers.Set("Authorization", auth_str);
 
     // 3. 发送请求
     std::map<std::string, std::string> resp_headers;
@@ -212,9 +334,45 @@ CosResult BaseOp::UploadAction(const std::string& host,
 
     std::string dest_url = GetRealUrl(host, path, req.IsHttps());
     std::string err_msg = "";
-    int http_code = HttpSender::SendRequest(req.GetMethod(), dest_url, req_params, req_headers,
-                                            is, req.GetConnTimeoutInms(), req.GetRecvTimeoutInms(),
-                                            &resp_headers, &resp_body, &err_msg);
+    // 只有输入流可以回退时才能重试
+    const RetryPolicy& retry_policy = m_config.GetRetryPolicy();
+    bool is_idempotent = RetryPolicy::IsIdempotentMethod(req.GetMethod());
+    std::streampos is_pos = is.tellg();
+    if (is_pos != std::streampos(-1)) {
+        is.seekg(0, std::ios::end);
+        std::streampos end_pos = is.tellg();
+        if (end_pos != std::streampos(-1)) {
+            AddExpectContinue(static_cast<uint64_t>(end_pos - is_pos), &req_headers);
+        }
+        is.clear();
+        is.seekg(is_pos);
+    }
+    SharedCancelToken cancel_token = CreateCancelToken(req);
+    SharedRateLimiter rate_limiter = CreateRateLimiter(req, true);
+    int http_code = -1;
+    for (unsigned attempt = 1; ; ++attempt) {
+        resp_headers.clear();
+        resp_body.clear();
+        err_msg.clear();
+        std::ostringstream oss;
+        http_code = HttpSender::SendRequest(req.GetMethod(), dest_url, req_params, req_headers,
+                                            is, GetConnTimeoutInms(req), GetRecvTimeoutInms(req),
+                                            &resp_headers, oss, &err_msg,
+                                            false, cancel_token.get(), rate_limiter.get(),
+                                            req.GetPriority());
+        resp_body = oss.str();
+        RETRY_ERROR_TYPE err_type = RetryPolicy::ClassifyError(http_code, err_msg);
+        if (!is_idempotent || is_pos == std::streampos(-1)
+            || !retry_policy.ShouldRetry(attempt, err_type)) {
+            break;
+        }
+        SDK_LOG_WARN("Upload fail, http_code=%d, err_msg=%s, url=%s, retry.",
+                     http_code, err_msg.c_str(), dest_url.c_str());
+        is.clear();
+        is.seekg(is_pos);
+        retry_policy.Backoff(attempt, err_type, cancel_token.get());
+    }
+
     if (http_code == -1) {
         result.SetErrorInfo(err_msg);
         return result;
@@ -230,7 +388,7 @@ CosResult BaseOp::UploadAction(const std::string& host,
     } else {
         result.SetSucc();
         resp->ParseFromXmlString(resp_body);
-        resp->ParseFromHeaders(resp_headers);
+        resp->SwapAndParseHeaders(&resp_headers);
         resp->SetBody(resp_body);
         // resp requestid to result
         result.SetXCosRequestId(resp->GetXCosRequestId());
@@ -253,11 +411,93 @@ std::string BaseOp::GetRealUrl(const std::string& host,
         temp = "/" + temp;
     }
 
-    if (!CosSysConfig::GetDestDomain().empty()) {
-        return protocal + CosSysConfig::GetDestDomain() + CodecUtil::EncodeKey(temp);
+    std::string dest_domain = m_config.GetClientSettings().GetDestDomain();
+    if (!dest_domain.empty()) {
+        return protocal + dest_domain + CodecUtil::EncodeKey(temp);
     }
 
     return protocal + host + CodecUtil::EncodeKey(temp);
 }
 
+uint64_t BaseOp::GetConnTimeoutInms(const BaseReq& req) const {
+    uint64_t conn_timeout_in_ms = req.GetConnTimeoutInms();
+    return conn_timeout_in_ms > 0 ? conn_timeout_in_ms
+        : m_config.GetClientSettings().GetConnTimeoutInms();
+}
+
+uint64_t BaseOp::GetRecvTimeoutInms(const BaseReq& req) const {
+    uint64_t recv_timeout_in_ms = req.GetRecvTimeoutInms();
+    return recv_timeout_in_ms > 0 ? recv_timeout_in_ms
+        : m_config.GetClientSettings().GetRecvTimeoutInms();
+}
+
+std::string BaseOp::Sign(const std::string& http_method,
+                         const std::string& in_uri,
+                         const std::map<std::string, std::string>& headers,
+                         const std::map<std::string, std::string>& params) const {
+    uint64_t start_time_in_s = HttpSender::GetTimeStampInUs() / 1000000;
+    uint64_t end_time_in_s = start_time_in_s + m_config.GetClientSettings().GetAuthExpiredTime();
+    return AuthTool::Sign(GetAccessKey(), GetSecretKey(), http_method, in_uri, headers, params,
+                          start_time_in_s, end_time_in_s);
+}
+
+std::string BaseOp::Sign(const std::string& http_method,
+                         const std::string& in_uri,
+                         const HeaderList& headers,
+                         const std::map<std::string, std::string>& params) const {
+    uint64_t start_time_in_s = HttpSender::GetTimeStampInUs() / 1000000;
+    uint64_t end_time_in_s = start_time_in_s + m_config.GetClientSettings().GetAuthExpiredTime();
+    return AuthTool::Sign(GetAccessKey(), GetSecretKey(), http_method, in_uri, headers, params,
+                          start_time_in_s, end_time_in_s);
+}
+
+void BaseOp::AddExpectContinue(uint64_t body_len,
+                               std::map<std::string, std::string>* headers) const {
+    uint64_t threshold = m_config.GetClientSettings().GetExpectContinueThreshold();
+    if (threshold > 0 && body_len >= threshold) {
+        (*headers)["Expect"] = "100-continue";
+    }
+}
+
+void BaseOp::AddExpectContinue(uint64_t body_len, HeaderList* headers) const {
+    uint64_t threshold = m_config.GetClientSettings().GetExpectContinueThreshold();
+    if (threshold > 0 && body_len >= threshold) {
+        headers->Set("Expect", "100-continue");
+    }
+}
+
+void BaseOp::BuildReqHeaders(const std::string& host,
+                             const BaseReq& req,
+                             const std::map<std::string, std::string>& additional_headers,
+                             HeaderList* req_headers) const {
+    req_headers->AddAll(req.GetHeaders());
+    req_headers->Merge(additional_headers);
+    const std::string& tmp_token = m_config.GetTmpToken();
+    if (!tmp_token.empty()) {
+        req_headers->Set("x-cos-security-token", tmp_token);
+    }
+    req_headers->Set("Host", host);
+}
+
+std::string BaseOp::GetWarmUpUrl(const std::string& bucket_or_host, bool is_https) {
+    // bucket名中不能包含'.'
+    std::string host = bucket_or_host;
+    if (bucket_or_host.find('.') == std::string::npos) {
+        host = CosSysConfig::GetHost(GetAppId(), m_config.GetRegion(), bucket_or_host);
+    }
+    return GetRealUrl(host, "/", is_https);
+}
+
+unsigned BaseOp::WarmUp(const std::string& bucket_or_host, unsigned n_connections,
+                        bool is_https) {
+    return HttpSessionPool::Instance().WarmUp(GetWarmUpUrl(bucket_or_host, is_https),
+                                              n_connections,
+                                              m_config.GetClientSettings().GetConnTimeoutInms());
+}
+
+void BaseOp::KeepWarm(const std::string& bucket_or_host, unsigned min_idle, bool is_https) {
+    HttpSessionPool::Instance().KeepWarm(GetWarmUpUrl(bucket_or_host, is_https), min_idle,
+                                         m_config.GetClientSettings().GetConnTimeoutInms());
+}
+
 } // namespace qcloud_cos
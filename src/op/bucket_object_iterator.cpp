@@ -0,0 +1,210 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: 自动翻页并预取的Object列表迭代器
+
+#include "op/bucket_object_iterator.h"
+
+#include <vector>
+
+#include "boost/bind.hpp"
+
+#include "cos_sys_config.h"
+
+namespace qcloud_cos {
+
+namespace {
+
+// 直接比较列表中的key, 不构造临时字符串
+bool IsKeyBefore(const CompactObjectRef& ref, const std::string& prefix) {
+    return prefix.compare(0, std::string::npos, ref.GetKeyData(), ref.GetKeySize()) > 0;
+}
+
+} // namespace
+
+BucketObjectIterator::BucketObjectIterator(const BucketOp& op, const GetBucketReq& req,
+                                           unsigned prefetch_depth)
+    : m_op(op), m_req(req), m_prefetch_depth(prefetch_depth),
+      m_cancel_token(new CancelToken()), m_marker(req.GetParam("marker")),
+      m_is_done(false), m_is_stopped(false), m_page_count(0),
+      m_content_idx(0), m_prefix_idx(0) {
+    // 调用方的句柄作为父句柄, 析构时只取消迭代器自己的请求
+    m_cancel_token->SetParent(req.GetCancelToken());
+    m_req.SetCancelToken(m_cancel_token);
+    if (m_prefetch_depth > 0) {
+        m_thread.reset(new boost::thread(boost::bind(&BucketObjectIterator::PrefetchLoop, this)));
+    }
+}
+
+BucketObjectIterator::~BucketObjectIterator() {
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+        m_is_stopped = true;
+    }
+    m_cond.notify_all();
+    m_cancel_token->Cancel();
+    if (m_thread) {
+        m_thread->join();
+    }
+}
+
+bool BucketObjectIterator::Next(BucketObjectEntry* entry) {
+    while (true) {
+        if (m_cur_page) {
+            const CompactObjectList& contents = m_cur_page->GetObjectList();
+            const std::vector<std::string>& prefixes = m_cur_page->GetCommonPrefixes();
+            bool has_content = m_content_idx < contents.Size();
+            bool has_prefix = m_prefix_idx < prefixes.size();
+            if (has_content && (!has_prefix || IsKeyBefore(contents.At(m_content_idx),
+                                                           prefixes[m_prefix_idx]))) {
+                contents.GetEntry(m_content_idx++, entry);
+                return true;
+            }
+            if (has_prefix) {
+                entry->m_is_common_prefix = true;
+                entry->m_key = prefixes[m_prefix_idx++];
+                entry->m_etag.clear();
+                entry->m_storage_class.clear();
+                entry->m_owner_id.clear();
+                entry->m_size = 0;
+                entry->m_last_modified_time = 0;
+                return true;
+            }
+        }
+
+        if (!PopPage()) {
+            return false;
+        }
+    }
+}
+
+bool BucketObjectIterator::IsError() const {
+    boost::mutex::scoped_lock lock(m_mutex);
+    return m_is_done && !m_result.IsSucc();
+}
+
+CosResult BucketObjectIterator::GetResult() const {
+    boost::mutex::scoped_lock lock(m_mutex);
+    return m_result;
+}
+
+uint64_t BucketObjectIterator::GetPageCount() const {
+    boost::mutex::scoped_lock lock(m_mutex);
+    return m_page_count;
+}
+
+CosResult BucketObjectIterator::FetchPage(SharedPage* page, bool* is_last) {
+    GetBucketReq req(m_req);
+    if (!m_marker.empty()) {
+        req.SetMarker(m_marker);
+    }
+    page->reset(new CompactGetBucketResp());
+    CosResult result = m_op.GetBucket(req, page->get());
+    if (!result.IsSucc()) {
+        return result;
+    }
+
+    const CompactGetBucketResp& resp = **page;
+    *is_last = !resp.IsTruncated();
+    if (*is_last) {
+        return result;
+    }
+
+    // 未返回NextMarker时, 以本页最大的key或Common Prefix作为下一页的起点
+    std::string next_marker = resp.GetNextMarker();
+    if (next_marker.empty()) {
+        const CompactObjectList& contents = resp.GetObjectList();
+        const std::vector<std::string>& prefixes = resp.GetCommonPrefixes();
+        if (!contents.Empty()) {
+            next_marker = contents.At(contents.Size() - 1).GetKey();
+        }
+        if (!prefixes.empty() && prefixes.back() > next_marker) {
+            next_marker = prefixes.back();
+        }
+    }
+    if (next_marker.empty() || next_marker == m_marker) {
+        SDK_LOG_ERR("List is truncated but marker does not advance, marker=%s",
+                    m_marker.c_str());
+        result.SetFail();
+        result.SetErrorInfo("List is truncated but marker does not advance, marker=" + m_marker);
+        return result;
+    }
+    m_marker = next_marker;
+    return result;
+}
+
+void BucketObjectIterator::PrefetchLoop() {
+    while (true) {
+        {
+            boost::mutex::scoped_lock lock(m_mutex);
+            while (!m_is_stopped && m_pages.size() >= m_prefetch_depth) {
+                m_cond.wait(lock);
+            }
+            if (m_is_stopped) {
+                return;
+            }
+        }
+
+        SharedPage page;
+        bool is_last = false;
+        CosResult result = FetchPage(&page, &is_last);
+        bool is_done = !result.IsSucc() || is_last;
+        {
+            boost::mutex::scoped_lock lock(m_mutex);
+            m_result = result;
+            if (result.IsSucc()) {
+                m_pages.push_back(page);
+                ++m_page_count;
+            }
+            m_is_done = is_done;
+        }
+        m_cond.notify_all();
+        if (is_done) {
+            return;
+        }
+    }
+}
+
+bool BucketObjectIterator::PopPage() {
+    m_cur_page.reset();
+    m_content_idx = 0;
+    m_prefix_idx = 0;
+
+    if (m_prefetch_depth == 0) {
+        {
+            boost::mutex::scoped_lock lock(m_mutex);
+            if (m_is_done) {
+                return false;
+            }
+        }
+        SharedPage page;
+        bool is_last = false;
+        CosResult result = FetchPage(&page, &is_last);
+        boost::mutex::scoped_lock lock(m_mutex);
+        m_result = result;
+        m_is_done = !result.IsSucc() || is_last;
+        if (!result.IsSucc()) {
+            return false;
+        }
+        m_cur_page = page;
+        ++m_page_count;
+        return true;
+    }
+
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+        while (m_pages.empty() && !m_is_done) {
+            m_cond.wait(lock);
+        }
+        if (m_pages.empty()) {
+            return false;
+        }
+        m_cur_page = m_pages.front();
+        m_pages.pop_front();
+    }
+    // 腾出了缓存位置, 唤醒后台线程拉取下一页
+    m_cond.notify_all();
+    return true;
+}
+
+} // namespace qcloud_cos
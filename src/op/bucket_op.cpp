@@ -6,6 +6,8 @@
 // Description:
 
 #include "op/bucket_op.h"
+#include "op/bucket_object_iterator.h"
+#include "op/parallel_bucket_lister.h"
 #include "util/codec_util.h"
 
 namespace qcloud_cos {
@@ -44,7 +46,26 @@ CosResult BucketOp::GetBucket(const GetBucketReq& req, GetBucketResp* resp) {
     std::string host = CosSysConfig::GetHost(GetAppId(), m_config.GetRegion(),
                                              req.GetBucketName());
     std::string path = req.GetPath();
-    return NormalAction(host, path, req, "", false, resp);
+    return SaxParseAction(host, path, req, resp, resp);
+}
+
+CosResult BucketOp::GetBucket(const GetBucketReq& req, CompactGetBucketResp* resp) {
+    std::string host = CosSysConfig::GetHost(GetAppId(), m_config.GetRegion(),
+                                             req.GetBucketName());
+    std::string path = req.GetPath();
+    return SaxParseAction(host, path, req, resp, resp);
+}
+
+SharedBucketObjectIterator BucketOp::GetBucketObjectIterator(const GetBucketReq& req,
+                                                             unsigned prefetch_depth) {
+    return SharedBucketObjectIterator(new BucketObjectIterator(*this, req, prefetch_depth));
+}
+
+CosResult BucketOp::ParallelListObjects(const ParallelListObjectsReq& req,
+                                        ListObjectsHandler* handler,
+                                        ParallelListObjectsResp* resp) {
+    ParallelBucketLister lister(*this, req, handler);
+    return lister.Run(resp);
 }
 
 CosResult BucketOp::DeleteBucket(const DeleteBucketReq& req, DeleteBucketResp* resp) {
@@ -248,7 +269,7 @@ CosResult BucketOp::GetBucketObjectVersions(const GetBucketObjectVersionsReq& re
     std::string host = CosSysConfig::GetHost(GetAppId(), m_config.GetRegion(),
                                              req.GetBucketName());
     std::string path = req.GetPath();
-    return NormalAction(host, path, req, "", false, resp);
+    return SaxParseAction(host, path, req, resp, resp);
 }
 
 } // qcloud_cos
@@ -0,0 +1,166 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: 按批次并发执行DeleteObjects的批量删除
+
+#include "op/bulk_deleter.h"
+
+#include <algorithm>
+
+#include "boost/bind.hpp"
+
+#include "cos_sys_config.h"
+#include "util/executor.h"
+
+namespace qcloud_cos {
+
+bool VectorDeleteKeyIterator::Next(ObjectVersionPair* key) {
+    if (m_idx >= m_keys.size()) {
+        return false;
+    }
+    *key = m_keys[m_idx++];
+    return true;
+}
+
+bool PrefixDeleteKeyIterator::Next(ObjectVersionPair* key) {
+    while (m_iter.Next(&m_entry)) {
+        if (!m_entry.m_is_common_prefix) {
+            key->m_object_name.swap(m_entry.m_key);
+            key->m_version_id.clear();
+            return true;
+        }
+    }
+    return false;
+}
+
+CosResult PrefixDeleteKeyIterator::GetResult() const {
+    if (m_iter.IsError()) {
+        return m_iter.GetResult();
+    }
+    CosResult result;
+    result.SetSucc();
+    return result;
+}
+
+BulkDeleter::BulkDeleter(const ObjectOp& op, const BulkDeleteReq& req)
+    : m_op(op), m_req(req), m_in_flight(0), m_is_stopped(false), m_deleted_count(0),
+      m_batch_count(0), m_failed_batch_count(0) {
+}
+
+CosResult BulkDeleter::Run(DeleteKeyIterator* keys, BulkDeleteResp* resp) {
+    unsigned thread_num = std::max(m_req.GetThreadNum(), 1u);
+    unsigned batch_size = m_req.GetBatchSize();
+    bool is_key_error = false;
+    CosResult key_result;
+    {
+        TaskGroup tp(thread_num);
+        SharedBatch batch(new std::vector<ObjectVersionPair>());
+        batch->reserve(batch_size);
+        ObjectVersionPair key;
+        while (!IsStopped()) {
+            bool has_key = keys->Next(&key);
+            if (has_key) {
+                batch->push_back(key);
+            }
+            if (batch->size() < batch_size && has_key) {
+                continue;
+            }
+            // 凑满一批或key来源结束, 等待空闲的并发名额后发出
+            if (!batch->empty() && AcquireSlot()) {
+                tp.Schedule(boost::bind(&BulkDeleter::RunBatch, this, batch));
+                batch.reset(new std::vector<ObjectVersionPair>());
+                batch->reserve(batch_size);
+            }
+            if (!has_key) {
+                key_result = keys->GetResult();
+                is_key_error = !key_result.IsSucc();
+                break;
+            }
+        }
+        tp.Wait();
+    }
+
+    boost::mutex::scoped_lock lock(m_mutex);
+    resp->SetDeletedCount(m_deleted_count);
+    resp->SetBatchCount(m_batch_count);
+    resp->SetFailedBatchCount(m_failed_batch_count);
+    resp->AddErrorInfos(m_error_infos);
+    SDK_LOG_INFO("Bulk delete finish, bucket=%s, deleted=%lu, failed=%lu, batch=%lu",
+                 m_req.GetBucketName().c_str(), static_cast<unsigned long>(m_deleted_count),
+                 static_cast<unsigned long>(m_error_infos.size()),
+                 static_cast<unsigned long>(m_batch_count));
+    if (m_is_stopped) {
+        return m_err_result;
+    }
+    if (is_key_error) {
+        return key_result;
+    }
+    CosResult result;
+    result.SetSucc();
+    return result;
+}
+
+bool BulkDeleter::AcquireSlot() {
+    boost::mutex::scoped_lock lock(m_mutex);
+    while (!m_is_stopped && m_in_flight >= std::max(m_req.GetThreadNum(), 1u)) {
+        m_cond.wait(lock);
+    }
+    if (m_is_stopped) {
+        return false;
+    }
+    ++m_in_flight;
+    ++m_batch_count;
+    return true;
+}
+
+void BulkDeleter::RunBatch(SharedBatch batch) {
+    // 继承调用方设置的请求头、超时和取消句柄, 不复制全部待删除的Object
+    DeleteObjectsReq req = m_req.CloneWithoutObjects();
+    for (std::vector<ObjectVersionPair>::const_iterator itr = batch->begin();
+         itr != batch->end(); ++itr) {
+        req.AddObjectVersion(itr->m_object_name, itr->m_version_id);
+    }
+    DeleteObjectsResp resp;
+    CosResult result = m_op.DeleteObjects(req, &resp);
+
+    std::vector<ErrorInfo> error_infos;
+    if (result.IsSucc()) {
+        error_infos = resp.GetErrorinfos();
+    } else {
+        SDK_LOG_ERR("Delete objects batch fail, first_key=%s, key_num=%u, err_msg=%s",
+                    batch->front().m_object_name.c_str(), static_cast<unsigned>(batch->size()),
+                    result.GetErrorInfo().c_str());
+        // 整批失败时每个Object都记为失败
+        error_infos.resize(batch->size());
+        for (size_t i = 0; i < batch->size(); ++i) {
+            error_infos[i].m_key = (*batch)[i].m_object_name;
+            error_infos[i].m_version_id = (*batch)[i].m_version_id;
+            error_infos[i].m_code = result.GetErrorCode();
+            error_infos[i].m_message = result.GetErrorInfo();
+        }
+    }
+
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+        --m_in_flight;
+        if (batch->size() > error_infos.size()) {
+            m_deleted_count += batch->size() - error_infos.size();
+        }
+        m_error_infos.insert(m_error_infos.end(), error_infos.begin(), error_infos.end());
+        if (!result.IsSucc()) {
+            ++m_failed_batch_count;
+            if (!m_is_stopped) {
+                m_is_stopped = true;
+                m_err_result = result;
+            }
+        }
+    }
+    m_cond.notify_all();
+}
+
+bool BulkDeleter::IsStopped() const {
+    boost::mutex::scoped_lock lock(m_mutex);
+    return m_is_stopped;
+}
+
+} // namespace qcloud_cos
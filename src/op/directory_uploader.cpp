@@ -0,0 +1,349 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: 并发扫描本地目录并上传其中的文件
+
+#include "op/directory_uploader.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <map>
+
+#include "boost/bind.hpp"
+#include "boost/date_time/posix_time/posix_time_types.hpp"
+
+#include "cos_params.h"
+#include "cos_sys_config.h"
+#include "util/executor.h"
+#include "util/file_util.h"
+#include "util/http_sender.h"
+#include "util/string_util.h"
+
+namespace qcloud_cos {
+
+namespace {
+
+// 待上传的文件超过该数量时暂停扫描, 限制扫描超前上传时占用的内存
+const size_t kUploadDirectoryMaxQueuedFiles = 10000;
+
+// 调度线程检查取消状态的间隔, 单位:毫秒
+const uint64_t kUploadDirectoryCheckIntervalInms = 50;
+
+} // namespace
+
+DirectoryUploader::DirectoryUploader(const ObjectOp& op, const UploadDirectoryReq& req,
+                                     UploadDirectoryHandler* handler)
+    : m_op(op), m_req(req), m_handler(handler), m_root(req.GetLocalDir()),
+      m_thread_num(std::max(req.GetThreadNum(), 1u)),
+      m_scanning(0), m_uploading(0), m_conns_in_use(0), m_memory_in_use(0),
+      m_uploaded_bytes(0) {
+    while (m_root.size() > 1 && m_root[m_root.size() - 1] == '/') {
+        m_root.erase(m_root.size() - 1);
+    }
+
+    CosConfig config = m_op.GetCosConfig();
+    const ClientSettings& settings = config.GetClientSettings();
+    m_part_size = req.GetPartSize() > 0 ? req.GetPartSize() : settings.GetUploadPartSize();
+    m_part_thread_num = req.GetPartThreadNum() > 0 ? req.GetPartThreadNum()
+        : settings.GetUploadThreadPoolSize();
+    // 分块上传的连接也计入ThreadNum, 单个文件的分块并发数不超过ThreadNum
+    m_part_thread_num = std::min(std::max(m_part_thread_num, 1u), m_thread_num);
+}
+
+CosResult DirectoryUploader::Run(UploadDirectoryResp* resp) {
+    CosResult result;
+    DIR* root_dir = m_root.empty() ? NULL : opendir(m_root.c_str());
+    if (root_dir == NULL) {
+        result.SetErrorInfo("Open local dir fail, local_dir=" + m_req.GetLocalDir());
+        return result;
+    }
+    closedir(root_dir);
+
+    unsigned walk_thread_num = std::max(m_req.GetWalkThreadNum(), 1u);
+    uint64_t memory_budget = m_req.GetMemoryBudget();
+    Executor& executor = Executor::Instance();
+    bool is_worker = executor.IsWorkerThread();
+    bool is_cancelled = false;
+    {
+        TaskGroup walk_tp(walk_thread_num);
+        TaskGroup upload_tp(m_thread_num);
+        boost::mutex::scoped_lock lock(m_mutex);
+        m_pending_dirs.push_back("");
+        while (true) {
+            if (!is_cancelled && IsCancelled()) {
+                is_cancelled = true;
+                SDK_LOG_ERR("Upload directory cancelled, local_dir=%s", m_root.c_str());
+            }
+            if (is_cancelled) {
+                // 不再发出新的任务, 在途的任务由取消句柄或截止时间结束
+                m_pending_dirs.clear();
+                m_files.clear();
+            }
+
+            while (!m_pending_dirs.empty() && m_scanning < walk_thread_num
+                   && m_files.size() < kUploadDirectoryMaxQueuedFiles) {
+                ++m_scanning;
+                walk_tp.Schedule(boost::bind(&DirectoryUploader::ScanDir, this,
+                                             m_pending_dirs.back()));
+                m_pending_dirs.pop_back();
+            }
+
+            while (!m_files.empty()) {
+                // 连接数按文件实际使用的连接计算, 简单上传和分块上传共享同一个上限
+                unsigned conns = GetConnCost(m_files.front());
+                if (m_conns_in_use + conns > m_thread_num) {
+                    break;
+                }
+                uint64_t cost = GetMemoryCost(m_files.front());
+                // 超过预算的大文件在没有其他在途文件时单独上传
+                if (m_uploading > 0 && m_memory_in_use + cost > memory_budget) {
+                    break;
+                }
+                ++m_uploading;
+                m_conns_in_use += conns;
+                m_memory_in_use += cost;
+                upload_tp.Schedule(boost::bind(&DirectoryUploader::UploadFile, this,
+                                               m_files.front()));
+                m_files.pop_front();
+            }
+
+            if (m_pending_dirs.empty() && m_scanning == 0) {
+                m_progress.m_is_walk_done = true;
+                if (m_files.empty() && m_uploading == 0) {
+                    break;
+                }
+            }
+
+            // 在工作线程上调用时帮助执行排队的任务, 避免所有工作线程都在等待
+            if (is_worker) {
+                lock.unlock();
+                bool is_run = executor.RunOne();
+                lock.lock();
+                if (is_run) {
+                    continue;
+                }
+            }
+            m_cond.timed_wait(lock,
+                boost::posix_time::milliseconds(kUploadDirectoryCheckIntervalInms));
+        }
+    }
+
+    boost::mutex::scoped_lock lock(m_mutex);
+    uint64_t uploaded_count = m_progress.m_done_count - m_progress.m_skipped_count
+        - m_progress.m_failed_count;
+    resp->SetFileCount(m_progress.m_file_count);
+    resp->SetUploadedCount(uploaded_count);
+    resp->SetSkippedCount(m_progress.m_skipped_count);
+    resp->SetFailedCount(m_progress.m_failed_count);
+    resp->SetTotalBytes(m_progress.m_total_bytes);
+    resp->SetUploadedBytes(m_uploaded_bytes);
+    resp->AddErrorInfos(m_error_infos);
+    SDK_LOG_INFO("Upload directory finish, local_dir=%s, bucket=%s, files=%lu, uploaded=%lu, "
+                 "skipped=%lu, failed=%lu", m_root.c_str(), m_req.GetBucketName().c_str(),
+                 static_cast<unsigned long>(m_progress.m_file_count),
+                 static_cast<unsigned long>(uploaded_count),
+                 static_cast<unsigned long>(m_progress.m_skipped_count),
+                 static_cast<unsigned long>(m_progress.m_failed_count));
+    if (is_cancelled) {
+        const SharedCancelToken& cancel_token = m_req.GetCancelToken();
+        result.SetErrorInfo(cancel_token && cancel_token->IsCancelled()
+                            ? cancel_token->GetErrMsg() : kRequestDeadlineExceededErrMsg);
+        return result;
+    }
+    result.SetSucc();
+    return result;
+}
+
+void DirectoryUploader::ScanDir(const std::string& rel_dir) {
+    std::string dir_path = rel_dir.empty() ? m_root : m_root + "/" + rel_dir;
+    std::vector<std::string> dirs;
+    std::vector<FileEntry> files;
+    uint64_t total_bytes = 0;
+    int err = 0;
+    DIR* dir = opendir(dir_path.c_str());
+    if (dir == NULL) {
+        err = errno;
+    } else {
+        struct dirent* entry = NULL;
+        while ((entry = readdir(dir)) != NULL) {
+            std::string name = entry->d_name;
+            if (name == "." || name == "..") {
+                continue;
+            }
+            std::string rel_path = rel_dir.empty() ? name : rel_dir + "/" + name;
+            std::string local_path = m_root + "/" + rel_path;
+            struct stat st;
+            if (lstat(local_path.c_str(), &st) != 0) {
+                continue;
+            }
+            if (S_ISDIR(st.st_mode)) {
+                dirs.push_back(rel_path);
+                continue;
+            }
+            // 跟随指向文件的符号链接, 不进入指向目录的符号链接, 避免循环
+            if (S_ISLNK(st.st_mode) && stat(local_path.c_str(), &st) != 0) {
+                continue;
+            }
+            if (!S_ISREG(st.st_mode)) {
+                continue;
+            }
+
+            FileEntry file;
+            file.m_local_path = local_path;
+            file.m_object_name = m_req.GetPrefix() + rel_path;
+            file.m_size = static_cast<uint64_t>(st.st_size);
+            total_bytes += file.m_size;
+            files.push_back(file);
+        }
+        closedir(dir);
+    }
+
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+        if (dir == NULL) {
+            SDK_LOG_ERR("Upload directory open dir fail, dir=%s, errno=%d",
+                        dir_path.c_str(), err);
+            ErrorInfo info;
+            info.m_key = m_req.GetPrefix() + rel_dir + "/";
+            info.m_code = "OpenDirFail";
+            info.m_message = "Open local dir fail, dir=" + dir_path + ", err=" + strerror(err);
+            m_error_infos.push_back(info);
+        }
+        m_pending_dirs.insert(m_pending_dirs.end(), dirs.begin(), dirs.end());
+        m_files.insert(m_files.end(), files.begin(), files.end());
+        m_progress.m_file_count += files.size();
+        m_progress.m_total_bytes += total_bytes;
+        --m_scanning;
+    }
+    m_cond.notify_all();
+}
+
+void DirectoryUploader::UploadFile(const FileEntry& file) {
+    CosResult result;
+    bool is_skipped = false;
+    std::string local_md5;
+    if (m_req.IsSkipExisting() && IsSameAsRemote(file, &local_md5)) {
+        is_skipped = true;
+        result.SetSucc();
+    } else {
+        result = PutFile(file, local_md5);
+    }
+    if (!result.IsSucc()) {
+        SDK_LOG_ERR("Upload directory file fail, local_path=%s, object=%s, err_msg=%s",
+                    file.m_local_path.c_str(), file.m_object_name.c_str(),
+                    result.GetErrorInfo().c_str());
+    }
+
+    UploadDirectoryProgress progress;
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+        --m_uploading;
+        m_conns_in_use -= GetConnCost(file);
+        m_memory_in_use -= GetMemoryCost(file);
+        ++m_progress.m_done_count;
+        m_progress.m_done_bytes += file.m_size;
+        if (is_skipped) {
+            ++m_progress.m_skipped_count;
+        } else if (result.IsSucc()) {
+            m_uploaded_bytes += file.m_size;
+        } else {
+            ++m_progress.m_failed_count;
+            ErrorInfo info;
+            info.m_key = file.m_object_name;
+            info.m_code = result.GetErrorCode();
+            info.m_message = result.GetErrorInfo();
+            m_error_infos.push_back(info);
+        }
+        progress = m_progress;
+    }
+    m_cond.notify_all();
+
+    if (m_handler != NULL) {
+        m_handler->OnFileDone(file.m_local_path, file.m_object_name, result, is_skipped,
+                              progress);
+    }
+}
+
+bool DirectoryUploader::IsSameAsRemote(const FileEntry& file, std::string* local_md5) {
+    HeadObjectReq head_req(m_req.GetBucketName(), file.m_object_name);
+    CopySettings(&head_req);
+    HeadObjectResp head_resp;
+    CosResult result = m_op.HeadObject(head_req, &head_resp);
+    if (!result.IsSucc() || head_resp.GetContentLength() != file.m_size) {
+        return false;
+    }
+
+    // 大小一致时才计算本地MD5
+    *local_md5 = FileUtil::GetFileMd5(file.m_local_path);
+    if (local_md5->empty()) {
+        return false;
+    }
+    std::string remote_md5 = head_resp.GetEtag();
+    if (StringUtil::IsMultipartUploadETag(remote_md5)) {
+        std::map<std::string, std::string> metas = head_resp.GetXCosMetas();
+        std::map<std::string, std::string>::const_iterator itr
+            = metas.find(kTransferMd5MetaKey);
+        remote_md5 = itr == metas.end() ? "" : itr->second;
+    }
+    return StringUtil::StringToLower(remote_md5) == *local_md5;
+}
+
+CosResult DirectoryUploader::PutFile(const FileEntry& file, const std::string& local_md5) {
+    if (file.m_size < m_req.GetMultipartThreshold()) {
+        PutObjectByFileReq put_req(m_req.GetBucketName(), file.m_object_name, file.m_local_path);
+        CopySettings(&put_req);
+        PutObjectByFileResp put_resp;
+        return m_op.PutObject(put_req, &put_resp);
+    }
+
+    MultiUploadObjectReq multi_req(m_req.GetBucketName(), file.m_object_name,
+                                   file.m_local_path);
+    CopySettings(&multi_req);
+    multi_req.SetPartSize(m_part_size);
+    multi_req.SetThreadPoolSize(static_cast<int>(m_part_thread_num));
+    if (m_req.IsSkipExisting()) {
+        std::string md5 = local_md5.empty() ? FileUtil::GetFileMd5(file.m_local_path) : local_md5;
+        if (!md5.empty()) {
+            multi_req.SetXCosMeta(kTransferMd5MetaKey, md5);
+        }
+    }
+    MultiUploadObjectResp multi_resp;
+    return m_op.MultiUploadObject(multi_req, &multi_resp);
+}
+
+uint64_t DirectoryUploader::GetMemoryCost(const FileEntry& file) const {
+    if (file.m_size < m_req.GetMultipartThreshold()) {
+        return file.m_size;
+    }
+    return std::min(file.m_size, m_part_size * m_part_thread_num);
+}
+
+unsigned DirectoryUploader::GetConnCost(const FileEntry& file) const {
+    return file.m_size < m_req.GetMultipartThreshold() ? 1u : m_part_thread_num;
+}
+
+bool DirectoryUploader::IsCancelled() const {
+    const SharedCancelToken& cancel_token = m_req.GetCancelToken();
+    if (cancel_token && cancel_token->IsCancelled()) {
+        return true;
+    }
+    uint64_t deadline_in_ms = m_req.GetDeadlineInms();
+    return deadline_in_ms != 0 && HttpSender::GetTimeStampInUs() / 1000 >= deadline_in_ms;
+}
+
+void DirectoryUploader::CopySettings(BaseReq* req) const {
+    req->SetConnTimeoutInms(m_req.GetConnTimeoutInms());
+    req->SetRecvTimeoutInms(m_req.GetRecvTimeoutInms());
+    req->SetCancelToken(m_req.GetCancelToken());
+    req->SetPriority(m_req.GetPriority());
+    req->SetDeadlineInms(m_req.GetDeadlineInms());
+    if (m_req.IsHttps()) {
+        req->SetHttps();
+    }
+}
+
+} // namespace qcloud_cos
@@ -49,34 +49,43 @@ void FileCopyTask::Run() {
 }
 
 void FileCopyTask::CopyTask() {
-    int loop = 0;
-    do {
-        loop++;
+    for (unsigned attempt = 1; ; ++attempt) {
         m_resp_headers.clear();
         m_resp = "";
+        m_err_msg = "";
 
         m_http_status = HttpSender::SendRequest("PUT", m_full_url, m_params, m_headers,
                                         "", m_conn_timeout_in_ms, m_recv_timeout_in_ms,
-                                        &m_resp_headers, &m_resp, &m_err_msg);
+                                        &m_resp_headers, &m_resp, &m_err_msg,
+                                        false, &m_cancel_token);
 
+        RETRY_ERROR_TYPE err_type = RETRY_ERR_NONE;
         if (m_http_status != 200) {
             SDK_LOG_ERR("FileUpload: url(%s) fail, httpcode:%d, resp: %s",
                         m_full_url.c_str(), m_http_status, m_resp.c_str());
             m_is_task_success = false;
-            continue;
-        }
-
-        UploadPartCopyDataResp resp;
-        if (!resp.ParseFromXmlString(m_resp)) {
+            err_type = RetryPolicy::ClassifyError(m_http_status, m_err_msg);
+        } else {
+            UploadPartCopyDataResp resp;
+            if (resp.ParseFromXmlString(m_resp)) {
+                m_etag = resp.GetEtag();
+                m_last_modified = resp.GetLastModified();
+                m_is_task_success = true;
+                break;
+            }
+
+            // 200时返回错误的body, 说明复制过程中服务端出错
             SDK_LOG_ERR("FileUpload response string is illegal. try again.")
             m_is_task_success = false;
-            continue;
+            err_type = RETRY_ERR_SERVER;
         }
 
-        m_etag = resp.GetEtag();
-        m_last_modified = resp.GetLastModified();
-        m_is_task_success = true;
-    } while (!m_is_task_success && loop <= kMaxRetryTimes);
+        // 已取消或超过截止时间时不再重试
+        if (m_cancel_token.IsCancelled() || !m_retry_policy.ShouldRetry(attempt, err_type)) {
+            break;
+        }
+        m_retry_policy.Backoff(attempt, err_type, &m_cancel_token);
+    }
 }
 
 }
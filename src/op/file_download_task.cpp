@@ -4,6 +4,7 @@
 #include <string.h>
 
 #include <map>
+#include <ostream>
 
 namespace qcloud_cos{
 
@@ -19,19 +20,24 @@ FileDownTask::FileDownTask(const std::string& full_url,
       m_conn_timeout_in_ms(conn_timeout_in_ms),
       m_recv_timeout_in_ms(recv_timeout_in_ms),
       m_offset(offset), m_data_buf_ptr(pbuf),
-      m_data_len(data_len), m_resp(""), m_is_task_success(false), m_real_down_len(0) {
+      m_data_len(data_len), m_resp(""), m_is_task_success(false), m_real_down_len(0),
+      m_priority(PRIORITY_NORMAL) {
 }
 
 void FileDownTask::Run() {
     m_resp = "";
     m_is_task_success = false;
+    m_progress.Start();
     DownTask();
+    m_progress.Finish();
 }
 
 void FileDownTask::SetDownParams(unsigned char* pbuf, size_t data_len, uint64_t offset) {
     m_data_buf_ptr = pbuf;
     m_data_len  = data_len;
     m_offset = offset;
+    m_progress.Reset();
+    m_cancel_token.Reset();
 }
 
 size_t FileDownTask::GetDownLoadLen() {
@@ -63,9 +69,38 @@ void FileDownTask::DownTask() {
     // 增加Range头域，避免大文件时将整个文件下载
     m_headers["Range"] = range_head;
 
-    m_http_status = HttpSender::SendRequest("GET", m_full_url, m_params, m_headers,
-                                            "", m_conn_timeout_in_ms, m_recv_timeout_in_ms,
-                                            &m_resp_headers, &m_resp, &m_err_msg);
+    for (unsigned attempt = 1; ; ++attempt) {
+        m_resp_headers.clear();
+        m_resp = "";
+        m_err_msg = "";
+        // 响应体直接写入分块缓冲区, 错误时的响应写入m_resp
+        MemoryOutputBuf data_buf(m_data_buf_ptr, m_data_len, &m_progress);
+        std::ostream data_os(&data_buf);
+        m_http_status = HttpSender::SendRequest("GET", m_full_url, m_params, m_headers,
+                                                "", m_conn_timeout_in_ms, m_recv_timeout_in_ms,
+                                                &m_resp_headers, &m_resp, data_os, &m_err_msg,
+                                                false, &m_cancel_token, m_rate_limiter.get(),
+                                                m_priority);
+        if (m_http_status == 200 || m_http_status == 206) {
+            if (data_os) {
+                m_real_down_len = data_buf.GetSize();
+                break;
+            }
+            // 服务端忽略了Range, 返回的数据超出分块大小
+            m_http_status = -1;
+            m_err_msg = "Exception:response body is larger than the slice size";
+            break;
+        }
+
+        RETRY_ERROR_TYPE err_type = RetryPolicy::ClassifyError(m_http_status, m_err_msg);
+        // 已取消或超过截止时间时不再重试
+        if (m_cancel_token.IsCancelled() || !m_retry_policy.ShouldRetry(attempt, err_type)) {
+            break;
+        }
+        SDK_LOG_WARN("FileDownload: url(%s) fail, httpcode:%d, retry.",
+                     m_full_url.c_str(), m_http_status);
+        m_retry_policy.Backoff(attempt, err_type, &m_cancel_token);
+    }
 
     //当实际长度小于请求的数据长度时httpcode为206
     if (m_http_status != 200 && m_http_status != 206) {
@@ -76,12 +111,7 @@ void FileDownTask::DownTask() {
         return;
     }
 
-    size_t buf_max_size = m_data_len;
-    size_t len = MIN(m_resp.length(), buf_max_size);
-    memcpy(m_data_buf_ptr, m_resp.c_str(), len);
-    m_real_down_len = len;
     m_is_task_success = true;
-    m_resp = "";
     return;
 }
 
@@ -3,13 +3,15 @@
 #include <stdint.h>
 #include <string.h>
 
+#include <istream>
 #include <map>
-#include <sstream>
 
-#include "Poco/MD5Engine.h"
+#include "boost/scoped_ptr.hpp"
 #include "Poco/DigestStream.h"
+#include "Poco/MD5Engine.h"
 #include "Poco/StreamCopier.h"
 
+#include "util/file_input_buf.h"
 #include "util/string_util.h"
 
 namespace qcloud_cos{
@@ -19,9 +21,9 @@ FileUploadTask::FileUploadTask(const std::string& full_url,
                                uint64_t recv_timeout_in_ms,
                                unsigned char* pbuf,
                                const size_t data_len)
-    : m_full_url(full_url), m_data_buf_ptr(pbuf), m_data_len(data_len),
+    : m_full_url(full_url), m_data_buf_ptr(pbuf), m_data_len(data_len), m_file_offset(0),
       m_conn_timeout_in_ms(conn_timeout_in_ms), m_recv_timeout_in_ms(recv_timeout_in_ms),
-      m_resp(""), m_is_task_success(false) {
+      m_resp(""), m_is_task_success(false), m_priority(PRIORITY_NORMAL) {
 }
 
 FileUploadTask::FileUploadTask(const std::string& full_url,
@@ -33,18 +35,35 @@ FileUploadTask::FileUploadTask(const std::string& full_url,
                                const size_t data_len)
     : m_full_url(full_url), m_headers(headers), m_params(params),
       m_conn_timeout_in_ms(conn_timeout_in_ms), m_recv_timeout_in_ms(recv_timeout_in_ms),
-      m_data_buf_ptr(pbuf), m_data_len(data_len), m_resp(""), m_is_task_success(false) {
+      m_data_buf_ptr(pbuf), m_data_len(data_len), m_file_offset(0), m_resp(""),
+      m_is_task_success(false), m_priority(PRIORITY_NORMAL) {
 }
 
 void FileUploadTask::Run() {
     m_resp = "";
     m_is_task_success = false;
+    m_progress.Start();
     UploadTask();
+    m_progress.Finish();
 }
 
 void FileUploadTask::SetUploadBuf(unsigned char* pbuf, size_t data_len) {
     m_data_buf_ptr = pbuf;
     m_data_len = data_len;
+    m_file_path.clear();
+    m_file_offset = 0;
+    m_progress.Reset();
+    m_cancel_token.Reset();
+}
+
+void FileUploadTask::SetUploadFileRange(const std::string& file_path, uint64_t offset,
+                                        size_t data_len) {
+    m_data_buf_ptr = NULL;
+    m_data_len = data_len;
+    m_file_path = file_path;
+    m_file_offset = offset;
+    m_progress.Reset();
+    m_cancel_token.Reset();
 }
 
 bool FileUploadTask::IsTaskSuccess() const {
@@ -74,42 +93,80 @@ void FileUploadTask::SetHeaders(const std::map<std::string, std::string>& header
 }
 
 void FileUploadTask::UploadTask() {
-    int loop = 0;
-
-    std::string body((const char *)m_data_buf_ptr, m_data_len);
     // 计算上传的md5
     Poco::MD5Engine md5;
-    std::istringstream istr(body);
-    Poco::DigestOutputStream dos(md5);
-    Poco::StreamCopier::copyStream(istr, dos);
-    dos.close();
+    if (m_file_path.empty()) {
+        md5.update(m_data_buf_ptr, m_data_len);
+    } else {
+        FileInputBuf md5_buf(m_file_path, m_file_offset, m_data_len);
+        std::istream md5_is(&md5_buf);
+        Poco::DigestOutputStream dos(md5);
+        Poco::StreamCopier::copyStream(md5_is, dos);
+        dos.close();
+        if (!md5_buf.IsOpen() || md5_buf.GetRemainBytes() > 0) {
+            m_http_status = -1;
+            m_err_msg = "Read local file fail, local file=" + m_file_path;
+            m_is_task_success = false;
+            return;
+        }
+    }
     const std::string& md5_str = Poco::DigestEngine::digestToHex(md5.digest());
 
-    do {
-        loop++;
+    // 分块请求头由调用方逐个分块生成, 服务端限速头在这里统一添加
+    if (!m_traffic_limit.empty()) {
+        m_headers[kReqHeaderXCosTrafficLimit] = m_traffic_limit;
+    }
+
+    for (unsigned attempt = 1; ; ++attempt) {
         m_resp_headers.clear();
         m_resp = "";
+        m_err_msg = "";
+        // 直接从分块缓冲区或本地文件读取请求体, 避免拷贝
+        boost::scoped_ptr<std::streambuf> data_buf;
+        if (m_file_path.empty()) {
+            data_buf.reset(new MemoryInputBuf(m_data_buf_ptr, m_data_len, &m_progress));
+        } else {
+            data_buf.reset(new FileInputBuf(m_file_path, m_file_offset, m_data_len,
+                                            &m_progress));
+        }
+        std::istream data_is(data_buf.get());
         m_http_status = HttpSender::SendRequest("PUT", m_full_url, m_params, m_headers,
-                                        body, m_conn_timeout_in_ms, m_recv_timeout_in_ms,
-                                        &m_resp_headers, &m_resp, &m_err_msg);
+                                        data_is, m_conn_timeout_in_ms, m_recv_timeout_in_ms,
+                                        &m_resp_headers, &m_resp, &m_err_msg,
+                                        false, &m_cancel_token, m_rate_limiter.get(),
+                                        m_priority);
 
+        RETRY_ERROR_TYPE err_type = RETRY_ERR_NONE;
         if (m_http_status != 200) {
             SDK_LOG_ERR("FileUpload: url(%s) fail, httpcode:%d, resp: %s",
                         m_full_url.c_str(), m_http_status, m_resp.c_str());
             m_is_task_success = false;
-            continue;
+            err_type = RetryPolicy::ClassifyError(m_http_status, m_err_msg);
+        } else {
+            std::map<std::string, std::string>::const_iterator c_itr = m_resp_headers.find("ETag");
+            std::string etag = "";
+            if (c_itr != m_resp_headers.end()) {
+                etag = StringUtil::Trim(c_itr->second, "\"");
+            }
+
+            if (etag != md5_str) {
+                SDK_LOG_ERR("Response etag is not correct, try again. Expect md5 is %s, but return etag is %s.",
+                            md5_str.c_str(), etag.c_str());
+                m_is_task_success = false;
+                // 数据在传输过程中损坏, 与网络错误同等对待
+                err_type = RETRY_ERR_NETWORK;
+            } else {
+                m_is_task_success = true;
+                break;
+            }
         }
 
-        std::map<std::string, std::string>::const_iterator c_itr = m_resp_headers.find("ETag");
-        if (c_itr == m_resp_headers.end() || StringUtil::Trim(c_itr->second, "\"") != md5_str) {
-            SDK_LOG_ERR("Response etag is not correct, try again. Expect md5 is %s, but return etag is %s.",
-                        md5_str.c_str(), StringUtil::Trim(c_itr->second, "\"").c_str());
-            m_is_task_success = false;
-            continue;
+        // 已取消或超过截止时间时不再重试
+        if (m_cancel_token.IsCancelled() || !m_retry_policy.ShouldRetry(attempt, err_type)) {
+            break;
         }
-
-        m_is_task_success = true;
-    } while (!m_is_task_success && loop <= kMaxRetryTimes);
+        m_retry_policy.Backoff(attempt, err_type, &m_cancel_token);
+    }
 
     return;
 }
@@ -11,17 +11,32 @@
 #include <stdint.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <unistd.h>
+
+#include <algorithm>
 
-#include "threadpool/boost/threadpool.hpp"
 #include <boost/bind.hpp>
+#include <boost/function.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/mutex.hpp>
 
 #include "cos_sys_config.h"
+#include "op/bucket_op.h"
+#include "op/bulk_deleter.h"
+#include "op/directory_uploader.h"
+#include "op/prefix_downloader.h"
 #include "op/file_copy_task.h"
 #include "op/file_download_task.h"
 #include "op/file_upload_task.h"
 #include "util/auth_tool.h"
+#include "util/cache_generation.h"
+#include "util/executor.h"
+#include "util/file_input_buf.h"
 #include "util/file_util.h"
 #include "util/http_sender.h"
+#include "util/http_session_pool.h"
+#include "util/negative_cache.h"
+#include "util/stall_policy.h"
 #include "util/string_util.h"
 
 #include "Poco/MD5Engine.h"
@@ -30,6 +45,575 @@
 
 namespace qcloud_cos {
 
+namespace {
+
+// 等待一批分块任务结束. 开启低速检测时, 对吞吐低于阈值的分块调用spec_fillers[i]填充
+// spec_tasks[i], 在新连接上推测执行; 先成功的任务胜出, 另一个被取消.
+// 返回时所有任务均已结束, (*winners)[i]为第i个分块最终采用的任务
+template <typename Task>
+void WaitPartTasks(const StallPolicy& stall_policy,
+                   TaskGroup* tp,
+                   TaskGroup* spec_tp,
+                   Task** tasks,
+                   Task** spec_tasks,
+                   const std::vector<boost::function<void()> >& spec_fillers,
+                   unsigned task_num,
+                   std::vector<Task*>* winners) {
+    winners->assign(tasks, tasks + task_num);
+    if (!stall_policy.IsEnable()) {
+        tp->Wait();
+        return;
+    }
+
+    std::vector<bool> is_decided(task_num, false);
+    std::vector<bool> is_speculated(task_num, false);
+    unsigned decided_num = 0;
+    while (decided_num < task_num) {
+        for (unsigned i = 0; i < task_num; ++i) {
+            if (is_decided[i]) {
+                continue;
+            }
+
+            Task* task = tasks[i];
+            Task* spec_task = is_speculated[i] ? spec_tasks[i] : NULL;
+            bool is_task_done = task->GetProgress().IsFinished();
+            bool is_spec_done = spec_task != NULL && spec_task->GetProgress().IsFinished();
+            if (is_task_done && task->IsTaskSuccess()) {
+                if (spec_task != NULL) {
+                    spec_task->Cancel();
+                }
+                (*winners)[i] = task;
+            } else if (is_spec_done && spec_task->IsTaskSuccess()) {
+                task->Cancel();
+                (*winners)[i] = spec_task;
+            } else if (is_task_done && (spec_task == NULL || is_spec_done)) {
+                // 都失败时返回原任务的结果
+                (*winners)[i] = task;
+            } else {
+                if (spec_task == NULL && stall_policy.IsStalled(task->GetProgress())) {
+                    SDK_LOG_WARN("Part task stalled, task_index=%u, bytes=%lu, elapsed=%lu ms, "
+                                 "issue speculative task.", i, task->GetProgress().GetBytes(),
+                                 task->GetProgress().GetElapsedInms());
+                    spec_fillers[i]();
+                    spec_tp->Schedule(boost::bind(&Task::Run, spec_tasks[i]));
+                    is_speculated[i] = true;
+                }
+                continue;
+            }
+            is_decided[i] = true;
+            ++decided_num;
+        }
+
+        if (decided_num < task_num) {
+            // 原任务都已结束时等待推测任务; 在执行器的工作线程上调用时, 等待期间同时执行排队的任务
+            if (tp->TimedWait(stall_policy.GetCheckIntervalInms())) {
+                spec_tp->TimedWait(stall_policy.GetCheckIntervalInms());
+            }
+        }
+    }
+
+    // 被取消的任务退出后才能复用任务及其缓冲区
+    tp->Wait();
+    spec_tp->Wait();
+}
+
+// 一次BatchHeadObject的共享状态, 工作线程依次领取下一个待检查的Object
+struct BatchHeadContext {
+    BatchHeadContext(const BatchHeadObjectReq& req, std::vector<HeadObjectResult>* results)
+        : m_req(req), m_results(results), m_next_idx(0) {}
+
+    const BatchHeadObjectReq& m_req;
+    std::vector<HeadObjectResult>* m_results;
+    boost::mutex m_mutex;
+    size_t m_next_idx;
+};
+
+void RunBatchHead(ObjectOp* op, BatchHeadContext* ctx) {
+    // 大量短请求, 不论是否全局开启长连接都复用连接
+    KeepAliveScope keep_alive;
+    const std::vector<std::string>& objects = ctx->m_req.GetObjects();
+    while (true) {
+        size_t idx = 0;
+        {
+            boost::mutex::scoped_lock lock(ctx->m_mutex);
+            if (ctx->m_next_idx >= objects.size()) {
+                return;
+            }
+            idx = ctx->m_next_idx++;
+        }
+
+        HeadObjectReq req(ctx->m_req.GetBucketName(), objects[idx]);
+        req.SetConnTimeoutInms(ctx->m_req.GetConnTimeoutInms());
+        req.SetRecvTimeoutInms(ctx->m_req.GetRecvTimeoutInms());
+        req.SetDeadlineInms(ctx->m_req.GetDeadlineInms());
+        req.SetCancelToken(ctx->m_req.GetCancelToken());
+        req.SetPriority(ctx->m_req.GetPriority());
+        if (ctx->m_req.IsHttps()) {
+            req.SetHttps();
+        }
+        HeadObjectResp resp;
+        CosResult result = op->HeadObject(req, &resp);
+
+        // 每个工作线程只写自己领取的位置, 无需加锁
+        HeadObjectResult& head_result = (*ctx->m_results)[idx];
+        head_result.m_http_status = result.GetHttpStatus();
+        if (result.IsSucc()) {
+            head_result.m_exists = true;
+            head_result.m_size = resp.GetContentLength();
+            head_result.m_etag = StringUtil::Trim(resp.GetEtag(), "\"");
+            head_result.m_last_modified_time
+                = StringUtil::HttpDateToTimestamp(resp.GetLastModified());
+        } else if (result.GetHttpStatus() != 404) {
+            SDK_LOG_DBG("Head object fail, bucket=%s, object=%s, http_status=%d, err_msg=%s",
+                        ctx->m_req.GetBucketName().c_str(), objects[idx].c_str(),
+                        result.GetHttpStatus(), result.GetErrorInfo().c_str());
+        }
+    }
+}
+
+// 带条件头、Range或其它参数(如versionId)的请求不经过元数据缓存.
+// is_get为true时允许If-None-Match, 由GetObject单独处理
+bool IsMetaCacheable(const BaseReq& req, bool is_get) {
+    if (!req.GetParams().empty()) {
+        return false;
+    }
+    const std::map<std::string, std::string>& headers = req.GetHeaders();
+    for (std::map<std::string, std::string>::const_iterator itr = headers.begin();
+         itr != headers.end(); ++itr) {
+        if (is_get && StringUtil::StringToLower(itr->first) == "if-none-match") {
+            continue;
+        }
+        if (StringUtil::StringStartsWithIgnoreCase(itr->first, "If-")
+            || StringUtil::StringToLower(itr->first) == "range") {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 缓存被并发淘汰时重新查找的次数上限, 超过后直接下载
+const unsigned kMaxDiskCacheAttempts = 3;
+
+// 把查找或填充时打开的缓存文件写入os, 或复制到local_path. 读取失败时返回false
+// 复制缓存文件的前size字节, 之后是缓存记录的key
+bool CopyCachedFile(const DiskCacheEntry& entry, std::ostream* os,
+                    const std::string& local_path) {
+    if (!entry.m_file || !entry.m_file->is_open()) {
+        return false;
+    }
+    std::ifstream& ifs = *entry.m_file;
+    ifs.clear();
+    if (!ifs.seekg(0)) {
+        return false;
+    }
+    std::ofstream ofs;
+    if (os == NULL) {
+        ofs.open(local_path.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!ofs.is_open()) {
+            return false;
+        }
+        os = &ofs;
+    }
+    char buf[64 * 1024];
+    uint64_t remain = entry.m_size;
+    while (remain > 0) {
+        std::streamsize len
+            = static_cast<std::streamsize>(std::min<uint64_t>(remain, sizeof(buf)));
+        if (!ifs.read(buf, len)) {
+            return false;
+        }
+        os->write(buf, len);
+        remain -= len;
+    }
+    return !os->bad();
+}
+
+// 缓存命中时返回的响应头: 填充时保存的响应头, 长度以缓存记录为准
+std::map<std::string, std::string> GetCachedRespHeaders(const DiskCacheEntry& entry) {
+    std::map<std::string, std::string> headers = entry.m_headers;
+    if (headers.find(kReqHeaderEtag) == headers.end()) {
+        headers[kReqHeaderEtag] = entry.m_etag;
+    }
+    headers[kReqHeaderContentLen] = StringUtil::Uint64ToString(entry.m_size);
+    return headers;
+}
+
+// 合并请求的key, 只有方法、地址、参数和请求头完全相同且写入计数相同的请求才会合并
+std::string GetSingleFlightKey(const std::string& host, const std::string& path,
+                               const BaseReq& req, uint64_t write_generation) {
+    std::string key = req.GetMethod() + (req.IsHttps() ? " https://" : " http://") + host + path;
+    const std::map<std::string, std::string>& params = req.GetParams();
+    for (std::map<std::string, std::string>::const_iterator itr = params.begin();
+         itr != params.end(); ++itr) {
+        key += "\n?" + itr->first + "=" + itr->second;
+    }
+    const std::map<std::string, std::string>& headers = req.GetHeaders();
+    for (std::map<std::string, std::string>::const_iterator itr = headers.begin();
+         itr != headers.end(); ++itr) {
+        key += "\n" + itr->first + ":" + itr->second;
+    }
+    // 写入开始后发出的请求不与写入前的请求合并, 避免拿到写入前的结果
+    key += "\n#" + StringUtil::Uint64ToString(write_generation);
+    return key;
+}
+
+} // namespace
+
+ObjectOp::ObjectOp(CosConfig& config)
+    : BaseOp(config), m_negative_cache(new NegativeCache()),
+      m_cache_generation(new CacheGeneration()) {
+    const MetaCachePolicy& policy = config.GetMetaCachePolicy();
+    if (policy.IsEnable()) {
+        m_meta_cache.reset(new ObjectMetaCache(policy));
+    }
+    // 打开失败时不使用磁盘缓存, 不影响正常下载
+    const DiskCachePolicy& disk_policy = config.GetDiskCachePolicy();
+    if (disk_policy.IsEnable()) {
+        m_disk_cache = DiskCache::Open(disk_policy);
+    }
+    if (config.GetSingleFlightPolicy().IsEnable()) {
+        m_single_flight.reset(new SingleFlight());
+    }
+}
+
+ObjectOp::ObjectOp()
+    : m_negative_cache(new NegativeCache()), m_cache_generation(new CacheGeneration()) {
+}
+
+ObjectOp::CacheWriteGuard::CacheWriteGuard(ObjectOp* op, const std::string& bucket_name)
+    : m_op(op), m_bucket_name(bucket_name) {
+}
+
+ObjectOp::CacheWriteGuard::CacheWriteGuard(ObjectOp* op, const std::string& bucket_name,
+                                           const std::string& object_name)
+    : m_op(op), m_bucket_name(bucket_name) {
+    Add(object_name);
+}
+
+ObjectOp::CacheWriteGuard::~CacheWriteGuard() {
+    // 写入期间发出的读取可能在写入前读到旧数据并放入缓存, 写入结束(无论成败)后再删除一次
+    for (size_t i = 0; i < m_object_names.size(); ++i) {
+        m_op->InvalidateCache(m_bucket_name, m_object_names[i]);
+    }
+}
+
+void ObjectOp::CacheWriteGuard::Add(const std::string& object_name) {
+    m_op->InvalidateCache(m_bucket_name, object_name);
+    m_object_names.push_back(object_name);
+}
+
+void ObjectOp::InvalidateCache(const std::string& bucket_name, const std::string& object_name) {
+    m_cache_generation->Bump(bucket_name, object_name);
+    m_negative_cache->Invalidate(bucket_name, object_name);
+    if (m_meta_cache) {
+        m_meta_cache->Invalidate(bucket_name, object_name);
+    }
+    if (m_disk_cache) {
+        m_disk_cache->Invalidate(bucket_name, object_name);
+    }
+}
+
+bool ObjectOp::UpdateMetaCache(const std::string& bucket_name, const std::string& object_name,
+                               const std::string& if_none_match, uint64_t write_generation,
+                               const CosResult& result, BaseResp* resp) {
+    if (result.IsSucc()) {
+        m_meta_cache->Put(bucket_name, object_name, resp->GetEtag(), resp->GetHeaders());
+        // 放入后再比较, 与写入结束时的删除不会交错出遗留的旧记录
+        if (m_cache_generation->IsChanged(bucket_name, object_name, write_generation)) {
+            m_meta_cache->Invalidate(bucket_name, object_name);
+        }
+        return false;
+    }
+    if (result.GetHttpStatus() == 304 && !if_none_match.empty()) {
+        std::map<std::string, std::string> headers;
+        if (m_meta_cache->Revalidate(bucket_name, object_name, if_none_match, &headers)) {
+            resp->ParseFromHeaders(headers);
+            if (m_cache_generation->IsChanged(bucket_name, object_name, write_generation)) {
+                m_meta_cache->Invalidate(bucket_name, object_name);
+            }
+            return true;
+        }
+        return false;
+    }
+    // 404等错误说明缓存的元数据已不可信
+    if (result.GetHttpStatus() != -1) {
+        m_meta_cache->Invalidate(bucket_name, object_name);
+    }
+    return false;
+}
+
+bool ObjectOp::GetNotModifiedFromCache(const ObjectReq& req, BaseResp* resp, CosResult* result) {
+    std::string if_none_match = req.GetHeader("If-None-Match");
+    if (!m_meta_cache || if_none_match.empty() || !IsMetaCacheable(req, true)) {
+        return false;
+    }
+    std::map<std::string, std::string> headers;
+    std::string etag;
+    if (m_meta_cache->Lookup(req.GetBucketName(), req.GetObjectName(), &headers, &etag)
+            != META_CACHE_FRESH || !StringUtil::ETagMatches(if_none_match, etag)) {
+        return false;
+    }
+    // 与服务端返回304时的结果保持一致
+    resp->ParseFromHeaders(headers);
+    result->SetHttpStatus(304);
+    return true;
+}
+
+ObjectMetaCacheStat ObjectOp::GetMetaCacheStat() const {
+    if (!m_meta_cache) {
+        return ObjectMetaCacheStat();
+    }
+    return m_meta_cache->GetStat();
+}
+
+DiskCacheStat ObjectOp::GetDiskCacheStat() const {
+    if (!m_disk_cache) {
+        return DiskCacheStat();
+    }
+    return m_disk_cache->GetStat();
+}
+
+SingleFlightStat ObjectOp::GetSingleFlightStat() const {
+    if (!m_single_flight) {
+        return SingleFlightStat();
+    }
+    return m_single_flight->GetStat();
+}
+
+CosResult ObjectOp::SingleFlightHead(const std::string& host, const std::string& path,
+                                     const HeadObjectReq& req, HeadObjectResp* resp) {
+    if (!m_single_flight) {
+        return NormalAction(host, path, req, "", false, resp);
+    }
+
+    std::string key = GetSingleFlightKey(host, path, req,
+        m_cache_generation->Get(req.GetBucketName(), req.GetObjectName()));
+    SharedFlightCall call;
+    if (!m_single_flight->Begin(key, &call)) {
+        if (m_single_flight->Wait(call, req.GetDeadlineInms(), req.GetCancelToken())) {
+            resp->ParseFromHeaders(call->m_resp_headers);
+            return call->m_result;
+        }
+        return NormalAction(host, path, req, "", false, resp);
+    }
+
+    CosResult result = NormalAction(host, path, req, "", false, resp);
+    // 未收到服务端响应(网络错误、取消或超时)时不分发, 等待方各自发出请求
+    call->m_is_shared = result.GetHttpStatus() > 0;
+    call->m_result = result;
+    call->m_resp_headers = resp->GetHeaders();
+    m_single_flight->End(key, call);
+    return result;
+}
+
+CosResult ObjectOp::SingleFlightDownload(const std::string& host, const std::string& path,
+                                         const GetObjectReq& req, GetObjectResp* resp,
+                                         std::ostream& os) {
+    if (!m_single_flight) {
+        return DownloadAction(host, path, req, resp, os, true);
+    }
+
+    std::string key = GetSingleFlightKey(host, path, req,
+        m_cache_generation->Get(req.GetBucketName(), req.GetObjectName()));
+    SharedFlightCall call;
+    if (!m_single_flight->Begin(key, &call)) {
+        if (m_single_flight->Wait(call, req.GetDeadlineInms(), req.GetCancelToken())) {
+            CosResult result = call->m_result;
+            resp->ParseFromHeaders(call->m_resp_headers);
+            os.write(call->m_body.data(), call->m_body.size());
+            if (os.bad()) {
+                result.SetFail();
+                result.SetErrorInfo("Write output stream fail, object=" + req.GetObjectName());
+            }
+            return result;
+        }
+        return DownloadAction(host, path, req, resp, os, true);
+    }
+
+    // 下载的同时在内存中暂存响应体, 超过上限时立即唤醒等待方各自下载
+    TeeStreamBuf tee_buf(&os, m_config.GetSingleFlightPolicy().GetMaxSharedBytes(),
+                         boost::bind(&SingleFlight::Abandon, m_single_flight.get(), key, call));
+    std::ostream tee_os(&tee_buf);
+    CosResult result = DownloadAction(host, path, req, resp, tee_os, true);
+    tee_os.flush();
+    if (!tee_buf.HasOverflowed() && result.GetHttpStatus() > 0) {
+        call->m_is_shared = true;
+        call->m_result = result;
+        call->m_resp_headers = resp->GetHeaders();
+        call->m_body = tee_buf.GetBytes();
+    }
+    m_single_flight->End(key, call);
+    return result;
+}
+
+bool ObjectOp::GetObjectByDiskCache(const GetObjectReq& req, bool is_multi, std::ostream* os,
+                                    const std::string& local_path, GetObjectResp* resp,
+                                    CosResult* result) {
+    if (!m_disk_cache || !IsMetaCacheable(req, false)) {
+        return false;
+    }
+
+    const std::string& bucket_name = req.GetBucketName();
+    const std::string& object_name = req.GetObjectName();
+    for (unsigned attempt = 0; attempt < kMaxDiskCacheAttempts; ++attempt) {
+        uint64_t write_generation = m_cache_generation->Get(bucket_name, object_name);
+        DiskCacheEntry entry;
+        bool is_cached = m_disk_cache->Lookup(bucket_name, object_name, &entry);
+        if (!is_cached || !entry.m_is_fresh) {
+            bool is_filled = false;
+            if (m_disk_cache->BeginFill(bucket_name, object_name, req.GetDeadlineInms(),
+                                        req.GetCancelToken(), &is_filled)) {
+                bool is_revalidated = false;
+                bool is_temp = false;
+                *result = FillDiskCache(req, is_multi, is_cached ? entry.m_etag : "",
+                                        write_generation, resp, &entry, &is_revalidated,
+                                        &is_temp);
+                m_disk_cache->EndFill(bucket_name, object_name, result->IsSucc() && !is_temp);
+                if (!result->IsSucc()) {
+                    return true;
+                }
+                bool is_copied = CopyCachedFile(entry, os, local_path);
+                if (is_temp) {
+                    unlink(entry.m_path.c_str());
+                }
+                if (is_copied) {
+                    if (is_revalidated) {
+                        m_disk_cache->AddHit(true);
+                    }
+                    return true;
+                }
+                continue;
+            }
+            // 其它线程填充失败或等待超时、被取消时直接下载, 取消和超时的错误由下载返回
+            if (!is_filled) {
+                break;
+            }
+            // 其它线程刚完成填充时直接读取, 不再重新验证
+            if (!m_disk_cache->Lookup(bucket_name, object_name, &entry)) {
+                continue;
+            }
+        }
+
+        if (CopyCachedFile(entry, os, local_path)) {
+            resp->ParseFromHeaders(GetCachedRespHeaders(entry));
+            m_disk_cache->AddHit(false);
+            result->SetSucc();
+            result->SetHttpStatus(200);
+            return true;
+        }
+    }
+
+    SDK_LOG_WARN("Read disk cache fail, download directly, bucket=%s, object=%s",
+                 bucket_name.c_str(), object_name.c_str());
+    return false;
+}
+
+CosResult ObjectOp::FillDiskCache(const GetObjectReq& req, bool is_multi,
+                                  const std::string& cached_etag, uint64_t write_generation,
+                                  GetObjectResp* resp, DiskCacheEntry* entry,
+                                  bool* is_revalidated, bool* is_temp) {
+    const std::string& bucket_name = req.GetBucketName();
+    const std::string& object_name = req.GetObjectName();
+    std::string temp_path = m_disk_cache->GetTempPath(bucket_name, object_name);
+    CosResult result;
+    // is_multi为true时req和resp分别是MultiGetObjectReq和MultiGetObjectResp
+    if (is_multi) {
+        // 分块下载不支持条件请求, 先比较HeadObject返回的ETag
+        if (!cached_etag.empty()) {
+            HeadObjectReq head_req(bucket_name, object_name);
+            head_req.AddHeaders(req.GetHeaders());
+            head_req.SetConnTimeoutInms(req.GetConnTimeoutInms());
+            head_req.SetRecvTimeoutInms(req.GetRecvTimeoutInms());
+            head_req.SetCancelToken(req.GetCancelToken());
+            head_req.SetPriority(req.GetPriority());
+            head_req.SetDeadlineInms(req.GetDeadlineInms());
+            if (req.IsHttps()) {
+                head_req.SetHttps();
+            }
+            HeadObjectResp head_resp;
+            result = HeadObject(head_req, &head_resp);
+            if (result.IsSucc() && head_resp.GetEtag() == cached_etag) {
+                result.SetHttpStatus(304);
+                result.SetFail();
+            }
+        }
+        if (cached_etag.empty() || result.IsSucc()) {
+            MultiGetObjectReq fill_req(static_cast<const MultiGetObjectReq&>(req));
+            fill_req.SetLocalFilePath(temp_path);
+            result = MultiThreadDownload(fill_req, static_cast<MultiGetObjectResp*>(resp));
+        }
+    } else {
+        GetObjectByFileReq fill_req(bucket_name, object_name, temp_path);
+        fill_req.AddHeaders(req.GetHeaders());
+        fill_req.SetConnTimeoutInms(req.GetConnTimeoutInms());
+        fill_req.SetRecvTimeoutInms(req.GetRecvTimeoutInms());
+        fill_req.SetCancelToken(req.GetCancelToken());
+        fill_req.SetPriority(req.GetPriority());
+        fill_req.SetDeadlineInms(req.GetDeadlineInms());
+        if (req.IsHttps()) {
+            fill_req.SetHttps();
+        }
+        if (!cached_etag.empty()) {
+            fill_req.AddHeader("If-None-Match", StringUtil::QuoteETag(cached_etag));
+        }
+        std::ofstream ofs(temp_path.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!ofs.is_open()) {
+            result.SetErrorInfo("Open disk cache file fail, file=" + temp_path);
+            return result;
+        }
+        std::string host = CosSysConfig::GetHost(GetAppId(), m_config.GetRegion(), bucket_name);
+        result = DownloadAction(host, req.GetPath(), fill_req, resp, ofs, true);
+        ofs.close();
+    }
+
+    if (result.GetHttpStatus() == 304 && !result.IsSucc()) {
+        // 未修改, 继续使用缓存文件
+        unlink(temp_path.c_str());
+        // 验证期间有写入时不延长有效期, 写入结束时会删除该记录
+        if (!m_cache_generation->IsChanged(bucket_name, object_name, write_generation)) {
+            m_disk_cache->Refresh(bucket_name, object_name);
+        }
+        // 返回缓存的响应头, request id以本次验证请求为准
+        std::map<std::string, std::string> headers = GetCachedRespHeaders(*entry);
+        std::string request_id = resp->GetXCosRequestId();
+        if (!request_id.empty()) {
+            headers[kReqHeaderXCosReqId] = request_id;
+        }
+        resp->ParseFromHeaders(headers);
+        *is_revalidated = true;
+        result = CosResult();
+        result.SetSucc();
+        result.SetHttpStatus(200);
+        return result;
+    }
+    if (!result.IsSucc()) {
+        unlink(temp_path.c_str());
+        if (result.GetHttpStatus() == 404) {
+            m_disk_cache->Invalidate(bucket_name, object_name);
+        }
+        return result;
+    }
+
+    // 下载期间有写入时文件可能是写入前的内容, 只给本次调用读取, 不加入缓存
+    uint64_t size = FileUtil::GetFileLen(temp_path);
+    // 分块下载的响应头来自其中一个分块, 不保存分块的范围
+    std::map<std::string, std::string> resp_headers = resp->GetHeaders();
+    resp_headers.erase("Content-Range");
+    if (m_cache_generation->IsChanged(bucket_name, object_name, write_generation)
+        || !m_disk_cache->Commit(bucket_name, object_name, temp_path, resp->GetEtag(), size,
+                                 resp_headers, entry)) {
+        entry->m_path = temp_path;
+        entry->m_file.reset(
+            new std::ifstream(temp_path.c_str(), std::ios::in | std::ios::binary));
+        entry->m_size = size;
+        *is_temp = true;
+    } else if (m_cache_generation->IsChanged(bucket_name, object_name, write_generation)) {
+        // 加入缓存的同时有写入开始, 删除记录, 已打开的文件仍可读取
+        m_disk_cache->Invalidate(bucket_name, object_name);
+    }
+    return result;
+}
+
 bool ObjectOp::IsObjectExist(const std::string& bucket_name, const std::string& object_name) {
     HeadObjectReq req(bucket_name, object_name);
     HeadObjectResp resp;
@@ -45,7 +629,111 @@ CosResult ObjectOp::HeadObject(const HeadObjectReq& req, HeadObjectResp* resp) {
     std::string host = CosSysConfig::GetHost(GetAppId(), m_config.GetRegion(),
                                              req.GetBucketName());
     std::string path = req.GetPath();
-    return NormalAction(host, path, req, "", false, resp);
+    if (!m_meta_cache || !IsMetaCacheable(req, false)) {
+        return SingleFlightHead(host, path, req, resp);
+    }
+
+    CosResult result;
+    std::map<std::string, std::string> headers;
+    std::string etag;
+    uint64_t write_generation = m_cache_generation->Get(req.GetBucketName(),
+                                                        req.GetObjectName());
+    META_CACHE_STATE state = m_meta_cache->Lookup(req.GetBucketName(), req.GetObjectName(),
+                                                  &headers, &etag);
+    if (state == META_CACHE_FRESH) {
+        resp->ParseFromHeaders(headers);
+        result.SetSucc();
+        result.SetHttpStatus(200);
+        result.SetXCosRequestId(resp->GetXCosRequestId());
+        return result;
+    }
+
+    // 过期的记录携带ETag重新验证, 未修改时服务端只返回304
+    if (state == META_CACHE_STALE && !etag.empty()) {
+        HeadObjectReq revalidate_req(req);
+        revalidate_req.AddHeader("If-None-Match", StringUtil::QuoteETag(etag));
+        result = SingleFlightHead(host, path, revalidate_req, resp);
+    } else {
+        etag.clear();
+        result = SingleFlightHead(host, path, req, resp);
+    }
+    if (UpdateMetaCache(req.GetBucketName(), req.GetObjectName(), etag, write_generation,
+                        result, resp)) {
+        result.SetSucc();
+        result.SetHttpStatus(200);
+        result.SetErrorInfo("");
+    } else if (result.GetHttpStatus() == 304) {
+        // 重新验证期间记录被删除, 重新获取完整的元数据
+        result = SingleFlightHead(host, path, req, resp);
+        UpdateMetaCache(req.GetBucketName(), req.GetObjectName(), "", write_generation, result,
+                        resp);
+    }
+    return result;
+}
+
+CosResult ObjectOp::BatchHeadObject(const BatchHeadObjectReq& req, BatchHeadObjectResp* resp) {
+    const std::vector<std::string>& objects = req.GetObjects();
+    std::vector<HeadObjectResult>* results = resp->GetResultsPtr();
+    results->assign(objects.size(), HeadObjectResult());
+
+    // 先过滤掉近期确认不存在的Object
+    std::vector<size_t> pending_idxs;
+    std::vector<std::string> pending_objects;
+    std::vector<uint64_t> write_generations;
+    uint64_t cache_hit_count = 0;
+    for (size_t i = 0; i < objects.size(); ++i) {
+        if (req.GetNegativeCacheTtlInms() > 0
+            && m_negative_cache->Contains(req.GetBucketName(), objects[i])) {
+            ++cache_hit_count;
+            continue;
+        }
+        pending_idxs.push_back(i);
+        pending_objects.push_back(objects[i]);
+        write_generations.push_back(m_cache_generation->Get(req.GetBucketName(), objects[i]));
+    }
+    resp->SetCacheHitCount(cache_hit_count);
+
+    std::vector<HeadObjectResult> pending_results(pending_objects.size());
+    BatchHeadObjectReq head_req(req.GetBucketName(), pending_objects);
+    head_req.SetConnTimeoutInms(req.GetConnTimeoutInms());
+    head_req.SetRecvTimeoutInms(req.GetRecvTimeoutInms());
+    head_req.SetDeadlineInms(req.GetDeadlineInms());
+    head_req.SetCancelToken(req.GetCancelToken());
+    head_req.SetPriority(req.GetPriority());
+    if (req.IsHttps()) {
+        head_req.SetHttps();
+    }
+    if (!pending_objects.empty()) {
+        unsigned thread_num = std::min(std::max(req.GetThreadNum(), 1u),
+                                       static_cast<unsigned>(pending_objects.size()));
+        BatchHeadContext ctx(head_req, &pending_results);
+        TaskGroup tp(thread_num);
+        for (unsigned i = 0; i < thread_num; ++i) {
+            tp.Schedule(boost::bind(&RunBatchHead, this, &ctx));
+        }
+        tp.Wait();
+    }
+
+    CosResult result;
+    result.SetSucc();
+    for (size_t i = 0; i < pending_idxs.size(); ++i) {
+        const HeadObjectResult& head_result = pending_results[i];
+        (*results)[pending_idxs[i]] = head_result;
+        if (head_result.m_http_status == 404) {
+            m_negative_cache->Add(req.GetBucketName(), pending_objects[i],
+                                  req.GetNegativeCacheTtlInms());
+            // 检查期间被写入的Object可能已经存在
+            if (m_cache_generation->IsChanged(req.GetBucketName(), pending_objects[i],
+                                              write_generations[i])) {
+                m_negative_cache->Invalidate(req.GetBucketName(), pending_objects[i]);
+            }
+        } else if (head_result.IsError() && result.IsSucc()) {
+            result.SetFail();
+            result.SetHttpStatus(head_result.m_http_status);
+            result.SetErrorInfo("Head object fail, object=" + pending_objects[i]);
+        }
+    }
+    return result;
 }
 
 CosResult ObjectOp::GetObject(const GetObjectByStreamReq& req,
@@ -53,8 +741,22 @@ CosResult ObjectOp::GetObject(const GetObjectByStreamReq& req,
     std::string host = CosSysConfig::GetHost(GetAppId(), m_config.GetRegion(),
                                              req.GetBucketName());
     std::string path = req.GetPath();
+    CosResult result;
+    uint64_t write_generation = m_cache_generation->Get(req.GetBucketName(),
+                                                        req.GetObjectName());
+    if (GetNotModifiedFromCache(req, resp, &result)) {
+        return result;
+    }
     std::ostream& os = req.GetStream();
-    return DownloadAction(host, path, req, resp, os);
+    if (GetObjectByDiskCache(req, false, &os, "", resp, &result)) {
+        return result;
+    }
+    result = SingleFlightDownload(host, path, req, resp, os);
+    if (m_meta_cache && IsMetaCacheable(req, true)) {
+        UpdateMetaCache(req.GetBucketName(), req.GetObjectName(), req.GetHeader("If-None-Match"),
+                        write_generation, result, resp);
+    }
+    return result;
 }
 
 CosResult ObjectOp::GetObject(const GetObjectByFileReq& req,
@@ -63,23 +765,41 @@ CosResult ObjectOp::GetObject(const GetObjectByFileReq& req,
     std::string host = CosSysConfig::GetHost(GetAppId(), m_config.GetRegion(),
                                              req.GetBucketName());
     std::string path = req.GetPath();
+    uint64_t write_generation = m_cache_generation->Get(req.GetBucketName(),
+                                                        req.GetObjectName());
+    // 未修改时不打开本地文件, 保留已有内容
+    if (GetNotModifiedFromCache(req, resp, &result)) {
+        return result;
+    }
+    if (GetObjectByDiskCache(req, false, NULL, req.GetLocalFilePath(), resp, &result)) {
+        return result;
+    }
     std::ofstream ofs(req.GetLocalFilePath().c_str(),
                      std::ios::out | std::ios::binary | std::ios::trunc);
     if (!ofs.is_open()) {
         result.SetErrorInfo("Open local file fail, local file=" + req.GetLocalFilePath());
         return result;
     }
-    result = DownloadAction(host, path, req, resp, ofs);
+    result = SingleFlightDownload(host, path, req, resp, ofs);
     ofs.close();
+    if (m_meta_cache && IsMetaCacheable(req, true)) {
+        UpdateMetaCache(req.GetBucketName(), req.GetObjectName(), req.GetHeader("If-None-Match"),
+                        write_generation, result, resp);
+    }
 
     return result;
 }
 
 CosResult ObjectOp::GetObject(const MultiGetObjectReq& req, MultiGetObjectResp* resp) {
+    CosResult result;
+    if (GetObjectByDiskCache(req, true, NULL, req.GetLocalFilePath(), resp, &result)) {
+        return result;
+    }
     return MultiThreadDownload(req, resp);
 }
 
 CosResult ObjectOp::PutObject(const PutObjectByStreamReq& req, PutObjectByStreamResp* resp) {
+    CacheWriteGuard cache_guard(this, req.GetBucketName(), req.GetObjectName());
     CosResult result;
     std::string host = CosSysConfig::GetHost(GetAppId(), m_config.GetRegion(),
                                              req.GetBucketName());
@@ -119,6 +839,7 @@ CosResult ObjectOp::PutObject(const PutObjectByStreamReq& req, PutObjectByStream
 }
 
 CosResult ObjectOp::PutObject(const PutObjectByFileReq& req, PutObjectByFileResp* resp) {
+    CacheWriteGuard cache_guard(this, req.GetBucketName(), req.GetObjectName());
     CosResult result;
     std::string host = CosSysConfig::GetHost(GetAppId(), m_config.GetRegion(),
                                              req.GetBucketName());
@@ -126,11 +847,14 @@ CosResult ObjectOp::PutObject(const PutObjectByFileReq& req, PutObjectByFileResp
     std::map<std::string, std::string> additional_headers;
     std::map<std::string, std::string> additional_params;
 
-    std::ifstream ifs(req.GetLocalFilePath().c_str(), std::ios::in | std::ios::binary);
-    if (!ifs.is_open()) {
-        result.SetErrorInfo("Open local file fail, local file=" + req.GetLocalFilePath());
+    // 非TLS连接上由HttpSender用sendfile直接发送文件数据
+    const std::string& local_file_path = req.GetLocalFilePath();
+    FileInputBuf file_buf(local_file_path, 0, FileUtil::GetFileLen(local_file_path));
+    if (!file_buf.IsOpen()) {
+        result.SetErrorInfo("Open local file fail, local file=" + local_file_path);
         return result;
     }
+    std::istream ifs(&file_buf);
 
     // 如果传递的header中没有Content-MD5则进行SDK进行MD5校验
     bool is_check_md5 = false;
@@ -157,11 +881,11 @@ CosResult ObjectOp::PutObject(const PutObjectByFileReq& req, PutObjectByFileResp
                     md5_str.c_str(), resp->GetEtag().c_str(), resp->GetXCosRequestId().c_str());
     }
 
-    ifs.close();
     return result;
 }
 
 CosResult ObjectOp::DeleteObject(const DeleteObjectReq& req, DeleteObjectResp* resp) {
+    CacheWriteGuard cache_guard(this, req.GetBucketName(), req.GetObjectName());
     std::string host = CosSysConfig::GetHost(GetAppId(), m_config.GetRegion(),
                                              req.GetBucketName());
     std::string path = req.GetPath();
@@ -169,6 +893,12 @@ CosResult ObjectOp::DeleteObject(const DeleteObjectReq& req, DeleteObjectResp* r
 }
 
 CosResult ObjectOp::DeleteObjects(const DeleteObjectsReq& req, DeleteObjectsResp* resp) {
+    const std::vector<ObjectVersionPair>& objects = req.GetObjectVersions();
+    CacheWriteGuard cache_guard(this, req.GetBucketName());
+    for (std::vector<ObjectVersionPair>::const_iterator itr = objects.begin();
+         itr != objects.end(); ++itr) {
+        cache_guard.Add(itr->m_object_name);
+    }
     std::string host = CosSysConfig::GetHost(GetAppId(), m_config.GetRegion(),
                                              req.GetBucketName());
 
@@ -188,6 +918,40 @@ CosResult ObjectOp::DeleteObjects(const DeleteObjectsReq& req, DeleteObjectsResp
                         additional_params, req_body, false, resp);
 }
 
+CosResult ObjectOp::BulkDelete(const BulkDeleteReq& req, BulkDeleteResp* resp) {
+    VectorDeleteKeyIterator keys(req.GetObjectVersions());
+    return BulkDelete(req, &keys, resp);
+}
+
+CosResult ObjectOp::BulkDelete(const BulkDeleteReq& req, DeleteKeyIterator* keys,
+                               BulkDeleteResp* resp) {
+    BulkDeleter deleter(*this, req);
+    return deleter.Run(keys, resp);
+}
+
+CosResult ObjectOp::DeleteObjectsByPrefix(const BulkDeleteReq& req, const std::string& prefix,
+                                          BulkDeleteResp* resp) {
+    if (prefix.empty()) {
+        CosResult result;
+        result.SetErrorInfo("Delete objects by prefix requires a non-empty prefix.");
+        return result;
+    }
+
+    GetBucketReq list_req(req.GetBucketName());
+    list_req.SetPrefix(prefix);
+    list_req.SetConnTimeoutInms(req.GetConnTimeoutInms());
+    list_req.SetRecvTimeoutInms(req.GetRecvTimeoutInms());
+    list_req.SetDeadlineInms(req.GetDeadlineInms());
+    list_req.SetCancelToken(req.GetCancelToken());
+    list_req.SetPriority(req.GetPriority());
+    if (req.IsHttps()) {
+        list_req.SetHttps();
+    }
+    BucketOp bucket_op(m_config);
+    PrefixDeleteKeyIterator keys(bucket_op, list_req, req.GetListPrefetchDepth());
+    return BulkDelete(req, &keys, resp);
+}
+
 CosResult ObjectOp::MultiUploadObject(const MultiUploadObjectReq& req,
                                       MultiUploadObjectResp* resp) {
     CosResult result;
@@ -208,9 +972,20 @@ CosResult ObjectOp::MultiUploadObject(const MultiUploadObjectReq& req,
     if (!server_side_encryption.empty()) {
         init_req.SetXCosServerSideEncryption(server_side_encryption);
     }
+    // 自定义元数据在初始化时设置
+    const std::map<std::string, std::string>& headers = req.GetHeaders();
+    for (std::map<std::string, std::string>::const_iterator itr = headers.begin();
+         itr != headers.end(); ++itr) {
+        if (StringUtil::StringStartsWith(itr->first, kXCosMetaPrefix)) {
+            init_req.AddHeader(itr->first, itr->second);
+        }
+    }
     InitMultiUploadResp init_resp;
     init_req.SetConnTimeoutInms(req.GetConnTimeoutInms());
     init_req.SetRecvTimeoutInms(req.GetRecvTimeoutInms());
+    init_req.SetCancelToken(req.GetCancelToken());
+    init_req.SetPriority(req.GetPriority());
+    init_req.SetDeadlineInms(req.GetDeadlineInms());
     result = InitMultiUpload(init_req, &init_resp);
     if (!result.IsSucc()) {
         SDK_LOG_ERR("Multi upload object fail, check init mutli result.");
@@ -231,7 +1006,8 @@ CosResult ObjectOp::MultiUploadObject(const MultiUploadObjectReq& req,
     result = MultiThreadUpload(req, upload_id, &etags, &part_numbers);
     if (!result.IsSucc()) {
         SDK_LOG_ERR("Multi upload object fail, check upload mutli result.");
-        // Copy失败则需要Abort
+        // Copy失败则需要Abort. 被取消或超时时同样需要Abort以释放已上传的分块,
+        // 因此Abort请求不使用调用方的取消句柄和截止时间
         AbortMultiUploadReq abort_req(req.GetBucketName(),
                 req.GetObjectName(), upload_id);
         AbortMultiUploadResp abort_resp;
@@ -249,7 +1025,10 @@ CosResult ObjectOp::MultiUploadObject(const MultiUploadObjectReq& req,
     CompleteMultiUploadReq comp_req(bucket_name, object_name, upload_id);
     CompleteMultiUploadResp comp_resp;
     comp_req.SetConnTimeoutInms(req.GetConnTimeoutInms());
-    comp_req.SetRecvTimeoutInms(req.GetRecvTimeoutInms() * 2); // Complete的超时翻倍
+    comp_req.SetRecvTimeoutInms(GetRecvTimeoutInms(req) * 2); // Complete的超时翻倍
+    comp_req.SetCancelToken(req.GetCancelToken());
+    comp_req.SetPriority(req.GetPriority());
+    comp_req.SetDeadlineInms(req.GetDeadlineInms());
     comp_req.SetEtags(etags);
     comp_req.SetPartNumbers(part_numbers);
     const std::string& pic_operations = req.GetHeader("Pic-Operations");
@@ -263,6 +1042,19 @@ CosResult ObjectOp::MultiUploadObject(const MultiUploadObjectReq& req,
     return result;
 }
 
+CosResult ObjectOp::UploadDirectory(const UploadDirectoryReq& req,
+                                    UploadDirectoryHandler* handler,
+                                    UploadDirectoryResp* resp) {
+    DirectoryUploader uploader(*this, req, handler);
+    return uploader.Run(resp);
+}
+
+CosResult ObjectOp::DownloadPrefix(const DownloadPrefixReq& req, DownloadPrefixHandler* handler,
+                                   DownloadPrefixResp* resp) {
+    PrefixDownloader downloader(*this, req, handler);
+    return downloader.Run(resp);
+}
+
 CosResult ObjectOp::InitMultiUpload(const InitMultiUploadReq& req, InitMultiUploadResp* resp) {
     std::string host = CosSysConfig::GetHost(GetAppId(), m_config.GetRegion(),
                                              req.GetBucketName());
@@ -336,6 +1128,7 @@ CosResult ObjectOp::UploadPartCopyData(const UploadPartCopyDataReq& req, UploadP
 
 CosResult ObjectOp::CompleteMultiUpload(const CompleteMultiUploadReq& req,
                                         CompleteMultiUploadResp* resp) {
+    CacheWriteGuard cache_guard(this, req.GetBucketName(), req.GetObjectName());
     std::string host = CosSysConfig::GetHost(GetAppId(), m_config.GetRegion(),
                                              req.GetBucketName());
     std::string path = req.GetPath();
@@ -383,6 +1176,7 @@ CosResult ObjectOp::GetObjectACL(const GetObjectACLReq& req,
 
 CosResult ObjectOp::PutObjectACL(const PutObjectACLReq& req,
                                  PutObjectACLResp* resp) {
+    CacheWriteGuard cache_guard(this, req.GetBucketName(), req.GetObjectName());
     std::string host = CosSysConfig::GetHost(GetAppId(), m_config.GetRegion(),
                                              req.GetBucketName());
     std::string path = req.GetPath();
@@ -412,6 +1206,7 @@ CosResult ObjectOp::PutObjectACL(const PutObjectACLReq& req,
 
 CosResult ObjectOp::PutObjectCopy(const PutObjectCopyReq& req,
                                   PutObjectCopyResp* resp) {
+    CacheWriteGuard cache_guard(this, req.GetBucketName(), req.GetObjectName());
     std::string host = CosSysConfig::GetHost(GetAppId(), m_config.GetRegion(),
                                              req.GetBucketName());
     std::string path = req.GetPath();
@@ -421,6 +1216,9 @@ CosResult ObjectOp::PutObjectCopy(const PutObjectCopyReq& req,
 CosResult ObjectOp::Copy(const CopyReq& req, CopyResp* resp) {
     SDK_LOG_DBG("Copy request=%s", req.DebugString().c_str());
     CosResult result;
+    const ClientSettings& settings = m_config.GetClientSettings();
+    uint64_t part_size = req.GetPartSize() > 0 ? req.GetPartSize()
+        : settings.GetUploadCopyPartSize();
 
     // 获取源bucket/object/region
     std::string src_bucket_appid = "", src_obj = "", src_region = "";
@@ -458,6 +1256,9 @@ CosResult ObjectOp::Copy(const CopyReq& req, CopyResp* resp) {
         PutObjectCopyResp put_copy_resp;
         put_copy_req.SetConnTimeoutInms(req.GetConnTimeoutInms());
         put_copy_req.SetRecvTimeoutInms(req.GetRecvTimeoutInms());
+        put_copy_req.SetCancelToken(req.GetCancelToken());
+        put_copy_req.SetPriority(req.GetPriority());
+        put_copy_req.SetDeadlineInms(req.GetDeadlineInms());
 
         result = PutObjectCopy(put_copy_req, &put_copy_resp);
         if (result.IsSucc()) {
@@ -470,6 +1271,9 @@ CosResult ObjectOp::Copy(const CopyReq& req, CopyResp* resp) {
     HeadObjectReq head_req(src_bucket_appid, src_obj);
     head_req.SetConnTimeoutInms(req.GetConnTimeoutInms());
     head_req.SetRecvTimeoutInms(req.GetRecvTimeoutInms());
+    head_req.SetCancelToken(req.GetCancelToken());
+    head_req.SetPriority(req.GetPriority());
+    head_req.SetDeadlineInms(req.GetDeadlineInms());
     HeadObjectResp head_resp;
     std::string host = v[0];
     std::string path = head_req.GetPath();
@@ -490,19 +1294,25 @@ CosResult ObjectOp::Copy(const CopyReq& req, CopyResp* resp) {
         PutObjectCopyResp put_copy_resp;
         put_copy_req.SetConnTimeoutInms(req.GetConnTimeoutInms());
         put_copy_req.SetRecvTimeoutInms(req.GetRecvTimeoutInms());
+        put_copy_req.SetCancelToken(req.GetCancelToken());
+        put_copy_req.SetPriority(req.GetPriority());
+        put_copy_req.SetDeadlineInms(req.GetDeadlineInms());
 
         result = PutObjectCopy(put_copy_req, &put_copy_resp);
         if (result.IsSucc()) {
             resp->CopyFrom(put_copy_resp);
         }
         return result;
-    } else if (file_size < req.GetPartSize() * 10000) {
+    } else if (file_size < part_size * 10000) {
         SDK_LOG_INFO("File Size=%ld bigger than 5G, use put object copy.", file_size);
         // 1. InitMultiUploadReq
         InitMultiUploadReq init_req(req.GetBucketName(), req.GetObjectName());
         InitMultiUploadResp init_resp;
         init_req.SetConnTimeoutInms(req.GetConnTimeoutInms());
         init_req.SetRecvTimeoutInms(req.GetRecvTimeoutInms());
+        init_req.SetCancelToken(req.GetCancelToken());
+        init_req.SetPriority(req.GetPriority());
+        init_req.SetDeadlineInms(req.GetDeadlineInms());
         init_req.AddHeaders(req.GetInitHeader());
 
         result = InitMultiUpload(init_req, &init_resp);
@@ -520,20 +1330,24 @@ CosResult ObjectOp::Copy(const CopyReq& req, CopyResp* resp) {
         std::vector<uint64_t> part_numbers;
         const std::map<std::string, std::string>& part_copy_headers = req.GetPartCopyHeader();
 
-        unsigned pool_size = req.GetThreadPoolSize();
-        unsigned part_size = req.GetPartSize();
+        unsigned pool_size = req.GetThreadPoolSize() > 0 ? req.GetThreadPoolSize()
+            : settings.GetUploadThreadPoolSize();
         unsigned max_task_num = file_size / part_size + 1;
         if (max_task_num < pool_size) {
             pool_size = max_task_num;
         }
 
-        boost::threadpool::pool tp(pool_size);
+        TaskGroup tp(pool_size);
         std::string path = "/" + req.GetObjectName();
         std::string host = CosSysConfig::GetHost(GetAppId(), m_config.GetRegion(), req.GetBucketName());
         std::string dest_url = GetRealUrl(host, path, req.IsHttps());
+        // 取消或超过截止时间后, 各分块任务的请求立即失败, 按分块失败的流程Abort
+        SharedCancelToken cancel_token = CreateCancelToken(req);
         FileCopyTask** pptaskArr = new FileCopyTask*[pool_size];
         for (int i = 0; i < pool_size; ++i) {
-            pptaskArr[i] = new FileCopyTask(dest_url, req.GetConnTimeoutInms(), req.GetRecvTimeoutInms());
+            pptaskArr[i] = new FileCopyTask(dest_url, GetConnTimeoutInms(req), GetRecvTimeoutInms(req));
+            pptaskArr[i]->SetRetryPolicy(m_config.GetRetryPolicy());
+            pptaskArr[i]->SetParentCancelToken(cancel_token);
         }
 
         while (offset < file_size) {
@@ -552,14 +1366,14 @@ CosResult ObjectOp::Copy(const CopyReq& req, CopyResp* resp) {
                 FillCopyTask(upload_id, host, path, part_number, range,
                              part_copy_headers, req.GetParams(), ptask);
 
-                tp.schedule(boost::bind(&FileCopyTask::Run, ptask));
+                tp.Schedule(boost::bind(&FileCopyTask::Run, ptask));
                 part_numbers.push_back(part_number);
                 ++part_number;
                 offset = end + 1;
             }
 
             unsigned task_num = task_index;
-            tp.wait();
+            tp.Wait();
 
             for (task_index = 0; task_index < task_num; ++task_index) {
                 FileCopyTask* ptask = pptaskArr[task_index];
@@ -605,7 +1419,10 @@ CosResult ObjectOp::Copy(const CopyReq& req, CopyResp* resp) {
         // 3. Complete
         CompleteMultiUploadReq comp_req(req.GetBucketName(), req.GetObjectName(), upload_id);
         comp_req.SetConnTimeoutInms(req.GetConnTimeoutInms());
-        comp_req.SetRecvTimeoutInms(req.GetRecvTimeoutInms() * 2); // Complete的超时翻倍
+        comp_req.SetRecvTimeoutInms(GetRecvTimeoutInms(req) * 2); // Complete的超时翻倍
+        comp_req.SetCancelToken(req.GetCancelToken());
+        comp_req.SetPriority(req.GetPriority());
+        comp_req.SetDeadlineInms(req.GetDeadlineInms());
         CompleteMultiUploadResp comp_resp;
 
         comp_req.SetEtags(etags);
@@ -620,7 +1437,7 @@ CosResult ObjectOp::Copy(const CopyReq& req, CopyResp* resp) {
     } else {
         SDK_LOG_ERR("Source Object is too large or your upload copy part size in config"
                     "is too small, src obj size=%ld, copy_part_size=%ld",
-                    file_size, CosSysConfig::GetUploadCopyPartSize());
+                    file_size, part_size);
         result.SetErrorInfo("Could not copy object, because of object size is too large "
                             "or part size is too small.");
         return result;
@@ -629,6 +1446,7 @@ CosResult ObjectOp::Copy(const CopyReq& req, CopyResp* resp) {
 
 CosResult ObjectOp::PostObjectRestore(const PostObjectRestoreReq& req,
                                       PostObjectRestoreResp* resp) {
+    CacheWriteGuard cache_guard(this, req.GetBucketName(), req.GetObjectName());
     std::string host = CosSysConfig::GetHost(GetAppId(), m_config.GetRegion(),
                                              req.GetBucketName());
     std::string path = req.GetPath();
@@ -654,6 +1472,9 @@ CosResult ObjectOp::MultiThreadDownload(const MultiGetObjectReq& req, MultiGetOb
     CosResult result;
     // 1. 调用HeadObject获取文件长度
     HeadObjectReq head_req(req.GetBucketName(), req.GetObjectName());;
+    head_req.SetCancelToken(req.GetCancelToken());
+    head_req.SetPriority(req.GetPriority());
+    head_req.SetDeadlineInms(req.GetDeadlineInms());
     HeadObjectResp head_resp;
     result = HeadObject(head_req, &head_resp);
     // TODO(sevenyou): 下载请求返回head失败的信息, 略奇怪, 后面考虑优化下
@@ -674,8 +1495,7 @@ CosResult ObjectOp::MultiThreadDownload(const MultiGetObjectReq& req, MultiGetOb
         headers["x-cos-security-token"] = tmp_token;
     }
 
-    std::string auth_str = AuthTool::Sign(GetAccessKey(), GetSecretKey(),
-                                          req.GetMethod(), path, headers, params);
+    std::string auth_str = Sign(req.GetMethod(), path, headers, params);
     if (auth_str.empty()) {
         result.SetErrorInfo("Generate auth str fail, check your access_key/secret_key.");
         return result;
@@ -695,10 +1515,19 @@ CosResult ObjectOp::MultiThreadDownload(const MultiGetObjectReq& req, MultiGetOb
         result.SetErrorInfo(err_info);
         return result;
     }
+#ifdef FALLOC_FL_KEEP_SIZE
+    // 预先分配磁盘空间, 减少各分片乱序写入造成的碎片. 不改变文件长度, 文件系统不支持时忽略
+    if (file_size > 0 && fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, file_size) != 0) {
+        SDK_LOG_DBG("fallocate file(%s) fail, errno=%d", local_path.c_str(), errno);
+    }
+#endif
 
     // 4. 多线程下载
-    unsigned pool_size = req.GetThreadPoolSize();
-    unsigned slice_size = req.GetSliceSize();
+    const ClientSettings& settings = m_config.GetClientSettings();
+    unsigned pool_size = req.GetThreadPoolSize() > 0 ? req.GetThreadPoolSize()
+        : settings.GetDownThreadPoolMaxSize();
+    uint64_t slice_size = req.GetSliceSize() > 0 ? req.GetSliceSize()
+        : settings.GetDownSliceSize();
     unsigned max_task_num = file_size / slice_size + 1;
     if (max_task_num < pool_size) {
         pool_size = max_task_num;
@@ -710,24 +1539,59 @@ CosResult ObjectOp::MultiThreadDownload(const MultiGetObjectReq& req, MultiGetOb
     }
 
     std::string dest_url = GetRealUrl(host, path, req.IsHttps());
+    SharedCancelToken cancel_token = CreateCancelToken(req);
+    // 所有分片共享同一个限速器, 各分片按申请顺序轮流获得带宽
+    SharedRateLimiter rate_limiter = CreateRateLimiter(req, false);
     FileDownTask** pptaskArr = new FileDownTask*[pool_size];
     for (unsigned i = 0; i < pool_size; ++i) {
         pptaskArr[i] = new FileDownTask(dest_url, headers, params,
-                                req.GetConnTimeoutInms(), req.GetRecvTimeoutInms());
+                                GetConnTimeoutInms(req), GetRecvTimeoutInms(req));
+        pptaskArr[i]->SetRetryPolicy(m_config.GetRetryPolicy());
+        pptaskArr[i]->SetParentCancelToken(cancel_token);
+        pptaskArr[i]->SetRateLimiter(rate_limiter);
+        pptaskArr[i]->SetPriority(req.GetPriority());
     }
 
+    // 开启低速检测时, 每个分块额外准备一个推测任务及其缓冲区
+    const StallPolicy& stall_policy = m_config.GetStallPolicy();
+    FileDownTask** spec_tasks = NULL;
+    unsigned char** spec_bufs = NULL;
+    boost::scoped_ptr<TaskGroup> spec_tp;
+    if (stall_policy.IsEnable()) {
+        spec_tasks = new FileDownTask*[pool_size];
+        spec_bufs = new unsigned char*[pool_size];
+        for (unsigned i = 0; i < pool_size; ++i) {
+            spec_tasks[i] = new FileDownTask(dest_url, headers, params,
+                                             GetConnTimeoutInms(req), GetRecvTimeoutInms(req));
+            spec_tasks[i]->SetRetryPolicy(m_config.GetRetryPolicy());
+            spec_tasks[i]->SetParentCancelToken(cancel_token);
+            spec_tasks[i]->SetRateLimiter(rate_limiter);
+            spec_tasks[i]->SetPriority(req.GetPriority());
+            spec_bufs[i] = new unsigned char[slice_size];
+        }
+        spec_tp.reset(new TaskGroup(pool_size));
+    }
+    std::vector<boost::function<void()> > spec_fillers(pool_size);
+    std::vector<FileDownTask*> winners;
+
     SDK_LOG_DBG("download data,url=%s, poolsize=%u,slice_size=%u,file_size=%lu",
                 dest_url.c_str(), pool_size, slice_size, file_size);
 
     std::vector<uint64_t> vec_offset;
     vec_offset.resize(pool_size);
-    boost::threadpool::pool tp(pool_size);
+    TaskGroup tp(pool_size);
     uint64_t offset =0;
     bool task_fail_flag = false;
     unsigned down_times = 0;
     bool is_header_set = false;
     while(offset < file_size) {
         SDK_LOG_DBG("down data, offset=%lu, file_size=%lu", offset, file_size);
+        if (cancel_token && cancel_token->IsCancelled()) {
+            SDK_LOG_ERR("down data, %s", cancel_token->GetErrMsg().c_str());
+            result.SetErrorInfo(cancel_token->GetErrMsg());
+            task_fail_flag = true;
+            break;
+        }
         unsigned task_index = 0;
         vec_offset.clear();
         for (; task_index < pool_size && (offset < file_size); ++task_index) {
@@ -736,7 +1600,12 @@ CosResult ObjectOp::MultiThreadDownload(const MultiGetObjectReq& req, MultiGetOb
             FileDownTask* ptask = pptaskArr[task_index];
 
             ptask->SetDownParams(file_content_buf[task_index], slice_size, offset);
-            tp.schedule(boost::bind(&FileDownTask::Run, ptask));
+            tp.Schedule(boost::bind(&FileDownTask::Run, ptask));
+            if (spec_tasks != NULL) {
+                spec_fillers[task_index] = boost::bind(&FileDownTask::SetDownParams,
+                                                       spec_tasks[task_index],
+                                                       spec_bufs[task_index], slice_size, offset);
+            }
             vec_offset[task_index] = offset;
             offset += slice_size;
             ++down_times;
@@ -744,10 +1613,13 @@ CosResult ObjectOp::MultiThreadDownload(const MultiGetObjectReq& req, MultiGetOb
 
         unsigned task_num = task_index;
 
-        tp.wait();
+        WaitPartTasks(stall_policy, &tp, spec_tp.get(), pptaskArr, spec_tasks,
+                      spec_fillers, task_num, &winners);
 
         for (task_index = 0; task_index < task_num; ++task_index) {
-            FileDownTask *ptask = pptaskArr[task_index];
+            FileDownTask *ptask = winners[task_index];
+            unsigned char* data_buf = (ptask == pptaskArr[task_index])
+                ? file_content_buf[task_index] : spec_bufs[task_index];
             if (!ptask->IsTaskSuccess()) {
                 const std::string& task_resp = ptask->GetTaskResp();
                 const std::map<std::string, std::string>& task_resp_headers
@@ -774,7 +1646,7 @@ CosResult ObjectOp::MultiThreadDownload(const MultiGetObjectReq& req, MultiGetOb
                     break;
                 }
 
-                if (-1 == write(fd, file_content_buf[task_index], ptask->GetDownLoadLen())) {
+                if (-1 == write(fd, data_buf, ptask->GetDownLoadLen())) {
                     std::string err_info = "down data, write ret="
                         + StringUtil::IntToString(errno) + ", len="
                         + StringUtil::Uint64ToString(ptask->GetDownLoadLen());
@@ -815,6 +1687,14 @@ CosResult ObjectOp::MultiThreadDownload(const MultiGetObjectReq& req, MultiGetOb
     }
     delete [] pptaskArr;
     delete [] file_content_buf;
+    if (spec_tasks != NULL) {
+        for (unsigned i = 0; i < pool_size; ++i) {
+            delete [] spec_bufs[i];
+            delete spec_tasks[i];
+        }
+        delete [] spec_bufs;
+        delete [] spec_tasks;
+    }
 
     uint64_t file_len = offset > file_size ? file_size : offset;
 
@@ -845,33 +1725,84 @@ CosResult ObjectOp::MultiThreadUpload(const MultiUploadObjectReq& req,
     uint64_t offset = 0;
     bool task_fail_flag = false;
 
-    uint64_t part_size = req.GetPartSize();
-    int pool_size = req.GetThreadPoolSize();
-    unsigned char** file_content_buf = new unsigned char*[pool_size];
-    for(int i = 0; i < pool_size; ++i) {
-        file_content_buf[i] = new unsigned char[part_size];
+    const ClientSettings& settings = m_config.GetClientSettings();
+    uint64_t part_size = req.GetPartSize() > 0 ? req.GetPartSize()
+        : settings.GetUploadPartSize();
+    int pool_size = req.GetThreadPoolSize() > 0 ? req.GetThreadPoolSize()
+        : static_cast<int>(settings.GetUploadThreadPoolSize());
+    std::string dest_url = GetRealUrl(host, path, req.IsHttps());
+    // 非TLS连接上分块任务直接读取本地文件, 由HttpSender用sendfile发送, 不需要分块缓冲区;
+    // TLS连接上仍然把分块读入缓冲区
+    bool is_zero_copy = !StringUtil::StringStartsWithIgnoreCase(dest_url, "https");
+    unsigned char** file_content_buf = NULL;
+    if (!is_zero_copy) {
+        file_content_buf = new unsigned char*[pool_size];
+        for(int i = 0; i < pool_size; ++i) {
+            file_content_buf[i] = new unsigned char[part_size];
+        }
     }
 
-    std::string dest_url = GetRealUrl(host, path, req.IsHttps());
+    SharedCancelToken cancel_token = CreateCancelToken(req);
+    // 所有分块共享同一个限速器, 各分块按申请顺序轮流获得带宽
+    SharedRateLimiter rate_limiter = CreateRateLimiter(req, true);
+    std::string traffic_limit = req.GetHeader(kReqHeaderXCosTrafficLimit);
     FileUploadTask** pptaskArr = new FileUploadTask*[pool_size];
     for (int i = 0; i < pool_size; ++i) {
-        pptaskArr[i] = new FileUploadTask(dest_url, req.GetConnTimeoutInms(), req.GetRecvTimeoutInms());
+        pptaskArr[i] = new FileUploadTask(dest_url, GetConnTimeoutInms(req), GetRecvTimeoutInms(req));
+        pptaskArr[i]->SetRetryPolicy(m_config.GetRetryPolicy());
+        pptaskArr[i]->SetParentCancelToken(cancel_token);
+        pptaskArr[i]->SetRateLimiter(rate_limiter);
+        pptaskArr[i]->SetPriority(req.GetPriority());
+        pptaskArr[i]->SetTrafficLimit(traffic_limit);
+    }
+
+    // 开启低速检测时, 每个分块额外准备一个推测任务, 与原任务共享分块数据,
+    // 同一个分块号重复上传是安全的
+    const StallPolicy& stall_policy = m_config.GetStallPolicy();
+    FileUploadTask** spec_tasks = NULL;
+    boost::scoped_ptr<TaskGroup> spec_tp;
+    if (stall_policy.IsEnable()) {
+        spec_tasks = new FileUploadTask*[pool_size];
+        for (int i = 0; i < pool_size; ++i) {
+            spec_tasks[i] = new FileUploadTask(dest_url, GetConnTimeoutInms(req),
+                                               GetRecvTimeoutInms(req));
+            spec_tasks[i]->SetRetryPolicy(m_config.GetRetryPolicy());
+            spec_tasks[i]->SetParentCancelToken(cancel_token);
+            spec_tasks[i]->SetRateLimiter(rate_limiter);
+            spec_tasks[i]->SetPriority(req.GetPriority());
+            spec_tasks[i]->SetTrafficLimit(traffic_limit);
+        }
+        spec_tp.reset(new TaskGroup(pool_size));
     }
+    std::vector<boost::function<void()> > spec_fillers(pool_size);
+    std::vector<FileUploadTask*> winners;
 
     SDK_LOG_DBG("upload data,url=%s, poolsize=%u, part_size=%lu, file_size=%lu",
                 dest_url.c_str(), pool_size, part_size, file_size);
 
-    boost::threadpool::pool tp(pool_size);
+    TaskGroup tp(pool_size);
 
     // 3. 多线程upload
     {
         uint64_t part_number = 1;
         while (offset < file_size) {
+            if (cancel_token && cancel_token->IsCancelled()) {
+                SDK_LOG_ERR("upload data, %s", cancel_token->GetErrMsg().c_str());
+                result.SetErrorInfo(cancel_token->GetErrMsg());
+                task_fail_flag = true;
+                break;
+            }
+
             int task_index = 0;
             for (; task_index < pool_size; ++task_index) {
-                fin.read((char *)file_content_buf[task_index], part_size);
-                size_t read_len = fin.gcount();
-                if (read_len == 0 && fin.eof()) {
+                size_t read_len = 0;
+                if (is_zero_copy) {
+                    read_len = static_cast<size_t>(std::min(part_size, file_size - offset));
+                } else {
+                    fin.read((char *)file_content_buf[task_index], part_size);
+                    read_len = fin.gcount();
+                }
+                if (read_len == 0 && (is_zero_copy || fin.eof())) {
                     SDK_LOG_DBG("read over, task_index: %d", task_index);
                     break;
                 }
@@ -880,9 +1811,27 @@ CosResult ObjectOp::MultiThreadUpload(const MultiUploadObjectReq& req,
                             task_index, file_size, offset, read_len);
 
                 FileUploadTask* ptask = pptaskArr[task_index];
-                FillUploadTask(upload_id, host, path, file_content_buf[task_index], read_len,
-                               part_number, ptask);
-                tp.schedule(boost::bind(&FileUploadTask::Run, ptask));
+                if (is_zero_copy) {
+                    FillUploadFileTask(upload_id, host, path, local_file_path, offset, read_len,
+                                       part_number, ptask);
+                } else {
+                    FillUploadTask(upload_id, host, path, file_content_buf[task_index], read_len,
+                                   part_number, ptask);
+                }
+                tp.Schedule(boost::bind(&FileUploadTask::Run, ptask));
+                if (spec_tasks != NULL && is_zero_copy) {
+                    spec_fillers[task_index] = boost::bind(&ObjectOp::FillUploadFileTask, this,
+                                                           upload_id, host, path,
+                                                           local_file_path, offset,
+                                                           read_len, part_number,
+                                                           spec_tasks[task_index]);
+                } else if (spec_tasks != NULL) {
+                    spec_fillers[task_index] = boost::bind(&ObjectOp::FillUploadTask, this,
+                                                           upload_id, host, path,
+                                                           file_content_buf[task_index],
+                                                           read_len, part_number,
+                                                           spec_tasks[task_index]);
+                }
                 offset += read_len;
                 part_numbers_ptr->push_back(part_number);
                 ++part_number;
@@ -890,9 +1839,10 @@ CosResult ObjectOp::MultiThreadUpload(const MultiUploadObjectReq& req,
 
             int max_task_num = task_index;
 
-            tp.wait();
+            WaitPartTasks(stall_policy, &tp, spec_tp.get(), pptaskArr, spec_tasks,
+                          spec_fillers, max_task_num, &winners);
             for (task_index = 0; task_index < max_task_num; ++task_index) {
-                FileUploadTask* ptask = pptaskArr[task_index];
+                FileUploadTask* ptask = winners[task_index];
                 if (!ptask->IsTaskSuccess()) {
                     const std::string& task_resp = ptask->GetTaskResp();
                     const std::map<std::string, std::string>& task_resp_headers = ptask->GetRespHeaders();
@@ -939,11 +1889,19 @@ CosResult ObjectOp::MultiThreadUpload(const MultiUploadObjectReq& req,
         delete pptaskArr[i];
     }
     delete [] pptaskArr;
+    if (spec_tasks != NULL) {
+        for (int i = 0; i < pool_size; ++i) {
+            delete spec_tasks[i];
+        }
+        delete [] spec_tasks;
+    }
 
-    for (int i = 0; i < pool_size; ++i) {
-        delete [] file_content_buf[i];
+    if (file_content_buf != NULL) {
+        for (int i = 0; i < pool_size; ++i) {
+            delete [] file_content_buf[i];
+        }
+        delete [] file_content_buf;
     }
-    delete [] file_content_buf;
 
     return result;
 }
@@ -967,9 +1925,9 @@ void ObjectOp::FillUploadTask(const std::string& upload_id, const std::string& h
                                      StringUtil::Uint64ToString(part_number)));
     std::map<std::string, std::string> req_headers;
     req_headers["Host"] = host;
-    std::string auth_str = AuthTool::Sign(GetAccessKey(), GetSecretKey(), "PUT",
-                                          path, req_headers, req_params);
+    std::string auth_str = Sign("PUT", path, req_headers, req_params);
     req_headers["Authorization"] = auth_str;
+    AddExpectContinue(len, &req_headers);
 
     const std::string& tmp_token = m_config.GetTmpToken();
     if (!tmp_token.empty()) {
@@ -981,6 +1939,14 @@ void ObjectOp::FillUploadTask(const std::string& upload_id, const std::string& h
     task_ptr->SetUploadBuf(file_content_buf, len);
 }
 
+void ObjectOp::FillUploadFileTask(const std::string& upload_id, const std::string& host,
+                                  const std::string& path, const std::string& local_file_path,
+                                  uint64_t file_offset, uint64_t len, uint64_t part_number,
+                                  FileUploadTask* task_ptr) {
+    FillUploadTask(upload_id, host, path, NULL, len, part_number, task_ptr);
+    task_ptr->SetUploadFileRange(local_file_path, file_offset, len);
+}
+
 void ObjectOp::FillCopyTask(const std::string& upload_id,
                             const std::string& host,
                             const std::string& path,
@@ -996,8 +1962,7 @@ void ObjectOp::FillCopyTask(const std::string& upload_id,
     std::map<std::string, std::string> req_headers = headers;
     req_headers["Host"] = host;
     req_headers["x-cos-copy-source-range"] = range;
-    std::string auth_str = AuthTool::Sign(GetAccessKey(), GetSecretKey(), "PUT",
-                                          path, req_headers, req_params);
+    std::string auth_str = Sign("PUT", path, req_headers, req_params);
     req_headers["Authorization"] = auth_str;
 
     const std::string& tmp_token = m_config.GetTmpToken();
@@ -1012,8 +1977,7 @@ void ObjectOp::FillCopyTask(const std::string& upload_id,
 std::string ObjectOp::GeneratePresignedUrl(const GeneratePresignedUrlReq& req) {
     std::string auth_str = "";
     if (req.GetStartTimeInSec() == 0 || req.GetExpiredTimeInSec() == 0) {
-        auth_str = AuthTool::Sign(GetAccessKey(), GetSecretKey(), req.GetMethod(),
-                req.GetPath(), req.GetHeaders(), req.GetParams());
+        auth_str = Sign(req.GetMethod(), req.GetPath(), req.GetHeaders(), req.GetParams());
     } else {
         auth_str = AuthTool::Sign(GetAccessKey(), GetSecretKey(), req.GetMethod(),
                 req.GetPath(), req.GetHeaders(), req.GetParams(),
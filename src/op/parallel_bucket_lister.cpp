@@ -0,0 +1,261 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: 按key空间分片并发列出Object
+
+#include "op/parallel_bucket_lister.h"
+
+#include <algorithm>
+
+#include "boost/bind.hpp"
+#include "threadpool/boost/threadpool.hpp"
+
+#include "cos_sys_config.h"
+
+namespace qcloud_cos {
+
+namespace {
+
+// 工作线程每攒够一批记录才加锁交给调用线程或检查停止标记
+const size_t kOrderedBatchEntries = 1000;
+
+} // namespace
+
+ParallelBucketLister::ParallelBucketLister(const BucketOp& op,
+                                           const ParallelListObjectsReq& req,
+                                           ListObjectsHandler* handler)
+    : m_op(op), m_req(req), m_handler(handler), m_cancel_token(new CancelToken()),
+      m_is_stopped(false), m_is_error(false), m_entry_count(0) {
+    // 回调要求停止时取消各分片正在进行的请求, 不影响调用方的句柄
+    m_cancel_token->SetParent(req.GetCancelToken());
+}
+
+CosResult ParallelBucketLister::Run(ParallelListObjectsResp* resp) {
+    std::vector<std::string> discovered;
+    if (!m_req.GetDiscoverDelimiter().empty()) {
+        CosResult result = Discover(&discovered);
+        if (!result.IsSucc()) {
+            return result;
+        }
+    }
+
+    std::string lower = m_req.GetParam("marker");
+    std::vector<std::string> split_points = MergeSplitPoints(m_req.GetSplitPoints(),
+                                                             discovered, lower);
+    for (size_t i = 0; i <= split_points.size(); ++i) {
+        SharedShard shard(new Shard());
+        shard->m_lower = lower;
+        if (i < split_points.size()) {
+            shard->m_upper = split_points[i];
+            lower = split_points[i];
+        }
+        m_shards.push_back(shard);
+    }
+    SDK_LOG_INFO("Parallel list objects, shard_num=%u, discovered=%u",
+                 static_cast<unsigned>(m_shards.size()), static_cast<unsigned>(discovered.size()));
+
+    unsigned thread_num = std::min(static_cast<unsigned>(m_shards.size()), m_req.GetThreadNum());
+    thread_num = std::max(thread_num, 1u);
+    {
+        boost::threadpool::pool tp(thread_num);
+        // 线程池按提交顺序执行, 有序模式下调用线程等待的分片总是已经开始或者已经结束
+        for (size_t i = 0; i < m_shards.size(); ++i) {
+            tp.schedule(boost::bind(&ParallelBucketLister::RunShard, this, m_shards[i]));
+        }
+        if (m_req.IsOrdered()) {
+            ConsumeOrdered();
+        }
+        tp.wait();
+    }
+
+    resp->SetShardCount(m_shards.size());
+    resp->SetEntryCount(m_entry_count);
+    if (m_is_error) {
+        return m_err_result;
+    }
+    CosResult result;
+    result.SetSucc();
+    return result;
+}
+
+std::vector<std::string> ParallelBucketLister::MergeSplitPoints(
+        const std::vector<std::string>& split_points,
+        const std::vector<std::string>& discovered,
+        const std::string& marker) {
+    std::vector<std::string> merged;
+    merged.reserve(split_points.size() + discovered.size());
+    for (size_t i = 0; i < split_points.size(); ++i) {
+        if (split_points[i] > marker) {
+            merged.push_back(split_points[i]);
+        }
+    }
+    for (size_t i = 0; i < discovered.size(); ++i) {
+        if (discovered[i] > marker) {
+            merged.push_back(discovered[i]);
+        }
+    }
+    std::sort(merged.begin(), merged.end());
+    merged.erase(std::unique(merged.begin(), merged.end()), merged.end());
+    return merged;
+}
+
+CosResult ParallelBucketLister::Discover(std::vector<std::string>* prefixes) {
+    GetBucketReq req(m_req);
+    req.SetDelimiter(m_req.GetDiscoverDelimiter());
+    req.SetCancelToken(m_cancel_token);
+    BucketObjectIterator iter(m_op, req, 1);
+    BucketObjectEntry entry;
+    while (prefixes->size() < m_req.GetMaxShards() && iter.Next(&entry)) {
+        if (entry.m_is_common_prefix) {
+            prefixes->push_back(entry.m_key);
+        }
+    }
+
+    if (iter.IsError()) {
+        return iter.GetResult();
+    }
+    CosResult result;
+    result.SetSucc();
+    return result;
+}
+
+void ParallelBucketLister::RunShard(SharedShard shard) {
+    uint64_t entry_count = 0;
+    if (!IsStopped()) {
+        GetBucketReq req(m_req);
+        if (!shard->m_lower.empty()) {
+            req.SetMarker(shard->m_lower);
+        }
+        req.SetCancelToken(m_cancel_token);
+        BucketObjectIterator iter(m_op, req, m_req.GetPrefetchDepth());
+
+        std::vector<BucketObjectEntry> batch;
+        BucketObjectEntry entry;
+        uint64_t scanned = 0;
+        // 提前退出时后台预取超出上界的页可能失败, 只有迭代器自然结束时才检查错误
+        bool is_exhausted = false;
+        while (true) {
+            if (!iter.Next(&entry)) {
+                is_exhausted = true;
+                break;
+            }
+            if (!shard->m_upper.empty() && entry.m_key > shard->m_upper) {
+                break;
+            }
+            // 其他分片出错或回调要求停止
+            if (++scanned % kOrderedBatchEntries == 0 && IsStopped()) {
+                break;
+            }
+            if (!m_req.IsOrdered()) {
+                if (!Emit(entry)) {
+                    break;
+                }
+                ++entry_count;
+                continue;
+            }
+            batch.push_back(entry);
+            if (batch.size() >= kOrderedBatchEntries) {
+                DeliverBatch(shard.get(), &batch);
+            }
+        }
+        if (!batch.empty()) {
+            DeliverBatch(shard.get(), &batch);
+        }
+        if (is_exhausted && iter.IsError()) {
+            CosResult result = iter.GetResult();
+            SDK_LOG_ERR("List shard fail, lower=%s, upper=%s, err_msg=%s",
+                        shard->m_lower.c_str(), shard->m_upper.c_str(),
+                        result.GetErrorInfo().c_str());
+            Stop(&result);
+        }
+    }
+
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+        shard->m_is_done = true;
+        m_entry_count += entry_count;
+    }
+    m_cond.notify_all();
+}
+
+void ParallelBucketLister::DeliverBatch(Shard* shard, std::vector<BucketObjectEntry>* batch) {
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+        while (!m_is_stopped && shard->m_entries.size() >= m_req.GetMaxBufferedEntries()) {
+            m_cond.wait(lock);
+        }
+        if (!m_is_stopped) {
+            shard->m_entries.insert(shard->m_entries.end(), batch->begin(), batch->end());
+        }
+    }
+    batch->clear();
+    m_cond.notify_all();
+}
+
+void ParallelBucketLister::ConsumeOrdered() {
+    std::deque<BucketObjectEntry> entries;
+    uint64_t entry_count = 0;
+    for (size_t i = 0; i < m_shards.size(); ++i) {
+        Shard* shard = m_shards[i].get();
+        while (true) {
+            {
+                boost::mutex::scoped_lock lock(m_mutex);
+                while (!m_is_stopped && shard->m_entries.empty() && !shard->m_is_done) {
+                    m_cond.wait(lock);
+                }
+                if (m_is_stopped || shard->m_entries.empty()) {
+                    break;
+                }
+                entries.swap(shard->m_entries);
+            }
+            // 腾出了缓存, 唤醒等待的工作线程
+            m_cond.notify_all();
+
+            for (std::deque<BucketObjectEntry>::const_iterator itr = entries.begin();
+                 itr != entries.end(); ++itr) {
+                if (!Emit(*itr)) {
+                    break;
+                }
+                ++entry_count;
+            }
+            entries.clear();
+        }
+        if (IsStopped()) {
+            break;
+        }
+    }
+
+    boost::mutex::scoped_lock lock(m_mutex);
+    m_entry_count += entry_count;
+}
+
+bool ParallelBucketLister::Emit(const BucketObjectEntry& entry) {
+    if (m_handler->OnEntry(entry)) {
+        return true;
+    }
+    Stop(NULL);
+    return false;
+}
+
+void ParallelBucketLister::Stop(const CosResult* err) {
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+        if (m_is_stopped) {
+            return;
+        }
+        m_is_stopped = true;
+        if (err != NULL) {
+            m_is_error = true;
+            m_err_result = *err;
+        }
+    }
+    m_cond.notify_all();
+    m_cancel_token->Cancel();
+}
+
+bool ParallelBucketLister::IsStopped() const {
+    boost::mutex::scoped_lock lock(m_mutex);
+    return m_is_stopped;
+}
+
+} // namespace qcloud_cos
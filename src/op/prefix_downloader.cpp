@@ -0,0 +1,386 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: 列出前缀下的Object并发下载到本地目录
+
+#include "op/prefix_downloader.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <map>
+
+#include "boost/bind.hpp"
+#include "boost/date_time/posix_time/posix_time_types.hpp"
+
+#include "cos_sys_config.h"
+#include "op/bucket_op.h"
+#include "util/executor.h"
+#include "util/file_util.h"
+#include "util/http_sender.h"
+#include "util/string_util.h"
+
+namespace qcloud_cos {
+
+namespace {
+
+// 下载中的临时文件后缀, 下载成功后重命名为目标文件. 后缀后再加上进程号和序号,
+// 避免与名称以该后缀结尾的Object或其他进程的临时文件冲突
+const std::string kDownloadTempSuffix = ".cos_tmp";
+
+uint64_t s_temp_seq = 0;
+
+std::string GetTempPath(const std::string& local_path) {
+    uint64_t seq = __sync_add_and_fetch(&s_temp_seq, 1);
+    return local_path + kDownloadTempSuffix + "." + StringUtil::IntToString(getpid())
+        + "." + StringUtil::Uint64ToString(seq);
+}
+
+// 调度线程检查取消状态的间隔, 单位:毫秒
+const uint64_t kDownloadPrefixCheckIntervalInms = 50;
+
+} // namespace
+
+PrefixDownloader::PrefixDownloader(const ObjectOp& op, const DownloadPrefixReq& req,
+                                   DownloadPrefixHandler* handler)
+    : m_op(op), m_req(req), m_handler(handler), m_root(req.GetLocalDir()),
+      m_thread_num(std::max(req.GetThreadNum(), 1u)),
+      m_downloading(0), m_conns_in_use(0), m_memory_in_use(0), m_downloaded_bytes(0) {
+    while (m_root.size() > 1 && m_root[m_root.size() - 1] == '/') {
+        m_root.erase(m_root.size() - 1);
+    }
+
+    CosConfig config = m_op.GetCosConfig();
+    const ClientSettings& settings = config.GetClientSettings();
+    m_slice_size = req.GetSliceSize() > 0 ? req.GetSliceSize() : settings.GetDownSliceSize();
+    m_slice_thread_num = req.GetSliceThreadNum() > 0 ? req.GetSliceThreadNum()
+        : settings.GetDownThreadPoolMaxSize();
+    // 分片下载的连接也计入ThreadNum, 单个Object的分片并发数不超过ThreadNum
+    m_slice_thread_num = std::min(std::max(m_slice_thread_num, 1u), m_thread_num);
+}
+
+CosResult PrefixDownloader::Run(DownloadPrefixResp* resp) {
+    CosResult result;
+    if (!FileUtil::MakeDirs(m_root)) {
+        result.SetErrorInfo("Create local dir fail, local_dir=" + m_req.GetLocalDir());
+        return result;
+    }
+
+    GetBucketReq list_req(m_req.GetBucketName());
+    list_req.SetPrefix(m_req.GetPrefix());
+    CopySettings(&list_req);
+    CosConfig config = m_op.GetCosConfig();
+    BucketOp bucket_op(config);
+
+    bool is_cancelled = false;
+    bool is_list_error = false;
+    CosResult list_result;
+    {
+        TaskGroup tp(m_thread_num);
+        BucketObjectIterator iter(bucket_op, list_req, m_req.GetListPrefetchDepth());
+        BucketObjectEntry entry;
+        while (iter.Next(&entry)) {
+            if (entry.m_is_common_prefix) {
+                continue;
+            }
+
+            std::string rel_path;
+            bool is_valid = GetRelativePath(m_req.GetPrefix(), entry.m_key, &rel_path);
+            // 以'/'结尾的目录占位Object只创建本地目录
+            if (StringUtil::StringEndsWith(entry.m_key, "/")) {
+                if (is_valid) {
+                    FileUtil::MakeDirs(m_root + "/" + rel_path);
+                }
+                continue;
+            }
+
+            ObjectEntry object;
+            object.m_object_name.swap(entry.m_key);
+            object.m_etag.swap(entry.m_etag);
+            object.m_size = entry.m_size;
+            {
+                boost::mutex::scoped_lock lock(m_mutex);
+                ++m_progress.m_object_count;
+                m_progress.m_total_bytes += object.m_size;
+            }
+            if (!is_valid) {
+                CosResult path_result;
+                path_result.SetErrorCode("InvalidLocalPath");
+                path_result.SetErrorInfo("Object name can not map to a local path under "
+                                         + m_req.GetLocalDir());
+                FinishObject(object, path_result, false);
+                continue;
+            }
+            object.m_local_path = m_root + "/" + rel_path;
+
+            if (!AcquireSlot(object.m_size)) {
+                is_cancelled = true;
+                break;
+            }
+            tp.Schedule(boost::bind(&PrefixDownloader::DownloadObject, this, object));
+        }
+
+        if (!is_cancelled && iter.IsError()) {
+            is_cancelled = IsCancelled();
+            is_list_error = !is_cancelled;
+            list_result = iter.GetResult();
+        }
+        {
+            boost::mutex::scoped_lock lock(m_mutex);
+            m_progress.m_is_list_done = !is_cancelled && !is_list_error;
+        }
+        tp.Wait();
+    }
+
+    boost::mutex::scoped_lock lock(m_mutex);
+    uint64_t downloaded_count = m_progress.m_done_count - m_progress.m_skipped_count
+        - m_progress.m_failed_count;
+    resp->SetObjectCount(m_progress.m_object_count);
+    resp->SetDownloadedCount(downloaded_count);
+    resp->SetSkippedCount(m_progress.m_skipped_count);
+    resp->SetFailedCount(m_progress.m_failed_count);
+    resp->SetTotalBytes(m_progress.m_total_bytes);
+    resp->SetDownloadedBytes(m_downloaded_bytes);
+    resp->AddErrorInfos(m_error_infos);
+    SDK_LOG_INFO("Download prefix finish, bucket=%s, prefix=%s, objects=%lu, downloaded=%lu, "
+                 "skipped=%lu, failed=%lu", m_req.GetBucketName().c_str(),
+                 m_req.GetPrefix().c_str(),
+                 static_cast<unsigned long>(m_progress.m_object_count),
+                 static_cast<unsigned long>(downloaded_count),
+                 static_cast<unsigned long>(m_progress.m_skipped_count),
+                 static_cast<unsigned long>(m_progress.m_failed_count));
+    if (is_cancelled) {
+        const SharedCancelToken& cancel_token = m_req.GetCancelToken();
+        result.SetErrorInfo(cancel_token && cancel_token->IsCancelled()
+                            ? cancel_token->GetErrMsg() : kRequestDeadlineExceededErrMsg);
+        return result;
+    }
+    if (is_list_error) {
+        return list_result;
+    }
+    result.SetSucc();
+    return result;
+}
+
+bool PrefixDownloader::GetRelativePath(const std::string& prefix,
+                                       const std::string& object_name,
+                                       std::string* rel_path) {
+    rel_path->clear();
+    if (!StringUtil::StringStartsWith(object_name, prefix)) {
+        return false;
+    }
+
+    size_t pos = prefix.size();
+    // prefix不以'/'结尾时跳过紧随其后的一个'/', 如prefix为"dir"时"dir/a"对应"a"
+    if (!prefix.empty() && !StringUtil::StringEndsWith(prefix, "/")
+        && pos < object_name.size() && object_name[pos] == '/') {
+        ++pos;
+    }
+    while (pos < object_name.size()) {
+        size_t end = object_name.find('/', pos);
+        if (end == std::string::npos) {
+            end = object_name.size();
+        }
+        std::string segment = object_name.substr(pos, end - pos);
+        pos = end + 1;
+        // 空段会使"a//b"和"a/b"映射到同一个本地路径, 与"."、".."一样无法映射
+        if (segment.empty() || segment == "." || segment == "..") {
+            rel_path->clear();
+            return false;
+        }
+        if (!rel_path->empty()) {
+            rel_path->append("/");
+        }
+        rel_path->append(segment);
+    }
+    return !rel_path->empty();
+}
+
+bool PrefixDownloader::AcquireSlot(uint64_t size) {
+    unsigned conns = GetConnCost(size);
+    uint64_t cost = GetMemoryCost(size);
+    uint64_t memory_budget = m_req.GetMemoryBudget();
+    Executor& executor = Executor::Instance();
+    bool is_worker = executor.IsWorkerThread();
+    boost::mutex::scoped_lock lock(m_mutex);
+    // 整体下载和分片下载共享连接数上限; 超过预算的大Object在没有其他在途Object时单独下载
+    while (m_conns_in_use + conns > m_thread_num
+           || (m_downloading > 0 && m_memory_in_use + cost > memory_budget)) {
+        if (IsCancelled()) {
+            return false;
+        }
+        // 在工作线程上调用时帮助执行排队的任务, 避免所有工作线程都在等待
+        if (is_worker) {
+            lock.unlock();
+            bool is_run = executor.RunOne();
+            lock.lock();
+            if (is_run) {
+                continue;
+            }
+        }
+        m_cond.timed_wait(lock,
+            boost::posix_time::milliseconds(kDownloadPrefixCheckIntervalInms));
+    }
+    if (IsCancelled()) {
+        return false;
+    }
+    ++m_downloading;
+    m_conns_in_use += conns;
+    m_memory_in_use += cost;
+    return true;
+}
+
+void PrefixDownloader::DownloadObject(const ObjectEntry& entry) {
+    CosResult result;
+    bool is_skipped = false;
+    if (m_req.IsSkipExisting() && IsSameAsLocal(entry)) {
+        is_skipped = true;
+        result.SetSucc();
+    } else {
+        std::string local_dir = entry.m_local_path.substr(0, entry.m_local_path.rfind('/'));
+        std::string temp_path = GetTempPath(entry.m_local_path);
+        if (!FileUtil::MakeDirs(local_dir)) {
+            result.SetErrorInfo("Create local dir fail, dir=" + local_dir);
+        } else {
+            // 先写入临时文件, 中途失败或进程退出时不会留下不完整的目标文件
+            result = GetObjectToFile(entry, temp_path);
+            if (result.IsSucc() && FileUtil::GetFileLen(temp_path) != entry.m_size) {
+                result.SetFail();
+                result.SetErrorInfo("Downloaded size mismatch, object may be modified, local file="
+                                    + temp_path);
+            }
+            if (result.IsSucc() && rename(temp_path.c_str(), entry.m_local_path.c_str()) != 0) {
+                result.SetFail();
+                result.SetErrorInfo("Rename local file fail, errno="
+                                    + StringUtil::IntToString(errno) + ", local file="
+                                    + entry.m_local_path);
+            }
+            if (!result.IsSucc()) {
+                unlink(temp_path.c_str());
+            }
+        }
+    }
+    if (!result.IsSucc()) {
+        SDK_LOG_ERR("Download prefix object fail, object=%s, local_path=%s, err_msg=%s",
+                    entry.m_object_name.c_str(), entry.m_local_path.c_str(),
+                    result.GetErrorInfo().c_str());
+    }
+
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+        --m_downloading;
+        m_conns_in_use -= GetConnCost(entry.m_size);
+        m_memory_in_use -= GetMemoryCost(entry.m_size);
+    }
+    m_cond.notify_all();
+    FinishObject(entry, result, is_skipped);
+}
+
+bool PrefixDownloader::IsSameAsLocal(const ObjectEntry& entry) {
+    struct stat st;
+    if (stat(entry.m_local_path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)
+        || static_cast<uint64_t>(st.st_size) != entry.m_size) {
+        return false;
+    }
+
+    std::string remote_md5 = entry.m_etag;
+    if (StringUtil::IsMultipartUploadETag(remote_md5)) {
+        // 分块上传的Object的ETag不是MD5, 使用上传时记录的MD5
+        HeadObjectReq head_req(m_req.GetBucketName(), entry.m_object_name);
+        CopySettings(&head_req);
+        HeadObjectResp head_resp;
+        if (!m_op.HeadObject(head_req, &head_resp).IsSucc()) {
+            return false;
+        }
+        std::map<std::string, std::string> metas = head_resp.GetXCosMetas();
+        std::map<std::string, std::string>::const_iterator itr = metas.find(kTransferMd5MetaKey);
+        if (itr == metas.end()) {
+            return false;
+        }
+        remote_md5 = itr->second;
+    }
+
+    std::string local_md5 = FileUtil::GetFileMd5(entry.m_local_path);
+    return !local_md5.empty() && StringUtil::StringToLower(remote_md5) == local_md5;
+}
+
+CosResult PrefixDownloader::GetObjectToFile(const ObjectEntry& entry,
+                                            const std::string& local_path) {
+    if (entry.m_size < m_req.GetMultiGetThreshold()) {
+        GetObjectByFileReq get_req(m_req.GetBucketName(), entry.m_object_name, local_path);
+        CopySettings(&get_req);
+        GetObjectByFileResp get_resp;
+        return m_op.GetObject(get_req, &get_resp);
+    }
+
+    MultiGetObjectReq multi_req(m_req.GetBucketName(), entry.m_object_name, local_path);
+    CopySettings(&multi_req);
+    multi_req.SetSliceSize(m_slice_size);
+    multi_req.SetThreadPoolSize(static_cast<int>(m_slice_thread_num));
+    MultiGetObjectResp multi_resp;
+    return m_op.GetObject(multi_req, &multi_resp);
+}
+
+uint64_t PrefixDownloader::GetMemoryCost(uint64_t size) const {
+    if (size < m_req.GetMultiGetThreshold()) {
+        return size;
+    }
+    return std::min(size, m_slice_size * m_slice_thread_num);
+}
+
+unsigned PrefixDownloader::GetConnCost(uint64_t size) const {
+    return size < m_req.GetMultiGetThreshold() ? 1u : m_slice_thread_num;
+}
+
+bool PrefixDownloader::IsCancelled() const {
+    const SharedCancelToken& cancel_token = m_req.GetCancelToken();
+    if (cancel_token && cancel_token->IsCancelled()) {
+        return true;
+    }
+    uint64_t deadline_in_ms = m_req.GetDeadlineInms();
+    return deadline_in_ms != 0 && HttpSender::GetTimeStampInUs() / 1000 >= deadline_in_ms;
+}
+
+void PrefixDownloader::CopySettings(BaseReq* req) const {
+    req->SetConnTimeoutInms(m_req.GetConnTimeoutInms());
+    req->SetRecvTimeoutInms(m_req.GetRecvTimeoutInms());
+    req->SetCancelToken(m_req.GetCancelToken());
+    req->SetPriority(m_req.GetPriority());
+    req->SetDeadlineInms(m_req.GetDeadlineInms());
+    if (m_req.IsHttps()) {
+        req->SetHttps();
+    }
+}
+
+void PrefixDownloader::FinishObject(const ObjectEntry& entry, const CosResult& result,
+                                    bool is_skipped) {
+    DownloadPrefixProgress progress;
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+        ++m_progress.m_done_count;
+        m_progress.m_done_bytes += entry.m_size;
+        if (is_skipped) {
+            ++m_progress.m_skipped_count;
+        } else if (result.IsSucc()) {
+            m_downloaded_bytes += entry.m_size;
+        } else {
+            ++m_progress.m_failed_count;
+            ErrorInfo info;
+            info.m_key = entry.m_object_name;
+            info.m_code = result.GetErrorCode();
+            info.m_message = result.GetErrorInfo();
+            m_error_infos.push_back(info);
+        }
+        progress = m_progress;
+    }
+
+    if (m_handler != NULL) {
+        m_handler->OnObjectDone(entry.m_object_name, entry.m_local_path, result, is_skipped,
+                                progress);
+    }
+}
+
+} // namespace qcloud_cos
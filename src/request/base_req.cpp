@@ -8,15 +8,20 @@
 #include "request/base_req.h"
 
 #include "cos_sys_config.h"
+#include "util/http_sender.h"
 
 namespace qcloud_cos {
 
-BaseReq::BaseReq() : m_is_https(false) {
-    m_recv_timeout_in_ms = CosSysConfig::GetRecvTimeoutInms();
-    m_conn_timeout_in_ms = CosSysConfig::GetConnTimeoutInms();
+BaseReq::BaseReq()
+    : m_conn_timeout_in_ms(0), m_recv_timeout_in_ms(0), m_deadline_in_ms(0),
+      m_rate_limit(0), m_priority(PRIORITY_NORMAL), m_is_https(false) {
     AddHeader("User-Agent", "cos-cpp-sdk-v5.4.3");
 }
 
+void BaseReq::SetTotalTimeoutInms(uint64_t timeout_in_ms) {
+    m_deadline_in_ms = HttpSender::GetTimeStampInUs() / 1000 + timeout_in_ms;
+}
+
 void BaseReq::AddHeader(const std::string& key, const std::string& value) {
     m_headers_map[key] = value;
 }
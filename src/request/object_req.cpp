@@ -91,36 +91,30 @@ std::map<std::string, std::string> CopyReq::GetPartCopyHeader() const {
 }
 
 bool DeleteObjectsReq::GenerateRequestBody(std::string* body) const {
-    // 1.生成DeleteObjectsReq需要的xml字符串
-    rapidxml::xml_document<> doc;
-    rapidxml::xml_node<>* root_node = doc.allocate_node(rapidxml::node_element,
-                                                doc.allocate_string("Delete"),
-                                                NULL);
-    doc.append_node(root_node);
-    root_node->append_node(doc.allocate_node(rapidxml::node_element,
-                     doc.allocate_string("Quiet"),
-                     doc.allocate_string(m_is_quiet ? "true" : "false")));
-
+    // 直接拼接xml字符串, 1000个key时避免构造DOM的大量小块内存分配
+    size_t body_size = 64;
     for (std::vector<ObjectVersionPair>::const_iterator c_itr = m_objvers.begin();
             c_itr != m_objvers.end(); ++c_itr) {
-        rapidxml::xml_node<>* object_node = doc.allocate_node(rapidxml::node_element,
-                doc.allocate_string("Object"), NULL);
-
-        object_node->append_node(doc.allocate_node(rapidxml::node_element,
-                    doc.allocate_string("Key"),
-                    doc.allocate_string(c_itr->m_object_name.c_str())));
+        body_size += 64 + c_itr->m_object_name.size() + c_itr->m_version_id.size();
+    }
+    body->reserve(body->size() + body_size);
 
+    body->append("<Delete><Quiet>");
+    body->append(m_is_quiet ? "true" : "false");
+    body->append("</Quiet>");
+    for (std::vector<ObjectVersionPair>::const_iterator c_itr = m_objvers.begin();
+            c_itr != m_objvers.end(); ++c_itr) {
+        body->append("<Object><Key>");
+        StringUtil::AppendXmlEscaped(c_itr->m_object_name, body);
+        body->append("</Key>");
         if (!c_itr->m_version_id.empty()) {
-            object_node->append_node(doc.allocate_node(rapidxml::node_element,
-                        doc.allocate_string("VersionId"),
-                        doc.allocate_string(c_itr->m_version_id.c_str())));
+            body->append("<VersionId>");
+            StringUtil::AppendXmlEscaped(c_itr->m_version_id, body);
+            body->append("</VersionId>");
         }
-        root_node->append_node(object_node);
+        body->append("</Object>");
     }
-
-    // 2. 填充xml字符串
-    rapidxml::print(std::back_inserter(*body), doc, 0);
-    doc.clear();
+    body->append("</Delete>");
 
     return true;
 }
@@ -35,7 +35,9 @@ void BaseResp::SetEtag(const std::string& etag) {
 }
 
 void BaseResp::ParseFromHeaders(const std::map<std::string, std::string>& headers) {
-    m_headers = headers;
+    if (&headers != &m_headers) {
+        m_headers = headers;
+    }
     std::map<std::string, std::string>::const_iterator itr;
     itr = headers.find(kReqHeaderContentLen);
     if (headers.end() != itr) {
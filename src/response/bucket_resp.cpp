@@ -20,88 +20,227 @@
 
 namespace qcloud_cos {
 
-bool GetBucketResp::ParseFromXmlString(const std::string& body) {
-    rapidxml::xml_document<> doc;
-    char* cstr = new char[body.size() + 1];
-    strcpy(cstr, body.c_str());
-    cstr[body.size()] = '\0';
+GetBucketResp::GetBucketResp() {
+    OnReset();
+}
 
-    if (!StringUtil::StringToXml(cstr, &doc)) {
-        SDK_LOG_ERR("Parse string to xml doc error, xml_body=%s", body.c_str());
-        delete cstr;
+bool GetBucketResp::ParseFromXmlString(const std::string& body) {
+    XmlSaxParser parser(this);
+    parser.Reset();
+    if (!parser.Feed(body.c_str(), body.size()) || !parser.Finish()) {
+        SDK_LOG_ERR("Parse ListBucketResult error, err_msg=%s, xml_body=%s",
+                    parser.GetErrMsg().c_str(), body.c_str());
         return false;
     }
+    return true;
+}
 
-    rapidxml::xml_node<>* root = doc.first_node(kGetBucketRoot.c_str());
-    if (NULL == root) {
-        SDK_LOG_ERR("Miss root node=ListBucketResult, xml_body=%s", body.c_str());
-        delete cstr;
-        return false;
+void GetBucketResp::OnStartElement(const std::string& name) {
+    ++m_xml_depth;
+    if (m_xml_depth == 1) {
+        m_has_root = (name == kGetBucketRoot);
+    } else if (m_has_root && m_xml_depth == 2) {
+        if (name == kGetBucketContents) {
+            // 直接在结果中构造, 避免整条记录的拷贝
+            m_contents.push_back(Content());
+            m_in_contents = true;
+        } else if (name == kGetBucketCommonPrefixes) {
+            m_in_common_prefixes = true;
+        }
     }
+}
 
-    rapidxml::xml_node<>* node = root->first_node();
-    for (; node != NULL; node = node->next_sibling()) {
-        const std::string& node_name = node->name();
-        if (node_name == kGetBucketName) {
-            m_name = node->value();
-        } else if (node_name == kGetBucketEncodingType) {
-            m_encoding_type = node->value();
-        } else if (node_name == kGetBucketNextMarker) {
-            m_next_marker = node->value();
-        } else if (node_name == kGetBucketDelimiter) {
-            m_delimiter = node->value();
-        } else if (node_name == kGetBucketPrefix) {
-            m_prefix = node->value();
-        } else if (node_name == kGetBucketMarker) {
-            m_marker = node->value();
-        } else if (node_name == kGetBucketMaxKeys) {
-            m_max_keys = StringUtil::StringToUint64(node->value());
-        } else if (node_name == kGetBucketIsTruncated) {
-            m_is_truncated = ("true" == std::string(node->value())) ? true : false;
-        } else if (node_name == kGetBucketCommonPrefixes) {
-            rapidxml::xml_node<>* common_prefix_node = node->first_node();
-            for (; common_prefix_node != NULL;
-                 common_prefix_node = common_prefix_node->next_sibling()) {
-                m_common_prefixes.push_back(std::string(common_prefix_node->value()));
-            }
-        } else if (node_name == kGetBucketContents) {
-            rapidxml::xml_node<>* contents_node = node->first_node();
-            Content cnt;
-            for (; contents_node != NULL; contents_node = contents_node->next_sibling()) {
-                const std::string name = contents_node->name();
-                if (name == kGetBucketContentsKey) {
-                    cnt.m_key = contents_node->value();
-                } else if (name == kGetBucketContentsLastModified) {
-                    cnt.m_last_modified = contents_node->value();
-                } else if (name == kGetBucketContentsETag) {
-                    cnt.m_etag = StringUtil::Trim(contents_node->value(), "\"");
-                } else if (name == kGetBucketContentsSize) {
-                    cnt.m_size = contents_node->value();
-                } else if (name == kGetBucketContentsStorageClass) {
-                    cnt.m_storage_class = contents_node->value();
-                } else if (name == kGetBucketContentsOwner) {
-                    rapidxml::xml_node<>* id_node = contents_node->first_node();
-                    for (; id_node != NULL; id_node = id_node->next_sibling()) {
-                        if (id_node->name() != kGetBucketContentsOwnerID) {
-                            continue;
-                        }
-                        cnt.m_owner_ids.push_back(std::string(id_node->value()));
-                    }
-                } else {
-                    SDK_LOG_WARN("Unknown field in content node, field_name=%s, xml_body=%s",
-                                name.c_str(), body.c_str());
-                }
-            }
-            m_contents.push_back(cnt);
+void GetBucketResp::OnEndElement(const std::string& name, const std::string& text) {
+    int depth = m_xml_depth--;
+    if (!m_has_root) {
+        return;
+    }
+
+    if (depth == 2) {
+        if (name == kGetBucketName) {
+            m_name = text;
+        } else if (name == kGetBucketEncodingType) {
+            m_encoding_type = text;
+        } else if (name == kGetBucketNextMarker) {
+            m_next_marker = text;
+        } else if (name == kGetBucketDelimiter) {
+            m_delimiter = text;
+        } else if (name == kGetBucketPrefix) {
+            m_prefix = text;
+        } else if (name == kGetBucketMarker) {
+            m_marker = text;
+        } else if (name == kGetBucketMaxKeys) {
+            m_max_keys = StringUtil::StringToUint64(text);
+        } else if (name == kGetBucketIsTruncated) {
+            m_is_truncated = ("true" == text);
+        } else if (name == kGetBucketContents) {
+            m_in_contents = false;
+        } else if (name == kGetBucketCommonPrefixes) {
+            m_in_common_prefixes = false;
         } else {
-            SDK_LOG_WARN("Unknown field, field_name=%s, xml_body=%s",
-                         node_name.c_str(), body.c_str());
+            SDK_LOG_WARN("Unknown field, field_name=%s", name.c_str());
+        }
+    } else if (depth == 3 && m_in_contents) {
+        Content& cnt = m_contents.back();
+        if (name == kGetBucketContentsKey) {
+            cnt.m_key = text;
+        } else if (name == kGetBucketContentsLastModified) {
+            cnt.m_last_modified = text;
+            cnt.m_last_modified_time = StringUtil::Iso8601ToTimestamp(text);
+        } else if (name == kGetBucketContentsETag) {
+            cnt.m_etag = StringUtil::Trim(text, "\"");
+        } else if (name == kGetBucketContentsSize) {
+            cnt.m_size = StringUtil::StringToUint64(text);
+        } else if (name == kGetBucketContentsStorageClass) {
+            cnt.m_storage_class = text;
+        } else if (name != kGetBucketContentsOwner) {
+            SDK_LOG_WARN("Unknown field in content node, field_name=%s", name.c_str());
         }
+    } else if (depth == 4 && m_in_contents) {
+        // Owner只关心ID
+        if (name == kGetBucketContentsOwnerID) {
+            m_contents.back().m_owner_ids.push_back(text);
+        }
+    } else if (depth == 3 && m_in_common_prefixes) {
+        m_common_prefixes.push_back(text);
+    }
+}
+
+void GetBucketResp::OnReset() {
+    m_xml_depth = 0;
+    m_has_root = false;
+    m_in_contents = false;
+    m_in_common_prefixes = false;
+    m_contents.clear();
+    m_name.clear();
+    m_encoding_type.clear();
+    m_delimiter.clear();
+    m_prefix.clear();
+    m_marker.clear();
+    m_max_keys = 0;
+    m_is_truncated = false;
+    m_next_marker.clear();
+    m_common_prefixes.clear();
+}
+
+bool GetBucketResp::OnEndDocument() {
+    if (!m_has_root) {
+        SDK_LOG_ERR("Miss root node=ListBucketResult");
+    }
+    return m_has_root;
+}
+
+CompactGetBucketResp::CompactGetBucketResp() : m_list(&m_own_list), m_first_idx(0) {
+    OnReset();
+}
+
+void CompactGetBucketResp::SetObjectList(CompactObjectList* list) {
+    m_list = (list != NULL ? list : &m_own_list);
+    m_first_idx = m_list->Size();
+}
+
+bool CompactGetBucketResp::ParseFromXmlString(const std::string& body) {
+    XmlSaxParser parser(this);
+    parser.Reset();
+    if (!parser.Feed(body.c_str(), body.size()) || !parser.Finish()) {
+        SDK_LOG_ERR("Parse ListBucketResult error, err_msg=%s", parser.GetErrMsg().c_str());
+        return false;
     }
-    delete cstr;
     return true;
 }
 
+void CompactGetBucketResp::OnStartElement(const std::string& name) {
+    ++m_xml_depth;
+    if (m_xml_depth == 1) {
+        m_has_root = (name == kGetBucketRoot);
+    } else if (m_has_root && m_xml_depth == 2) {
+        if (name == kGetBucketContents) {
+            m_cur_key.clear();
+            m_cur_etag.clear();
+            m_cur_storage_class.clear();
+            m_cur_owner_id.clear();
+            m_cur_size = 0;
+            m_cur_mtime = 0;
+            m_in_contents = true;
+        } else if (name == kGetBucketCommonPrefixes) {
+            m_in_common_prefixes = true;
+        }
+    }
+}
+
+void CompactGetBucketResp::OnEndElement(const std::string& name, const std::string& text) {
+    int depth = m_xml_depth--;
+    if (!m_has_root) {
+        return;
+    }
+
+    if (depth == 2) {
+        if (name == kGetBucketContents) {
+            m_list->Append(m_cur_key, m_cur_size, m_cur_mtime, m_cur_etag,
+                           m_cur_storage_class, m_cur_owner_id);
+            m_in_contents = false;
+        } else if (name == kGetBucketCommonPrefixes) {
+            m_in_common_prefixes = false;
+        } else if (name == kGetBucketName) {
+            m_name = text;
+        } else if (name == kGetBucketNextMarker) {
+            m_next_marker = text;
+        } else if (name == kGetBucketPrefix) {
+            m_prefix = text;
+        } else if (name == kGetBucketMarker) {
+            m_marker = text;
+        } else if (name == kGetBucketMaxKeys) {
+            m_max_keys = StringUtil::StringToUint64(text);
+        } else if (name == kGetBucketIsTruncated) {
+            m_is_truncated = ("true" == text);
+        }
+    } else if (depth == 3 && m_in_contents) {
+        if (name == kGetBucketContentsKey) {
+            m_cur_key = text;
+        } else if (name == kGetBucketContentsLastModified) {
+            m_cur_mtime = StringUtil::Iso8601ToTimestamp(text);
+        } else if (name == kGetBucketContentsETag) {
+            m_cur_etag = StringUtil::Trim(text, "\"");
+        } else if (name == kGetBucketContentsSize) {
+            m_cur_size = StringUtil::StringToUint64(text);
+        } else if (name == kGetBucketContentsStorageClass) {
+            m_cur_storage_class = text;
+        }
+    } else if (depth == 4 && m_in_contents) {
+        // 只保留第一个Owner ID
+        if (name == kGetBucketContentsOwnerID && m_cur_owner_id.empty()) {
+            m_cur_owner_id = text;
+        }
+    } else if (depth == 3 && m_in_common_prefixes) {
+        m_common_prefixes.push_back(text);
+    }
+}
+
+void CompactGetBucketResp::OnReset() {
+    m_xml_depth = 0;
+    m_has_root = false;
+    m_in_contents = false;
+    m_in_common_prefixes = false;
+    m_cur_size = 0;
+    m_cur_mtime = 0;
+    // 丢弃重试前已经追加的记录
+    m_list->Truncate(m_first_idx);
+    m_name.clear();
+    m_prefix.clear();
+    m_marker.clear();
+    m_max_keys = 0;
+    m_is_truncated = false;
+    m_next_marker.clear();
+    m_common_prefixes.clear();
+}
+
+bool CompactGetBucketResp::OnEndDocument() {
+    if (!m_has_root) {
+        SDK_LOG_ERR("Miss root node=ListBucketResult");
+    }
+    return m_has_root;
+}
+
 bool GetBucketReplicationResp::ParseFromXmlString(const std::string& body) {
     rapidxml::xml_document<> doc;
     char* cstr = new char[body.size() + 1];
@@ -478,94 +617,119 @@ bool GetBucketLocationResp::ParseFromXmlString(const std::string& body) {
     return true;
 }
 
-bool GetBucketObjectVersionsResp::ParseFromXmlString(const std::string& body) {
-    rapidxml::xml_document<> doc;
-    char* cstr = new char[body.size() + 1];
-    strcpy(cstr, body.c_str());
-    cstr[body.size()] = '\0';
+GetBucketObjectVersionsResp::GetBucketObjectVersionsResp() {
+    OnReset();
+}
 
-    if (!StringUtil::StringToXml(cstr, &doc)) {
-        SDK_LOG_ERR("Parse string to xml doc error, xml_body=%s", body.c_str());
-        delete cstr;
+bool GetBucketObjectVersionsResp::ParseFromXmlString(const std::string& body) {
+    XmlSaxParser parser(this);
+    parser.Reset();
+    if (!parser.Feed(body.c_str(), body.size()) || !parser.Finish()) {
+        SDK_LOG_ERR("Parse ListVersionsResult error, err_msg=%s, xml_body=%s",
+                    parser.GetErrMsg().c_str(), body.c_str());
         return false;
     }
+    return true;
+}
 
-    rapidxml::xml_node<>* root = doc.first_node("ListVersionsResult");
-    if (NULL == root) {
-        SDK_LOG_ERR("Miss root node=ListVersionsResult, xml_body=%s", body.c_str());
-        delete cstr;
-        return false;
+void GetBucketObjectVersionsResp::OnStartElement(const std::string& name) {
+    ++m_xml_depth;
+    if (m_xml_depth == 1) {
+        m_has_root = ("ListVersionsResult" == name);
+    } else if (m_has_root && m_xml_depth == 2
+               && ("DeleteMarker" == name || "Version" == name)) {
+        m_summaries.push_back(COSVersionSummary());
+        m_summaries.back().m_is_delete_marker = ("DeleteMarker" == name);
+        m_in_summary = true;
     }
+}
 
-    rapidxml::xml_node<>* node = root->first_node();
-    for (; node != NULL; node = node->next_sibling()) {
-        const std::string& node_name = node->name();
-        if ("Name" == node_name) {
-            m_bucket_name = node->value();
-        } else if ("Prefix" == node_name) {
-            m_prefix = node->value();
-        } else if ("KeyMarker" == node_name) {
-            m_key_marker = node->value();
-        } else if ("VersionIdMarker" == node_name) {
-            m_version_id_marker = node->value();
-        } else if ("MaxKeys" == node_name) {
-            m_max_keys = StringUtil::StringToUint64(node->value());
-        } else if ("IsTruncated" == node_name) {
-            m_is_truncated = ("true" == std::string(node->value())) ? true : false;
-        } else if ("Encoding-Type" == node_name) {
-            m_encoding_type = node->value();
-        } else if ("NextKeyMarker" == node_name) {
-            m_next_key_marker = node->value();
-        } else if ("NextVersionIdMarker" == node_name) {
-            m_next_version_id_marker = node->value();
-        } else if ("DeleteMarker" == node_name || "Version" == node_name) {
-            COSVersionSummary summary;
-            summary.m_is_delete_marker = ("DeleteMarker" == node_name) ? true : false;
-            rapidxml::xml_node<>* result_node = node->first_node();
-            for (; result_node != NULL; result_node = result_node->next_sibling()) {
-                const std::string& result_node_name = result_node->name();
-                if ("Key" == result_node_name) {
-                    summary.m_key = result_node->value();
-                } else if ("VersionId" == result_node_name) {
-                    summary.m_version_id = result_node->value();
-                } else if ("IsLatest" == result_node_name) {
-                    summary.m_is_latest = ("true" == result_node->value()) ? true : false;
-                } else if ("LastModified" == result_node_name) {
-                    summary.m_last_modified = result_node->value();
-                } else if ("Owner" == result_node_name) {
-                    rapidxml::xml_node<>* owner_node = result_node->first_node();
-                    for (; owner_node != NULL; owner_node = owner_node->next_sibling()) {
-                        const std::string& owner_node_name = owner_node->name();
-                        if ("DisplayName" == owner_node_name) {
-                            summary.m_owner.m_display_name = owner_node->value();
-                        } else if ("ID" == owner_node_name) {
-                            summary.m_owner.m_id = owner_node->value();
-                        } else {
-                            SDK_LOG_WARN("Unknown field in owner node, field_name=%s.",
-                                    owner_node_name.c_str());
-                        }
-                    }
-                } else if ("ETag" == result_node_name) {
-                    summary.m_etag = StringUtil::Trim(result_node->value(), "\"");
-                } else if  ("Size" == result_node_name) {
-                    summary.m_size = StringUtil::StringToUint64(result_node->value());
-                } else if ("StorageClass" == result_node_name) {
-                    summary.m_storage_class = result_node->value();
-                } else {
-                    SDK_LOG_WARN("Unknown field in DeleteMarker/Version node, field_name=%s.",
-                            result_node_name.c_str());
-                }
-            }
+void GetBucketObjectVersionsResp::OnEndElement(const std::string& name,
+                                               const std::string& text) {
+    int depth = m_xml_depth--;
+    if (!m_has_root) {
+        return;
+    }
 
-            m_summaries.push_back(summary);
+    if (depth == 2) {
+        if ("Name" == name) {
+            m_bucket_name = text;
+        } else if ("Prefix" == name) {
+            m_prefix = text;
+        } else if ("KeyMarker" == name) {
+            m_key_marker = text;
+        } else if ("VersionIdMarker" == name) {
+            m_version_id_marker = text;
+        } else if ("MaxKeys" == name) {
+            m_max_keys = StringUtil::StringToUint64(text);
+        } else if ("IsTruncated" == name) {
+            m_is_truncated = ("true" == text);
+        } else if ("Encoding-Type" == name) {
+            m_encoding_type = text;
+        } else if ("NextKeyMarker" == name) {
+            m_next_key_marker = text;
+        } else if ("NextVersionIdMarker" == name) {
+            m_next_version_id_marker = text;
+        } else if ("DeleteMarker" == name || "Version" == name) {
+            m_in_summary = false;
         } else {
             SDK_LOG_WARN("Unknown field in ListVersionsResult node, field_name=%s.",
-                    node_name.c_str());
+                         name.c_str());
+        }
+    } else if (depth == 3 && m_in_summary) {
+        COSVersionSummary& summary = m_summaries.back();
+        if ("Key" == name) {
+            summary.m_key = text;
+        } else if ("VersionId" == name) {
+            summary.m_version_id = text;
+        } else if ("IsLatest" == name) {
+            summary.m_is_latest = ("true" == text);
+        } else if ("LastModified" == name) {
+            summary.m_last_modified = text;
+            summary.m_last_modified_time = StringUtil::Iso8601ToTimestamp(text);
+        } else if ("ETag" == name) {
+            summary.m_etag = StringUtil::Trim(text, "\"");
+        } else if ("Size" == name) {
+            summary.m_size = StringUtil::StringToUint64(text);
+        } else if ("StorageClass" == name) {
+            summary.m_storage_class = text;
+        } else if ("Owner" != name) {
+            SDK_LOG_WARN("Unknown field in DeleteMarker/Version node, field_name=%s.",
+                         name.c_str());
+        }
+    } else if (depth == 4 && m_in_summary) {
+        COSVersionSummary& summary = m_summaries.back();
+        if ("DisplayName" == name) {
+            summary.m_owner.m_display_name = text;
+        } else if ("ID" == name) {
+            summary.m_owner.m_id = text;
+        } else {
+            SDK_LOG_WARN("Unknown field in owner node, field_name=%s.", name.c_str());
         }
     }
+}
 
-    delete cstr;
-    return true;
+void GetBucketObjectVersionsResp::OnReset() {
+    m_xml_depth = 0;
+    m_has_root = false;
+    m_in_summary = false;
+    m_summaries.clear();
+    m_encoding_type.clear();
+    m_is_truncated = false;
+    m_max_keys = 0;
+    m_bucket_name.clear();
+    m_key_marker.clear();
+    m_prefix.clear();
+    m_version_id_marker.clear();
+    m_next_key_marker.clear();
+    m_next_version_id_marker.clear();
+}
+
+bool GetBucketObjectVersionsResp::OnEndDocument() {
+    if (!m_has_root) {
+        SDK_LOG_ERR("Miss root node=ListVersionsResult");
+    }
+    return m_has_root;
 }
 
 } // namespace qcloud_cos
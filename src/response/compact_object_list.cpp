@@ -0,0 +1,193 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: 按列存储的紧凑Object列表
+
+#include "response/compact_object_list.h"
+
+namespace qcloud_cos {
+
+namespace {
+
+const char kHexChars[] = "0123456789abcdef";
+
+int HexValue(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
+// 解析"32位小写hex[后缀]"格式的ETag, 成功时md5写入16字节
+bool ParseMd5ETag(const std::string& etag, unsigned char* md5, std::string* suffix) {
+    if (etag.size() < 32 || (etag.size() > 32 && etag[32] != '-')) {
+        return false;
+    }
+    for (size_t i = 0; i < 16; ++i) {
+        int high = HexValue(etag[2 * i]);
+        int low = HexValue(etag[2 * i + 1]);
+        if (high < 0 || low < 0) {
+            return false;
+        }
+        md5[i] = static_cast<unsigned char>((high << 4) | low);
+    }
+    suffix->assign(etag, 32, std::string::npos);
+    return true;
+}
+
+template <typename T>
+uint64_t CapacityBytes(const std::vector<T>& v) {
+    return static_cast<uint64_t>(v.capacity()) * sizeof(T);
+}
+
+} // namespace
+
+StringInterner::StringInterner() {
+    Clear();
+}
+
+uint32_t StringInterner::Intern(const std::string& str) {
+    std::map<std::string, uint32_t>::const_iterator itr = m_ids.find(str);
+    if (itr != m_ids.end()) {
+        return itr->second;
+    }
+    uint32_t id = static_cast<uint32_t>(m_strings.size());
+    m_strings.push_back(str);
+    m_ids.insert(std::make_pair(str, id));
+    return id;
+}
+
+void StringInterner::Clear() {
+    m_strings.clear();
+    m_ids.clear();
+    Intern("");
+}
+
+const char* CompactObjectRef::GetKeyData() const {
+    uint64_t begin = m_idx == 0 ? 0 : m_list->m_key_ends[m_idx - 1];
+    return m_list->m_key_arena.data() + begin;
+}
+
+size_t CompactObjectRef::GetKeySize() const {
+    uint64_t begin = m_idx == 0 ? 0 : m_list->m_key_ends[m_idx - 1];
+    return static_cast<size_t>(m_list->m_key_ends[m_idx] - begin);
+}
+
+std::string CompactObjectRef::GetKey() const {
+    return std::string(GetKeyData(), GetKeySize());
+}
+
+uint64_t CompactObjectRef::GetSize() const {
+    return m_list->m_sizes[m_idx];
+}
+
+uint64_t CompactObjectRef::GetLastModifiedTime() const {
+    return m_list->m_mtimes[m_idx];
+}
+
+std::string CompactObjectRef::GetETag() const {
+    uint32_t etag_id = m_list->m_etag_ids[m_idx];
+    if (etag_id & CompactObjectList::kRawETagFlag) {
+        return m_list->m_interner.Get(etag_id & ~CompactObjectList::kRawETagFlag);
+    }
+
+    const std::string& suffix = m_list->m_interner.Get(etag_id);
+    std::string etag;
+    etag.reserve(2 * CompactObjectList::kMd5Bytes + suffix.size());
+    const char* md5 = m_list->m_etag_md5s.data() + m_idx * CompactObjectList::kMd5Bytes;
+    for (size_t i = 0; i < CompactObjectList::kMd5Bytes; ++i) {
+        unsigned char c = static_cast<unsigned char>(md5[i]);
+        etag.push_back(kHexChars[c >> 4]);
+        etag.push_back(kHexChars[c & 0x0F]);
+    }
+    etag.append(suffix);
+    return etag;
+}
+
+const std::string& CompactObjectRef::GetStorageClass() const {
+    return m_list->m_interner.Get(m_list->m_storage_class_ids[m_idx]);
+}
+
+const std::string& CompactObjectRef::GetOwnerId() const {
+    return m_list->m_interner.Get(m_list->m_owner_ids[m_idx]);
+}
+
+CompactObjectList::CompactObjectList() {
+}
+
+void CompactObjectList::Append(const std::string& key, uint64_t size,
+                               uint64_t last_modified_time, const std::string& etag,
+                               const std::string& storage_class,
+                               const std::string& owner_id) {
+    m_key_arena.append(key);
+    m_key_ends.push_back(m_key_arena.size());
+    m_sizes.push_back(size);
+    // 32位的秒级时间戳可以表示到2106年
+    m_mtimes.push_back(static_cast<uint32_t>(last_modified_time));
+
+    unsigned char md5[kMd5Bytes];
+    std::string suffix;
+    if (ParseMd5ETag(etag, md5, &suffix)) {
+        m_etag_md5s.append(reinterpret_cast<const char*>(md5), kMd5Bytes);
+        m_etag_ids.push_back(m_interner.Intern(suffix));
+    } else {
+        m_etag_md5s.append(kMd5Bytes, '\0');
+        m_etag_ids.push_back(m_interner.Intern(etag) | kRawETagFlag);
+    }
+    m_storage_class_ids.push_back(m_interner.Intern(storage_class));
+    m_owner_ids.push_back(m_interner.Intern(owner_id));
+}
+
+void CompactObjectList::GetEntry(size_t idx, BucketObjectEntry* entry) const {
+    CompactObjectRef ref(this, idx);
+    entry->m_is_common_prefix = false;
+    entry->m_key.assign(ref.GetKeyData(), ref.GetKeySize());
+    entry->m_etag = ref.GetETag();
+    entry->m_storage_class = ref.GetStorageClass();
+    entry->m_owner_id = ref.GetOwnerId();
+    entry->m_size = ref.GetSize();
+    entry->m_last_modified_time = ref.GetLastModifiedTime();
+}
+
+void CompactObjectList::Truncate(size_t size) {
+    if (size >= Size()) {
+        return;
+    }
+    m_key_arena.resize(size == 0 ? 0 : static_cast<size_t>(m_key_ends[size - 1]));
+    m_key_ends.resize(size);
+    m_sizes.resize(size);
+    m_mtimes.resize(size);
+    m_etag_md5s.resize(size * kMd5Bytes);
+    m_etag_ids.resize(size);
+    m_storage_class_ids.resize(size);
+    m_owner_ids.resize(size);
+}
+
+void CompactObjectList::Clear() {
+    Truncate(0);
+    m_interner.Clear();
+}
+
+void CompactObjectList::Reserve(size_t entry_num, size_t key_bytes) {
+    m_key_arena.reserve(key_bytes);
+    m_key_ends.reserve(entry_num);
+    m_sizes.reserve(entry_num);
+    m_mtimes.reserve(entry_num);
+    m_etag_md5s.reserve(entry_num * kMd5Bytes);
+    m_etag_ids.reserve(entry_num);
+    m_storage_class_ids.reserve(entry_num);
+    m_owner_ids.reserve(entry_num);
+}
+
+uint64_t CompactObjectList::GetMemoryUsage() const {
+    uint64_t usage = m_key_arena.capacity() + m_etag_md5s.capacity();
+    usage += CapacityBytes(m_key_ends) + CapacityBytes(m_sizes) + CapacityBytes(m_mtimes);
+    usage += CapacityBytes(m_etag_ids) + CapacityBytes(m_storage_class_ids);
+    usage += CapacityBytes(m_owner_ids);
+    return usage;
+}
+
+} // namespace qcloud_cos
@@ -15,14 +15,30 @@
 
 namespace qcloud_cos {
 
+bool AuthTool::IsSignHeader(const std::string& name) {
+    return (name[0] == 'x' || name[0] == 'X')
+        || !strcasecmp(name.c_str(), "content-type")
+        || !strcasecmp(name.c_str(), "host");
+}
+
 void AuthTool::FilterAndSetSignHeader(const std::map<std::string,std::string> &headers,
-                                      std::map<std::string, std::string>* filted_req_headers) {
+                                      HeaderList* filted_req_headers) {
     for(std::map<std::string, std::string>::const_iterator itr = headers.begin();
         itr != headers.end(); ++itr) {
-        if( (itr->first[0] == 'x' || itr->first[0] == 'X')
-            || !strcasecmp(itr->first.c_str(), "content-type")
-            || !strcasecmp(itr->first.c_str(), "host")) {
-            filted_req_headers->insert(std::make_pair(itr->first, itr->second));
+        if (IsSignHeader(itr->first)) {
+            filted_req_headers->Add(itr->first, itr->second);
+        }
+    }
+}
+
+void AuthTool::FilterAndSetSignHeader(const HeaderList& headers,
+                                      HeaderList* filted_req_headers) {
+    std::string name;
+    for (size_t i = 0; i < headers.Size(); ++i) {
+        name.clear();
+        headers.AppendName(i, &name);
+        if (IsSignHeader(name)) {
+            filted_req_headers->Add(name, headers.GetValue(i));
         }
     }
 }
@@ -33,48 +49,51 @@ void AuthTool::FillMap(const std::map<std::string,std::string> &params,
                        bool value_lower,
                        std::string* param_list,
                        std::string* param_value_list) {
-    if (params.empty()) {
-        return;
+    HeaderList trim_params;
+    for (std::map<std::string, std::string>::const_iterator itr = params.begin();
+         itr != params.end(); ++itr) {
+        trim_params.Add(itr->first, itr->second);
     }
+    FillList(&trim_params, key_encode, value_encode, value_lower, param_list, param_value_list);
+}
 
-    std::map<std::string, std::string>::const_iterator itr;
-    std::map<std::string, std::string> trim_params;
-
-    for (itr = params.begin(); itr != params.end(); ++itr) {
-        std::string key = itr->first;
-        std::string value;
-
-        if(value_encode) {
-            value = CodecUtil::UrlEncode(itr->second);
-        } else {
-            value = itr->second;
+void AuthTool::FillList(HeaderList* params,
+                        bool key_encode,
+                        bool value_encode,
+                        bool value_lower,
+                        std::string* param_list,
+                        std::string* param_value_list) {
+    // key转小写后排序, 转小写后重复的key只保留最后一个
+    params->LowerNames();
+    params->SortByName();
+
+    std::string value;
+    for (size_t i = 0; i < params->Size(); ++i) {
+        if (i > 0) {
+            param_list->append(";");
+            param_value_list->append("&");
         }
 
-        std::transform(key.begin(), key.end(), key.begin(), ::tolower);
-        if(value_lower) {
-            std::transform(value.begin(), value.end(), value.begin(), ::tolower);
+        if (key_encode) {
+            std::string key = CodecUtil::UrlEncode(params->GetName(i));
+            param_list->append(key);
+            param_value_list->append(key);
+        } else {
+            params->AppendName(i, param_list);
+            params->AppendName(i, param_value_list);
         }
-        trim_params[key] = value;
-    }
-
-    itr = trim_params.begin();
+        param_value_list->append("=");
 
-    if (key_encode) {
-        param_list->append(CodecUtil::UrlEncode(itr->first));
-        *param_value_list += CodecUtil::UrlEncode(itr->first) + "=" + itr->second;
-    } else {
-        param_list->append(itr->first);
-        *param_value_list += itr->first + "=" + itr->second;
-    }
-
-    for (++itr; itr != trim_params.end(); ++itr) {
-        if(key_encode) {
-            *param_list += ";" + CodecUtil::UrlEncode(itr->first);
-            *param_value_list += "&" + CodecUtil::UrlEncode(itr->first) + "=" + itr->second;
+        if (value_encode) {
+            value = CodecUtil::UrlEncode(params->GetValue(i));
         } else {
-            *param_list += ";" + itr->first;
-            *param_value_list += "&" + itr->first + "=" + itr->second;
+            value.clear();
+            params->AppendValue(i, &value);
+        }
+        if (value_lower) {
+            std::transform(value.begin(), value.end(), value.begin(), ::tolower);
         }
+        param_value_list->append(value);
     }
 }
 
@@ -99,19 +118,45 @@ std::string AuthTool::Sign(const std::string& access_key, const std::string& sec
     if (access_key.empty() || secret_key.empty()) {
         return "";
     }
-    std::string start_end_time_str = StringUtil::Uint64ToString(start_time_in_s) + ";"
-        + StringUtil::Uint64ToString(end_time_in_s);
 
     // 1. 获取签名所需的path/params/headers
-    std::map<std::string, std::string> filted_req_headers;
+    HeaderList filted_req_headers;
+    FilterAndSetSignHeader(headers, &filted_req_headers);
+    return SignFiltered(access_key, secret_key, http_method, in_uri, &filted_req_headers, params,
+                        start_time_in_s, end_time_in_s);
+}
+
+std::string AuthTool::Sign(const std::string& access_key, const std::string& secret_key,
+                           const std::string& http_method, const std::string& in_uri,
+                           const HeaderList& headers,
+                           const std::map<std::string, std::string>& params,
+                           uint64_t start_time_in_s,
+                           uint64_t end_time_in_s) {
+    if (access_key.empty() || secret_key.empty()) {
+        return "";
+    }
+
+    HeaderList filted_req_headers;
     FilterAndSetSignHeader(headers, &filted_req_headers);
+    return SignFiltered(access_key, secret_key, http_method, in_uri, &filted_req_headers, params,
+                        start_time_in_s, end_time_in_s);
+}
+
+std::string AuthTool::SignFiltered(const std::string& access_key, const std::string& secret_key,
+                                   const std::string& http_method, const std::string& in_uri,
+                                   HeaderList* filted_req_headers,
+                                   const std::map<std::string, std::string>& params,
+                                   uint64_t start_time_in_s,
+                                   uint64_t end_time_in_s) {
+    std::string start_end_time_str = StringUtil::Uint64ToString(start_time_in_s) + ";"
+        + StringUtil::Uint64ToString(end_time_in_s);
 
     // 2. 将header和params拼接为字符串
     std::string header_list, header_value_list;
     std::string param_list, param_value_list;
 
     FillMap(params, true, true, false, &param_list, &param_value_list);
-    FillMap(filted_req_headers, false, true, false, &header_list, &header_value_list);
+    FillList(filted_req_headers, false, true, false, &header_list, &header_value_list);
 
     std::string uri = in_uri;
     if (uri.empty()) {
@@ -0,0 +1,35 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: 按Object统计写入次数, 避免与写入并发的读取把旧数据放回缓存
+
+#include "util/cache_generation.h"
+
+namespace qcloud_cos {
+
+size_t CacheGeneration::GetSlot(const std::string& bucket_name,
+                                const std::string& object_name) {
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    std::string key = bucket_name + "/" + object_name;
+    for (size_t i = 0; i < key.size(); ++i) {
+        hash ^= static_cast<unsigned char>(key[i]);
+        hash *= 16777619u;
+    }
+    return hash % kCacheGenerationSlots;
+}
+
+uint64_t CacheGeneration::Get(const std::string& bucket_name,
+                              const std::string& object_name) const {
+    size_t slot = GetSlot(bucket_name, object_name);
+    SimpleMutexLocker locker(&m_mutex);
+    return m_generations[slot];
+}
+
+void CacheGeneration::Bump(const std::string& bucket_name, const std::string& object_name) {
+    size_t slot = GetSlot(bucket_name, object_name);
+    SimpleMutexLocker locker(&m_mutex);
+    ++m_generations[slot];
+}
+
+} // namespace qcloud_cos
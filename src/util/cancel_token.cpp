@@ -0,0 +1,194 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: 请求的取消句柄
+
+#include "util/cancel_token.h"
+
+#include <unistd.h>
+
+#include "Poco/Exception.h"
+#include "Poco/Net/HTTPClientSession.h"
+
+#include "util/http_sender.h"
+
+namespace qcloud_cos {
+
+namespace {
+
+// SleepInms检查取消状态的间隔
+const uint64_t kSleepCheckIntervalInms = 10;
+
+uint64_t NowInms() {
+    return HttpSender::GetTimeStampInUs() / 1000;
+}
+
+} // namespace
+
+CancelToken::CancelToken() : m_is_cancelled(false), m_deadline_in_ms(0) {
+}
+
+CancelToken::~CancelToken() {
+    if (m_parent) {
+        m_parent->RemoveChild(this);
+    }
+}
+
+void CancelToken::Cancel() {
+    SimpleMutexLocker locker(&m_mutex);
+    if (m_is_cancelled) {
+        return;
+    }
+    m_is_cancelled = true;
+
+    // 只shutdown不close, 避免fd被复用后误关其他连接, 连接由HttpSender负责释放
+    for (std::set<Poco::Net::HTTPClientSession*>::iterator itr = m_sessions.begin();
+         itr != m_sessions.end(); ++itr) {
+        try {
+            (*itr)->socket().shutdown();
+        } catch (const Poco::Exception&) {
+            // 连接尚未建立或已关闭
+        }
+    }
+
+    // 子句柄析构前需要获取本句柄的锁才能注销, 因此这里访问子句柄是安全的
+    for (std::set<CancelToken*>::iterator itr = m_children.begin();
+         itr != m_children.end(); ++itr) {
+        (*itr)->Cancel();
+    }
+}
+
+bool CancelToken::IsCancelled() const {
+    SharedCancelToken parent;
+    {
+        SimpleMutexLocker locker(&m_mutex);
+        if (m_is_cancelled) {
+            return true;
+        }
+        if (m_deadline_in_ms != 0 && NowInms() >= m_deadline_in_ms) {
+            return true;
+        }
+        parent = m_parent;
+    }
+    return parent && parent->IsCancelled();
+}
+
+bool CancelToken::IsDeadlineExceeded() const {
+    uint64_t deadline_in_ms = GetDeadlineInms();
+    return deadline_in_ms != 0 && NowInms() >= deadline_in_ms;
+}
+
+void CancelToken::Reset() {
+    SimpleMutexLocker locker(&m_mutex);
+    m_is_cancelled = false;
+}
+
+void CancelToken::SetDeadlineInms(uint64_t deadline_in_ms) {
+    SimpleMutexLocker locker(&m_mutex);
+    m_deadline_in_ms = deadline_in_ms;
+}
+
+uint64_t CancelToken::GetDeadlineInms() const {
+    SharedCancelToken parent;
+    uint64_t deadline_in_ms = 0;
+    {
+        SimpleMutexLocker locker(&m_mutex);
+        deadline_in_ms = m_deadline_in_ms;
+        parent = m_parent;
+    }
+    if (parent) {
+        uint64_t parent_deadline_in_ms = parent->GetDeadlineInms();
+        if (deadline_in_ms == 0
+            || (parent_deadline_in_ms != 0 && parent_deadline_in_ms < deadline_in_ms)) {
+            deadline_in_ms = parent_deadline_in_ms;
+        }
+    }
+    return deadline_in_ms;
+}
+
+uint64_t CancelToken::ClampTimeoutInms(uint64_t timeout_in_ms) const {
+    uint64_t deadline_in_ms = GetDeadlineInms();
+    if (deadline_in_ms == 0) {
+        return timeout_in_ms;
+    }
+
+    uint64_t now_in_ms = NowInms();
+    uint64_t remain_in_ms = deadline_in_ms > now_in_ms ? deadline_in_ms - now_in_ms : 0;
+    if (remain_in_ms < timeout_in_ms) {
+        timeout_in_ms = remain_in_ms;
+    }
+    return timeout_in_ms > 0 ? timeout_in_ms : 1;
+}
+
+bool CancelToken::SleepInms(uint64_t sleep_in_ms) const {
+    uint64_t end_in_ms = NowInms() + sleep_in_ms;
+    while (!IsCancelled()) {
+        uint64_t now_in_ms = NowInms();
+        if (now_in_ms >= end_in_ms) {
+            return true;
+        }
+        uint64_t interval_in_ms = end_in_ms - now_in_ms;
+        if (interval_in_ms > kSleepCheckIntervalInms) {
+            interval_in_ms = kSleepCheckIntervalInms;
+        }
+        usleep(interval_in_ms * 1000);
+    }
+    return false;
+}
+
+void CancelToken::SetParent(const SharedCancelToken& parent) {
+    SharedCancelToken old_parent;
+    {
+        SimpleMutexLocker locker(&m_mutex);
+        old_parent = m_parent;
+        m_parent = parent;
+    }
+    if (old_parent) {
+        old_parent->RemoveChild(this);
+    }
+    if (parent) {
+        parent->AddChild(this);
+    }
+}
+
+std::string CancelToken::GetErrMsg() const {
+    return IsDeadlineExceeded() ? kRequestDeadlineExceededErrMsg : kRequestCancelledErrMsg;
+}
+
+bool CancelToken::OnResponseHeader() {
+    return !IsCancelled();
+}
+
+bool CancelToken::AttachSession(Poco::Net::HTTPClientSession* session) {
+    {
+        SimpleMutexLocker locker(&m_mutex);
+        if (m_is_cancelled) {
+            return false;
+        }
+        m_sessions.insert(session);
+    }
+
+    // 注册之后父句柄的取消会传递到本句柄并shutdown该连接, 注册之前的取消在这里检查
+    if (IsCancelled()) {
+        DetachSession(session);
+        return false;
+    }
+    return true;
+}
+
+void CancelToken::DetachSession(Poco::Net::HTTPClientSession* session) {
+    SimpleMutexLocker locker(&m_mutex);
+    m_sessions.erase(session);
+}
+
+void CancelToken::AddChild(CancelToken* child) {
+    SimpleMutexLocker locker(&m_mutex);
+    m_children.insert(child);
+}
+
+void CancelToken::RemoveChild(CancelToken* child) {
+    SimpleMutexLocker locker(&m_mutex);
+    m_children.erase(child);
+}
+
+} // namespace qcloud_cos
@@ -0,0 +1,56 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: CosAPI实例级别的配置, 未设置的项使用CosSysConfig的全局配置
+
+#include "util/client_settings.h"
+
+#include "cos_sys_config.h"
+
+namespace qcloud_cos {
+
+uint64_t ClientSettings::GetConnTimeoutInms() const {
+    return m_conn_timeout_in_ms > 0 ? m_conn_timeout_in_ms : CosSysConfig::GetConnTimeoutInms();
+}
+
+uint64_t ClientSettings::GetRecvTimeoutInms() const {
+    return m_recv_timeout_in_ms > 0 ? m_recv_timeout_in_ms : CosSysConfig::GetRecvTimeoutInms();
+}
+
+uint64_t ClientSettings::GetAuthExpiredTime() const {
+    return m_auth_expired_time_in_s > 0 ? m_auth_expired_time_in_s
+        : CosSysConfig::GetAuthExpiredTime();
+}
+
+uint64_t ClientSettings::GetUploadPartSize() const {
+    return m_upload_part_size > 0 ? m_upload_part_size : CosSysConfig::GetUploadPartSize();
+}
+
+uint64_t ClientSettings::GetUploadCopyPartSize() const {
+    return m_upload_copy_part_size > 0 ? m_upload_copy_part_size
+        : CosSysConfig::GetUploadCopyPartSize();
+}
+
+unsigned ClientSettings::GetUploadThreadPoolSize() const {
+    return m_upload_thread_pool_size > 0 ? m_upload_thread_pool_size
+        : CosSysConfig::GetUploadThreadPoolSize();
+}
+
+uint64_t ClientSettings::GetDownSliceSize() const {
+    return m_down_slice_size > 0 ? m_down_slice_size : CosSysConfig::GetDownSliceSize();
+}
+
+unsigned ClientSettings::GetDownThreadPoolMaxSize() const {
+    return m_down_thread_pool_max_size > 0 ? m_down_thread_pool_max_size
+        : CosSysConfig::GetDownThreadPoolMaxSize();
+}
+
+bool ClientSettings::IsCheckMd5() const {
+    return m_check_md5 >= 0 ? m_check_md5 == 1 : CosSysConfig::IsCheckMd5();
+}
+
+std::string ClientSettings::GetDestDomain() const {
+    return m_is_dest_domain_set ? m_dest_domain : CosSysConfig::GetDestDomain();
+}
+
+} // namespace qcloud_cos
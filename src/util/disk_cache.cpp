@@ -0,0 +1,516 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: GetObject的本地磁盘读穿缓存, LRU索引保存在mmap的定长记录文件中
+
+#include "util/disk_cache.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "boost/date_time/posix_time/posix_time_types.hpp"
+#include "boost/weak_ptr.hpp"
+
+#include "cos_sys_config.h"
+#include "util/http_sender.h"
+
+namespace qcloud_cos {
+
+namespace {
+
+const uint32_t kIndexMagic = 0x434f5344; // "COSD"
+// 版本2起缓存文件末尾记录完整的key, 版本3起同时记录响应头
+const uint32_t kIndexVersion = 3;
+const size_t kMaxEtagLen = 72;
+const size_t kMaxKeyLen = 4096;
+const size_t kMaxHeadersLen = 16 * 1024;
+const char* const kTempSuffix = ".tmp";
+// 取消句柄没有唤醒等待方的回调, 等待填充时按该间隔检查取消状态
+const uint64_t kCancelCheckIntervalInms = 10;
+
+uint64_t NowInms() {
+    return HttpSender::GetTimeStampInUs() / 1000;
+}
+
+bool MakeDir(const std::string& path) {
+    return mkdir(path.c_str(), 0755) == 0 || errno == EEXIST;
+}
+
+// 响应头按"name:value\n"逐行编码, 名称不含':', 名称和值都不含换行
+std::string EncodeHeaders(const std::map<std::string, std::string>& headers) {
+    std::string encoded;
+    for (std::map<std::string, std::string>::const_iterator itr = headers.begin();
+         itr != headers.end(); ++itr) {
+        if (itr->first.empty() || itr->first.find_first_of(":\r\n") != std::string::npos
+            || itr->second.find_first_of("\r\n") != std::string::npos) {
+            continue;
+        }
+        encoded += itr->first + ":" + itr->second + "\n";
+    }
+    return encoded;
+}
+
+void DecodeHeaders(const std::string& encoded, std::map<std::string, std::string>* headers) {
+    size_t pos = 0;
+    while (pos < encoded.size()) {
+        size_t end = encoded.find('\n', pos);
+        if (end == std::string::npos) {
+            end = encoded.size();
+        }
+        size_t sep = encoded.find(':', pos);
+        if (sep != std::string::npos && sep < end) {
+            (*headers)[encoded.substr(pos, sep - pos)] = encoded.substr(sep + 1, end - sep - 1);
+        }
+        pos = end + 1;
+    }
+}
+
+// 在缓存文件末尾依次追加编码后的响应头、key, 以及4字节的响应头长度和4字节的key长度
+bool AppendFooter(const std::string& path, const std::string& key,
+                  const std::string& headers) {
+    int fd = open(path.c_str(), O_WRONLY | O_APPEND);
+    if (fd == -1) {
+        return false;
+    }
+    uint32_t headers_len = headers.size();
+    uint32_t key_len = key.size();
+    std::string footer = headers + key;
+    footer.append(reinterpret_cast<const char*>(&headers_len), sizeof(headers_len));
+    footer.append(reinterpret_cast<const char*>(&key_len), sizeof(key_len));
+    bool is_succ = write(fd, footer.data(), footer.size())
+        == static_cast<ssize_t>(footer.size());
+    close(fd);
+    return is_succ;
+}
+
+boost::mutex s_instances_mutex;
+std::map<std::string, boost::weak_ptr<DiskCache> > s_instances;
+
+} // namespace
+
+struct DiskCache::IndexHeader {
+    uint32_t m_magic;
+    uint32_t m_version;
+    uint32_t m_slot_num;
+    uint32_t m_reserved;
+    uint64_t m_access_seq; // 单调递增的访问序号
+};
+
+struct DiskCache::IndexSlot {
+    uint64_t m_key_hash;
+    uint64_t m_size;
+    uint64_t m_access_seq;
+    uint64_t m_fetch_time_in_ms; // 最近一次下载或重新验证的时间
+    uint32_t m_is_used;
+    uint32_t m_etag_len;
+    char m_etag[kMaxEtagLen];
+};
+
+boost::shared_ptr<DiskCache> DiskCache::Open(const DiskCachePolicy& policy) {
+    boost::mutex::scoped_lock lock(s_instances_mutex);
+    boost::shared_ptr<DiskCache> cache = s_instances[policy.GetCacheDir()].lock();
+    if (cache) {
+        return cache;
+    }
+    cache.reset(new DiskCache(policy));
+    if (!cache->Init()) {
+        SDK_LOG_ERR("Open disk cache fail, cache_dir=%s, errno=%d",
+                    policy.GetCacheDir().c_str(), errno);
+        return boost::shared_ptr<DiskCache>();
+    }
+    s_instances[policy.GetCacheDir()] = cache;
+    return cache;
+}
+
+DiskCache::DiskCache(const DiskCachePolicy& policy)
+    : m_policy(policy), m_data_dir(policy.GetCacheDir() + "/data"), m_index_fd(-1),
+      m_index_addr(NULL), m_index_len(0), m_total_bytes(0) {
+}
+
+DiskCache::~DiskCache() {
+    if (m_index_addr != NULL) {
+        munmap(m_index_addr, m_index_len);
+    }
+    if (m_index_fd != -1) {
+        close(m_index_fd);
+    }
+}
+
+bool DiskCache::Init() {
+    if (m_policy.GetMaxEntries() == 0 || !MakeDir(m_policy.GetCacheDir())
+        || !MakeDir(m_data_dir) || !LoadIndex()) {
+        return false;
+    }
+    LoadSlots();
+    RemoveOrphanFiles();
+    SDK_LOG_INFO("Open disk cache, cache_dir=%s, entries=%lu, bytes=%lu",
+                 m_policy.GetCacheDir().c_str(),
+                 static_cast<unsigned long>(m_slot_by_hash.size()),
+                 static_cast<unsigned long>(m_total_bytes));
+    return true;
+}
+
+std::string DiskCache::GetKey(const std::string& bucket_name, const std::string& object_name) {
+    return bucket_name + "/" + object_name;
+}
+
+uint64_t DiskCache::HashKey(const std::string& key) {
+    // FNV-1a
+    uint64_t hash = 14695981039346656037ULL;
+    for (std::string::const_iterator itr = key.begin(); itr != key.end(); ++itr) {
+        hash ^= static_cast<unsigned char>(*itr);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+std::string DiskCache::GetDataPath(uint64_t key_hash) const {
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(key_hash));
+    return m_data_dir + "/" + name;
+}
+
+bool DiskCache::ReadDataFooter(uint64_t key_hash, uint64_t size, std::string* key,
+                               std::map<std::string, std::string>* headers) const {
+    int fd = open(GetDataPath(key_hash).c_str(), O_RDONLY);
+    if (fd == -1) {
+        return false;
+    }
+    bool is_succ = false;
+    struct stat st;
+    uint32_t lens[2] = {0, 0}; // 响应头长度, key长度
+    if (fstat(fd, &st) == 0 && static_cast<uint64_t>(st.st_size) >= size + sizeof(lens)
+        && pread(fd, lens, sizeof(lens), st.st_size - sizeof(lens))
+            == static_cast<ssize_t>(sizeof(lens))
+        && lens[0] <= kMaxHeadersLen && lens[1] <= kMaxKeyLen
+        && static_cast<uint64_t>(st.st_size) == size + lens[0] + lens[1] + sizeof(lens)) {
+        std::string footer(lens[0] + lens[1], '\0');
+        is_succ = footer.empty()
+            || pread(fd, &footer[0], footer.size(), size) == static_cast<ssize_t>(footer.size());
+        if (is_succ) {
+            key->assign(footer, lens[0], lens[1]);
+            headers->clear();
+            DecodeHeaders(footer.substr(0, lens[0]), headers);
+        }
+    }
+    close(fd);
+    return is_succ;
+}
+
+std::string DiskCache::GetTempPath(const std::string& bucket_name,
+                                   const std::string& object_name) const {
+    // 同一个Object同时只有一个线程在填充, 临时文件不会冲突
+    return GetDataPath(HashKey(GetKey(bucket_name, object_name))) + kTempSuffix;
+}
+
+bool DiskCache::LoadIndex() {
+    std::string index_path = m_policy.GetCacheDir() + "/index";
+    m_index_fd = open(index_path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (m_index_fd == -1) {
+        return false;
+    }
+    m_index_len = sizeof(IndexHeader) + sizeof(IndexSlot) * m_policy.GetMaxEntries();
+    struct stat st;
+    if (fstat(m_index_fd, &st) != 0) {
+        return false;
+    }
+    bool is_resized = (static_cast<size_t>(st.st_size) != m_index_len);
+    if (is_resized && ftruncate(m_index_fd, m_index_len) != 0) {
+        return false;
+    }
+    m_index_addr = mmap(NULL, m_index_len, PROT_READ | PROT_WRITE, MAP_SHARED, m_index_fd, 0);
+    if (m_index_addr == MAP_FAILED) {
+        m_index_addr = NULL;
+        return false;
+    }
+
+    // 容量变化或格式不符时丢弃旧索引, 旧的缓存文件随后作为孤儿文件删除
+    IndexHeader* header = static_cast<IndexHeader*>(m_index_addr);
+    if (is_resized || header->m_magic != kIndexMagic || header->m_version != kIndexVersion
+        || header->m_slot_num != m_policy.GetMaxEntries()) {
+        ResetIndex();
+    }
+    return true;
+}
+
+void DiskCache::ResetIndex() {
+    memset(m_index_addr, 0, m_index_len);
+    IndexHeader* header = static_cast<IndexHeader*>(m_index_addr);
+    header->m_version = kIndexVersion;
+    header->m_slot_num = m_policy.GetMaxEntries();
+    header->m_access_seq = 0;
+    header->m_magic = kIndexMagic;
+}
+
+void DiskCache::LoadSlots() {
+    uint32_t slot_num = m_policy.GetMaxEntries();
+    m_slot_keys.resize(slot_num);
+    m_slot_headers.resize(slot_num);
+    for (uint32_t i = slot_num; i > 0; --i) {
+        uint32_t idx = i - 1;
+        IndexSlot* slot = GetSlot(idx);
+        if (slot->m_is_used) {
+            // 缓存文件缺失、大小不符(如写入过程中进程退出)或记录的key与哈希不符时丢弃该记录
+            if (slot->m_etag_len > kMaxEtagLen
+                || m_slot_by_hash.count(slot->m_key_hash) > 0
+                || !ReadDataFooter(slot->m_key_hash, slot->m_size, &m_slot_keys[idx],
+                                   &m_slot_headers[idx])
+                || HashKey(m_slot_keys[idx]) != slot->m_key_hash) {
+                slot->m_is_used = 0;
+                m_slot_keys[idx].clear();
+                m_slot_headers[idx].clear();
+            }
+        }
+        if (!slot->m_is_used) {
+            m_free_slots.push_back(idx);
+            continue;
+        }
+        m_slot_by_hash[slot->m_key_hash] = idx;
+        m_lru.insert(std::make_pair(slot->m_access_seq, idx));
+        m_total_bytes += slot->m_size;
+    }
+}
+
+void DiskCache::RemoveOrphanFiles() {
+    DIR* dir = opendir(m_data_dir.c_str());
+    if (dir == NULL) {
+        return;
+    }
+    struct dirent* ent = NULL;
+    while ((ent = readdir(dir)) != NULL) {
+        std::string name = ent->d_name;
+        if (name == "." || name == "..") {
+            continue;
+        }
+        unsigned long long key_hash = 0;
+        char tail = '\0';
+        if (name.size() == 16 && sscanf(name.c_str(), "%16llx%c", &key_hash, &tail) == 1
+            && m_slot_by_hash.count(key_hash) > 0) {
+            continue;
+        }
+        unlink((m_data_dir + "/" + name).c_str());
+    }
+    closedir(dir);
+}
+
+DiskCache::IndexSlot* DiskCache::GetSlot(uint32_t slot_idx) const {
+    char* slots = static_cast<char*>(m_index_addr) + sizeof(IndexHeader);
+    return reinterpret_cast<IndexSlot*>(slots) + slot_idx;
+}
+
+void DiskCache::TouchSlot(uint32_t slot_idx) {
+    IndexSlot* slot = GetSlot(slot_idx);
+    IndexHeader* header = static_cast<IndexHeader*>(m_index_addr);
+    m_lru.erase(std::make_pair(slot->m_access_seq, slot_idx));
+    slot->m_access_seq = ++header->m_access_seq;
+    m_lru.insert(std::make_pair(slot->m_access_seq, slot_idx));
+}
+
+void DiskCache::RemoveSlot(uint32_t slot_idx, bool is_evict) {
+    IndexSlot* slot = GetSlot(slot_idx);
+    slot->m_is_used = 0;
+    // 正在读取该文件的线程持有打开的句柄, 删除不影响其读取
+    unlink(GetDataPath(slot->m_key_hash).c_str());
+    m_total_bytes -= slot->m_size;
+    m_slot_by_hash.erase(slot->m_key_hash);
+    m_slot_keys[slot_idx].clear();
+    m_slot_headers[slot_idx].clear();
+    m_lru.erase(std::make_pair(slot->m_access_seq, slot_idx));
+    m_free_slots.push_back(slot_idx);
+    if (is_evict) {
+        ++m_stat.m_evictions;
+    }
+}
+
+bool DiskCache::Lookup(const std::string& bucket_name, const std::string& object_name,
+                       DiskCacheEntry* entry) {
+    std::string key = GetKey(bucket_name, object_name);
+    uint64_t key_hash = HashKey(key);
+    uint64_t now_in_ms = NowInms();
+    boost::mutex::scoped_lock lock(m_mutex);
+    std::map<uint64_t, uint32_t>::const_iterator itr = m_slot_by_hash.find(key_hash);
+    // 哈希相同的其它Object视为未命中
+    if (itr == m_slot_by_hash.end() || m_slot_keys[itr->second] != key) {
+        return false;
+    }
+    // 在锁内打开, 保证读到的是这条记录对应的文件, 而不是之后替换进来的同名文件
+    std::string data_path = GetDataPath(key_hash);
+    boost::shared_ptr<std::ifstream> file(
+        new std::ifstream(data_path.c_str(), std::ios::in | std::ios::binary));
+    if (!file->is_open()) {
+        RemoveSlot(itr->second, false);
+        return false;
+    }
+    const IndexSlot* slot = GetSlot(itr->second);
+    entry->m_path = data_path;
+    entry->m_file = file;
+    entry->m_etag.assign(slot->m_etag, slot->m_etag_len);
+    entry->m_size = slot->m_size;
+    entry->m_is_fresh = m_policy.GetFreshInms() > 0
+        && now_in_ms < slot->m_fetch_time_in_ms + m_policy.GetFreshInms();
+    entry->m_headers = m_slot_headers[itr->second];
+    TouchSlot(itr->second);
+    return true;
+}
+
+bool DiskCache::BeginFill(const std::string& bucket_name, const std::string& object_name,
+                          uint64_t deadline_in_ms, const SharedCancelToken& cancel_token,
+                          bool* is_filled) {
+    // 按哈希互斥, 哈希冲突的Object依次填充, 共用的临时文件不会同时写入
+    uint64_t key_hash = HashKey(GetKey(bucket_name, object_name));
+    boost::mutex::scoped_lock lock(m_mutex);
+    std::map<uint64_t, SharedFillState>::iterator itr = m_fills.find(key_hash);
+    if (itr == m_fills.end()) {
+        m_fills[key_hash].reset(new FillState());
+        return true;
+    }
+    SharedFillState state = itr->second;
+    ++m_stat.m_fill_waits;
+    while (!state->m_is_done) {
+        if (cancel_token && cancel_token->IsCancelled()) {
+            break;
+        }
+        if (deadline_in_ms == 0 && !cancel_token) {
+            state->m_cond.wait(lock);
+            continue;
+        }
+        uint64_t wait_in_ms = kCancelCheckIntervalInms;
+        if (deadline_in_ms != 0) {
+            uint64_t now_in_ms = NowInms();
+            if (now_in_ms >= deadline_in_ms) {
+                break;
+            }
+            if (!cancel_token || deadline_in_ms - now_in_ms < wait_in_ms) {
+                wait_in_ms = deadline_in_ms - now_in_ms;
+            }
+        }
+        state->m_cond.timed_wait(lock, boost::posix_time::milliseconds(wait_in_ms));
+    }
+    *is_filled = state->m_is_done && state->m_is_filled;
+    return false;
+}
+
+void DiskCache::EndFill(const std::string& bucket_name, const std::string& object_name,
+                        bool is_filled) {
+    uint64_t key_hash = HashKey(GetKey(bucket_name, object_name));
+    boost::mutex::scoped_lock lock(m_mutex);
+    std::map<uint64_t, SharedFillState>::iterator itr = m_fills.find(key_hash);
+    if (itr == m_fills.end()) {
+        return;
+    }
+    itr->second->m_is_done = true;
+    itr->second->m_is_filled = is_filled;
+    itr->second->m_cond.notify_all();
+    m_fills.erase(itr);
+}
+
+bool DiskCache::Commit(const std::string& bucket_name, const std::string& object_name,
+                       const std::string& temp_path, const std::string& etag, uint64_t size,
+                       const std::map<std::string, std::string>& headers,
+                       DiskCacheEntry* entry) {
+    std::string key = GetKey(bucket_name, object_name);
+    std::string encoded_headers = EncodeHeaders(headers);
+    if (size > m_policy.GetMaxBytes() || etag.empty() || etag.size() > kMaxEtagLen
+        || key.size() > kMaxKeyLen || encoded_headers.size() > kMaxHeadersLen) {
+        return false;
+    }
+    if (!AppendFooter(temp_path, key, encoded_headers)) {
+        SDK_LOG_ERR("Append footer to disk cache file fail, path=%s, errno=%d",
+                    temp_path.c_str(), errno);
+        truncate(temp_path.c_str(), size);
+        return false;
+    }
+
+    uint64_t key_hash = HashKey(key);
+    std::string data_path = GetDataPath(key_hash);
+    boost::mutex::scoped_lock lock(m_mutex);
+    // 哈希相同的其它Object共用缓存文件名, 一并替换
+    std::map<uint64_t, uint32_t>::const_iterator itr = m_slot_by_hash.find(key_hash);
+    if (itr != m_slot_by_hash.end()) {
+        RemoveSlot(itr->second, false);
+    }
+    while ((m_total_bytes + size > m_policy.GetMaxBytes() || m_free_slots.empty())
+           && !m_lru.empty()) {
+        RemoveSlot(m_lru.begin()->second, true);
+    }
+    if (rename(temp_path.c_str(), data_path.c_str()) != 0) {
+        SDK_LOG_ERR("Commit disk cache file fail, path=%s, errno=%d", data_path.c_str(), errno);
+        return false;
+    }
+
+    uint32_t slot_idx = m_free_slots.back();
+    m_free_slots.pop_back();
+    IndexSlot* slot = GetSlot(slot_idx);
+    IndexHeader* header = static_cast<IndexHeader*>(m_index_addr);
+    slot->m_key_hash = key_hash;
+    slot->m_size = size;
+    slot->m_access_seq = ++header->m_access_seq;
+    slot->m_fetch_time_in_ms = NowInms();
+    slot->m_etag_len = etag.size();
+    memcpy(slot->m_etag, etag.data(), etag.size());
+    m_slot_keys[slot_idx] = key;
+    // 与重新加载时一样按编码后的内容保存
+    m_slot_headers[slot_idx].clear();
+    DecodeHeaders(encoded_headers, &m_slot_headers[slot_idx]);
+    // 最后标记为有效, 进程在写入过程中退出时该记录被丢弃
+    slot->m_is_used = 1;
+    m_slot_by_hash[key_hash] = slot_idx;
+    m_lru.insert(std::make_pair(slot->m_access_seq, slot_idx));
+    m_total_bytes += size;
+    ++m_stat.m_misses;
+
+    entry->m_path = data_path;
+    entry->m_file.reset(new std::ifstream(data_path.c_str(), std::ios::in | std::ios::binary));
+    entry->m_etag = etag;
+    entry->m_size = size;
+    entry->m_is_fresh = m_policy.GetFreshInms() > 0;
+    entry->m_headers = m_slot_headers[slot_idx];
+    return true;
+}
+
+void DiskCache::Refresh(const std::string& bucket_name, const std::string& object_name) {
+    std::string key = GetKey(bucket_name, object_name);
+    uint64_t key_hash = HashKey(key);
+    boost::mutex::scoped_lock lock(m_mutex);
+    std::map<uint64_t, uint32_t>::const_iterator itr = m_slot_by_hash.find(key_hash);
+    if (itr != m_slot_by_hash.end() && m_slot_keys[itr->second] == key) {
+        GetSlot(itr->second)->m_fetch_time_in_ms = NowInms();
+        TouchSlot(itr->second);
+    }
+}
+
+void DiskCache::Invalidate(const std::string& bucket_name, const std::string& object_name) {
+    std::string key = GetKey(bucket_name, object_name);
+    uint64_t key_hash = HashKey(key);
+    boost::mutex::scoped_lock lock(m_mutex);
+    std::map<uint64_t, uint32_t>::const_iterator itr = m_slot_by_hash.find(key_hash);
+    if (itr != m_slot_by_hash.end() && m_slot_keys[itr->second] == key) {
+        RemoveSlot(itr->second, false);
+    }
+}
+
+void DiskCache::AddHit(bool is_revalidated) {
+    boost::mutex::scoped_lock lock(m_mutex);
+    if (is_revalidated) {
+        ++m_stat.m_revalidations;
+    } else {
+        ++m_stat.m_hits;
+    }
+}
+
+DiskCacheStat DiskCache::GetStat() const {
+    boost::mutex::scoped_lock lock(m_mutex);
+    DiskCacheStat stat = m_stat;
+    stat.m_entries = m_slot_by_hash.size();
+    stat.m_bytes = m_total_bytes;
+    return stat;
+}
+
+} // namespace qcloud_cos
@@ -0,0 +1,234 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: 域名解析缓存, 新建连接在解析到的多个地址间轮询
+
+#include "util/dns_cache.h"
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <string.h>
+#include <sys/socket.h>
+
+#include <algorithm>
+
+#include "boost/bind.hpp"
+
+#include "cos_sys_config.h"
+#include "util/executor.h"
+#include "util/http_sender.h"
+
+namespace qcloud_cos {
+
+namespace {
+
+bool IsIpAddress(const std::string& host) {
+    struct in_addr addr4;
+    struct in6_addr addr6;
+    return inet_pton(AF_INET, host.c_str(), &addr4) == 1
+        || inet_pton(AF_INET6, host.c_str(), &addr6) == 1;
+}
+
+uint64_t NowInms() {
+    return HttpSender::GetTimeStampInUs() / 1000;
+}
+
+} // namespace
+
+DnsCache& DnsCache::Instance() {
+    // 后台刷新任务可能在进程退出时仍在执行器中运行, 缓存不析构
+    static DnsCache* s_cache = new DnsCache();
+    return *s_cache;
+}
+
+DnsCache::DnsCache()
+    : m_resolver(&DnsCache::ResolveByGetAddrInfo), m_ttl_in_ms(0),
+      m_eject_in_ms(kDefaultDnsEjectInms) {
+}
+
+bool DnsCache::ResolveByGetAddrInfo(const std::string& host,
+                                    std::vector<std::string>* addresses) {
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo* result = NULL;
+    if (getaddrinfo(host.c_str(), NULL, &hints, &result) != 0) {
+        return false;
+    }
+
+    addresses->clear();
+    for (struct addrinfo* ai = result; ai != NULL; ai = ai->ai_next) {
+        char buf[INET6_ADDRSTRLEN] = {0};
+        const void* addr = NULL;
+        if (ai->ai_family == AF_INET) {
+            addr = &reinterpret_cast<struct sockaddr_in*>(ai->ai_addr)->sin_addr;
+        } else if (ai->ai_family == AF_INET6) {
+            addr = &reinterpret_cast<struct sockaddr_in6*>(ai->ai_addr)->sin6_addr;
+        } else {
+            continue;
+        }
+        if (inet_ntop(ai->ai_family, addr, buf, sizeof(buf)) == NULL) {
+            continue;
+        }
+        std::string ip(buf);
+        if (std::find(addresses->begin(), addresses->end(), ip) == addresses->end()) {
+            addresses->push_back(ip);
+        }
+    }
+    freeaddrinfo(result);
+    return !addresses->empty();
+}
+
+bool DnsCache::PickAddress(const std::string& host, std::string* address) {
+    ResolveFunc resolver = NULL;
+    bool is_hit = false;
+    bool is_refresh = false;
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+        if (m_ttl_in_ms == 0 || IsIpAddress(host)) {
+            return false;
+        }
+        resolver = m_resolver;
+        std::map<std::string, Entry>::iterator itr = m_entries.find(host);
+        if (itr == m_entries.end()) {
+            ++m_stat.m_misses;
+        } else {
+            Entry& entry = itr->second;
+            uint64_t now_in_ms = NowInms();
+            // 过期后继续使用旧地址, 提交到共享执行器重新解析, 每个host同时只有一个刷新任务
+            if (now_in_ms >= entry.m_expire_in_ms && !entry.m_is_refreshing) {
+                entry.m_is_refreshing = true;
+                is_refresh = true;
+                ++m_stat.m_refreshes;
+            }
+            // 轮询未被剔除的地址, 全部被剔除时轮询所有地址
+            size_t num = entry.m_addresses.size();
+            size_t picked = entry.m_next % num;
+            for (size_t i = 0; i < num; ++i) {
+                size_t idx = (entry.m_next + i) % num;
+                if (entry.m_addresses[idx].m_eject_until_in_ms <= now_in_ms) {
+                    picked = idx;
+                    break;
+                }
+            }
+            entry.m_next = picked + 1;
+            *address = entry.m_addresses[picked].m_ip;
+            ++m_stat.m_hits;
+            is_hit = true;
+        }
+    }
+
+    if (is_refresh) {
+        Executor::Instance().Submit(boost::bind(&DnsCache::Refresh, this, host));
+    }
+    if (is_hit) {
+        return true;
+    }
+
+    // 首次解析在请求路径上同步进行
+    std::vector<std::string> ips;
+    if (!resolver(host, &ips)) {
+        boost::mutex::scoped_lock lock(m_mutex);
+        ++m_stat.m_resolve_fails;
+        return false;
+    }
+    boost::mutex::scoped_lock lock(m_mutex);
+    Entry& entry = m_entries[host];
+    UpdateEntry(ips, NowInms(), &entry);
+    *address = entry.m_addresses[entry.m_next % entry.m_addresses.size()].m_ip;
+    ++entry.m_next;
+    return true;
+}
+
+void DnsCache::Refresh(const std::string& host) {
+    ResolveFunc resolver = NULL;
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+        resolver = m_resolver;
+    }
+    std::vector<std::string> ips;
+    bool is_resolved = resolver(host, &ips);
+
+    boost::mutex::scoped_lock lock(m_mutex);
+    std::map<std::string, Entry>::iterator itr = m_entries.find(host);
+    if (itr == m_entries.end()) {
+        return;
+    }
+    Entry& entry = itr->second;
+    entry.m_is_refreshing = false;
+    if (is_resolved) {
+        UpdateEntry(ips, NowInms(), &entry);
+    } else {
+        // 解析失败时继续使用旧地址, 一个有效期后再重试
+        ++m_stat.m_resolve_fails;
+        entry.m_expire_in_ms = NowInms() + m_ttl_in_ms;
+    }
+}
+
+void DnsCache::UpdateEntry(const std::vector<std::string>& ips, uint64_t now_in_ms,
+                           Entry* entry) {
+    std::vector<Address> addresses(ips.size());
+    for (size_t i = 0; i < ips.size(); ++i) {
+        addresses[i].m_ip = ips[i];
+        for (size_t j = 0; j < entry->m_addresses.size(); ++j) {
+            if (entry->m_addresses[j].m_ip == ips[i]) {
+                addresses[i].m_eject_until_in_ms = entry->m_addresses[j].m_eject_until_in_ms;
+                break;
+            }
+        }
+    }
+    entry->m_addresses.swap(addresses);
+    entry->m_expire_in_ms = now_in_ms + m_ttl_in_ms;
+}
+
+void DnsCache::ReportFailure(const std::string& host, const std::string& address) {
+    boost::mutex::scoped_lock lock(m_mutex);
+    std::map<std::string, Entry>::iterator itr = m_entries.find(host);
+    if (itr == m_entries.end()) {
+        return;
+    }
+    std::vector<Address>& addresses = itr->second.m_addresses;
+    for (size_t i = 0; i < addresses.size(); ++i) {
+        if (addresses[i].m_ip == address) {
+            addresses[i].m_eject_until_in_ms = NowInms() + m_eject_in_ms;
+            ++m_stat.m_ejections;
+            SDK_LOG_WARN("Eject address after connect fail, host=%s, address=%s",
+                         host.c_str(), address.c_str());
+            return;
+        }
+    }
+}
+
+void DnsCache::SetTtlInms(uint64_t ttl_in_ms) {
+    boost::mutex::scoped_lock lock(m_mutex);
+    m_ttl_in_ms = ttl_in_ms;
+}
+
+uint64_t DnsCache::GetTtlInms() const {
+    boost::mutex::scoped_lock lock(m_mutex);
+    return m_ttl_in_ms;
+}
+
+void DnsCache::SetEjectInms(uint64_t eject_in_ms) {
+    boost::mutex::scoped_lock lock(m_mutex);
+    m_eject_in_ms = eject_in_ms;
+}
+
+void DnsCache::SetResolver(ResolveFunc resolver) {
+    boost::mutex::scoped_lock lock(m_mutex);
+    m_resolver = resolver != NULL ? resolver : &DnsCache::ResolveByGetAddrInfo;
+}
+
+void DnsCache::Clear() {
+    boost::mutex::scoped_lock lock(m_mutex);
+    m_entries.clear();
+}
+
+DnsCacheStat DnsCache::GetStat() const {
+    boost::mutex::scoped_lock lock(m_mutex);
+    return m_stat;
+}
+
+} // namespace qcloud_cos
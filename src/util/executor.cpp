@@ -0,0 +1,334 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: 进程内共享的work-stealing执行器, 以及按调用限制并发的任务组
+
+#include "util/executor.h"
+
+#include <algorithm>
+#include <exception>
+
+#include "boost/bind.hpp"
+#include "boost/date_time/posix_time/posix_time_types.hpp"
+#include "cos_sys_config.h"
+
+namespace qcloud_cos {
+
+namespace {
+
+// 在工作线程上等待任务组时, 检查执行器中是否有可执行任务的间隔, 单位:毫秒
+const uint64_t kTaskGroupHelpIntervalInms = 10;
+
+} // namespace
+
+Executor::Executor(unsigned thread_num)
+    : m_thread_num(std::max(thread_num, 1u)), m_is_started(false), m_is_stopped(false),
+      m_idle_num(0), m_submitted(0), m_current_worker(&Executor::KeepWorker),
+      m_is_timer_started(false) {
+}
+
+Executor::~Executor() {
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+        m_is_stopped = true;
+        m_cond.notify_all();
+        m_timer_cond.notify_all();
+    }
+    m_threads.join_all();
+    for (size_t i = 0; i < m_workers.size(); ++i) {
+        delete m_workers[i];
+    }
+}
+
+Executor& Executor::Instance() {
+    // 不析构, 避免进程退出时仍有任务在执行
+    static Executor* executor = new Executor();
+    return *executor;
+}
+
+void Executor::SetThreadNum(unsigned thread_num) {
+    boost::mutex::scoped_lock lock(m_mutex);
+    if (m_is_started) {
+        SDK_LOG_WARN("Executor already started with %u threads, ignore thread num %u",
+                     m_thread_num, thread_num);
+        return;
+    }
+    m_thread_num = std::max(thread_num, 1u);
+}
+
+unsigned Executor::GetThreadNum() const {
+    boost::mutex::scoped_lock lock(m_mutex);
+    return m_thread_num;
+}
+
+void Executor::Submit(const ExecutorTask& task) {
+    Worker* worker = m_current_worker.get();
+    if (worker != NULL) {
+        boost::mutex::scoped_lock worker_lock(worker->m_mutex);
+        worker->m_tasks.push_back(task);
+    }
+
+    boost::mutex::scoped_lock lock(m_mutex);
+    if (!m_is_started) {
+        Start();
+    }
+    if (worker == NULL) {
+        m_injected.push_back(task);
+    }
+    ++m_submitted;
+    if (m_idle_num > 0) {
+        m_cond.notify_one();
+    }
+}
+
+void Executor::SubmitAt(const boost::system_time& due_time, const ExecutorTask& task) {
+    boost::mutex::scoped_lock lock(m_mutex);
+    if (m_is_stopped) {
+        return;
+    }
+    if (!m_is_timer_started) {
+        m_threads.create_thread(boost::bind(&Executor::TimerLoop, this));
+        m_is_timer_started = true;
+    }
+    std::multimap<boost::system_time, ExecutorTask>::iterator itr
+        = m_timed_tasks.insert(std::make_pair(due_time, task));
+    // 新任务最早到期时唤醒定时线程重新计算等待时间
+    if (itr == m_timed_tasks.begin()) {
+        m_timer_cond.notify_one();
+    }
+}
+
+bool Executor::IsWorkerThread() const {
+    return m_current_worker.get() != NULL;
+}
+
+bool Executor::RunOne() {
+    Worker* worker = m_current_worker.get();
+    ExecutorTask task;
+    if (worker == NULL || !PopTask(worker, &task)) {
+        return false;
+    }
+    RunTask(worker, task);
+    return true;
+}
+
+ExecutorStat Executor::GetStat() const {
+    ExecutorStat stat;
+    std::vector<Worker*> workers;
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+        stat.m_submitted = m_submitted;
+        workers = m_workers;
+    }
+    for (size_t i = 0; i < workers.size(); ++i) {
+        boost::mutex::scoped_lock worker_lock(workers[i]->m_mutex);
+        stat.m_executed += workers[i]->m_executed;
+        stat.m_stolen += workers[i]->m_stolen;
+    }
+    return stat;
+}
+
+void Executor::Start() {
+    // 先创建全部Worker再启动线程, 启动后m_workers不再修改
+    for (unsigned i = 0; i < m_thread_num; ++i) {
+        m_workers.push_back(new Worker());
+    }
+    for (unsigned i = 0; i < m_thread_num; ++i) {
+        m_threads.create_thread(boost::bind(&Executor::WorkerLoop, this, m_workers[i]));
+    }
+    m_is_started = true;
+    SDK_LOG_INFO("Executor started, thread_num=%u", m_thread_num);
+}
+
+void Executor::WorkerLoop(Worker* worker) {
+    m_current_worker.reset(worker);
+    ExecutorTask task;
+    while (true) {
+        if (PopTask(worker, &task)) {
+            RunTask(worker, task);
+            continue;
+        }
+
+        // 持有m_mutex时再检查一次, 提交方在放入任务之后才加锁通知, 不会丢失唤醒
+        boost::mutex::scoped_lock lock(m_mutex);
+        if (m_is_stopped) {
+            return;
+        }
+        ++m_idle_num;
+        while (!HasTask() && !m_is_stopped) {
+            m_cond.wait(lock);
+        }
+        --m_idle_num;
+    }
+}
+
+void Executor::TimerLoop() {
+    boost::mutex::scoped_lock lock(m_mutex);
+    while (!m_is_stopped) {
+        if (m_timed_tasks.empty()) {
+            m_timer_cond.wait(lock);
+            continue;
+        }
+        std::multimap<boost::system_time, ExecutorTask>::iterator itr = m_timed_tasks.begin();
+        if (boost::get_system_time() < itr->first) {
+            m_timer_cond.timed_wait(lock, itr->first);
+            continue;
+        }
+        ExecutorTask task;
+        task.swap(itr->second);
+        m_timed_tasks.erase(itr);
+        // 定时线程不是工作线程, 任务进入公共队列由空闲的工作线程领取
+        lock.unlock();
+        Submit(task);
+        lock.lock();
+    }
+    m_timed_tasks.clear();
+}
+
+bool Executor::PopTask(Worker* worker, ExecutorTask* task) {
+    {
+        boost::mutex::scoped_lock worker_lock(worker->m_mutex);
+        if (!worker->m_tasks.empty()) {
+            task->swap(worker->m_tasks.back());
+            worker->m_tasks.pop_back();
+            return true;
+        }
+    }
+
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+        if (!m_injected.empty()) {
+            task->swap(m_injected.front());
+            m_injected.pop_front();
+            return true;
+        }
+    }
+
+    // m_workers启动后不再修改, 从下一个线程开始窃取, 分散竞争
+    size_t worker_num = m_workers.size();
+    size_t self = 0;
+    while (self < worker_num && m_workers[self] != worker) {
+        ++self;
+    }
+    for (size_t i = 1; i < worker_num; ++i) {
+        Worker* victim = m_workers[(self + i) % worker_num];
+        boost::mutex::scoped_lock victim_lock(victim->m_mutex);
+        if (!victim->m_tasks.empty()) {
+            task->swap(victim->m_tasks.front());
+            victim->m_tasks.pop_front();
+            victim_lock.unlock();
+
+            boost::mutex::scoped_lock worker_lock(worker->m_mutex);
+            ++worker->m_stolen;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Executor::HasTask() {
+    if (!m_injected.empty()) {
+        return true;
+    }
+    for (size_t i = 0; i < m_workers.size(); ++i) {
+        boost::mutex::scoped_lock worker_lock(m_workers[i]->m_mutex);
+        if (!m_workers[i]->m_tasks.empty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Executor::RunTask(Worker* worker, const ExecutorTask& task) {
+    try {
+        task();
+    } catch (const std::exception& ex) {
+        SDK_LOG_ERR("Executor task throw exception: %s", ex.what());
+    } catch (...) {
+        SDK_LOG_ERR("Executor task throw unknown exception");
+    }
+
+    boost::mutex::scoped_lock worker_lock(worker->m_mutex);
+    ++worker->m_executed;
+}
+
+TaskGroup::TaskGroup(unsigned max_concurrency, Executor* executor)
+    : m_executor(executor), m_max_concurrency(std::max(max_concurrency, 1u)), m_running(0) {
+}
+
+TaskGroup::~TaskGroup() {
+    Wait();
+}
+
+void TaskGroup::Schedule(const ExecutorTask& task) {
+    boost::mutex::scoped_lock lock(m_mutex);
+    m_pending.push_back(task);
+    Dispatch();
+}
+
+void TaskGroup::Wait() {
+    WaitUntil(NULL);
+}
+
+bool TaskGroup::TimedWait(uint64_t timeout_in_ms) {
+    boost::system_time deadline = boost::get_system_time()
+        + boost::posix_time::milliseconds(timeout_in_ms);
+    return WaitUntil(&deadline);
+}
+
+bool TaskGroup::WaitUntil(const boost::system_time* deadline) {
+    bool is_worker = m_executor->IsWorkerThread();
+    boost::mutex::scoped_lock lock(m_mutex);
+    while (m_running > 0 || !m_pending.empty()) {
+        if (deadline != NULL && boost::get_system_time() >= *deadline) {
+            return false;
+        }
+        if (!is_worker) {
+            if (deadline == NULL) {
+                m_cond.wait(lock);
+            } else {
+                m_cond.timed_wait(lock, *deadline);
+            }
+            continue;
+        }
+
+        // 工作线程在等待时执行排队的任务, 组内任务可能正排在自己的队列里
+        lock.unlock();
+        bool is_run = m_executor->RunOne();
+        lock.lock();
+        if (!is_run && (m_running > 0 || !m_pending.empty())) {
+            boost::system_time next = boost::get_system_time()
+                + boost::posix_time::milliseconds(kTaskGroupHelpIntervalInms);
+            if (deadline != NULL && *deadline < next) {
+                next = *deadline;
+            }
+            m_cond.timed_wait(lock, next);
+        }
+    }
+    return true;
+}
+
+void TaskGroup::Dispatch() {
+    while (m_running < m_max_concurrency && !m_pending.empty()) {
+        ++m_running;
+        m_executor->Submit(boost::bind(&TaskGroup::RunTask, this, m_pending.front()));
+        m_pending.pop_front();
+    }
+}
+
+void TaskGroup::RunTask(const ExecutorTask& task) {
+    try {
+        task();
+    } catch (const std::exception& ex) {
+        SDK_LOG_ERR("Task group task throw exception: %s", ex.what());
+    } catch (...) {
+        SDK_LOG_ERR("Task group task throw unknown exception");
+    }
+
+    boost::mutex::scoped_lock lock(m_mutex);
+    --m_running;
+    Dispatch();
+    m_cond.notify_all();
+}
+
+} // namespace qcloud_cos
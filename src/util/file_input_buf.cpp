@@ -0,0 +1,124 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: 读取本地文件中一段数据的流缓冲区, 供HttpSender零拷贝发送
+
+#include "util/file_input_buf.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+namespace qcloud_cos {
+
+namespace {
+
+const size_t kFileInputBufSize = 64 * 1024;
+
+} // namespace
+
+FileInputBuf::FileInputBuf(const std::string& file_path, uint64_t offset, uint64_t len,
+                           TransferProgress* progress)
+    : m_fd(-1), m_begin(0), m_end(0), m_buf_offset(0), m_buf(new char[kFileInputBufSize]),
+      m_progress(progress) {
+    m_fd = ::open(file_path.c_str(), O_RDONLY);
+    if (m_fd >= 0) {
+        struct stat st;
+        uint64_t file_size = ::fstat(m_fd, &st) == 0 ? static_cast<uint64_t>(st.st_size) : 0;
+        m_begin = std::min(offset, file_size);
+        m_end = m_begin + std::min(len, file_size - m_begin);
+    }
+    ResetBuffer(m_begin);
+}
+
+FileInputBuf::~FileInputBuf() {
+    if (m_fd >= 0) {
+        ::close(m_fd);
+    }
+    delete [] m_buf;
+}
+
+uint64_t FileInputBuf::GetFileOffset() const {
+    return m_buf_offset + (gptr() - eback());
+}
+
+uint64_t FileInputBuf::GetRemainBytes() const {
+    return m_end - GetFileOffset();
+}
+
+void FileInputBuf::Consume(uint64_t n) {
+    n = std::min(n, GetRemainBytes());
+    ResetBuffer(GetFileOffset() + n);
+    if (m_progress != NULL) {
+        m_progress->AddBytes(n);
+    }
+}
+
+void FileInputBuf::ResetBuffer(uint64_t file_offset) {
+    m_buf_offset = file_offset;
+    setg(m_buf, m_buf, m_buf);
+}
+
+FileInputBuf::int_type FileInputBuf::underflow() {
+    if (gptr() < egptr()) {
+        return traits_type::to_int_type(*gptr());
+    }
+
+    uint64_t file_offset = GetFileOffset();
+    if (m_fd < 0 || file_offset >= m_end) {
+        return traits_type::eof();
+    }
+    size_t count = static_cast<size_t>(std::min<uint64_t>(kFileInputBufSize,
+                                                          m_end - file_offset));
+    ssize_t n = 0;
+    do {
+        n = ::pread(m_fd, m_buf, count, static_cast<off_t>(file_offset));
+    } while (n < 0 && errno == EINTR);
+    if (n <= 0) {
+        return traits_type::eof();
+    }
+
+    m_buf_offset = file_offset;
+    setg(m_buf, m_buf, m_buf + n);
+    if (m_progress != NULL) {
+        m_progress->AddBytes(n);
+    }
+    return traits_type::to_int_type(*gptr());
+}
+
+FileInputBuf::pos_type FileInputBuf::seekoff(off_type off, std::ios_base::seekdir dir,
+                                             std::ios_base::openmode which) {
+    if (!(which & std::ios_base::in)) {
+        return pos_type(off_type(-1));
+    }
+
+    // 位置相对于范围起始
+    int64_t base = static_cast<int64_t>(GetFileOffset() - m_begin);
+    if (dir == std::ios_base::beg) {
+        base = 0;
+    } else if (dir == std::ios_base::end) {
+        base = static_cast<int64_t>(m_end - m_begin);
+    }
+    int64_t target = base + off;
+    if (target < 0 || static_cast<uint64_t>(target) > m_end - m_begin) {
+        return pos_type(off_type(-1));
+    }
+    // 在缓冲区内移动时保留已读入的数据
+    uint64_t file_offset = m_begin + target;
+    if (file_offset >= m_buf_offset
+        && file_offset <= m_buf_offset + static_cast<uint64_t>(egptr() - eback())) {
+        setg(eback(), eback() + (file_offset - m_buf_offset), egptr());
+    } else {
+        ResetBuffer(file_offset);
+    }
+    return pos_type(target);
+}
+
+FileInputBuf::pos_type FileInputBuf::seekpos(pos_type pos, std::ios_base::openmode which) {
+    return seekoff(off_type(pos), std::ios_base::beg, which);
+}
+
+} // namespace qcloud_cos
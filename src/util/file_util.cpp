@@ -1,9 +1,17 @@
 #include "util/file_util.h"
 
+#include <errno.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
 #include <fstream>
 #include <iostream>
 #include <sstream>
 
+#include "Poco/DigestStream.h"
+#include "Poco/MD5Engine.h"
+#include "Poco/StreamCopier.h"
+
 #include "cos_defines.h"
 #include "cos_sys_config.h"
 #include "util/codec_util.h"
@@ -31,4 +39,33 @@ uint64_t FileUtil::GetFileLen(const std::string& local_file_path) {
     file_input.close();
     return file_len;
 }
+
+std::string FileUtil::GetFileMd5(const std::string& local_file_path) {
+    std::ifstream file_input(local_file_path.c_str(), std::ios::in | std::ios::binary);
+    if (!file_input) {
+        return "";
+    }
+    Poco::MD5Engine md5;
+    Poco::DigestOutputStream dos(md5);
+    Poco::StreamCopier::copyStream(file_input, dos);
+    dos.close();
+    return Poco::DigestEngine::digestToHex(md5.digest());
+}
+
+bool FileUtil::MakeDirs(const std::string& path) {
+    if (path.empty()) {
+        return false;
+    }
+    // 从前往后逐级创建, 其他线程并发创建同一目录时mkdir返回EEXIST
+    size_t pos = 0;
+    while (pos != std::string::npos) {
+        pos = path.find('/', pos + 1);
+        std::string dir = path.substr(0, pos);
+        if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) {
+            return false;
+        }
+    }
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+}
 } //namespace qcloud_cos
@@ -0,0 +1,163 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: 请求热路径上使用的扁平header/param列表
+
+#include "util/header_list.h"
+
+#include <ctype.h>
+#include <strings.h>
+
+#include <algorithm>
+
+namespace qcloud_cos {
+
+class HeaderList::NameLess {
+public:
+    explicit NameLess(const HeaderList* list) : m_list(list) {}
+
+    bool operator()(const Entry& lhs, const Entry& rhs) const {
+        return m_list->CompareName(lhs, rhs) < 0;
+    }
+
+private:
+    const HeaderList* m_list;
+};
+
+HeaderList::HeaderList() {
+    m_arena.reserve(kHeaderListReserveBytes);
+    m_entries.reserve(kHeaderListReserveEntries);
+}
+
+void HeaderList::Add(const std::string& name, const std::string& value) {
+    Entry entry;
+    entry.m_name_len = static_cast<uint32_t>(name.size());
+    entry.m_name_pos = AppendToArena(name);
+    entry.m_value_len = static_cast<uint32_t>(value.size());
+    entry.m_value_pos = AppendToArena(value);
+    m_entries.push_back(entry);
+}
+
+void HeaderList::AddAll(const std::map<std::string, std::string>& kvs) {
+    for (std::map<std::string, std::string>::const_iterator itr = kvs.begin();
+         itr != kvs.end(); ++itr) {
+        Add(itr->first, itr->second);
+    }
+}
+
+void HeaderList::Merge(const std::map<std::string, std::string>& kvs) {
+    for (std::map<std::string, std::string>::const_iterator itr = kvs.begin();
+         itr != kvs.end(); ++itr) {
+        if (FindIndex(itr->first) < 0) {
+            Add(itr->first, itr->second);
+        }
+    }
+}
+
+void HeaderList::Set(const std::string& name, const std::string& value) {
+    int idx = FindIndex(name);
+    if (idx < 0) {
+        Add(name, value);
+        return;
+    }
+
+    // 旧值留在字符区中, 整个列表析构时一并释放
+    Entry& entry = m_entries[idx];
+    entry.m_value_len = static_cast<uint32_t>(value.size());
+    entry.m_value_pos = AppendToArena(value);
+}
+
+bool HeaderList::Find(const std::string& name, std::string* value) const {
+    int idx = FindIndex(name);
+    if (idx < 0) {
+        return false;
+    }
+
+    value->clear();
+    AppendValue(idx, value);
+    return true;
+}
+
+void HeaderList::LowerNames() {
+    for (std::vector<Entry>::const_iterator itr = m_entries.begin();
+         itr != m_entries.end(); ++itr) {
+        std::string::iterator begin = m_arena.begin() + itr->m_name_pos;
+        std::transform(begin, begin + itr->m_name_len, begin, ::tolower);
+    }
+}
+
+void HeaderList::SortByName() {
+    std::stable_sort(m_entries.begin(), m_entries.end(), NameLess(this));
+
+    // 同名条目相邻且保持插入顺序, 保留每组的最后一个
+    size_t count = 0;
+    for (size_t i = 0; i < m_entries.size(); ++i) {
+        if (i + 1 < m_entries.size() && CompareName(m_entries[i], m_entries[i + 1]) == 0) {
+            continue;
+        }
+        m_entries[count++] = m_entries[i];
+    }
+    m_entries.resize(count);
+}
+
+std::string HeaderList::GetName(size_t idx) const {
+    const Entry& entry = m_entries[idx];
+    return m_arena.substr(entry.m_name_pos, entry.m_name_len);
+}
+
+std::string HeaderList::GetValue(size_t idx) const {
+    const Entry& entry = m_entries[idx];
+    return m_arena.substr(entry.m_value_pos, entry.m_value_len);
+}
+
+void HeaderList::AppendName(size_t idx, std::string* out) const {
+    const Entry& entry = m_entries[idx];
+    out->append(m_arena, entry.m_name_pos, entry.m_name_len);
+}
+
+void HeaderList::AppendValue(size_t idx, std::string* out) const {
+    const Entry& entry = m_entries[idx];
+    out->append(m_arena, entry.m_value_pos, entry.m_value_len);
+}
+
+void HeaderList::Clear() {
+    m_arena.clear();
+    m_entries.clear();
+}
+
+int HeaderList::FindIndex(const std::string& name) const {
+    for (int i = static_cast<int>(m_entries.size()) - 1; i >= 0; --i) {
+        const Entry& entry = m_entries[i];
+        if (entry.m_name_len == name.size()
+            && strncasecmp(m_arena.data() + entry.m_name_pos, name.data(), name.size()) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+uint32_t HeaderList::AppendToArena(const std::string& str) {
+    uint32_t pos = static_cast<uint32_t>(m_arena.size());
+    m_arena.append(str);
+    return pos;
+}
+
+int HeaderList::CompareName(const Entry& lhs, const Entry& rhs) const {
+    const char* lhs_name = m_arena.data() + lhs.m_name_pos;
+    const char* rhs_name = m_arena.data() + rhs.m_name_pos;
+    size_t len = std::min(lhs.m_name_len, rhs.m_name_len);
+    for (size_t i = 0; i < len; ++i) {
+        int lhs_ch = ::tolower(static_cast<unsigned char>(lhs_name[i]));
+        int rhs_ch = ::tolower(static_cast<unsigned char>(rhs_name[i]));
+        if (lhs_ch != rhs_ch) {
+            return lhs_ch - rhs_ch;
+        }
+    }
+
+    if (lhs.m_name_len == rhs.m_name_len) {
+        return 0;
+    }
+    return lhs.m_name_len < rhs.m_name_len ? -1 : 1;
+}
+
+} // namespace qcloud_cos
@@ -0,0 +1,120 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: 对冲请求策略
+
+#include "util/hedge_policy.h"
+
+#include <algorithm>
+
+namespace qcloud_cos {
+
+namespace {
+
+// 桶上界从1ms开始按1.25倍增长, 最后一个桶约为100s
+const unsigned kHistogramBucketNum = 52;
+const double kHistogramBucketGrowth = 1.25;
+
+} // namespace
+
+LatencyHistogram::LatencyHistogram(uint64_t window_size)
+    : m_window_size(window_size), m_total(0), m_counts(kHistogramBucketNum, 0) {
+    double bound = 1;
+    for (unsigned i = 0; i < kHistogramBucketNum; ++i) {
+        uint64_t cur = static_cast<uint64_t>(bound);
+        if (!m_bounds.empty() && cur <= m_bounds.back()) {
+            cur = m_bounds.back() + 1;
+        }
+        m_bounds.push_back(cur);
+        bound *= kHistogramBucketGrowth;
+    }
+}
+
+void LatencyHistogram::Record(uint64_t latency_in_ms) {
+    std::vector<uint64_t>::const_iterator itr
+        = std::lower_bound(m_bounds.begin(), m_bounds.end(), latency_in_ms);
+    size_t index = (itr == m_bounds.end()) ? m_bounds.size() - 1 : itr - m_bounds.begin();
+    m_counts[index] += 1;
+    m_total += 1;
+
+    if (m_total > m_window_size) {
+        m_total = 0;
+        for (size_t i = 0; i < m_counts.size(); ++i) {
+            m_counts[i] /= 2;
+            m_total += m_counts[i];
+        }
+    }
+}
+
+uint64_t LatencyHistogram::GetPercentile(double percentile) const {
+    if (m_total <= 0) {
+        return 0;
+    }
+
+    double target = m_total * percentile;
+    double sum = 0;
+    for (size_t i = 0; i < m_counts.size(); ++i) {
+        sum += m_counts[i];
+        if (sum >= target) {
+            return m_bounds[i];
+        }
+    }
+    return m_bounds.back();
+}
+
+uint64_t LatencyHistogram::GetCount() const {
+    return static_cast<uint64_t>(m_total);
+}
+
+HedgePolicy::HedgePolicy()
+    : m_is_enable(false), m_percentile(kDefaultHedgePercentile),
+      m_min_delay_in_ms(kDefaultHedgeMinDelayInms),
+      m_max_delay_in_ms(kDefaultHedgeMaxDelayInms),
+      m_budget_ratio(kDefaultHedgeBudgetRatio), m_state(new State()) {
+}
+
+uint64_t HedgePolicy::GetHedgeDelayInms(const std::string& http_method) const {
+    uint64_t delay = m_max_delay_in_ms;
+    {
+        SimpleMutexLocker locker(&m_state->m_mutex);
+        const LatencyHistogram& histogram = (http_method == "HEAD")
+            ? m_state->m_head_histogram : m_state->m_get_histogram;
+        if (histogram.GetCount() >= kHedgeMinSamples) {
+            delay = histogram.GetPercentile(m_percentile);
+        }
+    }
+
+    if (delay < m_min_delay_in_ms) {
+        delay = m_min_delay_in_ms;
+    }
+    if (delay > m_max_delay_in_ms) {
+        delay = m_max_delay_in_ms;
+    }
+    return delay;
+}
+
+void HedgePolicy::RecordLatency(const std::string& http_method, uint64_t latency_in_ms) const {
+    SimpleMutexLocker locker(&m_state->m_mutex);
+    if (http_method == "HEAD") {
+        m_state->m_head_histogram.Record(latency_in_ms);
+    } else {
+        m_state->m_get_histogram.Record(latency_in_ms);
+    }
+}
+
+void HedgePolicy::OnRequest() const {
+    SimpleMutexLocker locker(&m_state->m_mutex);
+    m_state->m_budget_tokens = std::min(kHedgeBudgetCapacity,
+                                        m_state->m_budget_tokens + m_budget_ratio);
+}
+
+bool HedgePolicy::TryAcquireHedge() const {
+    SimpleMutexLocker locker(&m_state->m_mutex);
+    if (m_state->m_budget_tokens < 1.0) {
+        return false;
+    }
+    m_state->m_budget_tokens -= 1.0;
+    return true;
+}
+
+} // namespace qcloud_cos
@@ -0,0 +1,230 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: 对冲请求发送
+
+#include "util/hedged_sender.h"
+
+#include <vector>
+
+#include "boost/bind.hpp"
+#include "boost/thread/condition_variable.hpp"
+#include "boost/thread/mutex.hpp"
+#include "boost/thread/thread_time.hpp"
+
+#include "cos_sys_config.h"
+#include "util/cancel_token.h"
+#include "util/executor.h"
+#include "util/http_sender.h"
+#include "util/http_session_pool.h"
+
+namespace qcloud_cos {
+
+namespace {
+
+struct HedgeRace;
+
+// 一次尝试的结果, 由执行该尝试的线程写入
+struct HedgeAttempt {
+    HedgeAttempt() : m_http_code(-1), m_is_done(false), m_start_us(0) {}
+
+    SharedCancelToken m_cancel_token;
+    int m_http_code;
+    std::map<std::string, std::string> m_resp_headers;
+    std::string m_xml_err_str;
+    std::string m_err_msg;
+    bool m_is_done;
+    uint64_t m_start_us;
+};
+
+// 一次对冲请求的共享状态. 落败的对冲请求可能在SendRequest返回后才结束,
+// 因此请求参数都拷贝一份, 由执行器上的任务通过shared_ptr持有
+struct HedgeRace {
+    HedgeRace() : m_winner(-1), m_done_count(0), m_is_closed(false), m_resp_stream(NULL) {}
+
+    boost::mutex m_mutex;
+    boost::condition_variable m_cond;
+    int m_winner;
+    size_t m_done_count;
+    // 主请求结束后置为true, 之后不再发出对冲请求
+    bool m_is_closed;
+    std::vector<boost::shared_ptr<HedgeAttempt> > m_attempts;
+
+    HedgePolicy m_hedge_policy;
+    std::string m_http_method;
+    std::string m_url_str;
+    std::map<std::string, std::string> m_req_params;
+    HeaderList m_req_headers;
+    uint64_t m_conn_timeout_in_ms;
+    uint64_t m_recv_timeout_in_ms;
+    bool m_is_check_md5;
+    // 调用方的取消句柄, 作为各次尝试的父句柄
+    SharedCancelToken m_cancel_token;
+    // 各次尝试共享的限速器, 可以为空
+    SharedRateLimiter m_rate_limiter;
+    REQUEST_PRIORITY m_priority;
+    // 调用线程在KeepAliveScope内时, 各次尝试也复用长连接
+    bool m_is_keep_alive;
+    // 只有胜出的尝试会写入该流
+    std::ostream* m_resp_stream;
+
+    // 收到响应头时调用, 第一个调用者胜出并取消其余尝试
+    bool TryWin(size_t index) {
+        boost::mutex::scoped_lock lock(m_mutex);
+        if (m_winner != -1) {
+            return false;
+        }
+        m_winner = static_cast<int>(index);
+        for (size_t i = 0; i < m_attempts.size(); ++i) {
+            if (i != index) {
+                m_attempts[i]->m_cancel_token->Cancel();
+            }
+        }
+
+        const boost::shared_ptr<HedgeAttempt>& attempt = m_attempts[index];
+        uint64_t latency_in_ms = (HttpSender::GetTimeStampInUs() - attempt->m_start_us) / 1000;
+        m_hedge_policy.RecordLatency(m_http_method, latency_in_ms);
+        m_cond.notify_all();
+        return true;
+    }
+
+    bool IsFinished() const {
+        if (m_winner != -1) {
+            return m_attempts[m_winner]->m_is_done;
+        }
+        return m_done_count == m_attempts.size();
+    }
+};
+
+class HedgeAttemptToken : public CancelToken {
+public:
+    HedgeAttemptToken(HedgeRace* race, size_t index) : m_race(race), m_index(index) {}
+
+    virtual bool OnResponseHeader() {
+        return !IsCancelled() && m_race->TryWin(m_index);
+    }
+
+private:
+    // HedgeRace持有token, 执行尝试的线程持有HedgeRace, 这里用裸指针避免循环引用
+    HedgeRace* m_race;
+    size_t m_index;
+};
+
+void RunAttempt(boost::shared_ptr<HedgeRace> race, boost::shared_ptr<HedgeAttempt> attempt) {
+    KeepAliveScope keep_alive(race->m_is_keep_alive);
+    int http_code = HttpSender::SendRequest(race->m_http_method, race->m_url_str,
+                                            race->m_req_params, race->m_req_headers, "",
+                                            race->m_conn_timeout_in_ms,
+                                            race->m_recv_timeout_in_ms,
+                                            &attempt->m_resp_headers,
+                                            &attempt->m_xml_err_str,
+                                            *race->m_resp_stream,
+                                            &attempt->m_err_msg,
+                                            race->m_is_check_md5,
+                                            attempt->m_cancel_token.get(),
+                                            race->m_rate_limiter.get(),
+                                            race->m_priority);
+
+    boost::mutex::scoped_lock lock(race->m_mutex);
+    attempt->m_http_code = http_code;
+    attempt->m_is_done = true;
+    ++race->m_done_count;
+    race->m_cond.notify_all();
+}
+
+// 调用方已持有锁
+boost::shared_ptr<HedgeAttempt> AddAttempt(const boost::shared_ptr<HedgeRace>& race) {
+    boost::shared_ptr<HedgeAttempt> attempt(new HedgeAttempt());
+    attempt->m_cancel_token.reset(new HedgeAttemptToken(race.get(), race->m_attempts.size()));
+    attempt->m_cancel_token->SetParent(race->m_cancel_token);
+    attempt->m_start_us = HttpSender::GetTimeStampInUs();
+    race->m_attempts.push_back(attempt);
+    return attempt;
+}
+
+// 对冲延迟到期后由执行器的定时线程提交, 主请求仍未收到响应头且未结束时在当前工作线程上
+// 发出对冲请求, 否则直接返回
+void RunHedge(boost::shared_ptr<HedgeRace> race) {
+    boost::shared_ptr<HedgeAttempt> attempt;
+    {
+        boost::mutex::scoped_lock lock(race->m_mutex);
+        bool is_cancelled = race->m_cancel_token && race->m_cancel_token->IsCancelled();
+        if (race->m_is_closed || race->m_winner != -1 || race->IsFinished() || is_cancelled) {
+            return;
+        }
+        if (!race->m_hedge_policy.TryAcquireHedge()) {
+            SDK_LOG_DBG("Hedge budget exhausted, url=%s", race->m_url_str.c_str());
+            return;
+        }
+        SDK_LOG_INFO("No response after hedge delay, send hedged request, url=%s",
+                     race->m_url_str.c_str());
+        attempt = AddAttempt(race);
+    }
+    RunAttempt(race, attempt);
+}
+
+} // namespace
+
+int HedgedSender::SendRequest(const HedgePolicy& hedge_policy,
+                              const std::string& http_method,
+                              const std::string& url_str,
+                              const std::map<std::string, std::string>& req_params,
+                              const HeaderList& req_headers,
+                              uint64_t conn_timeout_in_ms,
+                              uint64_t recv_timeout_in_ms,
+                              std::map<std::string, std::string>* resp_headers,
+                              std::string* xml_err_str,
+                              std::ostream& resp_stream,
+                              std::string* err_msg,
+                              bool is_check_md5,
+                              const SharedCancelToken& cancel_token,
+                              const SharedRateLimiter& rate_limiter,
+                              REQUEST_PRIORITY priority) {
+    boost::shared_ptr<HedgeRace> race(new HedgeRace());
+    race->m_hedge_policy = hedge_policy;
+    race->m_http_method = http_method;
+    race->m_url_str = url_str;
+    race->m_req_params = req_params;
+    race->m_req_headers = req_headers;
+    race->m_conn_timeout_in_ms = conn_timeout_in_ms;
+    race->m_recv_timeout_in_ms = recv_timeout_in_ms;
+    race->m_is_check_md5 = is_check_md5;
+    race->m_cancel_token = cancel_token;
+    race->m_rate_limiter = rate_limiter;
+    race->m_priority = priority;
+    race->m_is_keep_alive = KeepAliveScope::IsActive();
+    race->m_resp_stream = &resp_stream;
+
+    hedge_policy.OnRequest();
+    uint64_t hedge_delay_in_ms = hedge_policy.GetHedgeDelayInms(http_method);
+
+    boost::shared_ptr<HedgeAttempt> primary;
+    {
+        boost::mutex::scoped_lock lock(race->m_mutex);
+        primary = AddAttempt(race);
+    }
+
+    // 1. 对冲请求在对冲延迟到期后提交到共享执行器按需发出, 等待期间不占用工作线程;
+    //    主请求在调用线程上执行
+    boost::system_time due_time = boost::get_system_time()
+        + boost::posix_time::milliseconds(hedge_delay_in_ms);
+    Executor::Instance().SubmitAt(due_time, boost::bind(&RunHedge, race));
+    RunAttempt(race, primary);
+
+    // 2. 主请求结束后不再发出对冲请求, 等待胜出的请求完成, 或所有已发出的请求都失败
+    boost::mutex::scoped_lock lock(race->m_mutex);
+    race->m_is_closed = true;
+    while (!race->IsFinished()) {
+        race->m_cond.wait(lock);
+    }
+
+    // 都未收到响应头时返回主请求的结果
+    const boost::shared_ptr<HedgeAttempt>& result
+        = race->m_attempts[race->m_winner == -1 ? 0 : race->m_winner];
+    resp_headers->insert(result->m_resp_headers.begin(), result->m_resp_headers.end());
+    *xml_err_str = result->m_xml_err_str;
+    *err_msg = result->m_err_msg;
+    return result->m_http_code;
+}
+
+} // namespace qcloud_cos
@@ -7,30 +7,244 @@
 
 #include "util/http_sender.h"
 
+#include <errno.h>
+#include <string.h>
+#include <sys/sendfile.h>
 #include <sys/time.h>
 
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 
-#include "boost/scoped_ptr.hpp"
 #include "Poco/DigestStream.h"
 #include "Poco/MD5Engine.h"
-#include "Poco/Net/Context.h"
 #include "Poco/Net/HTTPClientSession.h"
 #include "Poco/Net/HTTPRequest.h"
 #include "Poco/Net/HTTPResponse.h"
-#include "Poco/Net/HTTPSClientSession.h"
 #include "Poco/Net/NetException.h"
 #include "Poco/StreamCopier.h"
 #include "Poco/URI.h"
 
 #include "cos_config.h"
 #include "cos_sys_config.h"
-#include "util/string_util.h"
 #include "util/codec_util.h"
+#include "util/file_input_buf.h"
+#include "util/http_session_pool.h"
+#include "util/rate_limiter.h"
+#include "util/string_util.h"
 
 namespace qcloud_cos {
 
+namespace {
+
+// 请求期间把连接注册到取消句柄上, 析构时注销
+class CancelTokenSessionGuard {
+public:
+    CancelTokenSessionGuard(CancelToken* cancel_token, Poco::Net::HTTPClientSession* session)
+        : m_cancel_token(cancel_token), m_session(session), m_is_attached(false) {
+        if (m_cancel_token != NULL) {
+            m_is_attached = m_cancel_token->AttachSession(m_session);
+        }
+    }
+
+    ~CancelTokenSessionGuard() {
+        if (m_is_attached) {
+            m_cancel_token->DetachSession(m_session);
+        }
+    }
+
+    bool IsCancelled() const {
+        return m_cancel_token != NULL && (!m_is_attached || m_cancel_token->IsCancelled());
+    }
+
+private:
+    CancelToken* m_cancel_token;
+    Poco::Net::HTTPClientSession* m_session;
+    bool m_is_attached;
+};
+
+// 请求被取消导致的异常, 统一返回取消的错误信息
+void SetCancelledErrMsg(CancelToken* cancel_token, std::string* err_msg) {
+    if (cancel_token != NULL && cancel_token->IsCancelled()) {
+        *err_msg = cancel_token->GetErrMsg();
+    }
+}
+
+uint64_t ClampTimeoutInms(CancelToken* cancel_token, uint64_t timeout_in_ms) {
+    return cancel_token != NULL ? cancel_token->ClampTimeoutInms(timeout_in_ms) : timeout_in_ms;
+}
+
+const std::streamsize kCopyBufferSize = 8192;
+
+// 拷贝请求体或响应体. 有取消句柄或限速器时分块拷贝, 每块之前检查是否已取消,
+// 并按截止时间的剩余时间收紧收发超时, 使慢速传输也能在截止时间附近结束;
+// 每块之后向限速器申请令牌, 超出速率时等待. tee不为NULL时同时写入tee, 用于边拷贝边计算MD5
+std::streamsize CopyStream(std::istream& in, std::ostream& out,
+                           CancelToken* cancel_token,
+                           Poco::Net::HTTPClientSession* session,
+                           uint64_t timeout_in_ms,
+                           RateLimiter* rate_limiter = NULL,
+                           std::ostream* tee = NULL) {
+    if (cancel_token == NULL && rate_limiter == NULL && tee == NULL) {
+        return Poco::StreamCopier::copyStream(in, out);
+    }
+
+    bool has_deadline = cancel_token != NULL && cancel_token->GetDeadlineInms() != 0;
+    char buf[kCopyBufferSize];
+    std::streamsize len = 0;
+    while (cancel_token == NULL || !cancel_token->IsCancelled()) {
+        if (has_deadline) {
+            Poco::Timespan timeout(0, cancel_token->ClampTimeoutInms(timeout_in_ms) * 1000);
+            session->socket().setSendTimeout(timeout);
+            session->socket().setReceiveTimeout(timeout);
+        }
+        in.read(buf, kCopyBufferSize);
+        std::streamsize n = in.gcount();
+        if (n <= 0) {
+            break;
+        }
+        out.write(buf, n);
+        if (tee != NULL) {
+            tee->write(buf, n);
+        }
+        len += n;
+        if (!in || !out) {
+            break;
+        }
+        if (rate_limiter != NULL && !rate_limiter->Acquire(n, cancel_token)) {
+            break;
+        }
+    }
+    return len;
+}
+
+// 每次sendfile发送的最大字节数, 分块发送以便检查取消和截止时间
+const size_t kSendFileChunkSize = 4 * 1024 * 1024;
+
+// 用sendfile把文件数据直接从页缓存发送到socket, 不经过用户态缓冲区.
+// 请求头在sendRequest返回前已经写入socket, 请求体流中没有缓冲的数据
+std::streamsize SendFile(FileInputBuf* file_buf, CancelToken* cancel_token,
+                         Poco::Net::HTTPClientSession* session, uint64_t timeout_in_ms,
+                         RateLimiter* rate_limiter) {
+    int sock_fd = session->socket().impl()->sockfd();
+    // 限速时按限速器的建议块大小发送, 避免一次发送大块数据后长时间停顿
+    size_t chunk_size = rate_limiter != NULL ? rate_limiter->GetChunkSize() : kSendFileChunkSize;
+    chunk_size = std::min(chunk_size, kSendFileChunkSize);
+    std::streamsize len = 0;
+    while (file_buf->GetRemainBytes() > 0) {
+        if (cancel_token != NULL) {
+            if (cancel_token->IsCancelled()) {
+                break;
+            }
+            if (cancel_token->GetDeadlineInms() != 0) {
+                Poco::Timespan timeout(0, cancel_token->ClampTimeoutInms(timeout_in_ms) * 1000);
+                session->socket().setSendTimeout(timeout);
+            }
+        }
+        off_t offset = static_cast<off_t>(file_buf->GetFileOffset());
+        size_t count = static_cast<size_t>(
+            std::min<uint64_t>(file_buf->GetRemainBytes(), chunk_size));
+        ssize_t n = ::sendfile(sock_fd, file_buf->GetFd(), &offset, count);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                throw Poco::TimeoutException("sendfile timeout");
+            }
+            throw Poco::Net::NetException(std::string("sendfile fail, ") + strerror(errno));
+        }
+        if (n == 0) {
+            // 文件在上传过程中被截断
+            throw Poco::Net::NetException("sendfile fail, unexpected end of file");
+        }
+        file_buf->Consume(n);
+        len += n;
+        if (rate_limiter != NULL && !rate_limiter->Acquire(n, cancel_token)) {
+            break;
+        }
+    }
+    return len;
+}
+
+// 发送请求体. 请求体是本地文件且连接不是TLS时使用sendfile, 否则经用户态缓冲区拷贝
+std::streamsize SendBody(std::istream& is, std::ostream& os, CancelToken* cancel_token,
+                         Poco::Net::HTTPClientSession* session, uint64_t timeout_in_ms,
+                         RateLimiter* rate_limiter) {
+    FileInputBuf* file_buf = dynamic_cast<FileInputBuf*>(is.rdbuf());
+    if (file_buf != NULL && file_buf->IsOpen() && !session->secure()) {
+        return SendFile(file_buf, cancel_token, session, timeout_in_ms, rate_limiter);
+    }
+    return CopyStream(is, os, cancel_token, session, timeout_in_ms, rate_limiter);
+}
+
+// 等待100 Continue的最长时间, 超时后视为服务端或代理不支持, 直接发送请求体
+const uint64_t kExpectContinueWaitInms = 1000;
+
+bool IsExpectContinue(const HeaderList& req_headers) {
+    std::string value;
+    if (!req_headers.Find("Expect", &value)) {
+        return false;
+    }
+    value = StringUtil::StringToLower(value);
+    return StringUtil::Trim(value) == "100-continue";
+}
+
+// 请求头带有Expect: 100-continue时, 在发送请求体前等待服务端确认.
+// 收到100 Continue或等待超时时返回true; 收到最终响应(如签名错误、无权限)时返回false,
+// 此时不再发送请求体, 响应头已读入res
+bool WaitContinue(Poco::Net::HTTPClientSession* session, Poco::Net::HTTPResponse* res,
+                  CancelToken* cancel_token, uint64_t timeout_in_ms) {
+    uint64_t wait_in_ms = ClampTimeoutInms(cancel_token,
+                                           std::min(kExpectContinueWaitInms, timeout_in_ms));
+    if (!session->socket().poll(Poco::Timespan(0, wait_in_ms * 1000),
+                                Poco::Net::Socket::SELECT_READ)) {
+        SDK_LOG_DBG("Wait 100-continue timeout, send body directly");
+        return true;
+    }
+    return session->peekResponse(*res);
+}
+
+// 拼接编码后的path和query字符串, 直接追加到结果中, 不为每个参数生成临时字符串
+std::string BuildPathAndQuery(const std::string& path,
+                              const std::map<std::string, std::string>& req_params) {
+    std::string path_and_query_str = CodecUtil::EncodeKey(path);
+    for (std::map<std::string, std::string>::const_iterator c_itr = req_params.begin();
+         c_itr != req_params.end(); ++c_itr) {
+        path_and_query_str.append(c_itr == req_params.begin() ? "?" : "&");
+        path_and_query_str.append(CodecUtil::UrlEncode(c_itr->first));
+        if (!c_itr->second.empty()) {
+            path_and_query_str.append("=");
+            path_and_query_str.append(CodecUtil::UrlEncode(c_itr->second));
+        }
+    }
+    return path_and_query_str;
+}
+
+// 发送请求头, 新建连接失败时把连接的地址报告给域名解析缓存
+std::ostream& SendRequestHeader(PooledSession* session, Poco::Net::HTTPRequest* req) {
+    try {
+        return (*session)->sendRequest(*req);
+    } catch (const Poco::Exception&) {
+        session->ReportConnectFail();
+        throw;
+    }
+}
+
+// 连接池中的空闲连接可能已被服务端关闭, 在其上发送请求会在收到任何响应数据前
+// 遇到对端关闭或连接重置, 此时服务端没有处理该请求, 可以在新连接上重新发送
+bool IsStaleConnectionError(const PooledSession& session, const Poco::Exception& ex) {
+    if (!session.IsReused()) {
+        return false;
+    }
+    return dynamic_cast<const Poco::Net::NoMessageException*>(&ex) != NULL
+        || dynamic_cast<const Poco::Net::ConnectionResetException*>(&ex) != NULL
+        || dynamic_cast<const Poco::Net::ConnectionAbortedException*>(&ex) != NULL
+        || ex.code() == EPIPE;
+}
+
+} // namespace
+
 int HttpSender::SendRequest(const std::string& http_method,
                             const std::string& url_str,
                             const std::map<std::string, std::string>& req_params,
@@ -41,7 +255,10 @@ int HttpSender::SendRequest(const std::string& http_method,
                             std::map<std::string, std::string>* resp_headers,
                             std::string* resp_body,
                             std::string* err_msg,
-                            bool is_check_md5) {
+                            bool is_check_md5,
+                            CancelToken* cancel_token,
+                            RateLimiter* rate_limiter,
+                            REQUEST_PRIORITY priority) {
     std::istringstream is(req_body);
     std::ostringstream oss;
     int ret = SendRequest(http_method,
@@ -54,7 +271,10 @@ int HttpSender::SendRequest(const std::string& http_method,
                           resp_headers,
                           oss,
                           err_msg,
-                          is_check_md5);
+                          is_check_md5,
+                          cancel_token,
+                          rate_limiter,
+                          priority);
     *resp_body = oss.str();
     return ret;
 }
@@ -69,7 +289,10 @@ int HttpSender::SendRequest(const std::string& http_method,
                             std::map<std::string, std::string>* resp_headers,
                             std::ostream& resp_stream,
                             std::string* err_msg,
-                            bool is_check_md5) {
+                            bool is_check_md5,
+                            CancelToken* cancel_token,
+                            RateLimiter* rate_limiter,
+                            REQUEST_PRIORITY priority) {
     std::istringstream is(req_body);
     int ret = SendRequest(http_method,
                           url_str,
@@ -81,7 +304,10 @@ int HttpSender::SendRequest(const std::string& http_method,
                           resp_headers,
                           resp_stream,
                           err_msg,
-                          is_check_md5);
+                          is_check_md5,
+                          cancel_token,
+                          rate_limiter,
+                          priority);
     return ret;
 }
 
@@ -95,7 +321,10 @@ int HttpSender::SendRequest(const std::string& http_method,
                             std::map<std::string, std::string>* resp_headers,
                             std::string* resp_body,
                             std::string* err_msg,
-                            bool is_check_md5) {
+                            bool is_check_md5,
+                            CancelToken* cancel_token,
+                            RateLimiter* rate_limiter,
+                            REQUEST_PRIORITY priority) {
     std::ostringstream oss;
     int ret = SendRequest(http_method,
                           url_str,
@@ -107,7 +336,10 @@ int HttpSender::SendRequest(const std::string& http_method,
                           resp_headers,
                           oss,
                           err_msg,
-                          is_check_md5);
+                          is_check_md5,
+                          cancel_token,
+                          rate_limiter,
+                          priority);
     *resp_body = oss.str();
     return ret;
 }
@@ -122,51 +354,62 @@ int HttpSender::SendRequest(const std::string& http_method,
                             std::map<std::string, std::string>* resp_headers,
                             std::ostream& resp_stream,
                             std::string* err_msg,
-                            bool is_check_md5) {
+                            bool is_check_md5,
+                            CancelToken* cancel_token,
+                            RateLimiter* rate_limiter,
+                            REQUEST_PRIORITY priority) {
+    HeaderList headers;
+    headers.AddAll(req_headers);
+    return SendRequest(http_method, url_str, req_params, headers, is, conn_timeout_in_ms,
+                       recv_timeout_in_ms, resp_headers, resp_stream, err_msg, is_check_md5,
+                       cancel_token, rate_limiter, priority);
+}
+
+int HttpSender::SendRequest(const std::string& http_method,
+                            const std::string& url_str,
+                            const std::map<std::string, std::string>& req_params,
+                            const HeaderList& req_headers,
+                            std::istream& is,
+                            uint64_t conn_timeout_in_ms,
+                            uint64_t recv_timeout_in_ms,
+                            std::map<std::string, std::string>* resp_headers,
+                            std::ostream& resp_stream,
+                            std::string* err_msg,
+                            bool is_check_md5,
+                            CancelToken* cancel_token,
+                            RateLimiter* rate_limiter,
+                            REQUEST_PRIORITY priority) {
+    RequestSlot slot(priority, cancel_token);
+    if (!slot.IsAcquired()) {
+        *err_msg = cancel_token->GetErrMsg();
+        return -1;
+    }
+
     Poco::Net::HTTPResponse res;
     try {
         Poco::URI url(url_str);
-        boost::scoped_ptr<Poco::Net::HTTPClientSession> session;
-        if (StringUtil::StringStartsWithIgnoreCase(url_str, "https")) {
-            Poco::Net::Context::Ptr context = new Poco::Net::Context(Poco::Net::Context::CLIENT_USE,
-                                                     "", "", "", Poco::Net::Context::VERIFY_RELAXED,
-                                                     9, true, "ALL:!ADH:!LOW:!EXP:!MD5:@STRENGTH");
-            session.reset(new Poco::Net::HTTPSClientSession(url.getHost(), url.getPort(), context));
-        } else {
-            session.reset(new Poco::Net::HTTPClientSession(url.getHost(), url.getPort()));
+        PooledSession session(url_str);
+
+        uint64_t conn_timeout = ClampTimeoutInms(cancel_token, conn_timeout_in_ms);
+        session->setTimeout(Poco::Timespan(0, conn_timeout * 1000));
+        CancelTokenSessionGuard cancel_guard(cancel_token, session.get());
+        if (cancel_guard.IsCancelled()) {
+            *err_msg = cancel_token->GetErrMsg();
+            return -1;
         }
 
-        session->setTimeout(Poco::Timespan(0, conn_timeout_in_ms * 1000));
-
         // 1. 拼接path_query字符串
         std::string path = url.getPath();
         if (path.empty()) {
             path += "/";
         }
 
-        std::string query_str;
-        for (std::map<std::string, std::string>::const_iterator c_itr = req_params.begin();
-                c_itr != req_params.end(); ++c_itr) {
-            std::string part;
-            if (c_itr->second.empty()) {
-                part = CodecUtil::UrlEncode(c_itr->first) + "&";
-            } else {
-                part = CodecUtil::UrlEncode(c_itr->first) + "=" + CodecUtil::UrlEncode(c_itr->second) + "&";
-            }
-            query_str += part;
-        }
-
-        if (!query_str.empty()) {
-            query_str = "?" + query_str.substr(0, query_str.size() - 1);
-        }
-        std::string path_and_query_str = CodecUtil::EncodeKey(path) + query_str;
-        //std::string path_and_query_str = CodecUtil::EncodeKey(path) + CodecUtil::UrlEncode("?response-content-type") + "= " + CodecUtil::UrlEncode("abcd\r\rnef");
+        std::string path_and_query_str = BuildPathAndQuery(path, req_params);
 
         // 2. 创建http request, 并填充头部
         Poco::Net::HTTPRequest req(http_method, path_and_query_str, Poco::Net::HTTPMessage::HTTP_1_1);
-        for (std::map<std::string, std::string>::const_iterator c_itr = req_headers.begin();
-                c_itr != req_headers.end(); ++c_itr) {
-            req.add(c_itr->first, (c_itr->second).c_str());
+        for (size_t i = 0; i < req_headers.Size(); ++i) {
+            req.add(req_headers.GetName(i), req_headers.GetValue(i));
         }
 
         // 3. 计算长度
@@ -181,14 +424,56 @@ int HttpSender::SendRequest(const std::string& http_method,
         SDK_LOG_DBG("request=[%s]", debug_os.str().c_str());
 #endif
 
-        // 4. 发送请求
-        std::ostream& os = session->sendRequest(req);
-        Poco::StreamCopier::copyStream(is, os);
+        // 4. 发送请求并接收响应头. 复用的连接已被服务端关闭时在新连接上重新发送一次
+        bool is_body_sent = true;
+        bool is_reconnected = false;
+        std::istream* recv_stream_ptr = NULL;
+        while (recv_stream_ptr == NULL) {
+            try {
+                std::ostream& os = SendRequestHeader(&session, &req);
+                is_body_sent = true;
+                if (IsExpectContinue(req_headers) && req.getContentLength() > 0) {
+                    is_body_sent = WaitContinue(session.get(), &res, cancel_token,
+                                                conn_timeout_in_ms);
+                }
+                if (is_body_sent) {
+                    SendBody(is, os, cancel_token, session.get(), conn_timeout_in_ms,
+                             rate_limiter);
+                } else {
+                    SDK_LOG_INFO("Server responded before body sent, status=%d, "
+                                 "skip sending %lld bytes", res.getStatus(),
+                                 static_cast<long long>(req.getContentLength()));
+                }
+
+                // 连接建立前取消时shutdown无效, 这里再检查一次
+                if (cancel_guard.IsCancelled()) {
+                    *err_msg = cancel_token->GetErrMsg();
+                    return -1;
+                }
+                Poco::Net::StreamSocket& ss = session->socket();
+                uint64_t recv_timeout = ClampTimeoutInms(cancel_token, recv_timeout_in_ms);
+                ss.setReceiveTimeout(Poco::Timespan(0, recv_timeout * 1000));
+                recv_stream_ptr = &session->receiveResponse(res);
+            } catch (const Poco::Exception& ex) {
+                if (is_reconnected || cancel_guard.IsCancelled()
+                    || !IsStaleConnectionError(session, ex)) {
+                    throw;
+                }
+                SDK_LOG_WARN("Reused connection closed by server, resend on a new connection, "
+                             "exception=%s", ex.displayText().c_str());
+                session.Reconnect();
+                is_reconnected = true;
+                is.clear();
+                is.seekg(pos);
+            }
+        }
 
         // 5. 接收返回
-        Poco::Net::StreamSocket& ss = session->socket();
-        ss.setReceiveTimeout(Poco::Timespan(0, recv_timeout_in_ms * 1000));
-        std::istream& recv_stream = session->receiveResponse(res);
+        std::istream& recv_stream = *recv_stream_ptr;
+        if (cancel_token != NULL && !cancel_token->OnResponseHeader()) {
+            *err_msg = cancel_token->GetErrMsg();
+            return -1;
+        }
 
         // 6. 处理返回
         int ret = res.getStatus();
@@ -201,18 +486,21 @@ int HttpSender::SendRequest(const std::string& http_method,
             etag = StringUtil::Trim(etag_itr->second, "\"");
         }
 
-        if (is_check_md5 && !StringUtil::IsV4ETag(etag)
-            && !StringUtil::IsMultipartUploadETag(etag)) {
+        // 响应流不可回退, 拷贝响应体的同时计算MD5
+        bool is_md5_checked = is_check_md5 && !StringUtil::IsV4ETag(etag)
+            && !StringUtil::IsMultipartUploadETag(etag);
+        Poco::MD5Engine md5;
+        Poco::DigestOutputStream dos(md5);
+        CopyStream(recv_stream, resp_stream, cancel_token, session.get(), recv_timeout_in_ms,
+                   rate_limiter, is_md5_checked ? &dos : NULL);
+        if (cancel_guard.IsCancelled()) {
+            *err_msg = cancel_token->GetErrMsg();
+            return -1;
+        }
+        if (is_md5_checked) {
             SDK_LOG_DBG("Check Response Md5");
-            Poco::MD5Engine md5;
-            Poco::DigestOutputStream dos(md5);
-            std::streampos pos = recv_stream.tellg();
-            Poco::StreamCopier::copyStream(recv_stream, dos);
-            recv_stream.clear();
-            recv_stream.seekg(pos);
             dos.close();
             std::string md5_str = Poco::DigestEngine::digestToHex(md5.digest());
-
             if (etag != md5_str) {
                 *err_msg = "Md5 of response body is not equal to the etag in the header."
                     " Body Md5= " + md5_str + ", etag=" + etag;
@@ -220,8 +508,10 @@ int HttpSender::SendRequest(const std::string& http_method,
                 ret = -1;
             }
         }
-
-        Poco::StreamCopier::copyStream(recv_stream, resp_stream);
+        // 响应体已读完, 连接可以复用. 未发送请求体时服务端的读取状态不确定, 关闭连接
+        if (ret != -1 && is_body_sent && res.getKeepAlive() && recv_stream.eof()) {
+            session.MarkReusable();
+        }
 #ifdef __COS_DEBUG__
         SDK_LOG_DBG("response header :\n");
         for (std::map<std::string, std::string>::const_iterator itr = resp_headers->begin();
@@ -235,14 +525,17 @@ int HttpSender::SendRequest(const std::string& http_method,
     } catch (Poco::Net::NetException& ex){
         SDK_LOG_ERR("Net Exception:%s", ex.displayText().c_str());
         *err_msg = "Net Exception:" + ex.displayText();
+        SetCancelledErrMsg(cancel_token, err_msg);
         return -1;
     } catch (Poco::TimeoutException& ex) {
         SDK_LOG_ERR("TimeoutException:%s", ex.displayText().c_str());
         *err_msg = "TimeoutException:" + ex.displayText();
+        SetCancelledErrMsg(cancel_token, err_msg);
         return -1;
     } catch (const std::exception &ex) {
         SDK_LOG_ERR("Exception:%s, errno=%d", std::string(ex.what()).c_str(), errno);
         *err_msg = "Exception:" + std::string(ex.what());
+        SetCancelledErrMsg(cancel_token, err_msg);
         return -1;
     }
 
@@ -260,20 +553,49 @@ int HttpSender::SendRequest(const std::string& http_method,
                             std::string* xml_err_str,
                             std::ostream& resp_stream,
                             std::string* err_msg,
-                            bool is_check_md5) {
+                            bool is_check_md5,
+                            CancelToken* cancel_token,
+                            RateLimiter* rate_limiter,
+                            REQUEST_PRIORITY priority) {
+    HeaderList headers;
+    headers.AddAll(req_headers);
+    return SendRequest(http_method, url_str, req_params, headers, req_body, conn_timeout_in_ms,
+                       recv_timeout_in_ms, resp_headers, xml_err_str, resp_stream, err_msg,
+                       is_check_md5, cancel_token, rate_limiter, priority);
+}
+
+int HttpSender::SendRequest(const std::string& http_method,
+                            const std::string& url_str,
+                            const std::map<std::string, std::string>& req_params,
+                            const HeaderList& req_headers,
+                            const std::string& req_body,
+                            uint64_t conn_timeout_in_ms,
+                            uint64_t recv_timeout_in_ms,
+                            std::map<std::string, std::string>* resp_headers,
+                            std::string* xml_err_str,
+                            std::ostream& resp_stream,
+                            std::string* err_msg,
+                            bool is_check_md5,
+                            CancelToken* cancel_token,
+                            RateLimiter* rate_limiter,
+                            REQUEST_PRIORITY priority) {
+    RequestSlot slot(priority, cancel_token);
+    if (!slot.IsAcquired()) {
+        *err_msg = cancel_token->GetErrMsg();
+        return -1;
+    }
+
     Poco::Net::HTTPResponse res;
     try {
         Poco::URI url(url_str);
-        boost::scoped_ptr<Poco::Net::HTTPClientSession> session;
-        if (StringUtil::StringStartsWithIgnoreCase(url_str, "https")) {
-            Poco::Net::Context::Ptr context = new Poco::Net::Context(Poco::Net::Context::CLIENT_USE,
-                                                     "", "", "", Poco::Net::Context::VERIFY_RELAXED,
-                                                     9, true, "ALL:!ADH:!LOW:!EXP:!MD5:@STRENGTH");
-            session.reset(new Poco::Net::HTTPSClientSession(url.getHost(), url.getPort(), context));
-        } else {
-            session.reset(new Poco::Net::HTTPClientSession(url.getHost(), url.getPort()));
+        PooledSession session(url_str);
+        uint64_t conn_timeout = ClampTimeoutInms(cancel_token, conn_timeout_in_ms);
+        session->setTimeout(Poco::Timespan(0, conn_timeout * 1000));
+        CancelTokenSessionGuard cancel_guard(cancel_token, session.get());
+        if (cancel_guard.IsCancelled()) {
+            *err_msg = cancel_token->GetErrMsg();
+            return -1;
         }
-        session->setTimeout(Poco::Timespan(0, conn_timeout_in_ms * 1000));
 
         // 1. 拼接path_query字符串
         std::string path = url.getPath();
@@ -281,30 +603,12 @@ int HttpSender::SendRequest(const std::string& http_method,
             path += "/";
         }
 
-        std::string query_str;
-        for (std::map<std::string, std::string>::const_iterator c_itr = req_params.begin();
-                c_itr != req_params.end(); ++c_itr) {
-            std::string part;
-            if (c_itr->second.empty()) {
-                part = CodecUtil::UrlEncode(c_itr->first) + "&";
-            } else {
-                part = CodecUtil::UrlEncode(c_itr->first) + "=" + CodecUtil::UrlEncode(c_itr->second) + "&";
-            }
-            query_str += part;
-        }
-
-        if (!query_str.empty()) {
-            query_str = "?" + query_str.substr(0, query_str.size() - 1);
-        }
-        // std::string path_and_query_str = CodecUtil::EncodeKey(path) + CodecUtil::UrlEncode(query_str);
-        std::string path_and_query_str = CodecUtil::EncodeKey(path) + query_str;
-        //std::string path_and_query_str = CodecUtil::EncodeKey(path) + "response-content-type=abcd%0A%0Def";
+        std::string path_and_query_str = BuildPathAndQuery(path, req_params);
 
         // 2. 创建http request, 并填充头部
         Poco::Net::HTTPRequest req(http_method, path_and_query_str, Poco::Net::HTTPMessage::HTTP_1_1);
-        for (std::map<std::string, std::string>::const_iterator c_itr = req_headers.begin();
-                c_itr != req_headers.end(); ++c_itr) {
-            req.add(c_itr->first, (c_itr->second).c_str());
+        for (size_t i = 0; i < req_headers.Size(); ++i) {
+            req.add(req_headers.GetName(i), req_headers.GetValue(i));
         }
         req.add("Content-Length", StringUtil::Uint64ToString(req_body.size()));
 
@@ -314,21 +618,51 @@ int HttpSender::SendRequest(const std::string& http_method,
         SDK_LOG_DBG("request=[%s]", debug_os.str().c_str());
 #endif
 
-        // 3. 发送请求
-        std::ostream& os = session->sendRequest(req);
-        if (!req_body.empty()) {
-            os << req_body;
+        // 3. 发送请求并接收响应头. 复用的连接已被服务端关闭时在新连接上重新发送一次
+        bool is_reconnected = false;
+        std::istream* recv_stream_ptr = NULL;
+        while (recv_stream_ptr == NULL) {
+            try {
+                std::ostream& os = SendRequestHeader(&session, &req);
+                if (!req_body.empty()) {
+                    os << req_body;
+                }
+
+                // 连接建立前取消时shutdown无效, 这里再检查一次
+                if (cancel_guard.IsCancelled()) {
+                    *err_msg = cancel_token->GetErrMsg();
+                    return -1;
+                }
+                Poco::Net::StreamSocket& ss = session->socket();
+                uint64_t recv_timeout = ClampTimeoutInms(cancel_token, recv_timeout_in_ms);
+                ss.setReceiveTimeout(Poco::Timespan(0, recv_timeout * 1000));
+                recv_stream_ptr = &session->receiveResponse(res);
+            } catch (const Poco::Exception& ex) {
+                if (is_reconnected || cancel_guard.IsCancelled()
+                    || !IsStaleConnectionError(session, ex)) {
+                    throw;
+                }
+                SDK_LOG_WARN("Reused connection closed by server, resend on a new connection, "
+                             "exception=%s", ex.displayText().c_str());
+                session.Reconnect();
+                is_reconnected = true;
+            }
         }
 
         // 4. 接收返回
-        Poco::Net::StreamSocket& ss = session->socket();
-        ss.setReceiveTimeout(Poco::Timespan(0, recv_timeout_in_ms * 1000));
-        std::istream& recv_stream = session->receiveResponse(res);
+        std::istream& recv_stream = *recv_stream_ptr;
+        if (cancel_token != NULL && !cancel_token->OnResponseHeader()) {
+            *err_msg = cancel_token->GetErrMsg();
+            return -1;
+        }
 
         // 6. 处理返回
         int ret = res.getStatus();
         resp_headers->insert(res.begin(), res.end());
-        if (ret != 200 && ret != 206) {
+        // HEAD的响应没有响应体, Content-Length为Object的大小, 不读取也不校验长度
+        if (http_method == "HEAD") {
+            SDK_LOG_DBG("Response of HEAD has no body, status=%d", ret);
+        } else if (ret != 200 && ret != 206) {
             Poco::StreamCopier::copyToString(recv_stream, *xml_err_str);
         } else {
             std::string etag = "";
@@ -338,18 +672,22 @@ int HttpSender::SendRequest(const std::string& http_method,
                 etag = StringUtil::Trim(etag_itr->second, "\"");
             }
 
-            if (is_check_md5 && !StringUtil::IsV4ETag(etag)
-                && !StringUtil::IsMultipartUploadETag(etag)) {
+            // 响应流不可回退, 拷贝响应体的同时计算MD5
+            bool is_md5_checked = is_check_md5 && !StringUtil::IsV4ETag(etag)
+                && !StringUtil::IsMultipartUploadETag(etag);
+            Poco::MD5Engine md5;
+            Poco::DigestOutputStream dos(md5);
+            std::streamsize recv_len = CopyStream(recv_stream, resp_stream, cancel_token,
+                                                  session.get(), recv_timeout_in_ms,
+                                                  rate_limiter, is_md5_checked ? &dos : NULL);
+            if (cancel_guard.IsCancelled()) {
+                *err_msg = cancel_token->GetErrMsg();
+                return -1;
+            }
+            if (is_md5_checked) {
                 SDK_LOG_DBG("Check Response Md5");
-                Poco::MD5Engine md5;
-                Poco::DigestOutputStream dos(md5);
-                std::streampos pos = recv_stream.tellg();
-                Poco::StreamCopier::copyStream(recv_stream, dos);
-                recv_stream.clear();
-                recv_stream.seekg(pos);
                 dos.close();
                 std::string md5_str = Poco::DigestEngine::digestToHex(md5.digest());
-
                 if (etag != md5_str) {
                     *err_msg = "Md5 of response body is not equal to the etag in the header."
                         " Body Md5= " + md5_str + ", etag=" + etag;
@@ -357,8 +695,16 @@ int HttpSender::SendRequest(const std::string& http_method,
                     ret = -1;
                 }
             }
-
-            Poco::StreamCopier::copyStream(recv_stream, resp_stream);
+            // 连接中途断开时Poco不会抛出异常, 需根据Content-Length判断响应体是否完整
+            Poco::Int64 content_len = res.getContentLength64();
+            if (ret != -1 && content_len != Poco::Net::HTTPMessage::UNKNOWN_CONTENT_LENGTH
+                && static_cast<Poco::Int64>(recv_len) < content_len) {
+                *err_msg = "Net Exception:response body is truncated, expect "
+                    + StringUtil::Uint64ToString(content_len) + " bytes, but receive "
+                    + StringUtil::Uint64ToString(recv_len) + " bytes";
+                SDK_LOG_ERR("%s", err_msg->c_str());
+                ret = -1;
+            }
         }
 
 #ifdef __COS_DEBUG__
@@ -368,19 +714,25 @@ int HttpSender::SendRequest(const std::string& http_method,
             SDK_LOG_DBG("key=[%s], value=[%s]\n", itr->first.c_str(), itr->second.c_str());
         }
 #endif
+        if (ret != -1 && res.getKeepAlive()) {
+            session.MarkReusable();
+        }
         SDK_LOG_INFO("Send request over, status=%d, reason=%s", ret, res.getReason().c_str());
         return ret;
     } catch (Poco::Net::NetException& ex){
         SDK_LOG_ERR("Net Exception:%s", ex.displayText().c_str());
         *err_msg = "Net Exception:" + ex.displayText();
+        SetCancelledErrMsg(cancel_token, err_msg);
         return -1;
     } catch (Poco::TimeoutException& ex) {
         SDK_LOG_ERR("TimeoutException:%s", ex.displayText().c_str());
         *err_msg = "TimeoutException:" + ex.displayText();
+        SetCancelledErrMsg(cancel_token, err_msg);
         return -1;
     } catch (const std::exception &ex) {
         SDK_LOG_ERR("Exception:%s, errno=%d", std::string(ex.what()).c_str(), errno);
         *err_msg = "Exception:" + std::string(ex.what());
+        SetCancelledErrMsg(cancel_token, err_msg);
         return -1;
     }
 
@@ -0,0 +1,424 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: HTTP长连接池, 按scheme://host:port缓存空闲连接
+
+#include "util/http_session_pool.h"
+
+#include <errno.h>
+#include <sys/socket.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "boost/bind.hpp"
+#include "Poco/Exception.h"
+#include "Poco/Net/Context.h"
+#include "Poco/Net/HTTPSClientSession.h"
+#include "Poco/Net/SocketAddress.h"
+#include "Poco/URI.h"
+
+#include "cos_sys_config.h"
+#include "util/dns_cache.h"
+#include "util/executor.h"
+#include "util/http_sender.h"
+#include "util/string_util.h"
+
+namespace qcloud_cos {
+
+namespace {
+
+// 当前线程所在的KeepAliveScope层数
+boost::thread_specific_ptr<unsigned> s_keep_alive_depth;
+
+std::string GetPoolKey(const Poco::URI& url) {
+    return StringUtil::StringToLower(url.getScheme()) + "://" + url.getHost() + ":"
+        + StringUtil::IntToString(url.getPort());
+}
+
+// 在发送请求前建立连接, 用于预热
+class SessionConnector {
+public:
+    virtual ~SessionConnector() {}
+    virtual void Connect() = 0;
+};
+
+// Poco只在发送请求时建立连接, 通过子类调用reconnect提前完成DNS解析、TCP和TLS握手
+template <class Session>
+class ConnectableSession : public Session, public SessionConnector {
+public:
+    template <class A1>
+    explicit ConnectableSession(const A1& a1) : Session(a1) {}
+
+    template <class A1, class A2>
+    ConnectableSession(const A1& a1, const A2& a2) : Session(a1, a2) {}
+
+    template <class A1, class A2, class A3>
+    ConnectableSession(const A1& a1, const A2& a2, const A3& a3) : Session(a1, a2, a3) {}
+
+    virtual void Connect() {
+        this->reconnect();
+    }
+};
+
+void ConnectSession(const std::string& url_str, uint64_t conn_timeout_in_ms,
+                    Poco::Net::HTTPClientSession** result) {
+    Poco::Net::HTTPClientSession* session = HttpSessionPool::CreateSession(url_str);
+    try {
+        session->setTimeout(Poco::Timespan(0, conn_timeout_in_ms * 1000));
+        dynamic_cast<SessionConnector*>(session)->Connect();
+        *result = session;
+        return;
+    } catch (const Poco::Exception& ex) {
+        SDK_LOG_WARN("Warm up connection fail, url=%s, address=%s, exception=%s",
+                     url_str.c_str(), session->getHost().c_str(), ex.displayText().c_str());
+        DnsCache::Instance().ReportFailure(Poco::URI(url_str).getHost(), session->getHost());
+    }
+    delete session;
+}
+
+// 空闲连接上不应有可读数据, 可读说明服务端已关闭连接. https连接上可能有TLS层的数据(如会话票据),
+// 只以对端关闭为准
+bool IsIdleSessionAlive(Poco::Net::HTTPClientSession* session, bool is_https) {
+    if (!session->connected()) {
+        return false;
+    }
+    char c = 0;
+    ssize_t n = ::recv(session->socket().impl()->sockfd(), &c, 1, MSG_PEEK | MSG_DONTWAIT);
+    if (n == 0) {
+        return false;
+    }
+    if (n < 0) {
+        return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+    return is_https;
+}
+
+} // namespace
+
+HttpSessionPool& HttpSessionPool::Instance() {
+    static HttpSessionPool s_pool;
+    return s_pool;
+}
+
+HttpSessionPool::HttpSessionPool()
+    : m_max_idle_per_host(kDefaultMaxIdleSessionsPerHost),
+      m_keep_warm_interval_in_ms(kDefaultKeepWarmIntervalInms), m_keeper(NULL),
+      m_is_keeper_stop(false) {
+}
+
+HttpSessionPool::~HttpSessionPool() {
+    StopKeepWarm();
+    Clear();
+}
+
+Poco::Net::HTTPClientSession* HttpSessionPool::CreateSession(const std::string& url_str) {
+    Poco::URI url(url_str);
+    if (StringUtil::StringStartsWithIgnoreCase(url_str, "https")) {
+        Poco::Net::Context::Ptr context = new Poco::Net::Context(Poco::Net::Context::CLIENT_USE,
+                                                 "", "", "", Poco::Net::Context::VERIFY_RELAXED,
+                                                 9, true, "ALL:!ADH:!LOW:!EXP:!MD5:@STRENGTH");
+        return new ConnectableSession<Poco::Net::HTTPSClientSession>(url.getHost(),
+                                                                     url.getPort(), context);
+    }
+    // https需要用域名做SNI和证书校验, 只有http连接使用缓存的地址. Host头由请求显式设置
+    std::string address;
+    if (DnsCache::Instance().PickAddress(url.getHost(), &address)) {
+        return new ConnectableSession<Poco::Net::HTTPClientSession>(
+            Poco::Net::SocketAddress(address, url.getPort()));
+    }
+    return new ConnectableSession<Poco::Net::HTTPClientSession>(url.getHost(), url.getPort());
+}
+
+Poco::Net::HTTPClientSession* HttpSessionPool::Acquire(const std::string& url_str,
+                                                       std::string* key, bool* is_reused) {
+    *key = GetPoolKey(Poco::URI(url_str));
+    *is_reused = false;
+
+    uint64_t now_in_ms = HttpSender::GetTimeStampInUs() / 1000;
+    uint64_t max_idle_in_ms = static_cast<uint64_t>(CosSysConfig::GetKeepIdle()) * 1000;
+    Poco::Net::HTTPClientSession* session = NULL;
+    std::deque<IdleSession> expired;
+    {
+        SimpleMutexLocker locker(&m_mutex);
+        std::map<std::string, std::deque<IdleSession> >::iterator itr = m_idle_sessions.find(*key);
+        if (itr != m_idle_sessions.end()) {
+            std::deque<IdleSession>& idle = itr->second;
+            // 队首是最早归还的连接, 先清理空闲超时的
+            while (!idle.empty() && now_in_ms - idle.front().m_release_time_in_ms > max_idle_in_ms) {
+                expired.push_back(idle.front());
+                idle.pop_front();
+                --m_stat.m_idle;
+            }
+            // 优先使用最近归还的连接
+            if (!idle.empty()) {
+                session = idle.back().m_session;
+                idle.pop_back();
+                --m_stat.m_idle;
+                ++m_stat.m_reused;
+                *is_reused = true;
+            }
+        }
+        if (session == NULL) {
+            ++m_stat.m_created;
+        }
+    }
+
+    // 关闭连接可能阻塞, 在锁外进行
+    for (std::deque<IdleSession>::iterator itr = expired.begin(); itr != expired.end(); ++itr) {
+        delete itr->m_session;
+    }
+    if (session == NULL) {
+        session = CreateSession(url_str);
+    }
+    return session;
+}
+
+void HttpSessionPool::Release(const std::string& key, Poco::Net::HTTPClientSession* session) {
+    {
+        SimpleMutexLocker locker(&m_mutex);
+        std::deque<IdleSession>& idle = m_idle_sessions[key];
+        if (idle.size() < m_max_idle_per_host) {
+            IdleSession idle_session;
+            idle_session.m_session = session;
+            idle_session.m_release_time_in_ms = HttpSender::GetTimeStampInUs() / 1000;
+            idle.push_back(idle_session);
+            ++m_stat.m_idle;
+            return;
+        }
+    }
+    delete session;
+}
+
+unsigned HttpSessionPool::WarmUp(const std::string& url_str, unsigned n_connections,
+                                 uint64_t conn_timeout_in_ms) {
+    if (!CosSysConfig::GetKeepAlive()) {
+        SDK_LOG_WARN("Skip warm up since keep alive is disabled, url=%s", url_str.c_str());
+        return 0;
+    }
+    {
+        SimpleMutexLocker locker(&m_mutex);
+        n_connections = std::min(n_connections, m_max_idle_per_host);
+    }
+    if (n_connections == 0) {
+        return 0;
+    }
+
+    // 握手在共享执行器上并行进行
+    std::vector<Poco::Net::HTTPClientSession*> sessions(n_connections, NULL);
+    {
+        TaskGroup group(n_connections);
+        for (unsigned i = 0; i < n_connections; ++i) {
+            group.Schedule(boost::bind(&ConnectSession, url_str, conn_timeout_in_ms,
+                                       &sessions[i]));
+        }
+        group.Wait();
+    }
+
+    std::string key = GetPoolKey(Poco::URI(url_str));
+    unsigned warmed = 0;
+    for (unsigned i = 0; i < n_connections; ++i) {
+        if (sessions[i] != NULL) {
+            sessions[i]->setKeepAlive(true);
+            Release(key, sessions[i]);
+            ++warmed;
+        }
+    }
+
+    SimpleMutexLocker locker(&m_mutex);
+    m_stat.m_warmed += warmed;
+    m_stat.m_warm_fails += n_connections - warmed;
+    return warmed;
+}
+
+unsigned HttpSessionPool::CheckIdleSessions(const std::string& key) {
+    bool is_https = StringUtil::StringStartsWithIgnoreCase(key, "https");
+    uint64_t now_in_ms = HttpSender::GetTimeStampInUs() / 1000;
+    uint64_t max_idle_in_ms = static_cast<uint64_t>(CosSysConfig::GetKeepIdle()) * 1000;
+    std::vector<Poco::Net::HTTPClientSession*> closed;
+    unsigned idle_num = 0;
+    {
+        // 检查只是一次非阻塞的recv, 在锁内进行以保持空闲连接的归还顺序
+        SimpleMutexLocker locker(&m_mutex);
+        std::map<std::string, std::deque<IdleSession> >::iterator itr = m_idle_sessions.find(key);
+        if (itr == m_idle_sessions.end()) {
+            return 0;
+        }
+        std::deque<IdleSession> alive;
+        for (std::deque<IdleSession>::iterator s_itr = itr->second.begin();
+             s_itr != itr->second.end(); ++s_itr) {
+            if (now_in_ms - s_itr->m_release_time_in_ms > max_idle_in_ms) {
+                closed.push_back(s_itr->m_session);
+            } else if (!IsIdleSessionAlive(s_itr->m_session, is_https)) {
+                closed.push_back(s_itr->m_session);
+                ++m_stat.m_unhealthy;
+            } else {
+                alive.push_back(*s_itr);
+            }
+        }
+        m_stat.m_idle -= closed.size();
+        itr->second.swap(alive);
+        idle_num = itr->second.size();
+    }
+
+    for (std::vector<Poco::Net::HTTPClientSession*>::iterator itr = closed.begin();
+         itr != closed.end(); ++itr) {
+        delete *itr;
+    }
+    return idle_num;
+}
+
+void HttpSessionPool::KeepWarm(const std::string& url_str, unsigned min_idle,
+                               uint64_t conn_timeout_in_ms) {
+    if (min_idle > 0 && !CosSysConfig::GetKeepAlive()) {
+        SDK_LOG_WARN("Skip keep warm since keep alive is disabled, url=%s", url_str.c_str());
+        return;
+    }
+    std::string key = GetPoolKey(Poco::URI(url_str));
+    boost::mutex::scoped_lock lock(m_keeper_mutex);
+    if (min_idle == 0) {
+        m_keep_warm_targets.erase(key);
+        return;
+    }
+    KeepWarmTarget& target = m_keep_warm_targets[key];
+    target.m_url = url_str;
+    target.m_min_idle = min_idle;
+    target.m_conn_timeout_in_ms = conn_timeout_in_ms;
+    if (m_keeper == NULL) {
+        m_is_keeper_stop = false;
+        m_keeper = new boost::thread(boost::bind(&HttpSessionPool::KeepWarmLoop, this));
+    } else {
+        m_keeper_cond.notify_all();
+    }
+}
+
+void HttpSessionPool::SetKeepWarmIntervalInms(uint64_t interval_in_ms) {
+    boost::mutex::scoped_lock lock(m_keeper_mutex);
+    m_keep_warm_interval_in_ms = interval_in_ms;
+    m_keeper_cond.notify_all();
+}
+
+void HttpSessionPool::StopKeepWarm() {
+    boost::thread* keeper = NULL;
+    {
+        boost::mutex::scoped_lock lock(m_keeper_mutex);
+        m_keep_warm_targets.clear();
+        m_is_keeper_stop = true;
+        m_keeper_cond.notify_all();
+        keeper = m_keeper;
+        m_keeper = NULL;
+    }
+    if (keeper != NULL) {
+        keeper->join();
+        delete keeper;
+    }
+}
+
+void HttpSessionPool::KeepWarmLoop() {
+    boost::mutex::scoped_lock lock(m_keeper_mutex);
+    while (!m_is_keeper_stop) {
+        std::map<std::string, KeepWarmTarget> targets = m_keep_warm_targets;
+        lock.unlock();
+        for (std::map<std::string, KeepWarmTarget>::const_iterator itr = targets.begin();
+             itr != targets.end(); ++itr) {
+            unsigned idle_num = CheckIdleSessions(itr->first);
+            if (idle_num < itr->second.m_min_idle) {
+                WarmUp(itr->second.m_url, itr->second.m_min_idle - idle_num,
+                       itr->second.m_conn_timeout_in_ms);
+            }
+        }
+        lock.lock();
+        if (m_is_keeper_stop) {
+            break;
+        }
+        m_keeper_cond.timed_wait(lock,
+            boost::posix_time::milliseconds(m_keep_warm_interval_in_ms));
+    }
+}
+
+void HttpSessionPool::Clear() {
+    std::map<std::string, std::deque<IdleSession> > idle_sessions;
+    {
+        SimpleMutexLocker locker(&m_mutex);
+        idle_sessions.swap(m_idle_sessions);
+        m_stat.m_idle = 0;
+    }
+    for (std::map<std::string, std::deque<IdleSession> >::iterator itr = idle_sessions.begin();
+         itr != idle_sessions.end(); ++itr) {
+        for (std::deque<IdleSession>::iterator s_itr = itr->second.begin();
+             s_itr != itr->second.end(); ++s_itr) {
+            delete s_itr->m_session;
+        }
+    }
+}
+
+void HttpSessionPool::SetMaxIdlePerHost(unsigned max_idle) {
+    SimpleMutexLocker locker(&m_mutex);
+    m_max_idle_per_host = max_idle;
+}
+
+HttpSessionPoolStat HttpSessionPool::GetStat() const {
+    SimpleMutexLocker locker(&m_mutex);
+    return m_stat;
+}
+
+void HttpSessionPool::ReportStale() {
+    SimpleMutexLocker locker(&m_mutex);
+    ++m_stat.m_stale;
+}
+
+KeepAliveScope::KeepAliveScope(bool is_enable) : m_is_enable(is_enable) {
+    if (!m_is_enable) {
+        return;
+    }
+    if (s_keep_alive_depth.get() == NULL) {
+        s_keep_alive_depth.reset(new unsigned(0));
+    }
+    ++*s_keep_alive_depth;
+}
+
+KeepAliveScope::~KeepAliveScope() {
+    if (m_is_enable) {
+        --*s_keep_alive_depth;
+    }
+}
+
+bool KeepAliveScope::IsActive() {
+    return s_keep_alive_depth.get() != NULL && *s_keep_alive_depth > 0;
+}
+
+PooledSession::PooledSession(const std::string& url_str)
+    : m_session(NULL), m_host(Poco::URI(url_str).getHost()),
+      m_is_keep_alive(CosSysConfig::GetKeepAlive() || KeepAliveScope::IsActive()),
+      m_is_reused(false), m_is_reusable(false) {
+    if (m_is_keep_alive) {
+        m_session = HttpSessionPool::Instance().Acquire(url_str, &m_key, &m_is_reused);
+        m_session->setKeepAlive(true);
+        m_session->setKeepAliveTimeout(Poco::Timespan(CosSysConfig::GetKeepIdle(), 0));
+    } else {
+        m_session = HttpSessionPool::CreateSession(url_str);
+    }
+}
+
+void PooledSession::ReportConnectFail() {
+    // 复用的连接失败通常是服务端关闭了空闲连接, 与地址无关
+    if (!m_is_reused) {
+        DnsCache::Instance().ReportFailure(m_host, m_session->getHost());
+    }
+}
+
+void PooledSession::Reconnect() {
+    m_session->reset();
+    m_is_reused = false;
+    HttpSessionPool::Instance().ReportStale();
+}
+
+PooledSession::~PooledSession() {
+    if (m_is_keep_alive && m_is_reusable) {
+        HttpSessionPool::Instance().Release(m_key, m_session);
+    } else {
+        delete m_session;
+    }
+}
+
+} // namespace qcloud_cos
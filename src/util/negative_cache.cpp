@@ -0,0 +1,79 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: 记录近期确认不存在的Object, 在有效期内避免重复的HeadObject请求
+
+#include "util/negative_cache.h"
+
+#include "util/http_sender.h"
+
+namespace qcloud_cos {
+
+void NegativeCache::Add(const std::string& bucket_name, const std::string& object_name,
+                        uint64_t ttl_in_ms) {
+    if (ttl_in_ms == 0 || m_max_entries == 0) {
+        return;
+    }
+
+    std::string key = GetKey(bucket_name, object_name);
+    Entry entry;
+    entry.m_expire_time_in_ms = HttpSender::GetTimeStampInUs() / 1000 + ttl_in_ms;
+    SimpleMutexLocker locker(&m_mutex);
+    entry.m_seq = m_next_seq++;
+    m_entries[key] = entry;
+    m_insert_order.push_back(std::make_pair(key, entry.m_seq));
+    while (m_entries.size() > m_max_entries && !m_insert_order.empty()) {
+        std::map<std::string, Entry>::iterator itr = m_entries.find(m_insert_order.front().first);
+        // 同一个key重复加入时只有最后一次的记录有效
+        if (itr != m_entries.end() && itr->second.m_seq == m_insert_order.front().second) {
+            m_entries.erase(itr);
+        }
+        m_insert_order.pop_front();
+    }
+    // 失效的记录过多时压缩加入顺序队列
+    if (m_insert_order.size() > 2 * m_max_entries) {
+        std::deque<std::pair<std::string, uint64_t> > insert_order;
+        for (std::deque<std::pair<std::string, uint64_t> >::const_iterator itr
+                 = m_insert_order.begin(); itr != m_insert_order.end(); ++itr) {
+            std::map<std::string, Entry>::const_iterator e_itr = m_entries.find(itr->first);
+            if (e_itr != m_entries.end() && e_itr->second.m_seq == itr->second) {
+                insert_order.push_back(*itr);
+            }
+        }
+        m_insert_order.swap(insert_order);
+    }
+}
+
+bool NegativeCache::Contains(const std::string& bucket_name, const std::string& object_name) {
+    std::string key = GetKey(bucket_name, object_name);
+    uint64_t now_in_ms = HttpSender::GetTimeStampInUs() / 1000;
+    SimpleMutexLocker locker(&m_mutex);
+    std::map<std::string, Entry>::iterator itr = m_entries.find(key);
+    if (itr == m_entries.end()) {
+        return false;
+    }
+    if (itr->second.m_expire_time_in_ms <= now_in_ms) {
+        m_entries.erase(itr);
+        return false;
+    }
+    return true;
+}
+
+void NegativeCache::Invalidate(const std::string& bucket_name, const std::string& object_name) {
+    std::string key = GetKey(bucket_name, object_name);
+    SimpleMutexLocker locker(&m_mutex);
+    m_entries.erase(key);
+}
+
+void NegativeCache::Clear() {
+    SimpleMutexLocker locker(&m_mutex);
+    m_entries.clear();
+    m_insert_order.clear();
+}
+
+size_t NegativeCache::Size() const {
+    SimpleMutexLocker locker(&m_mutex);
+    return m_entries.size();
+}
+
+} // namespace qcloud_cos
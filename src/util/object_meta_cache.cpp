@@ -0,0 +1,147 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: 按bucket/object分片的Object元数据LRU缓存
+
+#include "util/object_meta_cache.h"
+
+#include <algorithm>
+
+#include "util/http_sender.h"
+#include "util/string_util.h"
+
+namespace qcloud_cos {
+
+namespace {
+
+uint64_t NowInms() {
+    return HttpSender::GetTimeStampInUs() / 1000;
+}
+
+// FNV-1a
+uint32_t HashKey(const std::string& key) {
+    uint32_t hash = 2166136261u;
+    for (std::string::const_iterator itr = key.begin(); itr != key.end(); ++itr) {
+        hash ^= static_cast<unsigned char>(*itr);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+} // namespace
+
+ObjectMetaCache::ObjectMetaCache(const MetaCachePolicy& policy)
+    : m_ttl_in_ms(policy.GetTtlInms()), m_shard_num(std::max(policy.GetShardNum(), 1u)) {
+    // 容量按分片均分, 每个分片至少缓存一条记录
+    m_shard_capacity = std::max<uint64_t>(policy.GetCapacity() / m_shard_num, 1);
+    m_shards.reset(new Shard[m_shard_num]);
+}
+
+ObjectMetaCache::Shard& ObjectMetaCache::GetShard(const std::string& key) {
+    return m_shards[HashKey(key) % m_shard_num];
+}
+
+META_CACHE_STATE ObjectMetaCache::Lookup(const std::string& bucket_name,
+                                         const std::string& object_name,
+                                         std::map<std::string, std::string>* headers,
+                                         std::string* etag) {
+    std::string key = GetKey(bucket_name, object_name);
+    Shard& shard = GetShard(key);
+    uint64_t now_in_ms = NowInms();
+    SimpleMutexLocker locker(&shard.m_mutex);
+    std::map<std::string, EntryList::iterator>::iterator itr = shard.m_index.find(key);
+    if (itr == shard.m_index.end()) {
+        ++shard.m_misses;
+        return META_CACHE_MISS;
+    }
+
+    EntryList::iterator entry = itr->second;
+    shard.m_lru.splice(shard.m_lru.begin(), shard.m_lru, entry);
+    *headers = entry->m_headers;
+    *etag = entry->m_etag;
+    if (entry->m_expire_time_in_ms <= now_in_ms) {
+        ++shard.m_misses;
+        return META_CACHE_STALE;
+    }
+    ++shard.m_hits;
+    return META_CACHE_FRESH;
+}
+
+void ObjectMetaCache::Put(const std::string& bucket_name, const std::string& object_name,
+                          const std::string& etag,
+                          const std::map<std::string, std::string>& headers) {
+    std::string key = GetKey(bucket_name, object_name);
+    Shard& shard = GetShard(key);
+    uint64_t expire_time = NowInms() + m_ttl_in_ms;
+    SimpleMutexLocker locker(&shard.m_mutex);
+    std::map<std::string, EntryList::iterator>::iterator itr = shard.m_index.find(key);
+    if (itr != shard.m_index.end()) {
+        shard.m_lru.splice(shard.m_lru.begin(), shard.m_lru, itr->second);
+    } else {
+        shard.m_lru.push_front(Entry());
+        shard.m_lru.front().m_key = key;
+        shard.m_index[key] = shard.m_lru.begin();
+    }
+    Entry& entry = shard.m_lru.front();
+    entry.m_etag = etag;
+    entry.m_headers = headers;
+    entry.m_expire_time_in_ms = expire_time;
+
+    while (shard.m_index.size() > m_shard_capacity) {
+        shard.m_index.erase(shard.m_lru.back().m_key);
+        shard.m_lru.pop_back();
+        ++shard.m_evictions;
+    }
+}
+
+bool ObjectMetaCache::Revalidate(const std::string& bucket_name, const std::string& object_name,
+                                 const std::string& etag,
+                                 std::map<std::string, std::string>* headers) {
+    std::string key = GetKey(bucket_name, object_name);
+    Shard& shard = GetShard(key);
+    uint64_t expire_time = NowInms() + m_ttl_in_ms;
+    SimpleMutexLocker locker(&shard.m_mutex);
+    std::map<std::string, EntryList::iterator>::iterator itr = shard.m_index.find(key);
+    if (itr == shard.m_index.end() || !StringUtil::ETagMatches(etag, itr->second->m_etag)) {
+        return false;
+    }
+    itr->second->m_expire_time_in_ms = expire_time;
+    *headers = itr->second->m_headers;
+    ++shard.m_revalidations;
+    return true;
+}
+
+void ObjectMetaCache::Invalidate(const std::string& bucket_name,
+                                 const std::string& object_name) {
+    std::string key = GetKey(bucket_name, object_name);
+    Shard& shard = GetShard(key);
+    SimpleMutexLocker locker(&shard.m_mutex);
+    std::map<std::string, EntryList::iterator>::iterator itr = shard.m_index.find(key);
+    if (itr != shard.m_index.end()) {
+        shard.m_lru.erase(itr->second);
+        shard.m_index.erase(itr);
+    }
+}
+
+void ObjectMetaCache::Clear() {
+    for (unsigned i = 0; i < m_shard_num; ++i) {
+        SimpleMutexLocker locker(&m_shards[i].m_mutex);
+        m_shards[i].m_lru.clear();
+        m_shards[i].m_index.clear();
+    }
+}
+
+ObjectMetaCacheStat ObjectMetaCache::GetStat() const {
+    ObjectMetaCacheStat stat;
+    for (unsigned i = 0; i < m_shard_num; ++i) {
+        SimpleMutexLocker locker(&m_shards[i].m_mutex);
+        stat.m_hits += m_shards[i].m_hits;
+        stat.m_misses += m_shards[i].m_misses;
+        stat.m_revalidations += m_shards[i].m_revalidations;
+        stat.m_evictions += m_shards[i].m_evictions;
+        stat.m_entries += m_shards[i].m_index.size();
+    }
+    return stat;
+}
+
+} // namespace qcloud_cos
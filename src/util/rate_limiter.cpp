@@ -0,0 +1,126 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: 客户端上传/下载带宽限速, 分为进程、CosAPI实例和请求三级
+
+#include "util/rate_limiter.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "util/http_sender.h"
+
+namespace qcloud_cos {
+
+namespace {
+
+// 等待令牌时检查取消状态的间隔, 单位:微秒
+const uint64_t kRateLimitCheckIntervalInus = 10 * 1000;
+
+} // namespace
+
+RateLimiter::RateLimiter(uint64_t rate_in_bytes_per_s)
+    : m_rate_in_bytes_per_s(rate_in_bytes_per_s), m_ready_us(0) {
+}
+
+SharedRateLimiter RateLimiter::Create(uint64_t rate_in_bytes_per_s,
+                                      const SharedRateLimiter& parent) {
+    SharedRateLimiter limiter(new RateLimiter(rate_in_bytes_per_s));
+    limiter->SetParent(parent);
+    return limiter;
+}
+
+const SharedRateLimiter& RateLimiter::GlobalUploadLimiter() {
+    // 不析构, 避免进程退出时仍有线程在使用
+    static SharedRateLimiter* limiter = new SharedRateLimiter(new RateLimiter());
+    return *limiter;
+}
+
+const SharedRateLimiter& RateLimiter::GlobalDownloadLimiter() {
+    static SharedRateLimiter* limiter = new SharedRateLimiter(new RateLimiter());
+    return *limiter;
+}
+
+void RateLimiter::SetRate(uint64_t rate_in_bytes_per_s) {
+    SimpleMutexLocker locker(&m_mutex);
+    m_rate_in_bytes_per_s = rate_in_bytes_per_s;
+}
+
+uint64_t RateLimiter::GetRate() const {
+    SimpleMutexLocker locker(&m_mutex);
+    return m_rate_in_bytes_per_s;
+}
+
+bool RateLimiter::IsLimited() const {
+    for (const RateLimiter* limiter = this; limiter != NULL; limiter = limiter->m_parent.get()) {
+        if (limiter->GetRate() != 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t RateLimiter::GetChunkSize() const {
+    uint64_t min_rate = 0;
+    for (const RateLimiter* limiter = this; limiter != NULL; limiter = limiter->m_parent.get()) {
+        uint64_t rate = limiter->GetRate();
+        if (rate != 0 && (min_rate == 0 || rate < min_rate)) {
+            min_rate = rate;
+        }
+    }
+    if (min_rate == 0) {
+        return kRateLimitMaxChunkSize;
+    }
+
+    uint64_t chunk_size = min_rate * kRateLimitBurstInms / 1000;
+    chunk_size = std::max<uint64_t>(chunk_size, kRateLimitMinChunkSize);
+    return static_cast<size_t>(std::min<uint64_t>(chunk_size, kRateLimitMaxChunkSize));
+}
+
+bool RateLimiter::Acquire(uint64_t bytes, const CancelToken* cancel_token) {
+    uint64_t wait_us = 0;
+    for (RateLimiter* limiter = this; limiter != NULL; limiter = limiter->m_parent.get()) {
+        wait_us = std::max(wait_us, limiter->Reserve(bytes));
+    }
+
+    uint64_t end_us = HttpSender::GetTimeStampInUs() + wait_us;
+    while (cancel_token == NULL || !cancel_token->IsCancelled()) {
+        uint64_t now_us = HttpSender::GetTimeStampInUs();
+        if (now_us >= end_us) {
+            return true;
+        }
+        usleep(std::min(end_us - now_us, kRateLimitCheckIntervalInus));
+    }
+    return false;
+}
+
+RateLimiterStat RateLimiter::GetStat() const {
+    SimpleMutexLocker locker(&m_mutex);
+    return m_stat;
+}
+
+uint64_t RateLimiter::Reserve(uint64_t bytes) {
+    uint64_t now_us = HttpSender::GetTimeStampInUs();
+    SimpleMutexLocker locker(&m_mutex);
+    m_stat.m_bytes += bytes;
+    if (m_rate_in_bytes_per_s == 0) {
+        return 0;
+    }
+
+    // 空闲期间不积累令牌, 最多允许突发时长内的数据立即收发
+    if (m_ready_us < now_us) {
+        m_ready_us = now_us;
+    }
+    m_ready_us += bytes * 1000000 / m_rate_in_bytes_per_s;
+
+    uint64_t burst_us = kRateLimitBurstInms * 1000;
+    if (m_ready_us <= now_us + burst_us) {
+        return 0;
+    }
+    uint64_t wait_us = m_ready_us - now_us - burst_us;
+    m_stat.m_throttled_us += wait_us;
+    return wait_us;
+}
+
+} // namespace qcloud_cos
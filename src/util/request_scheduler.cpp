@@ -0,0 +1,155 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: 按优先级调度进程内并发的HTTP请求
+
+#include "util/request_scheduler.h"
+
+#include <algorithm>
+
+#include "boost/date_time/posix_time/posix_time_types.hpp"
+
+#include "util/http_sender.h"
+
+namespace qcloud_cos {
+
+namespace {
+
+// stride调度中pass的步长基数, 每次分配许可后pass增加kStride / weight
+const uint64_t kStride = 1 << 20;
+
+// 排队时检查取消状态的间隔, 单位:毫秒
+const uint64_t kSchedulerCheckIntervalInms = 10;
+
+unsigned PriorityIndex(REQUEST_PRIORITY priority) {
+    unsigned idx = static_cast<unsigned>(priority);
+    return idx < kRequestPriorityNum ? idx : static_cast<unsigned>(PRIORITY_NORMAL);
+}
+
+} // namespace
+
+RequestScheduler::RequestScheduler()
+    : m_max_concurrency(0), m_running(0), m_global_pass(0) {
+    m_weights[PRIORITY_INTERACTIVE] = kDefaultInteractiveWeight;
+    m_weights[PRIORITY_NORMAL] = kDefaultNormalWeight;
+    m_weights[PRIORITY_BULK] = kDefaultBulkWeight;
+    for (unsigned i = 0; i < kRequestPriorityNum; ++i) {
+        m_passes[i] = 0;
+    }
+}
+
+RequestScheduler& RequestScheduler::Instance() {
+    // 不析构, 避免进程退出时仍有线程在排队
+    static RequestScheduler* scheduler = new RequestScheduler();
+    return *scheduler;
+}
+
+void RequestScheduler::SetMaxConcurrency(unsigned max_concurrency) {
+    boost::mutex::scoped_lock lock(m_mutex);
+    m_max_concurrency = max_concurrency;
+    // 上限调大或取消限制后, 立即放行排队的请求
+    GrantWaiters();
+}
+
+unsigned RequestScheduler::GetMaxConcurrency() const {
+    boost::mutex::scoped_lock lock(m_mutex);
+    return m_max_concurrency;
+}
+
+void RequestScheduler::SetWeight(REQUEST_PRIORITY priority, unsigned weight) {
+    boost::mutex::scoped_lock lock(m_mutex);
+    m_weights[PriorityIndex(priority)] = std::max(weight, 1u);
+}
+
+bool RequestScheduler::Acquire(REQUEST_PRIORITY priority, const CancelToken* cancel_token) {
+    unsigned idx = PriorityIndex(priority);
+    boost::mutex::scoped_lock lock(m_mutex);
+    if (m_max_concurrency == 0) {
+        ++m_running;
+        Admit(idx);
+        return true;
+    }
+
+    bool has_waiter = false;
+    for (unsigned i = 0; i < kRequestPriorityNum; ++i) {
+        has_waiter = has_waiter || !m_queues[i].empty();
+    }
+    if (!has_waiter && m_running < m_max_concurrency) {
+        ++m_running;
+        Admit(idx);
+        return true;
+    }
+
+    // 空闲的优先级重新排队时从当前的pass开始, 不能凭空闲期间的份额连续抢占许可
+    if (m_queues[idx].empty()) {
+        m_passes[idx] = std::max(m_passes[idx], m_global_pass);
+    }
+
+    Waiter waiter;
+    m_queues[idx].push_back(&waiter);
+    ++m_stat.m_queued[idx];
+    ++m_stat.m_waiting;
+    uint64_t start_us = HttpSender::GetTimeStampInUs();
+    while (!waiter.m_is_granted) {
+        if (cancel_token != NULL && cancel_token->IsCancelled()) {
+            std::deque<Waiter*>& queue = m_queues[idx];
+            queue.erase(std::find(queue.begin(), queue.end(), &waiter));
+            --m_stat.m_waiting;
+            return false;
+        }
+        m_cond.timed_wait(lock, boost::posix_time::milliseconds(kSchedulerCheckIntervalInms));
+    }
+    m_stat.m_wait_us[idx] += HttpSender::GetTimeStampInUs() - start_us;
+    return true;
+}
+
+void RequestScheduler::Release() {
+    boost::mutex::scoped_lock lock(m_mutex);
+    if (m_running > 0) {
+        --m_running;
+    }
+    GrantWaiters();
+}
+
+RequestSchedulerStat RequestScheduler::GetStat() const {
+    boost::mutex::scoped_lock lock(m_mutex);
+    RequestSchedulerStat stat = m_stat;
+    stat.m_running = m_running;
+    return stat;
+}
+
+void RequestScheduler::GrantWaiters() {
+    bool is_granted = false;
+    while (m_max_concurrency == 0 || m_running < m_max_concurrency) {
+        // 选择pass最小的非空队列, pass相同时优先级高者优先
+        int next = -1;
+        for (unsigned i = 0; i < kRequestPriorityNum; ++i) {
+            if (!m_queues[i].empty() && (next == -1 || m_passes[i] < m_passes[next])) {
+                next = static_cast<int>(i);
+            }
+        }
+        if (next == -1) {
+            break;
+        }
+
+        Waiter* waiter = m_queues[next].front();
+        m_queues[next].pop_front();
+        waiter->m_is_granted = true;
+        --m_stat.m_waiting;
+        ++m_running;
+        Admit(static_cast<unsigned>(next));
+        is_granted = true;
+    }
+
+    if (is_granted) {
+        m_cond.notify_all();
+    }
+}
+
+void RequestScheduler::Admit(unsigned idx) {
+    m_global_pass = std::max(m_global_pass, m_passes[idx]);
+    m_passes[idx] += kStride / m_weights[idx];
+    ++m_stat.m_admitted[idx];
+}
+
+} // namespace qcloud_cos
@@ -0,0 +1,157 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: 请求失败后的重试策略
+
+#include "util/retry_policy.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "boost/thread/tss.hpp"
+
+#include "cos_sys_config.h"
+#include "util/cancel_token.h"
+#include "util/string_util.h"
+
+namespace qcloud_cos {
+
+namespace {
+
+uint64_t NowInUs() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+// 每个线程的抖动随机数状态, 第一次使用时播种一次, 之后沿序列取值,
+// 避免同一时刻开始退避的请求得到相关的等待时间
+boost::thread_specific_ptr<unsigned> s_jitter_seed;
+unsigned s_jitter_seed_count = 0;
+
+unsigned NextJitterRand() {
+    unsigned* seed = s_jitter_seed.get();
+    if (seed == NULL) {
+        unsigned count = __sync_add_and_fetch(&s_jitter_seed_count, 1);
+        seed = new unsigned(static_cast<unsigned>(NowInUs())
+                            ^ static_cast<unsigned>(pthread_self())
+                            ^ (count * 2654435761u));
+        s_jitter_seed.reset(seed);
+    }
+    return static_cast<unsigned>(rand_r(seed));
+}
+
+} // namespace
+
+RetryBudget::RetryBudget(unsigned capacity, unsigned refill_per_sec)
+    : m_capacity(capacity), m_refill_per_sec(refill_per_sec),
+      m_tokens(capacity), m_last_refill_us(NowInUs()) {
+}
+
+bool RetryBudget::TryAcquire() {
+    SimpleMutexLocker locker(&m_mutex);
+    uint64_t now = NowInUs();
+    if (now > m_last_refill_us) {
+        m_tokens += static_cast<double>(now - m_last_refill_us) * m_refill_per_sec / 1000000;
+        if (m_tokens > m_capacity) {
+            m_tokens = m_capacity;
+        }
+    }
+    m_last_refill_us = now;
+
+    if (m_tokens < 1.0) {
+        return false;
+    }
+    m_tokens -= 1.0;
+    return true;
+}
+
+RetryPolicy::RetryPolicy()
+    : m_max_retry_times(kDefaultMaxRetryTimes),
+      m_base_delay_in_ms(kDefaultRetryBaseDelayInms),
+      m_max_delay_in_ms(kDefaultRetryMaxDelayInms),
+      m_budget(new RetryBudget(kDefaultRetryBudgetCapacity, kDefaultRetryBudgetRefillPerSec)) {
+}
+
+void RetryPolicy::SetRetryBudget(unsigned capacity, unsigned refill_per_sec) {
+    if (capacity == 0) {
+        m_budget.reset();
+        return;
+    }
+    m_budget.reset(new RetryBudget(capacity, refill_per_sec));
+}
+
+RETRY_ERROR_TYPE RetryPolicy::ClassifyError(int http_status, const std::string& err_msg) {
+    if (http_status == -1) {
+        // 主动取消的请求不再重试
+        if (StringUtil::StringStartsWith(err_msg, "CancelledException")) {
+            return RETRY_ERR_NONE;
+        }
+        if (StringUtil::StringStartsWith(err_msg, "TimeoutException")) {
+            return RETRY_ERR_TIMEOUT;
+        }
+        return RETRY_ERR_NETWORK;
+    }
+
+    if (http_status == 503) {
+        return RETRY_ERR_SLOW_DOWN;
+    }
+
+    if (http_status >= 500 && http_status <= 599) {
+        return RETRY_ERR_SERVER;
+    }
+
+    return RETRY_ERR_NONE;
+}
+
+bool RetryPolicy::IsIdempotentMethod(const std::string& method) {
+    return method == "GET" || method == "HEAD" || method == "PUT"
+        || method == "DELETE" || method == "OPTIONS";
+}
+
+bool RetryPolicy::ShouldRetry(unsigned attempt, RETRY_ERROR_TYPE err_type) const {
+    if (err_type == RETRY_ERR_NONE || attempt > m_max_retry_times) {
+        return false;
+    }
+
+    if (m_budget && !m_budget->TryAcquire()) {
+        SDK_LOG_WARN("Retry budget exhausted, give up retry, attempt=%u", attempt);
+        return false;
+    }
+    return true;
+}
+
+uint64_t RetryPolicy::GetBackoffInms(unsigned attempt, RETRY_ERROR_TYPE err_type) const {
+    uint64_t ceiling = m_base_delay_in_ms;
+    // 服务端限流时退避翻倍
+    if (err_type == RETRY_ERR_SLOW_DOWN) {
+        ceiling *= 2;
+    }
+    for (unsigned i = 1; i < attempt && ceiling < m_max_delay_in_ms; ++i) {
+        ceiling *= 2;
+    }
+    if (ceiling > m_max_delay_in_ms) {
+        ceiling = m_max_delay_in_ms;
+    }
+    if (ceiling == 0) {
+        return 0;
+    }
+
+    // full jitter: 在[0, ceiling]内随机
+    return static_cast<uint64_t>(NextJitterRand()) % (ceiling + 1);
+}
+
+void RetryPolicy::Backoff(unsigned attempt, RETRY_ERROR_TYPE err_type,
+                          const CancelToken* cancel_token) const {
+    uint64_t delay = GetBackoffInms(attempt, err_type);
+    SDK_LOG_INFO("Retry after %lu ms, attempt=%u, err_type=%d", delay, attempt, err_type);
+    if (cancel_token != NULL) {
+        cancel_token->SleepInms(delay);
+    } else if (delay > 0) {
+        usleep(delay * 1000);
+    }
+}
+
+} // namespace qcloud_cos
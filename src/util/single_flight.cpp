@@ -0,0 +1,162 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: 合并同时发出的相同读请求
+
+#include "util/single_flight.h"
+
+#include "boost/date_time/posix_time/posix_time_types.hpp"
+
+#include "util/http_sender.h"
+
+namespace qcloud_cos {
+
+// 取消句柄没有唤醒等待方的回调, 等待时按该间隔检查取消状态
+static const uint64_t kCancelCheckIntervalInms = 10;
+
+bool SingleFlight::Begin(const std::string& key, SharedFlightCall* call) {
+    boost::mutex::scoped_lock lock(m_mutex);
+    std::map<std::string, SharedFlightCall>::iterator itr = m_calls.find(key);
+    if (itr != m_calls.end()) {
+        *call = itr->second;
+        return false;
+    }
+    call->reset(new SingleFlightCall());
+    m_calls[key] = *call;
+    ++m_stat.m_leaders;
+    return true;
+}
+
+void SingleFlight::End(const std::string& key, const SharedFlightCall& call) {
+    boost::mutex::scoped_lock lock(m_mutex);
+    std::map<std::string, SharedFlightCall>::iterator itr = m_calls.find(key);
+    if (itr != m_calls.end() && itr->second == call) {
+        m_calls.erase(itr);
+    }
+    call->m_is_done = true;
+    call->m_cond.notify_all();
+}
+
+void SingleFlight::Abandon(const std::string& key, const SharedFlightCall& call) {
+    boost::mutex::scoped_lock lock(m_mutex);
+    std::map<std::string, SharedFlightCall>::iterator itr = m_calls.find(key);
+    if (itr != m_calls.end() && itr->second == call) {
+        m_calls.erase(itr);
+    }
+    call->m_is_shared = false;
+    call->m_is_done = true;
+    call->m_cond.notify_all();
+}
+
+bool SingleFlight::Wait(const SharedFlightCall& call, uint64_t deadline_in_ms,
+                        const SharedCancelToken& cancel_token) {
+    boost::mutex::scoped_lock lock(m_mutex);
+    while (!call->m_is_done) {
+        if (cancel_token && cancel_token->IsCancelled()) {
+            break;
+        }
+        if (deadline_in_ms == 0 && !cancel_token) {
+            call->m_cond.wait(lock);
+            continue;
+        }
+        uint64_t wait_in_ms = kCancelCheckIntervalInms;
+        if (deadline_in_ms != 0) {
+            uint64_t now_in_ms = HttpSender::GetTimeStampInUs() / 1000;
+            if (now_in_ms >= deadline_in_ms) {
+                break;
+            }
+            if (!cancel_token || deadline_in_ms - now_in_ms < wait_in_ms) {
+                wait_in_ms = deadline_in_ms - now_in_ms;
+            }
+        }
+        call->m_cond.timed_wait(lock, boost::posix_time::milliseconds(wait_in_ms));
+    }
+    if (call->m_is_done && call->m_is_shared) {
+        ++m_stat.m_shared;
+        return true;
+    }
+    ++m_stat.m_fallbacks;
+    return false;
+}
+
+SingleFlightStat SingleFlight::GetStat() const {
+    boost::mutex::scoped_lock lock(m_mutex);
+    return m_stat;
+}
+
+TeeStreamBuf::TeeStreamBuf(std::ostream* os, uint64_t max_bytes,
+                           const boost::function<void()>& on_overflow)
+    : m_os(os), m_max_bytes(max_bytes), m_start_pos(os->tellp()), m_is_overflow(false),
+      m_has_overflowed(false), m_on_overflow(on_overflow) {
+}
+
+void TeeStreamBuf::SetOverflow() {
+    m_is_overflow = true;
+    std::string().swap(m_bytes);
+    if (!m_has_overflowed) {
+        m_has_overflowed = true;
+        if (m_on_overflow) {
+            m_on_overflow();
+        }
+    }
+}
+
+std::streamsize TeeStreamBuf::xsputn(const char* s, std::streamsize n) {
+    m_os->write(s, n);
+    if (!*m_os) {
+        return 0;
+    }
+    if (!m_is_overflow) {
+        if (m_bytes.size() + static_cast<uint64_t>(n) > m_max_bytes) {
+            SetOverflow();
+        } else {
+            m_bytes.append(s, n);
+        }
+    }
+    return n;
+}
+
+TeeStreamBuf::int_type TeeStreamBuf::overflow(int_type c) {
+    if (traits_type::eq_int_type(c, traits_type::eof())) {
+        return traits_type::not_eof(c);
+    }
+    char ch = traits_type::to_char_type(c);
+    return xsputn(&ch, 1) == 1 ? c : traits_type::eof();
+}
+
+int TeeStreamBuf::sync() {
+    m_os->flush();
+    return m_os->bad() ? -1 : 0;
+}
+
+// 只支持查询当前位置, 供下载重试前记录写入起点
+TeeStreamBuf::pos_type TeeStreamBuf::seekoff(off_type off, std::ios_base::seekdir dir,
+                                             std::ios_base::openmode which) {
+    if (off != 0 || dir != std::ios_base::cur || m_start_pos == std::streampos(-1)) {
+        return pos_type(off_type(-1));
+    }
+    return m_os->tellp();
+}
+
+TeeStreamBuf::pos_type TeeStreamBuf::seekpos(pos_type pos, std::ios_base::openmode which) {
+    if (m_start_pos == std::streampos(-1) || pos < m_start_pos) {
+        return pos_type(off_type(-1));
+    }
+    m_os->clear();
+    m_os->seekp(pos);
+    if (m_os->fail()) {
+        return pos_type(off_type(-1));
+    }
+    uint64_t len = static_cast<uint64_t>(pos - m_start_pos);
+    if (len == 0) {
+        m_is_overflow = false;
+        m_bytes.clear();
+    } else if (!m_is_overflow && len <= m_bytes.size()) {
+        m_bytes.resize(len);
+    } else {
+        SetOverflow();
+    }
+    return pos;
+}
+
+} // namespace qcloud_cos
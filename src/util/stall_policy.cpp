@@ -0,0 +1,28 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: 分块传输的低速检测策略
+
+#include "util/stall_policy.h"
+
+namespace qcloud_cos {
+
+StallPolicy::StallPolicy()
+    : m_min_rate_bytes_per_sec(0),
+      m_grace_period_in_ms(kDefaultStallGracePeriodInms),
+      m_check_interval_in_ms(kDefaultStallCheckIntervalInms) {
+}
+
+bool StallPolicy::IsStalled(const TransferProgress& progress) const {
+    if (!IsEnable() || !progress.IsStarted() || progress.IsFinished()) {
+        return false;
+    }
+
+    uint64_t elapsed_in_ms = progress.GetElapsedInms();
+    if (elapsed_in_ms < m_grace_period_in_ms || elapsed_in_ms == 0) {
+        return false;
+    }
+    return progress.GetBytes() * 1000 / elapsed_in_ms < m_min_rate_bytes_per_sec;
+}
+
+} // namespace qcloud_cos
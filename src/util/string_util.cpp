@@ -2,6 +2,7 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
 
 #include <iostream>
 #include <sstream>
@@ -199,4 +200,83 @@ bool StringUtil::IsMultipartUploadETag(const std::string& etag) {
     return false;
 }
 
+std::string StringUtil::NormalizeETag(const std::string& etag) {
+    std::string ret = etag;
+    Trim(ret);
+    if (StringStartsWith(ret, "W/")) {
+        ret.erase(0, 2);
+    }
+    return Trim(ret, "\"");
+}
+
+bool StringUtil::ETagMatches(const std::string& if_none_match, const std::string& etag) {
+    std::string expected = NormalizeETag(etag);
+    if (expected.empty()) {
+        return false;
+    }
+    std::vector<std::string> candidates;
+    SplitString(if_none_match, ',', &candidates);
+    for (std::vector<std::string>::const_iterator itr = candidates.begin();
+         itr != candidates.end(); ++itr) {
+        std::string candidate = NormalizeETag(*itr);
+        if (candidate == "*" || candidate == expected) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string StringUtil::QuoteETag(const std::string& etag) {
+    return "\"" + NormalizeETag(etag) + "\"";
+}
+
+uint64_t StringUtil::Iso8601ToTimestamp(const std::string& time_str) {
+    struct tm t;
+    memset(&t, 0, sizeof(t));
+    if (sscanf(time_str.c_str(), "%4d-%2d-%2dT%2d:%2d:%2d", &t.tm_year, &t.tm_mon,
+               &t.tm_mday, &t.tm_hour, &t.tm_min, &t.tm_sec) != 6) {
+        return 0;
+    }
+    t.tm_year -= 1900;
+    t.tm_mon -= 1;
+    time_t ts = timegm(&t);
+    return ts < 0 ? 0 : static_cast<uint64_t>(ts);
+}
+
+uint64_t StringUtil::HttpDateToTimestamp(const std::string& time_str) {
+    struct tm t;
+    memset(&t, 0, sizeof(t));
+    const char* end = strptime(time_str.c_str(), "%a, %d %b %Y %H:%M:%S", &t);
+    if (end == NULL) {
+        return 0;
+    }
+    time_t ts = timegm(&t);
+    return ts < 0 ? 0 : static_cast<uint64_t>(ts);
+}
+
+void StringUtil::AppendXmlEscaped(const std::string& str, std::string* out) {
+    for (std::string::const_iterator itr = str.begin(); itr != str.end(); ++itr) {
+        switch (*itr) {
+            case '&':
+                out->append("&amp;");
+                break;
+            case '<':
+                out->append("&lt;");
+                break;
+            case '>':
+                out->append("&gt;");
+                break;
+            case '"':
+                out->append("&quot;");
+                break;
+            case '\'':
+                out->append("&apos;");
+                break;
+            default:
+                out->push_back(*itr);
+                break;
+        }
+    }
+}
+
 } // namespace qcloud_cos
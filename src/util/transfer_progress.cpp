@@ -0,0 +1,171 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: 分块传输的进度统计
+
+#include "util/transfer_progress.h"
+
+#include <string.h>
+
+#include "util/http_sender.h"
+
+namespace qcloud_cos {
+
+TransferProgress::TransferProgress()
+    : m_is_started(false), m_is_finished(false), m_bytes(0), m_start_us(0), m_finish_us(0) {
+}
+
+void TransferProgress::Reset() {
+    SimpleMutexLocker locker(&m_mutex);
+    m_is_started = false;
+    m_is_finished = false;
+    m_bytes = 0;
+    m_start_us = 0;
+    m_finish_us = 0;
+}
+
+void TransferProgress::Start() {
+    SimpleMutexLocker locker(&m_mutex);
+    m_is_started = true;
+    m_start_us = HttpSender::GetTimeStampInUs();
+}
+
+void TransferProgress::Finish() {
+    SimpleMutexLocker locker(&m_mutex);
+    m_is_finished = true;
+    m_finish_us = HttpSender::GetTimeStampInUs();
+}
+
+void TransferProgress::AddBytes(uint64_t bytes) {
+    SimpleMutexLocker locker(&m_mutex);
+    m_bytes += bytes;
+}
+
+bool TransferProgress::IsStarted() const {
+    SimpleMutexLocker locker(&m_mutex);
+    return m_is_started;
+}
+
+bool TransferProgress::IsFinished() const {
+    SimpleMutexLocker locker(&m_mutex);
+    return m_is_finished;
+}
+
+uint64_t TransferProgress::GetBytes() const {
+    SimpleMutexLocker locker(&m_mutex);
+    return m_bytes;
+}
+
+uint64_t TransferProgress::GetElapsedInms() const {
+    SimpleMutexLocker locker(&m_mutex);
+    if (!m_is_started) {
+        return 0;
+    }
+    uint64_t end_us = m_is_finished ? m_finish_us : HttpSender::GetTimeStampInUs();
+    return end_us > m_start_us ? (end_us - m_start_us) / 1000 : 0;
+}
+
+MemoryInputBuf::MemoryInputBuf(const unsigned char* data, size_t len, TransferProgress* progress)
+    : m_begin(reinterpret_cast<char*>(const_cast<unsigned char*>(data))),
+      m_end(m_begin + len), m_progress(progress) {
+    setg(m_begin, m_begin, m_end);
+}
+
+std::streamsize MemoryInputBuf::xsgetn(char* s, std::streamsize n) {
+    std::streamsize avail = egptr() - gptr();
+    if (n > avail) {
+        n = avail;
+    }
+    if (n > 0) {
+        memcpy(s, gptr(), n);
+        gbump(static_cast<int>(n));
+        if (m_progress != NULL) {
+            m_progress->AddBytes(n);
+        }
+    }
+    return n;
+}
+
+MemoryInputBuf::int_type MemoryInputBuf::underflow() {
+    return gptr() < egptr() ? traits_type::to_int_type(*gptr()) : traits_type::eof();
+}
+
+MemoryInputBuf::int_type MemoryInputBuf::uflow() {
+    if (gptr() >= egptr()) {
+        return traits_type::eof();
+    }
+    int_type c = traits_type::to_int_type(*gptr());
+    gbump(1);
+    if (m_progress != NULL) {
+        m_progress->AddBytes(1);
+    }
+    return c;
+}
+
+MemoryInputBuf::pos_type MemoryInputBuf::seekoff(off_type off, std::ios_base::seekdir dir,
+                                                 std::ios_base::openmode which) {
+    if (!(which & std::ios_base::in)) {
+        return pos_type(off_type(-1));
+    }
+
+    char* base = gptr();
+    if (dir == std::ios_base::beg) {
+        base = m_begin;
+    } else if (dir == std::ios_base::end) {
+        base = m_end;
+    }
+    char* target = base + off;
+    if (target < m_begin || target > m_end) {
+        return pos_type(off_type(-1));
+    }
+    setg(m_begin, target, m_end);
+    return pos_type(target - m_begin);
+}
+
+MemoryInputBuf::pos_type MemoryInputBuf::seekpos(pos_type pos, std::ios_base::openmode which) {
+    return seekoff(off_type(pos), std::ios_base::beg, which);
+}
+
+MemoryOutputBuf::MemoryOutputBuf(unsigned char* data, size_t capacity, TransferProgress* progress)
+    : m_begin(reinterpret_cast<char*>(data)), m_progress(progress) {
+    setp(m_begin, m_begin + capacity);
+}
+
+size_t MemoryOutputBuf::GetSize() const {
+    return pptr() - pbase();
+}
+
+std::streamsize MemoryOutputBuf::xsputn(const char* s, std::streamsize n) {
+    std::streamsize avail = epptr() - pptr();
+    if (n > avail) {
+        n = avail;
+    }
+    if (n > 0) {
+        memcpy(pptr(), s, n);
+        pbump(static_cast<int>(n));
+        if (m_progress != NULL) {
+            m_progress->AddBytes(n);
+        }
+    }
+    return n;
+}
+
+MemoryOutputBuf::int_type MemoryOutputBuf::overflow(int_type c) {
+    // 缓冲区已满
+    return traits_type::eof();
+}
+
+MemoryOutputBuf::pos_type MemoryOutputBuf::seekoff(off_type off, std::ios_base::seekdir dir,
+                                                   std::ios_base::openmode which) {
+    // 只支持查询当前位置, 供tellp使用
+    if ((which & std::ios_base::out) && dir == std::ios_base::cur && off == 0) {
+        return pos_type(pptr() - pbase());
+    }
+    return pos_type(off_type(-1));
+}
+
+MemoryOutputBuf::pos_type MemoryOutputBuf::seekpos(pos_type pos, std::ios_base::openmode which) {
+    return pos_type(off_type(-1));
+}
+
+} // namespace qcloud_cos
@@ -0,0 +1,286 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: 增量SAX方式的XML解析器
+
+#include "util/xml_sax_parser.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace qcloud_cos {
+
+namespace {
+
+const char* const kXmlSpaces = " \t\r\n";
+
+bool StartsWith(const std::string& str, const char* prefix, size_t prefix_len) {
+    return str.size() >= prefix_len && str.compare(0, prefix_len, prefix) == 0;
+}
+
+bool EndsWith(const std::string& str, const char* suffix, size_t suffix_len) {
+    return str.size() >= suffix_len
+        && str.compare(str.size() - suffix_len, suffix_len, suffix) == 0;
+}
+
+// 把unicode码点编码为UTF-8
+bool AppendUtf8(unsigned long code_point, std::string* out) {
+    if (code_point < 0x80) {
+        out->push_back(static_cast<char>(code_point));
+    } else if (code_point < 0x800) {
+        out->push_back(static_cast<char>(0xC0 | (code_point >> 6)));
+        out->push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+    } else if (code_point < 0x10000) {
+        out->push_back(static_cast<char>(0xE0 | (code_point >> 12)));
+        out->push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+        out->push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+    } else if (code_point < 0x110000) {
+        out->push_back(static_cast<char>(0xF0 | (code_point >> 18)));
+        out->push_back(static_cast<char>(0x80 | ((code_point >> 12) & 0x3F)));
+        out->push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+        out->push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+    } else {
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+XmlSaxParser::XmlSaxParser(XmlSaxHandler* handler)
+    : m_handler(handler), m_in_tag(false), m_quote(0), m_has_root(false), m_fed_bytes(0) {
+}
+
+bool XmlSaxParser::Feed(const char* data, size_t len) {
+    if (IsError()) {
+        return false;
+    }
+    m_fed_bytes += len;
+
+    const char* p = data;
+    const char* end = data + len;
+    while (p < end) {
+        if (!m_in_tag) {
+            // 文本整段拷贝, 遇到'<'进入标签
+            const char* lt = static_cast<const char*>(memchr(p, '<', end - p));
+            if (lt == NULL) {
+                m_raw_text.append(p, end);
+                break;
+            }
+            m_raw_text.append(p, lt);
+            p = lt + 1;
+            m_in_tag = true;
+            m_quote = 0;
+            m_tag.clear();
+            continue;
+        }
+
+        for (; p < end; ++p) {
+            char c = *p;
+            if (m_quote != 0) {
+                if (c == m_quote) {
+                    m_quote = 0;
+                }
+            } else if (c == '>') {
+                break;
+            } else if ((c == '"' || c == '\'') && !m_tag.empty() && m_tag[0] != '!') {
+                // 属性值中可能出现'>'
+                m_quote = c;
+            }
+            m_tag.push_back(c);
+        }
+        if (p == end) {
+            break;
+        }
+        ++p;
+        if (!HandleTag()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool XmlSaxParser::Finish() {
+    if (IsError()) {
+        return false;
+    }
+    if (m_in_tag || !m_stack.empty() || !m_has_root) {
+        return SetError("incomplete xml document");
+    }
+    if (!m_handler->OnEndDocument()) {
+        return SetError("unexpected xml document");
+    }
+    return true;
+}
+
+void XmlSaxParser::Reset() {
+    m_in_tag = false;
+    m_quote = 0;
+    m_has_root = false;
+    m_tag.clear();
+    m_raw_text.clear();
+    m_text.clear();
+    m_stack.clear();
+    m_err_msg.clear();
+    m_fed_bytes = 0;
+    m_handler->OnReset();
+}
+
+bool XmlSaxParser::HandleTag() {
+    // 注释和CDATA中可能出现'>', 未到结尾时继续作为标签内容读取
+    if (StartsWith(m_tag, "!--", 3)) {
+        if (m_tag.size() < 5 || !EndsWith(m_tag, "--", 2)) {
+            m_tag.push_back('>');
+            return true;
+        }
+        m_in_tag = false;
+        return true;
+    }
+
+    if (StartsWith(m_tag, "![CDATA[", 8)) {
+        if (m_tag.size() < 10 || !EndsWith(m_tag, "]]", 2)) {
+            m_tag.push_back('>');
+            return true;
+        }
+        m_in_tag = false;
+        if (!DecodeText(m_raw_text, &m_text)) {
+            return SetError("invalid entity in text");
+        }
+        m_raw_text.clear();
+        m_text.append(m_tag, 8, m_tag.size() - 10);
+        return true;
+    }
+
+    m_in_tag = false;
+    if (m_tag.empty()) {
+        return SetError("empty tag");
+    }
+    // XML声明、处理指令和DOCTYPE
+    if (m_tag[0] == '?' || m_tag[0] == '!') {
+        return true;
+    }
+
+    if (!DecodeText(m_raw_text, &m_text)) {
+        return SetError("invalid entity in text");
+    }
+    m_raw_text.clear();
+
+    if (m_tag[0] == '/') {
+        size_t name_end = m_tag.find_last_not_of(kXmlSpaces);
+        std::string name = m_tag.substr(1, name_end);
+        if (m_stack.empty() || m_stack.back() != name) {
+            return SetError("mismatched end tag " + name);
+        }
+        m_handler->OnEndElement(name, m_text);
+        m_stack.pop_back();
+        m_text.clear();
+        return true;
+    }
+
+    if (m_stack.empty() && m_has_root) {
+        return SetError("multiple root elements");
+    }
+    bool is_self_closing = m_tag[m_tag.size() - 1] == '/';
+    size_t name_end = m_tag.find_first_of(" \t\r\n/");
+    std::string name = m_tag.substr(0, name_end);
+    if (name.empty()) {
+        return SetError("empty element name");
+    }
+
+    m_has_root = true;
+    m_text.clear();
+    m_handler->OnStartElement(name);
+    if (is_self_closing) {
+        m_handler->OnEndElement(name, m_text);
+    } else {
+        m_stack.push_back(name);
+    }
+    return true;
+}
+
+bool XmlSaxParser::SetError(const std::string& err_msg) {
+    m_err_msg = err_msg + ", offset=";
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%lu", static_cast<unsigned long>(m_fed_bytes));
+    m_err_msg += buf;
+    return false;
+}
+
+bool XmlSaxParser::DecodeText(const std::string& raw, std::string* out) {
+    size_t pos = 0;
+    while (pos < raw.size()) {
+        size_t amp = raw.find('&', pos);
+        if (amp == std::string::npos) {
+            out->append(raw, pos, std::string::npos);
+            break;
+        }
+        out->append(raw, pos, amp - pos);
+
+        size_t semicolon = raw.find(';', amp);
+        if (semicolon == std::string::npos) {
+            return false;
+        }
+        const char* entity = raw.c_str() + amp + 1;
+        size_t entity_len = semicolon - amp - 1;
+        if (entity_len == 3 && strncmp(entity, "amp", 3) == 0) {
+            out->push_back('&');
+        } else if (entity_len == 2 && strncmp(entity, "lt", 2) == 0) {
+            out->push_back('<');
+        } else if (entity_len == 2 && strncmp(entity, "gt", 2) == 0) {
+            out->push_back('>');
+        } else if (entity_len == 4 && strncmp(entity, "quot", 4) == 0) {
+            out->push_back('"');
+        } else if (entity_len == 4 && strncmp(entity, "apos", 4) == 0) {
+            out->push_back('\'');
+        } else if (entity_len >= 2 && entity[0] == '#') {
+            // 字符引用: &#123; 或 &#x7B;
+            bool is_hex = entity[1] == 'x' || entity[1] == 'X';
+            std::string digits(entity + (is_hex ? 2 : 1), entity + entity_len);
+            char* digits_end = NULL;
+            unsigned long code_point = strtoul(digits.c_str(), &digits_end, is_hex ? 16 : 10);
+            if (digits.empty() || *digits_end != '\0' || !AppendUtf8(code_point, out)) {
+                return false;
+            }
+        } else {
+            return false;
+        }
+        pos = semicolon + 1;
+    }
+    return true;
+}
+
+std::streamsize XmlSaxOutputBuf::xsputn(const char* s, std::streamsize n) {
+    // 格式错误时继续接收数据, 由调用方在结束后检查解析器的状态,
+    // 避免写入失败被当作网络错误重试
+    m_parser->Feed(s, static_cast<size_t>(n));
+    return n;
+}
+
+XmlSaxOutputBuf::int_type XmlSaxOutputBuf::overflow(int_type c) {
+    if (traits_type::eq_int_type(c, traits_type::eof())) {
+        return traits_type::not_eof(c);
+    }
+    char ch = traits_type::to_char_type(c);
+    m_parser->Feed(&ch, 1);
+    return c;
+}
+
+XmlSaxOutputBuf::pos_type XmlSaxOutputBuf::seekoff(off_type off, std::ios_base::seekdir dir,
+                                                   std::ios_base::openmode which) {
+    // 只支持tellp
+    if (off != 0 || dir != std::ios_base::cur || !(which & std::ios_base::out)) {
+        return pos_type(off_type(-1));
+    }
+    return pos_type(static_cast<off_type>(m_parser->GetFedBytes()));
+}
+
+XmlSaxOutputBuf::pos_type XmlSaxOutputBuf::seekpos(pos_type pos, std::ios_base::openmode which) {
+    if (pos != pos_type(0) || !(which & std::ios_base::out)) {
+        return pos_type(off_type(-1));
+    }
+    m_parser->Reset();
+    return pos;
+}
+
+} // namespace qcloud_cos
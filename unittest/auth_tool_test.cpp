@@ -46,6 +46,14 @@ TEST(AuthToolTest, NormalTest) {
     sign_result.resize(sign_result.size() - 1);
     EXPECT_EQ(expected, sign_result);
 
+    // 使用HeaderList传入头部时签名不变
+    HeaderList header_list;
+    header_list.AddAll(headers);
+    EXPECT_EQ(AuthTool::Sign(access_key, secret_key, http_method, in_uri,
+                             headers, params, 1502493430, 1502573430),
+              AuthTool::Sign(access_key, secret_key, http_method, in_uri,
+                             header_list, params, 1502493430, 1502573430));
+
     // 3. params为空
     std::string no_param_expected = "q-sign-algorithm=sha1&q-ak=access_key_test&q-sig"
                                     "n-time=1502493430;1502573430&q-key-time=15024934"
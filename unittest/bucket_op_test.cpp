@@ -169,7 +169,7 @@ TEST_F(BucketOpTest, GetBucketTest) {
         const Content& cnt_01 = contents[0];
         EXPECT_EQ("prefixA_0", cnt_01.m_key);
         EXPECT_EQ("3be03ea31c1d6ce899f419c04cbf1ea9", cnt_01.m_etag);
-        EXPECT_EQ("9", cnt_01.m_size);
+        EXPECT_EQ(9u, cnt_01.m_size);
         EXPECT_EQ("STANDARD_IA", cnt_01.m_storage_class);
     }
 }
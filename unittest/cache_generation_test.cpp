@@ -0,0 +1,28 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: 写入计数的单元测试
+
+#include "gtest/gtest.h"
+
+#include "util/cache_generation.h"
+
+namespace qcloud_cos {
+
+TEST(CacheGenerationTest, BumpTest) {
+    CacheGeneration generation;
+    uint64_t a = generation.Get("bucket", "a");
+    EXPECT_FALSE(generation.IsChanged("bucket", "a", a));
+
+    generation.Bump("bucket", "a");
+    EXPECT_TRUE(generation.IsChanged("bucket", "a", a));
+    EXPECT_EQ(a + 1, generation.Get("bucket", "a"));
+
+    // 写入开始和结束各计一次, 写入期间取得的计数在结束后也不再相同
+    uint64_t during = generation.Get("bucket", "a");
+    generation.Bump("bucket", "a");
+    EXPECT_TRUE(generation.IsChanged("bucket", "a", during));
+    EXPECT_EQ(a + 2, generation.Get("bucket", "a"));
+}
+
+} // namespace qcloud_cos
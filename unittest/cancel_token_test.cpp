@@ -0,0 +1,101 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: 取消句柄及截止时间的单元测试
+
+#include "gtest/gtest.h"
+
+#include <unistd.h>
+
+#include "boost/bind.hpp"
+#include "boost/thread/thread.hpp"
+
+#include "util/cancel_token.h"
+#include "util/http_sender.h"
+
+namespace qcloud_cos {
+
+namespace {
+
+uint64_t NowInms() {
+    return HttpSender::GetTimeStampInUs() / 1000;
+}
+
+void CancelAfter(SharedCancelToken token, unsigned delay_in_ms) {
+    usleep(delay_in_ms * 1000);
+    token->Cancel();
+}
+
+} // namespace
+
+TEST(CancelTokenTest, ParentCancelTest) {
+    SharedCancelToken parent(new CancelToken());
+    CancelToken child;
+    child.SetParent(parent);
+    EXPECT_FALSE(child.IsCancelled());
+
+    // 子句柄取消不影响父句柄
+    CancelToken sibling;
+    sibling.SetParent(parent);
+    sibling.Cancel();
+    EXPECT_TRUE(sibling.IsCancelled());
+    EXPECT_FALSE(parent->IsCancelled());
+
+    parent->Cancel();
+    EXPECT_TRUE(child.IsCancelled());
+    EXPECT_EQ(kRequestCancelledErrMsg, child.GetErrMsg());
+
+    // Reset只恢复自身状态, 父句柄仍处于取消状态
+    child.Reset();
+    EXPECT_TRUE(child.IsCancelled());
+    child.SetParent(SharedCancelToken());
+    EXPECT_FALSE(child.IsCancelled());
+}
+
+TEST(CancelTokenTest, DeadlineTest) {
+    CancelToken token;
+    EXPECT_EQ(0u, token.GetDeadlineInms());
+    EXPECT_EQ(5000u, token.ClampTimeoutInms(5000));
+
+    token.SetDeadlineInms(NowInms() + 100);
+    EXPECT_FALSE(token.IsCancelled());
+    EXPECT_LE(token.ClampTimeoutInms(5000), 100u);
+    EXPECT_EQ(10u, token.ClampTimeoutInms(10));
+
+    usleep(150 * 1000);
+    EXPECT_TRUE(token.IsCancelled());
+    EXPECT_TRUE(token.IsDeadlineExceeded());
+    EXPECT_EQ(kRequestDeadlineExceededErrMsg, token.GetErrMsg());
+    EXPECT_EQ(1u, token.ClampTimeoutInms(5000));
+}
+
+TEST(CancelTokenTest, ParentDeadlineTest) {
+    uint64_t now = NowInms();
+    SharedCancelToken parent(new CancelToken());
+    parent->SetDeadlineInms(now + 1000);
+    CancelToken child;
+    child.SetParent(parent);
+    child.SetDeadlineInms(now + 5000);
+    EXPECT_EQ(now + 1000, child.GetDeadlineInms());
+
+    child.SetDeadlineInms(now + 500);
+    EXPECT_EQ(now + 500, child.GetDeadlineInms());
+
+    parent->SetDeadlineInms(now - 1);
+    EXPECT_TRUE(child.IsCancelled());
+    EXPECT_EQ(kRequestDeadlineExceededErrMsg, child.GetErrMsg());
+}
+
+TEST(CancelTokenTest, SleepTest) {
+    SharedCancelToken token(new CancelToken());
+    EXPECT_TRUE(token->SleepInms(20));
+
+    // 休眠期间被取消时提前返回
+    boost::thread t(boost::bind(&CancelAfter, token, 50));
+    uint64_t start = NowInms();
+    EXPECT_FALSE(token->SleepInms(3000));
+    EXPECT_LT(NowInms() - start, 1000u);
+    t.join();
+}
+
+} // namespace qcloud_cos
@@ -0,0 +1,90 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: CosAPI实例级别配置的单元测试
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <string>
+
+#include "cos_config.h"
+#include "cos_sys_config.h"
+#include "util/client_settings.h"
+
+namespace qcloud_cos {
+
+TEST(ClientSettingsTest, FallbackTest) {
+    ClientSettings settings;
+    EXPECT_EQ(CosSysConfig::GetConnTimeoutInms(), settings.GetConnTimeoutInms());
+    EXPECT_EQ(CosSysConfig::GetRecvTimeoutInms(), settings.GetRecvTimeoutInms());
+    EXPECT_EQ(CosSysConfig::GetUploadPartSize(), settings.GetUploadPartSize());
+    EXPECT_EQ(CosSysConfig::GetDownThreadPoolMaxSize(), settings.GetDownThreadPoolMaxSize());
+    EXPECT_EQ(CosSysConfig::IsCheckMd5(), settings.IsCheckMd5());
+
+    // 未设置的项跟随全局配置变化
+    CosSysConfig::SetDestDomain("global.example.com");
+    EXPECT_EQ("global.example.com", settings.GetDestDomain());
+    settings.SetDestDomain("");
+    EXPECT_EQ("", settings.GetDestDomain());
+    CosSysConfig::SetDestDomain("");
+
+    settings.SetConnTimeoutInms(123);
+    settings.SetUploadPartSize(2 * 1024 * 1024);
+    settings.SetCheckMd5(!CosSysConfig::IsCheckMd5());
+    EXPECT_EQ(123u, settings.GetConnTimeoutInms());
+    EXPECT_EQ(2u * 1024 * 1024, settings.GetUploadPartSize());
+    EXPECT_NE(CosSysConfig::IsCheckMd5(), settings.IsCheckMd5());
+    EXPECT_EQ(CosSysConfig::GetRecvTimeoutInms(), settings.GetRecvTimeoutInms());
+
+    EXPECT_EQ(kDefaultExpectContinueThreshold, settings.GetExpectContinueThreshold());
+    settings.SetExpectContinueThreshold(0);
+    EXPECT_EQ(0u, settings.GetExpectContinueThreshold());
+
+    EXPECT_EQ(0u, settings.GetUploadRateLimit());
+    EXPECT_EQ(0u, settings.GetDownloadRateLimit());
+}
+
+TEST(ClientSettingsTest, InitConfTest) {
+    char path[] = "/tmp/cos_client_settings_XXXXXX";
+    int fd = mkstemp(path);
+    ASSERT_GE(fd, 0);
+    close(fd);
+    {
+        std::ofstream ofs(path);
+        ofs << "{\"ConnectTimeoutInms\": 1234, \"ReceiveTimeoutInms\": 5678,"
+            << " \"UploadPartSize\": 2097152, \"down_slice_size\": 1048576,"
+            << " \"DestDomain\": \"bulk.example.com\", \"ExpectContinueThreshold\": 4096,"
+            << " \"UploadRateLimit\": 1048576, \"DownloadRateLimit\": 2097152}";
+    }
+
+    uint64_t global_conn_timeout = CosSysConfig::GetConnTimeoutInms();
+    uint64_t global_part_size = CosSysConfig::GetUploadPartSize();
+    CosConfig config(path);
+    unlink(path);
+
+    const ClientSettings& settings = config.GetClientSettings();
+    EXPECT_EQ(1234u, settings.GetConnTimeoutInms());
+    EXPECT_EQ(5678u, settings.GetRecvTimeoutInms());
+    EXPECT_EQ(2097152u, settings.GetUploadPartSize());
+    EXPECT_EQ(1048576u, settings.GetDownSliceSize());
+    EXPECT_EQ("bulk.example.com", settings.GetDestDomain());
+    EXPECT_EQ(4096u, settings.GetExpectContinueThreshold());
+    EXPECT_EQ(1048576u, settings.GetUploadRateLimit());
+    EXPECT_EQ(2097152u, settings.GetDownloadRateLimit());
+
+    // 不影响全局配置和其它实例
+    EXPECT_EQ(global_conn_timeout, CosSysConfig::GetConnTimeoutInms());
+    EXPECT_EQ(global_part_size, CosSysConfig::GetUploadPartSize());
+    EXPECT_EQ("", CosSysConfig::GetDestDomain());
+    CosConfig other_config(0, "ak", "sk", "cn-north");
+    EXPECT_EQ(global_conn_timeout, other_config.GetClientSettings().GetConnTimeoutInms());
+
+    CosConfig copied_config(config);
+    EXPECT_EQ(1234u, copied_config.GetClientSettings().GetConnTimeoutInms());
+}
+
+} // namespace qcloud_cos
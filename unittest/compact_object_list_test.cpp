@@ -0,0 +1,182 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: 紧凑Object列表及其列出结果解析的单元测试
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+
+#include "response/bucket_resp.h"
+#include "response/compact_object_list.h"
+
+namespace qcloud_cos {
+
+namespace {
+
+const std::string kMd5ETag = "0123456789abcdef0123456789abcdef";
+
+std::string BuildListXml(unsigned begin, unsigned end, bool is_truncated) {
+    std::string xml = "<?xml version='1.0' encoding='utf-8' ?>\n<ListBucketResult>\n"
+                      "<Name>bucket-1250000000</Name><Prefix>dir/</Prefix><MaxKeys>1000</MaxKeys>";
+    xml += is_truncated ? "<IsTruncated>true</IsTruncated>" : "<IsTruncated>false</IsTruncated>";
+    char buf[512];
+    for (unsigned i = begin; i < end; ++i) {
+        snprintf(buf, sizeof(buf),
+                 "<Contents><Key>dir/k%05u</Key>"
+                 "<LastModified>2017-08-01T08:00:00.000Z</LastModified>"
+                 "<ETag>&quot;%s-%u&quot;</ETag><Size>%u</Size>"
+                 "<Owner><ID>1250000000</ID></Owner>"
+                 "<StorageClass>STANDARD</StorageClass></Contents>",
+                 i, kMd5ETag.c_str(), i % 3 + 1, i);
+        xml += buf;
+    }
+    xml += "<CommonPrefixes><Prefix>dir/sub/</Prefix></CommonPrefixes>";
+    if (is_truncated) {
+        snprintf(buf, sizeof(buf), "<NextMarker>dir/k%05u</NextMarker>", end - 1);
+        xml += buf;
+    }
+    xml += "</ListBucketResult>";
+    return xml;
+}
+
+} // namespace
+
+TEST(CompactObjectListTest, AppendAndIterate) {
+    CompactObjectList list;
+    EXPECT_TRUE(list.Empty());
+    list.Append("a/1", 10, 1500000000, kMd5ETag, "STANDARD", "100");
+    list.Append("", 0, 0, "", "", "");
+    list.Append("a/3", 30, 1500000002, kMd5ETag + "-12", "STANDARD_IA", "100");
+    ASSERT_EQ(3u, list.Size());
+
+    std::vector<std::string> keys;
+    for (CompactObjectList::ConstIterator itr = list.Begin(); itr != list.End(); ++itr) {
+        keys.push_back(itr->GetKey());
+    }
+    ASSERT_EQ(3u, keys.size());
+    EXPECT_EQ("a/1", keys[0]);
+    EXPECT_EQ("", keys[1]);
+    EXPECT_EQ("a/3", keys[2]);
+
+    CompactObjectRef ref = list.At(2);
+    EXPECT_EQ(3u, ref.GetKeySize());
+    EXPECT_EQ(30u, ref.GetSize());
+    EXPECT_EQ(1500000002u, ref.GetLastModifiedTime());
+    EXPECT_EQ(kMd5ETag + "-12", ref.GetETag());
+    EXPECT_EQ("STANDARD_IA", ref.GetStorageClass());
+    EXPECT_EQ("100", ref.GetOwnerId());
+
+    BucketObjectEntry entry;
+    entry.m_is_common_prefix = true;
+    list.GetEntry(0, &entry);
+    EXPECT_FALSE(entry.m_is_common_prefix);
+    EXPECT_EQ("a/1", entry.m_key);
+    EXPECT_EQ(kMd5ETag, entry.m_etag);
+    EXPECT_EQ(10u, entry.m_size);
+    EXPECT_EQ("STANDARD", entry.m_storage_class);
+    EXPECT_EQ("100", entry.m_owner_id);
+}
+
+TEST(CompactObjectListTest, RawETag) {
+    CompactObjectList list;
+    // 大写hex、长度不足、后缀不以'-'开头时按原样保存
+    const std::string etags[] = {"0123456789ABCDEF0123456789ABCDEF", "abc",
+                                 kMd5ETag + "x", "0123456789abcdef0123456789abcdeg"};
+    for (size_t i = 0; i < sizeof(etags) / sizeof(etags[0]); ++i) {
+        list.Append("k", 1, 1, etags[i], "", "");
+        EXPECT_EQ(etags[i], list.At(i).GetETag());
+    }
+}
+
+TEST(CompactObjectListTest, InternAndTruncate) {
+    CompactObjectList list;
+    for (unsigned i = 0; i < 1000; ++i) {
+        char key[32];
+        snprintf(key, sizeof(key), "key%04u", i);
+        list.Append(key, i, i, kMd5ETag + (i % 2 ? "-2" : ""), "STANDARD", "owner");
+    }
+    EXPECT_EQ("key0999", list.At(999).GetKey());
+    EXPECT_EQ(kMd5ETag + "-2", list.At(999).GetETag());
+    EXPECT_EQ(kMd5ETag, list.At(998).GetETag());
+
+    // 同样的key用std::string和Content保存至少需要的内存
+    uint64_t content_usage = 1000 * (sizeof(Content) + sizeof(std::string));
+    EXPECT_LT(list.GetMemoryUsage(), content_usage);
+
+    list.Truncate(10);
+    ASSERT_EQ(10u, list.Size());
+    EXPECT_EQ("key0009", list.At(9).GetKey());
+    list.Append("next", 1, 1, "", "", "");
+    EXPECT_EQ("next", list.At(10).GetKey());
+    EXPECT_EQ("STANDARD", list.At(9).GetStorageClass());
+
+    list.Clear();
+    EXPECT_TRUE(list.Empty());
+    EXPECT_TRUE(list.Begin() == list.End());
+}
+
+TEST(CompactObjectListTest, StringInterner) {
+    StringInterner interner;
+    EXPECT_EQ(1u, interner.Size());
+    EXPECT_EQ(0u, interner.Intern(""));
+    uint32_t id = interner.Intern("STANDARD");
+    EXPECT_EQ(id, interner.Intern("STANDARD"));
+    EXPECT_NE(id, interner.Intern("STANDARD_IA"));
+    EXPECT_EQ("STANDARD", interner.Get(id));
+    EXPECT_EQ(3u, interner.Size());
+}
+
+TEST(CompactObjectListTest, ParseListResult) {
+    CompactGetBucketResp resp;
+    ASSERT_TRUE(resp.ParseFromXmlString(BuildListXml(0, 5, true)));
+    EXPECT_EQ("bucket-1250000000", resp.GetName());
+    EXPECT_EQ("dir/", resp.GetPrefix());
+    EXPECT_EQ(1000u, resp.GetMaxKeys());
+    EXPECT_TRUE(resp.IsTruncated());
+    EXPECT_EQ("dir/k00004", resp.GetNextMarker());
+    ASSERT_EQ(1u, resp.GetCommonPrefixes().size());
+    EXPECT_EQ("dir/sub/", resp.GetCommonPrefixes()[0]);
+
+    const CompactObjectList& list = resp.GetObjectList();
+    ASSERT_EQ(5u, list.Size());
+    EXPECT_EQ(5u, resp.GetObjectCount());
+    CompactObjectRef ref = list.At(4);
+    EXPECT_EQ("dir/k00004", ref.GetKey());
+    EXPECT_EQ(4u, ref.GetSize());
+    EXPECT_EQ(1501574400u, ref.GetLastModifiedTime());
+    EXPECT_EQ(kMd5ETag + "-2", ref.GetETag());
+    EXPECT_EQ("STANDARD", ref.GetStorageClass());
+    EXPECT_EQ("1250000000", ref.GetOwnerId());
+
+    EXPECT_FALSE(resp.ParseFromXmlString("<Error><Code>NoSuchBucket</Code></Error>"));
+}
+
+TEST(CompactObjectListTest, AppendPages) {
+    CompactObjectList list;
+    CompactGetBucketResp first;
+    first.SetObjectList(&list);
+    ASSERT_TRUE(first.ParseFromXmlString(BuildListXml(0, 3, true)));
+
+    CompactGetBucketResp second;
+    second.SetObjectList(&list);
+    EXPECT_EQ(3u, second.GetFirstIndex());
+    ASSERT_TRUE(second.ParseFromXmlString(BuildListXml(3, 6, false)));
+    EXPECT_EQ(3u, second.GetObjectCount());
+
+    // 重试时重新解析只丢弃本页已追加的记录
+    second.OnReset();
+    EXPECT_EQ(3u, list.Size());
+    ASSERT_TRUE(second.ParseFromXmlString(BuildListXml(3, 6, false)));
+    ASSERT_EQ(6u, list.Size());
+    for (unsigned i = 0; i < 6; ++i) {
+        char key[32];
+        snprintf(key, sizeof(key), "dir/k%05u", i);
+        EXPECT_EQ(key, list.At(i).GetKey());
+    }
+}
+
+} // namespace qcloud_cos
@@ -0,0 +1,283 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: GetObject磁盘缓存的单元测试
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <map>
+#include <string>
+
+#include "boost/bind.hpp"
+#include "boost/thread/thread.hpp"
+
+#include "util/disk_cache.h"
+#include "util/file_util.h"
+#include "util/http_sender.h"
+
+namespace qcloud_cos {
+
+namespace {
+
+void WriteFile(const std::string& path, const std::string& content) {
+    std::ofstream ofs(path.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    ofs << content;
+}
+
+// 写入临时文件并提交到缓存
+bool Fill(DiskCache* cache, const std::string& object, const std::string& content,
+          DiskCacheEntry* entry,
+          const std::map<std::string, std::string>& headers
+              = std::map<std::string, std::string>()) {
+    std::string temp_path = cache->GetTempPath("bucket", object);
+    WriteFile(temp_path, content);
+    return cache->Commit("bucket", object, temp_path, "etag_" + object, content.size(),
+                         headers, entry);
+}
+
+// 读取缓存文件中Object的内容, 不含末尾记录的key
+std::string ReadCached(const DiskCacheEntry& entry) {
+    return FileUtil::GetFileContent(entry.m_path).substr(0, entry.m_size);
+}
+
+// 从查找时打开的文件读取Object的内容
+std::string ReadOpened(const DiskCacheEntry& entry) {
+    std::string content(entry.m_size, '\0');
+    entry.m_file->seekg(0);
+    entry.m_file->read(&content[0], content.size());
+    return content;
+}
+
+void FillOnce(DiskCache* cache, const std::string& object, unsigned* fill_times) {
+    bool is_filled = false;
+    if (cache->BeginFill("bucket", object, 0, SharedCancelToken(), &is_filled)) {
+        usleep(50 * 1000);
+        DiskCacheEntry entry;
+        Fill(cache, object, "content", &entry);
+        __sync_fetch_and_add(fill_times, 1);
+        cache->EndFill("bucket", object, true);
+    }
+}
+
+} // namespace
+
+class DiskCacheTest : public testing::Test {
+protected:
+    virtual void SetUp() {
+        char dir[] = "/tmp/cos_disk_cache_test_XXXXXX";
+        ASSERT_TRUE(mkdtemp(dir) != NULL);
+        m_dir = dir;
+    }
+
+    virtual void TearDown() {
+        std::string cmd = "rm -rf " + m_dir;
+        system(cmd.c_str());
+    }
+
+    DiskCachePolicy MakePolicy(uint64_t max_bytes, uint32_t max_entries) const {
+        DiskCachePolicy policy;
+        policy.SetCacheDir(m_dir);
+        policy.SetMaxBytes(max_bytes);
+        policy.SetMaxEntries(max_entries);
+        policy.SetFreshInms(60000);
+        return policy;
+    }
+
+    std::string m_dir;
+};
+
+TEST_F(DiskCacheTest, CommitLookupTest) {
+    boost::shared_ptr<DiskCache> cache = DiskCache::Open(MakePolicy(1024, 16));
+    ASSERT_TRUE(cache);
+    DiskCacheEntry entry;
+    EXPECT_FALSE(cache->Lookup("bucket", "a", &entry));
+    ASSERT_TRUE(Fill(cache.get(), "a", "hello", &entry));
+
+    DiskCacheEntry found;
+    ASSERT_TRUE(cache->Lookup("bucket", "a", &found));
+    EXPECT_EQ(entry.m_path, found.m_path);
+    EXPECT_EQ("etag_a", found.m_etag);
+    EXPECT_EQ(5u, found.m_size);
+    EXPECT_TRUE(found.m_is_fresh);
+    EXPECT_EQ("hello", ReadCached(found));
+    // 缓存文件末尾记录完整的key
+    std::string file_content = FileUtil::GetFileContent(found.m_path);
+    EXPECT_EQ(5u + 8u + 8u, file_content.size());
+    EXPECT_EQ("bucket/a", file_content.substr(5, 8));
+
+    // 同一目录共享一个实例
+    EXPECT_EQ(cache.get(), DiskCache::Open(MakePolicy(1024, 16)).get());
+
+    cache->Invalidate("bucket", "a");
+    EXPECT_FALSE(cache->Lookup("bucket", "a", &found));
+    EXPECT_NE(0, access(entry.m_path.c_str(), F_OK));
+}
+
+TEST_F(DiskCacheTest, EvictTest) {
+    boost::shared_ptr<DiskCache> cache = DiskCache::Open(MakePolicy(10, 3));
+    ASSERT_TRUE(cache);
+    DiskCacheEntry entry;
+    ASSERT_TRUE(Fill(cache.get(), "a", "aaaa", &entry));
+    ASSERT_TRUE(Fill(cache.get(), "b", "bbbb", &entry));
+    // 访问a后b成为最久未使用
+    ASSERT_TRUE(cache->Lookup("bucket", "a", &entry));
+    ASSERT_TRUE(Fill(cache.get(), "c", "cccc", &entry));
+    EXPECT_FALSE(cache->Lookup("bucket", "b", &entry));
+    EXPECT_TRUE(cache->Lookup("bucket", "a", &entry));
+
+    // 超过总大小上限的Object不缓存, 临时文件保留给调用方
+    std::string temp_path = cache->GetTempPath("bucket", "big");
+    WriteFile(temp_path, "0123456789abc");
+    EXPECT_FALSE(cache->Commit("bucket", "big", temp_path, "etag_big", 13,
+                               std::map<std::string, std::string>(), &entry));
+    EXPECT_EQ(0, access(temp_path.c_str(), F_OK));
+    unlink(temp_path.c_str());
+
+    DiskCacheStat stat = cache->GetStat();
+    EXPECT_EQ(1u, stat.m_evictions);
+    EXPECT_EQ(2u, stat.m_entries);
+    EXPECT_EQ(8u, stat.m_bytes);
+}
+
+TEST_F(DiskCacheTest, ReopenTest) {
+    {
+        boost::shared_ptr<DiskCache> cache = DiskCache::Open(MakePolicy(1024, 16));
+        ASSERT_TRUE(cache);
+        DiskCacheEntry entry;
+        ASSERT_TRUE(Fill(cache.get(), "a", "hello", &entry));
+        WriteFile(cache->GetTempPath("bucket", "c"), "partial");
+        ASSERT_TRUE(Fill(cache.get(), "d", "other", &entry));
+        // 模拟缓存文件记录的key与哈希不符, 如哈希冲突的Object
+        std::string content = FileUtil::GetFileContent(entry.m_path);
+        content.replace(5, 8, "bucket/e");
+        WriteFile(entry.m_path, content);
+        ASSERT_TRUE(Fill(cache.get(), "b", "world", &entry));
+        // 模拟缓存文件被外部删除
+        unlink(entry.m_path.c_str());
+    }
+
+    boost::shared_ptr<DiskCache> cache = DiskCache::Open(MakePolicy(1024, 16));
+    ASSERT_TRUE(cache);
+    DiskCacheEntry entry;
+    ASSERT_TRUE(cache->Lookup("bucket", "a", &entry));
+    EXPECT_EQ("etag_a", entry.m_etag);
+    EXPECT_EQ("hello", ReadCached(entry));
+    EXPECT_FALSE(cache->Lookup("bucket", "b", &entry));
+    EXPECT_FALSE(cache->Lookup("bucket", "d", &entry));
+    EXPECT_FALSE(cache->Lookup("bucket", "e", &entry));
+    EXPECT_NE(0, access(cache->GetTempPath("bucket", "c").c_str(), F_OK));
+    EXPECT_EQ(1u, cache->GetStat().m_entries);
+}
+
+TEST_F(DiskCacheTest, HeadersTest) {
+    std::map<std::string, std::string> headers;
+    headers["Content-Type"] = "text/plain";
+    headers["x-cos-meta-tag"] = "a:b";
+    headers["x-cos-request-id"] = "req_id";
+    {
+        boost::shared_ptr<DiskCache> cache = DiskCache::Open(MakePolicy(1024, 16));
+        ASSERT_TRUE(cache);
+        DiskCacheEntry entry;
+        ASSERT_TRUE(Fill(cache.get(), "a", "hello", &entry, headers));
+        EXPECT_EQ(headers, entry.m_headers);
+        EXPECT_EQ("hello", ReadCached(entry));
+        DiskCacheEntry found;
+        ASSERT_TRUE(cache->Lookup("bucket", "a", &found));
+        EXPECT_EQ(headers, found.m_headers);
+    }
+
+    // 响应头随缓存文件保留, 重新打开后仍可返回
+    boost::shared_ptr<DiskCache> cache = DiskCache::Open(MakePolicy(1024, 16));
+    ASSERT_TRUE(cache);
+    DiskCacheEntry entry;
+    ASSERT_TRUE(cache->Lookup("bucket", "a", &entry));
+    EXPECT_EQ(headers, entry.m_headers);
+    EXPECT_EQ("hello", ReadCached(entry));
+}
+
+TEST_F(DiskCacheTest, ResizeTest) {
+    {
+        boost::shared_ptr<DiskCache> cache = DiskCache::Open(MakePolicy(1024, 16));
+        ASSERT_TRUE(cache);
+        DiskCacheEntry entry;
+        ASSERT_TRUE(Fill(cache.get(), "a", "hello", &entry));
+    }
+    // 索引容量变化后丢弃旧的缓存
+    boost::shared_ptr<DiskCache> cache = DiskCache::Open(MakePolicy(1024, 32));
+    ASSERT_TRUE(cache);
+    DiskCacheEntry entry;
+    EXPECT_FALSE(cache->Lookup("bucket", "a", &entry));
+    EXPECT_EQ(0u, cache->GetStat().m_bytes);
+}
+
+TEST_F(DiskCacheTest, FillDedupTest) {
+    boost::shared_ptr<DiskCache> cache = DiskCache::Open(MakePolicy(1024, 16));
+    ASSERT_TRUE(cache);
+    unsigned fill_times = 0;
+    boost::thread_group threads;
+    for (unsigned i = 0; i < 8; ++i) {
+        threads.create_thread(boost::bind(&FillOnce, cache.get(), "hot", &fill_times));
+    }
+    threads.join_all();
+    EXPECT_EQ(1u, fill_times);
+    EXPECT_EQ(7u, cache->GetStat().m_fill_waits);
+    DiskCacheEntry entry;
+    EXPECT_TRUE(cache->Lookup("bucket", "hot", &entry));
+}
+
+TEST_F(DiskCacheTest, ReplaceAfterLookupTest) {
+    boost::shared_ptr<DiskCache> cache = DiskCache::Open(MakePolicy(1024, 16));
+    ASSERT_TRUE(cache);
+    DiskCacheEntry entry;
+    ASSERT_TRUE(Fill(cache.get(), "a", "old", &entry));
+    DiskCacheEntry found;
+    ASSERT_TRUE(cache->Lookup("bucket", "a", &found));
+    ASSERT_TRUE(found.m_file);
+
+    // 查找之后记录被替换, 已打开的文件仍是查找时的内容
+    cache->Invalidate("bucket", "a");
+    ASSERT_TRUE(Fill(cache.get(), "a", "new content", &entry));
+    EXPECT_EQ(found.m_path, entry.m_path);
+    EXPECT_EQ("old", ReadOpened(found));
+    EXPECT_EQ("new content", ReadOpened(entry));
+
+    // 缓存文件被外部删除时视为未命中并删除记录
+    unlink(entry.m_path.c_str());
+    EXPECT_FALSE(cache->Lookup("bucket", "a", &found));
+    EXPECT_EQ(0u, cache->GetStat().m_entries);
+}
+
+TEST_F(DiskCacheTest, FillWaitTimeoutTest) {
+    boost::shared_ptr<DiskCache> cache = DiskCache::Open(MakePolicy(1024, 16));
+    ASSERT_TRUE(cache);
+    bool is_filled = true;
+    ASSERT_TRUE(cache->BeginFill("bucket", "slow", 0, SharedCancelToken(), &is_filled));
+
+    // 填充一直未结束时等待方按截止时间返回
+    uint64_t start_in_ms = HttpSender::GetTimeStampInUs() / 1000;
+    EXPECT_FALSE(cache->BeginFill("bucket", "slow", start_in_ms + 100, SharedCancelToken(),
+                                  &is_filled));
+    EXPECT_FALSE(is_filled);
+    uint64_t elapsed_in_ms = HttpSender::GetTimeStampInUs() / 1000 - start_in_ms;
+    EXPECT_GE(elapsed_in_ms, 100u);
+    EXPECT_LT(elapsed_in_ms, 1000u);
+
+    // 取消句柄被取消时立即返回
+    SharedCancelToken cancel_token(new CancelToken());
+    cancel_token->Cancel();
+    is_filled = true;
+    EXPECT_FALSE(cache->BeginFill("bucket", "slow", 0, cancel_token, &is_filled));
+    EXPECT_FALSE(is_filled);
+
+    cache->EndFill("bucket", "slow", false);
+    EXPECT_EQ(2u, cache->GetStat().m_fill_waits);
+    EXPECT_TRUE(cache->BeginFill("bucket", "slow", 0, SharedCancelToken(), &is_filled));
+    cache->EndFill("bucket", "slow", false);
+}
+
+} // namespace qcloud_cos
@@ -0,0 +1,185 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: 域名解析缓存的单元测试
+
+#include "gtest/gtest.h"
+
+#include <unistd.h>
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "util/dns_cache.h"
+
+namespace qcloud_cos {
+
+namespace {
+
+unsigned g_resolve_times = 0;
+bool g_is_resolve_fail = false;
+std::vector<std::string> g_addresses;
+
+bool FakeResolve(const std::string& host, std::vector<std::string>* addresses) {
+    (void)host;
+    __sync_fetch_and_add(&g_resolve_times, 1);
+    if (g_is_resolve_fail) {
+        return false;
+    }
+    *addresses = g_addresses;
+    return true;
+}
+
+// 等待后台刷新线程结束
+void WaitResolveTimes(unsigned times) {
+    for (int i = 0; i < 200 && __sync_fetch_and_add(&g_resolve_times, 0) < times; ++i) {
+        usleep(5 * 1000);
+    }
+    usleep(10 * 1000);
+}
+
+} // namespace
+
+class DnsCacheTest : public testing::Test {
+protected:
+    virtual void SetUp() {
+        g_resolve_times = 0;
+        g_is_resolve_fail = false;
+        g_addresses.clear();
+        g_addresses.push_back("10.0.0.1");
+        g_addresses.push_back("10.0.0.2");
+        g_addresses.push_back("10.0.0.3");
+        DnsCache::Instance().Clear();
+        DnsCache::Instance().SetResolver(&FakeResolve);
+        DnsCache::Instance().SetTtlInms(60 * 1000);
+        DnsCache::Instance().SetEjectInms(kDefaultDnsEjectInms);
+    }
+
+    virtual void TearDown() {
+        DnsCache::Instance().Clear();
+        DnsCache::Instance().SetResolver(NULL);
+        DnsCache::Instance().SetTtlInms(0);
+    }
+};
+
+TEST_F(DnsCacheTest, DisabledByDefaultTtl) {
+    DnsCache::Instance().SetTtlInms(0);
+    std::string address;
+    EXPECT_FALSE(DnsCache::Instance().PickAddress("bucket.cos.ap-guangzhou.myqcloud.com",
+                                                  &address));
+    EXPECT_EQ(0u, g_resolve_times);
+}
+
+TEST_F(DnsCacheTest, IpHostBypass) {
+    std::string address;
+    EXPECT_FALSE(DnsCache::Instance().PickAddress("127.0.0.1", &address));
+    EXPECT_FALSE(DnsCache::Instance().PickAddress("::1", &address));
+    EXPECT_EQ(0u, g_resolve_times);
+}
+
+TEST_F(DnsCacheTest, ResolveOnceWithinTtl) {
+    DnsCacheStat before = DnsCache::Instance().GetStat();
+    std::string address;
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_TRUE(DnsCache::Instance().PickAddress("host", &address));
+    }
+    EXPECT_EQ(1u, g_resolve_times);
+    DnsCacheStat after = DnsCache::Instance().GetStat();
+    EXPECT_EQ(before.m_misses + 1, after.m_misses);
+    EXPECT_EQ(before.m_hits + 9, after.m_hits);
+}
+
+TEST_F(DnsCacheTest, RoundRobin) {
+    std::vector<std::string> picked;
+    for (int i = 0; i < 6; ++i) {
+        std::string address;
+        EXPECT_TRUE(DnsCache::Instance().PickAddress("host", &address));
+        picked.push_back(address);
+    }
+    EXPECT_EQ(3u, std::set<std::string>(picked.begin(), picked.end()).size());
+    EXPECT_EQ(picked[0], picked[3]);
+    EXPECT_EQ(picked[1], picked[4]);
+    EXPECT_EQ(picked[2], picked[5]);
+}
+
+TEST_F(DnsCacheTest, EjectFailedAddress) {
+    std::string address;
+    EXPECT_TRUE(DnsCache::Instance().PickAddress("host", &address));
+    DnsCache::Instance().ReportFailure("host", "10.0.0.2");
+    for (int i = 0; i < 6; ++i) {
+        EXPECT_TRUE(DnsCache::Instance().PickAddress("host", &address));
+        EXPECT_NE("10.0.0.2", address);
+    }
+
+    // 剔除时间结束后重新选择
+    DnsCache::Instance().SetEjectInms(1);
+    DnsCache::Instance().ReportFailure("host", "10.0.0.2");
+    usleep(5 * 1000);
+    std::set<std::string> picked;
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_TRUE(DnsCache::Instance().PickAddress("host", &address));
+        picked.insert(address);
+    }
+    EXPECT_EQ(1u, picked.count("10.0.0.2"));
+}
+
+TEST_F(DnsCacheTest, AllEjectedStillPick) {
+    std::string address;
+    EXPECT_TRUE(DnsCache::Instance().PickAddress("host", &address));
+    DnsCache::Instance().ReportFailure("host", "10.0.0.1");
+    DnsCache::Instance().ReportFailure("host", "10.0.0.2");
+    DnsCache::Instance().ReportFailure("host", "10.0.0.3");
+    std::set<std::string> picked;
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_TRUE(DnsCache::Instance().PickAddress("host", &address));
+        picked.insert(address);
+    }
+    EXPECT_EQ(3u, picked.size());
+}
+
+TEST_F(DnsCacheTest, ServeStaleWhileRefresh) {
+    DnsCache::Instance().SetTtlInms(1);
+    std::string address;
+    EXPECT_TRUE(DnsCache::Instance().PickAddress("host", &address));
+    usleep(5 * 1000);
+
+    // 过期后仍返回旧地址, 在后台重新解析
+    g_addresses.clear();
+    g_addresses.push_back("10.0.1.1");
+    DnsCache::Instance().SetTtlInms(60 * 1000);
+    EXPECT_TRUE(DnsCache::Instance().PickAddress("host", &address));
+    EXPECT_EQ(0u, address.find("10.0.0."));
+    WaitResolveTimes(2);
+    EXPECT_EQ(2u, g_resolve_times);
+
+    EXPECT_TRUE(DnsCache::Instance().PickAddress("host", &address));
+    EXPECT_EQ("10.0.1.1", address);
+}
+
+TEST_F(DnsCacheTest, KeepStaleOnRefreshFail) {
+    DnsCache::Instance().SetTtlInms(1);
+    std::string address;
+    EXPECT_TRUE(DnsCache::Instance().PickAddress("host", &address));
+    usleep(5 * 1000);
+
+    g_is_resolve_fail = true;
+    EXPECT_TRUE(DnsCache::Instance().PickAddress("host", &address));
+    WaitResolveTimes(2);
+    EXPECT_TRUE(DnsCache::Instance().PickAddress("host", &address));
+    EXPECT_EQ(0u, address.find("10.0.0."));
+}
+
+TEST_F(DnsCacheTest, ResolveFail) {
+    g_is_resolve_fail = true;
+    std::string address;
+    EXPECT_FALSE(DnsCache::Instance().PickAddress("host", &address));
+}
+
+TEST_F(DnsCacheTest, ResolveLocalhost) {
+    std::vector<std::string> addresses;
+    EXPECT_TRUE(DnsCache::ResolveByGetAddrInfo("localhost", &addresses));
+    EXPECT_FALSE(addresses.empty());
+}
+
+} // namespace qcloud_cos
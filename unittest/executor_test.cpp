@@ -0,0 +1,153 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: work-stealing执行器和任务组的单元测试
+
+#include "gtest/gtest.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "boost/bind.hpp"
+#include "boost/thread/mutex.hpp"
+
+#include "util/executor.h"
+
+namespace qcloud_cos {
+
+namespace {
+
+struct ConcurrencyCounter {
+    ConcurrencyCounter() : m_running(0), m_max_running(0), m_done(0) {}
+
+    boost::mutex m_mutex;
+    unsigned m_running;
+    unsigned m_max_running;
+    unsigned m_done;
+};
+
+void CountedTask(ConcurrencyCounter* counter, unsigned sleep_in_ms) {
+    {
+        boost::mutex::scoped_lock lock(counter->m_mutex);
+        ++counter->m_running;
+        counter->m_max_running = std::max(counter->m_max_running, counter->m_running);
+    }
+    usleep(sleep_in_ms * 1000);
+    boost::mutex::scoped_lock lock(counter->m_mutex);
+    --counter->m_running;
+    ++counter->m_done;
+}
+
+// 在工作线程上创建子任务组并等待, 模拟在执行器上发起的分块传输
+void NestedTask(Executor* executor, ConcurrencyCounter* counter) {
+    TaskGroup group(4, executor);
+    for (int i = 0; i < 4; ++i) {
+        group.Schedule(boost::bind(&CountedTask, counter, 1));
+    }
+    group.Wait();
+}
+
+} // namespace
+
+TEST(ExecutorTest, TaskGroupTest) {
+    Executor executor(8);
+    ConcurrencyCounter counter;
+    {
+        TaskGroup group(3, &executor);
+        for (int i = 0; i < 30; ++i) {
+            group.Schedule(boost::bind(&CountedTask, &counter, 5));
+        }
+        group.Wait();
+        EXPECT_EQ(30u, counter.m_done);
+    }
+
+    // 执行器有8个线程, 但同一组内同时执行的任务不超过3个
+    EXPECT_LE(counter.m_max_running, 3u);
+    EXPECT_GE(counter.m_max_running, 2u);
+
+    EXPECT_EQ(30u, executor.GetStat().m_submitted);
+}
+
+TEST(ExecutorTest, TimedWaitTest) {
+    Executor executor(2);
+    ConcurrencyCounter counter;
+    TaskGroup group(2, &executor);
+    group.Schedule(boost::bind(&CountedTask, &counter, 200));
+    EXPECT_FALSE(group.TimedWait(10));
+    EXPECT_TRUE(group.TimedWait(2000));
+    EXPECT_EQ(1u, counter.m_done);
+}
+
+TEST(ExecutorTest, SharedExecutorTest) {
+    // 两个组共享执行器, 合计并发受线程数限制
+    Executor executor(4);
+    ConcurrencyCounter counter;
+    {
+        TaskGroup group1(4, &executor);
+        TaskGroup group2(4, &executor);
+        for (int i = 0; i < 16; ++i) {
+            group1.Schedule(boost::bind(&CountedTask, &counter, 5));
+            group2.Schedule(boost::bind(&CountedTask, &counter, 5));
+        }
+    }
+    EXPECT_EQ(32u, counter.m_done);
+    EXPECT_LE(counter.m_max_running, 4u);
+}
+
+TEST(ExecutorTest, NestedWaitTest) {
+    // 外层任务占满所有工作线程并等待内层任务, 等待的线程执行排队的任务, 不会死锁
+    Executor executor(2);
+    ConcurrencyCounter counter;
+    {
+        TaskGroup group(8, &executor);
+        for (int i = 0; i < 8; ++i) {
+            group.Schedule(boost::bind(&NestedTask, &executor, &counter));
+        }
+    }
+    EXPECT_EQ(32u, counter.m_done);
+    EXPECT_GT(executor.GetStat().m_submitted, 32u);
+}
+
+TEST(ExecutorTest, SubmitAtTest) {
+    // 延迟任务到期前不占用工作线程, 唯一的工作线程可以执行其他任务
+    Executor executor(1);
+    ConcurrencyCounter delayed;
+    ConcurrencyCounter counter;
+    boost::system_time now = boost::get_system_time();
+    executor.SubmitAt(now + boost::posix_time::milliseconds(300),
+                      boost::bind(&CountedTask, &delayed, 0));
+    executor.SubmitAt(now + boost::posix_time::milliseconds(100),
+                      boost::bind(&CountedTask, &delayed, 0));
+    {
+        TaskGroup group(1, &executor);
+        group.Schedule(boost::bind(&CountedTask, &counter, 0));
+        EXPECT_TRUE(group.TimedWait(50));
+    }
+    EXPECT_EQ(1u, counter.m_done);
+    EXPECT_EQ(0u, delayed.m_done);
+
+    usleep(200 * 1000);
+    {
+        boost::mutex::scoped_lock lock(delayed.m_mutex);
+        EXPECT_EQ(1u, delayed.m_done);
+    }
+    usleep(300 * 1000);
+    boost::mutex::scoped_lock lock(delayed.m_mutex);
+    EXPECT_EQ(2u, delayed.m_done);
+}
+
+TEST(ExecutorTest, WorkStealingTest) {
+    // 同一工作线程提交的任务被其他空闲线程窃取
+    Executor executor(4);
+    ConcurrencyCounter counter;
+    {
+        TaskGroup group(1, &executor);
+        group.Schedule(boost::bind(&NestedTask, &executor, &counter));
+    }
+    EXPECT_EQ(4u, counter.m_done);
+    EXPECT_GT(executor.GetStat().m_stolen, 0u);
+    EXPECT_GE(executor.GetThreadNum(), 4u);
+}
+
+} // namespace qcloud_cos
@@ -0,0 +1,108 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: 读取本地文件范围的流缓冲区的单元测试
+
+#include "gtest/gtest.h"
+
+#include <unistd.h>
+
+#include <fstream>
+#include <istream>
+#include <iterator>
+#include <string>
+
+#include "util/file_input_buf.h"
+#include "util/transfer_progress.h"
+
+namespace qcloud_cos {
+
+class FileInputBufTest : public testing::Test {
+protected:
+    virtual void SetUp() {
+        m_file_path = "./file_input_buf_test.dat";
+        m_content.clear();
+        // 超过内部缓冲区大小, 覆盖多次读入
+        for (unsigned i = 0; i < 200 * 1024; ++i) {
+            m_content.push_back(static_cast<char>(i * 31 + i / 7));
+        }
+        std::ofstream ofs(m_file_path.c_str(), std::ios::out | std::ios::binary);
+        ofs.write(m_content.data(), m_content.size());
+    }
+
+    virtual void TearDown() {
+        unlink(m_file_path.c_str());
+    }
+
+    static std::string ReadAll(std::istream& is) {
+        return std::string(std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>());
+    }
+
+    std::string m_file_path;
+    std::string m_content;
+};
+
+TEST_F(FileInputBufTest, ReadRange) {
+    FileInputBuf buf(m_file_path, 1000, 100 * 1024);
+    ASSERT_TRUE(buf.IsOpen());
+    std::istream is(&buf);
+    EXPECT_EQ(m_content.substr(1000, 100 * 1024), ReadAll(is));
+    EXPECT_EQ(0u, buf.GetRemainBytes());
+}
+
+TEST_F(FileInputBufTest, ClampToFileEnd) {
+    FileInputBuf buf(m_file_path, m_content.size() - 10, 100);
+    std::istream is(&buf);
+    EXPECT_EQ(m_content.substr(m_content.size() - 10), ReadAll(is));
+
+    FileInputBuf empty_buf(m_file_path, m_content.size() + 10, 100);
+    EXPECT_EQ(0u, empty_buf.GetRemainBytes());
+}
+
+TEST_F(FileInputBufTest, OpenFail) {
+    FileInputBuf buf("./not_exist_file_input_buf_test.dat", 0, 100);
+    EXPECT_FALSE(buf.IsOpen());
+    std::istream is(&buf);
+    EXPECT_EQ("", ReadAll(is));
+}
+
+TEST_F(FileInputBufTest, SeekAndLength) {
+    FileInputBuf buf(m_file_path, 4096, 150 * 1024);
+    std::istream is(&buf);
+    is.seekg(0, std::ios::end);
+    EXPECT_EQ(150 * 1024, static_cast<int>(is.tellg()));
+    is.seekg(0, std::ios::beg);
+
+    char head[100];
+    is.read(head, sizeof(head));
+    EXPECT_EQ(m_content.substr(4096, 100), std::string(head, sizeof(head)));
+    EXPECT_EQ(100, static_cast<int>(is.tellg()));
+
+    // 在缓冲区内回退以及跳到缓冲区外
+    is.seekg(10);
+    is.read(head, 10);
+    EXPECT_EQ(m_content.substr(4096 + 10, 10), std::string(head, 10));
+    is.seekg(120 * 1024);
+    EXPECT_EQ(m_content.substr(4096 + 120 * 1024, 30 * 1024), ReadAll(is));
+
+    is.clear();
+    EXPECT_TRUE(is.seekg(150 * 1024 + 1).fail());
+}
+
+TEST_F(FileInputBufTest, ConsumeAndProgress) {
+    TransferProgress progress;
+    FileInputBuf buf(m_file_path, 100, 100 * 1024, &progress);
+    std::istream is(&buf);
+    char head[10];
+    is.read(head, sizeof(head));
+    EXPECT_EQ(100u + 10, buf.GetFileOffset());
+
+    // 数据绕过缓冲区发送后跳过
+    buf.Consume(50 * 1024);
+    EXPECT_EQ(100u + 10 + 50 * 1024, buf.GetFileOffset());
+    EXPECT_EQ(100u * 1024 - 10 - 50 * 1024, buf.GetRemainBytes());
+    EXPECT_EQ(m_content.substr(100 + 10 + 50 * 1024, 100 * 1024 - 10 - 50 * 1024), ReadAll(is));
+    EXPECT_LE(100u * 1024, progress.GetBytes());
+}
+
+} // namespace qcloud_cos
@@ -0,0 +1,105 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: 扁平header/param列表的单元测试
+
+#include "gtest/gtest.h"
+
+#include <map>
+#include <string>
+
+#include "util/header_list.h"
+
+namespace qcloud_cos {
+
+TEST(HeaderListTest, AddAndFind) {
+    HeaderList list;
+    EXPECT_TRUE(list.Empty());
+
+    list.Add("Content-Type", "text/plain");
+    list.Add("x-cos-meta-a", "");
+    EXPECT_EQ(2u, list.Size());
+
+    std::string value;
+    EXPECT_TRUE(list.Find("content-type", &value));
+    EXPECT_EQ("text/plain", value);
+    EXPECT_TRUE(list.Find("X-COS-META-A", &value));
+    EXPECT_EQ("", value);
+    EXPECT_FALSE(list.Find("host", &value));
+
+    EXPECT_EQ("Content-Type", list.GetName(0));
+    EXPECT_EQ("text/plain", list.GetValue(0));
+}
+
+TEST(HeaderListTest, SetReplacesValue) {
+    HeaderList list;
+    list.Set("Host", "a.example.com");
+    list.Set("host", "b.example.com");
+    EXPECT_EQ(1u, list.Size());
+    EXPECT_EQ("Host", list.GetName(0));
+    EXPECT_EQ("b.example.com", list.GetValue(0));
+}
+
+TEST(HeaderListTest, AddAllAndMerge) {
+    std::map<std::string, std::string> headers;
+    headers["Content-Type"] = "text/plain";
+    headers["x-cos-meta-a"] = "1";
+    HeaderList list;
+    list.AddAll(headers);
+    EXPECT_EQ(2u, list.Size());
+
+    // 已存在的名字(大小写不敏感)保留原值
+    std::map<std::string, std::string> additional;
+    additional["content-type"] = "application/xml";
+    additional["x-cos-meta-b"] = "2";
+    list.Merge(additional);
+    ASSERT_EQ(3u, list.Size());
+    std::string value;
+    EXPECT_TRUE(list.Find("content-type", &value));
+    EXPECT_EQ("text/plain", value);
+    EXPECT_TRUE(list.Find("x-cos-meta-b", &value));
+    EXPECT_EQ("2", value);
+}
+
+TEST(HeaderListTest, SortByNameKeepsLastDuplicate) {
+    HeaderList list;
+    list.Add("x-cos-b", "1");
+    list.Add("Host", "h");
+    list.Add("X-Cos-B", "2");
+    list.Add("x-cos-a", "3");
+    list.Add("x-cos", "4");
+
+    list.SortByName();
+    ASSERT_EQ(4u, list.Size());
+    EXPECT_EQ("Host", list.GetName(0));
+    EXPECT_EQ("x-cos", list.GetName(1));
+    EXPECT_EQ("x-cos-a", list.GetName(2));
+    EXPECT_EQ("X-Cos-B", list.GetName(3));
+    EXPECT_EQ("2", list.GetValue(3));
+
+    list.LowerNames();
+    EXPECT_EQ("x-cos-b", list.GetName(3));
+}
+
+TEST(HeaderListTest, AppendAndClear) {
+    HeaderList list;
+    list.Add("k1", "v1");
+    list.Add("k2", "v2");
+
+    std::string out;
+    for (size_t i = 0; i < list.Size(); ++i) {
+        list.AppendName(i, &out);
+        out.append("=");
+        list.AppendValue(i, &out);
+        out.append(";");
+    }
+    EXPECT_EQ("k1=v1;k2=v2;", out);
+
+    list.Clear();
+    EXPECT_TRUE(list.Empty());
+    list.Add("k3", "v3");
+    EXPECT_EQ("k3", list.GetName(0));
+    EXPECT_EQ("v3", list.GetValue(0));
+}
+
+} // namespace qcloud_cos
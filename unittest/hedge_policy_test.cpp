@@ -0,0 +1,78 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: 对冲策略的单元测试
+
+#include "gtest/gtest.h"
+
+#include "util/hedge_policy.h"
+
+namespace qcloud_cos {
+
+TEST(HedgePolicyTest, LatencyHistogramTest) {
+    LatencyHistogram histogram;
+    EXPECT_EQ(0u, histogram.GetPercentile(0.95));
+
+    for (int i = 0; i < 90; ++i) {
+        histogram.Record(10);
+    }
+    for (int i = 0; i < 10; ++i) {
+        histogram.Record(500);
+    }
+    EXPECT_EQ(100u, histogram.GetCount());
+    uint64_t p50 = histogram.GetPercentile(0.5);
+    uint64_t p99 = histogram.GetPercentile(0.99);
+    EXPECT_GE(p50, 10u);
+    EXPECT_LT(p50, 15u);
+    EXPECT_GE(p99, 500u);
+    EXPECT_LT(p99, 700u);
+}
+
+TEST(HedgePolicyTest, LatencyHistogramDecayTest) {
+    LatencyHistogram histogram(100);
+    for (int i = 0; i < 100; ++i) {
+        histogram.Record(500);
+    }
+    // 旧样本逐步衰减, 分位数向新的延迟收敛
+    for (int i = 0; i < 500; ++i) {
+        histogram.Record(10);
+    }
+    EXPECT_LE(histogram.GetCount(), 100u);
+    EXPECT_LT(histogram.GetPercentile(0.95), 15u);
+}
+
+TEST(HedgePolicyTest, HedgeDelayTest) {
+    HedgePolicy policy;
+    policy.SetMinDelayInms(20);
+    policy.SetMaxDelayInms(300);
+    // 样本不足时使用上限
+    EXPECT_EQ(300u, policy.GetHedgeDelayInms("GET"));
+
+    for (uint64_t i = 0; i < kHedgeMinSamples; ++i) {
+        policy.RecordLatency("GET", 100);
+        policy.RecordLatency("HEAD", 1);
+    }
+    uint64_t get_delay = policy.GetHedgeDelayInms("GET");
+    EXPECT_GE(get_delay, 100u);
+    EXPECT_LT(get_delay, 130u);
+    EXPECT_EQ(20u, policy.GetHedgeDelayInms("HEAD"));
+}
+
+TEST(HedgePolicyTest, HedgeBudgetTest) {
+    HedgePolicy policy;
+    policy.SetBudgetRatio(0.5);
+    // 初始预算耗尽后, 每两个请求补充一次对冲机会
+    int hedges = 0;
+    while (policy.TryAcquireHedge()) {
+        ++hedges;
+    }
+    EXPECT_EQ(static_cast<int>(kHedgeBudgetCapacity), hedges);
+
+    policy.OnRequest();
+    EXPECT_FALSE(policy.TryAcquireHedge());
+    policy.OnRequest();
+    EXPECT_TRUE(policy.TryAcquireHedge());
+    EXPECT_FALSE(policy.TryAcquireHedge());
+}
+
+} // namespace qcloud_cos
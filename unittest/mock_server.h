@@ -9,21 +9,37 @@
 #define MOCK_SERVER_H
 #pragma once
 
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <fstream>
 #include <iostream>
+#include <map>
+#include <sstream>
 #include <string>
 #include <vector>
 
+#include "Poco/DigestStream.h"
+#include "Poco/MD5Engine.h"
 #include "Poco/Net/HTTPRequestHandler.h"
 #include "Poco/Net/HTTPRequestHandlerFactory.h"
 #include "Poco/Net/HTTPResponse.h"
 #include "Poco/Net/HTTPServer.h"
+#include "Poco/Net/HTTPServerParams.h"
 #include "Poco/Net/HTTPServerRequest.h"
 #include "Poco/Net/HTTPServerResponse.h"
 #include "Poco/Net/ServerSocket.h"
 #include "Poco/StreamCopier.h"
+#include "Poco/Thread.h"
+#include "Poco/Timestamp.h"
+#include "Poco/URI.h"
 #include "Poco/Util/ServerApplication.h"
 
 #include "cos_params.h"
+#include "util/simple_mutex.h"
 #include "util/string_util.h"
 
 namespace qcloud_cos {
@@ -31,6 +47,10 @@ namespace qcloud_cos {
 const std::string kMockServerName = "MOCK_SERVER";
 const std::string kMockObjectTypeNormal = "normal";
 const std::string kMockLastModified = "Sat, 22 Jul 2017 08:42:09 GMT";
+// HEAD请求的Object名包含kMockMissingKeyword时返回404
+const std::string kMockMissingKeyword = "missing";
+// HEAD/GET请求的Object名包含kMockExistingKeyword时返回MockGetObjectContent()的md5作为ETag
+const std::string kMockExistingKeyword = "existing";
 
 const std::string kMockHeadContentType  = "application/x-www-form-urlencoded; charset=UTF-8";
 const std::string kMockHeadETag = "TEST_HEAD_ETAG";
@@ -43,6 +63,16 @@ const std::string kMockPutObjectReqId = "TEST_HEAD_REQUEST_ID";
 const std::string kMockGetObjectContentType = "application/octet-stream";
 const std::string kMockGetObjectETag = "TEST_GET_ETAG";
 const std::string kMockGetObjectReqId = "TEST_GET_OBJECT_REQUEST_ID";
+const size_t kMockGetObjectSize = 1024 * 1024;
+
+/// \brief mock对象的内容, 按位置填充不同字符, 便于校验分块下载拼接的结果
+inline std::string MockGetObjectContent() {
+    std::string content(kMockGetObjectSize, 'a');
+    for (size_t i = 0; i < content.size(); ++i) {
+        content[i] = static_cast<char>('a' + i % 26);
+    }
+    return content;
+}
 
 const std::string kMockInitMultiUploadContentType = "application/xml";
 const std::string kMockInitMultiUploadReqId = "TEST_INIT_MULTI_UPLOAD_REQUEST_ID";
@@ -62,12 +92,296 @@ const std::string kMockPutBucketReqId = "TEST_PUT_BUCKET_REQUEST_ID";
 const std::string kMockPutBucketReplicationReqId = "TEST_PUT_BUCKET_REPLICATION_REQUEST_ID";
 const std::string kMockGetBucketReplicationReqId = "TEST_GET_BUCKET_REPLICATION_REQUEST_ID";
 const std::string kMockDeleteBucketReplicationReqId = "TEST_DELETE_BUCKET_REPLICATION_REQUEST_ID";
+const std::string kMockFaultReqId = "TEST_FAULT_REQUEST_ID";
+
+// prefix以kMockListPrefix开头的GetBucket请求按真实的分页语义列出mock key:
+// list/d<目录序号>/k<key序号>, 共kMockListDirCount个目录, 每个目录kMockListKeysPerDir个key
+const std::string kMockListPrefix = "list/";
+const std::string kMockListReqId = "TEST_LIST_REQUEST_ID";
+const size_t kMockListDirCount = 10;
+const size_t kMockListKeysPerDir = 250;
+
+/// \brief 按字典序排列的全部mock key, 第i个key的大小为i + 1
+inline const std::vector<std::string>& MockListKeys() {
+    static std::vector<std::string> s_keys;
+    if (s_keys.empty()) {
+        for (size_t dir = 0; dir < kMockListDirCount; ++dir) {
+            for (size_t i = 0; i < kMockListKeysPerDir; ++i) {
+                char key[64];
+                snprintf(key, sizeof(key), "%sd%u/k%05u", kMockListPrefix.c_str(),
+                         static_cast<unsigned>(dir), static_cast<unsigned>(i));
+                s_keys.push_back(key);
+            }
+        }
+    }
+    return s_keys;
+}
+
+// prefix以kMockDownloadPrefix开头的GetBucket请求列出MockDownloadKeys(), 不分页.
+// 除目录标记外每个Object的大小和ETag都与MockGetObjectContent()一致, 供按前缀下载使用
+const std::string kMockDownloadPrefix = "download/";
+
+inline const std::vector<std::string>& MockDownloadKeys() {
+    static std::vector<std::string> s_keys;
+    if (s_keys.empty()) {
+        s_keys.push_back(kMockDownloadPrefix + "a.dat");
+        s_keys.push_back(kMockDownloadPrefix + "sub/");
+        s_keys.push_back(kMockDownloadPrefix + "sub/b.dat");
+        s_keys.push_back(kMockDownloadPrefix + "sub/deep/c.dat");
+        s_keys.push_back(kMockDownloadPrefix + "x/../evil.dat");
+    }
+    return s_keys;
+}
+
+/// \brief mock server的故障注入配置, 概率取值范围均为[0, 1]
+struct MockFaultConfig {
+    MockFaultConfig()
+        : m_seed(1), m_min_latency_ms(0), m_max_latency_ms(0),
+          m_tail_latency_ratio(0.0), m_tail_latency_ms(0), m_max_tail_latencies(0),
+          m_bandwidth_bytes_per_s(0), m_error_ratio(0.0), m_error_burst_len(1),
+          m_max_errors(0), m_is_slow_down(true), m_reset_ratio(0.0), m_max_resets(0),
+          m_stall_ratio(0.0), m_max_stalls(0), m_stall_ms(0) {}
+
+    unsigned m_seed;                  // 随机数种子, 相同种子可复现同一故障序列
+    uint64_t m_min_latency_ms;        // 处理请求前的延迟, 在[min, max]内均匀分布
+    uint64_t m_max_latency_ms;
+    double m_tail_latency_ratio;      // 额外注入长尾延迟的概率
+    uint64_t m_tail_latency_ms;       // 长尾延迟
+    uint64_t m_max_tail_latencies;    // 最多注入的长尾延迟数, 0表示不限制
+    uint64_t m_bandwidth_bytes_per_s; // 响应体发送带宽上限, 0表示不限速
+    double m_error_ratio;             // 触发5xx错误的概率
+    unsigned m_error_burst_len;       // 触发错误后连续返回错误的请求数
+    uint64_t m_max_errors;            // 最多注入的错误数, 0表示不限制
+    bool m_is_slow_down;              // true返回503 SlowDown, false返回500 InternalError
+    double m_reset_ratio;             // 响应体发送一半后断开连接的概率
+    uint64_t m_max_resets;            // 最多注入的连接重置数, 0表示不限制
+    double m_stall_ratio;             // 响应体发送一半后停止发送的概率
+    uint64_t m_max_stalls;            // 最多注入的停顿数, 0表示不限制
+    uint64_t m_stall_ms;              // 停止发送的时长
+};
+
+/// \brief 故障注入的统计信息
+struct MockFaultStat {
+    MockFaultStat()
+        : m_requests(0), m_errors(0), m_resets(0), m_stalls(0), m_tail_latencies(0),
+          m_max_in_flight(0) {}
+
+    uint64_t m_requests;
+    uint64_t m_errors;
+    uint64_t m_resets;
+    uint64_t m_stalls;
+    uint64_t m_tail_latencies;
+    unsigned m_max_in_flight; // 同时处理中的请求数的最大值
+};
+
+/// \brief 故障注入的决策结果, 每个请求一份
+struct MockFaultDecision {
+    MockFaultDecision()
+        : m_latency_ms(0), m_is_error(false), m_is_reset(false), m_is_stall(false) {}
+
+    uint64_t m_latency_ms;
+    bool m_is_error;
+    bool m_is_reset;
+    bool m_is_stall;
+};
+
+/// \brief mock server通过抛出该异常让Poco直接关闭连接, 模拟响应体传输中途连接被重置
+class MockConnectionResetException : public std::exception {
+public:
+    virtual const char* what() const throw() { return "mock connection reset"; }
+};
+
+/// \brief 全局的故障注入器, mock server的每个请求都会向其获取本次的故障决策
+class MockFaultInjector {
+public:
+    static MockFaultInjector& Instance() {
+        static MockFaultInjector s_injector;
+        return s_injector;
+    }
+
+    void SetConfig(const MockFaultConfig& config) {
+        SimpleMutexLocker locker(&m_mutex);
+        m_config = config;
+        m_rand_state = config.m_seed;
+        m_remain_errors = 0;
+        m_stat = MockFaultStat();
+        m_stat.m_max_in_flight = m_in_flight;
+    }
+
+    /// \brief 恢复为不注入任何故障
+    void Reset() {
+        SetConfig(MockFaultConfig());
+    }
+
+    MockFaultConfig GetConfig() {
+        SimpleMutexLocker locker(&m_mutex);
+        return m_config;
+    }
+
+    MockFaultStat GetStat() {
+        SimpleMutexLocker locker(&m_mutex);
+        return m_stat;
+    }
+
+    /// \brief has_body为false的请求(如HEAD)不会注入连接重置和停顿
+    MockFaultDecision Decide(bool has_body) {
+        SimpleMutexLocker locker(&m_mutex);
+        MockFaultDecision decision;
+        ++m_stat.m_requests;
+        ++m_in_flight;
+        m_stat.m_max_in_flight = std::max(m_stat.m_max_in_flight, m_in_flight);
+
+        decision.m_latency_ms = m_config.m_min_latency_ms;
+        if (m_config.m_max_latency_ms > m_config.m_min_latency_ms) {
+            decision.m_latency_ms += NextRand()
+                % (m_config.m_max_latency_ms - m_config.m_min_latency_ms + 1);
+        }
+        if ((m_config.m_max_tail_latencies == 0
+             || m_stat.m_tail_latencies < m_config.m_max_tail_latencies)
+            && Hit(m_config.m_tail_latency_ratio)) {
+            decision.m_latency_ms += m_config.m_tail_latency_ms;
+            ++m_stat.m_tail_latencies;
+        }
+
+        if (m_config.m_max_errors > 0 && m_stat.m_errors >= m_config.m_max_errors) {
+            m_remain_errors = 0;
+        } else if (m_remain_errors > 0) {
+            --m_remain_errors;
+            decision.m_is_error = true;
+        } else if (Hit(m_config.m_error_ratio)) {
+            m_remain_errors = m_config.m_error_burst_len > 0 ? m_config.m_error_burst_len - 1 : 0;
+            decision.m_is_error = true;
+        }
+
+        if (decision.m_is_error) {
+            ++m_stat.m_errors;
+            return decision;
+        }
+
+        if (!has_body) {
+            return decision;
+        }
+
+        if ((m_config.m_max_resets == 0 || m_stat.m_resets < m_config.m_max_resets)
+            && Hit(m_config.m_reset_ratio)) {
+            decision.m_is_reset = true;
+            ++m_stat.m_resets;
+        } else if ((m_config.m_max_stalls == 0 || m_stat.m_stalls < m_config.m_max_stalls)
+                   && Hit(m_config.m_stall_ratio)) {
+            decision.m_is_stall = true;
+            ++m_stat.m_stalls;
+        }
+        return decision;
+    }
+
+    /// \brief 请求处理结束, 与Decide成对调用
+    void Finish() {
+        SimpleMutexLocker locker(&m_mutex);
+        --m_in_flight;
+    }
+
+private:
+    MockFaultInjector() : m_rand_state(1), m_remain_errors(0), m_in_flight(0) {}
+
+    // 调用方已持有锁
+    unsigned NextRand() {
+        return static_cast<unsigned>(rand_r(&m_rand_state));
+    }
+
+    bool Hit(double ratio) {
+        if (ratio <= 0.0) {
+            return false;
+        }
+        return NextRand() < ratio * (static_cast<double>(RAND_MAX) + 1.0);
+    }
+
+private:
+    SimpleMutex m_mutex;
+    MockFaultConfig m_config;
+    MockFaultStat m_stat;
+    unsigned m_rand_state;
+    unsigned m_remain_errors;
+    unsigned m_in_flight;
+};
+
+// DeleteObjects请求中key包含kMockDeleteFailKeyword的Object返回删除失败
+const std::string kMockDeleteObjectsReqId = "TEST_DELETE_OBJECTS_REQUEST_ID";
+const std::string kMockDeleteFailKeyword = "fail";
+
+/// \brief DeleteObjects请求的统计
+struct MockDeleteStat {
+    MockDeleteStat() : m_requests(0), m_max_batch_size(0), m_max_in_flight(0) {}
+
+    uint64_t m_requests;
+    size_t m_max_batch_size;
+    unsigned m_max_in_flight;
+    std::vector<std::string> m_deleted_keys;
+};
+
+/// \brief 记录mock server收到的DeleteObjects请求
+class MockDeleteRecorder {
+public:
+    static MockDeleteRecorder& Instance() {
+        static MockDeleteRecorder s_recorder;
+        return s_recorder;
+    }
+
+    void Reset() {
+        SimpleMutexLocker locker(&m_mutex);
+        m_in_flight = 0;
+        m_stat = MockDeleteStat();
+    }
+
+    MockDeleteStat GetStat() {
+        SimpleMutexLocker locker(&m_mutex);
+        return m_stat;
+    }
+
+    void Begin(size_t batch_size) {
+        SimpleMutexLocker locker(&m_mutex);
+        ++m_stat.m_requests;
+        ++m_in_flight;
+        m_stat.m_max_in_flight = std::max(m_stat.m_max_in_flight, m_in_flight);
+        m_stat.m_max_batch_size = std::max(m_stat.m_max_batch_size, batch_size);
+    }
+
+    void End(const std::vector<std::string>& deleted_keys) {
+        SimpleMutexLocker locker(&m_mutex);
+        --m_in_flight;
+        m_stat.m_deleted_keys.insert(m_stat.m_deleted_keys.end(),
+                                     deleted_keys.begin(), deleted_keys.end());
+    }
+
+private:
+    MockDeleteRecorder() : m_in_flight(0) {}
+
+private:
+    SimpleMutex m_mutex;
+    unsigned m_in_flight;
+    MockDeleteStat m_stat;
+};
+
+// 请求处理结束时通知故障注入器, 用于统计同时处理中的请求数
+class MockFinishGuard {
+public:
+    ~MockFinishGuard() { MockFaultInjector::Instance().Finish(); }
+};
 
 class MockRequestHandler : public Poco::Net::HTTPRequestHandler {
 public:
     virtual void handleRequest(Poco::Net::HTTPServerRequest& req,
                                Poco::Net::HTTPServerResponse& resp) {
         try {
+            m_fault = MockFaultInjector::Instance().Decide(req.getMethod() == "GET");
+            MockFinishGuard finish_guard;
+            if (m_fault.m_latency_ms > 0) {
+                Poco::Thread::sleep(m_fault.m_latency_ms);
+            }
+            if (m_fault.m_is_error) {
+                handleFaultErrorRequest(req, resp);
+                return;
+            }
+
             std::string host = req.getHost();
             std::string method = req.getMethod();
             std::string uri = req.getURI();
@@ -91,7 +405,9 @@ public:
                     handleGetObjectRequest(req, resp);
                 }
             } else if ("POST" == method) {
-                if (uri.find("uploads") != std::string::npos) {
+                if (StringUtil::StringStartsWith(uri, "/?delete")) {
+                    handleDeleteObjectsRequest(req, resp);
+                } else if (uri.find("uploads") != std::string::npos) {
                     handleInitMultiUploadRequest(req, resp);
                 } else if (uri.find("uploadId") != std::string::npos) {
                     handleCompMultiUploadRequest(req, resp);
@@ -120,6 +436,9 @@ public:
                     handleAbortMultiUploadRequest(req, resp);
                 }
             }
+        } catch (const MockConnectionResetException& ex) {
+            // 交给Poco关闭连接
+            throw;
         } catch (const Poco::NotFoundException& ex) {
             std::cout << "exception" << std::endl;
         } catch (const std::exception& ex) {
@@ -128,6 +447,71 @@ public:
     }
 
 private:
+    // 按照故障决策发送响应体: 限速、中途断开或者停顿
+    void sendBody(std::ostream& out, const std::string& body) {
+        const MockFaultConfig& config = MockFaultInjector::Instance().GetConfig();
+        size_t total = body.size();
+        if (m_fault.m_is_reset) {
+            total = body.size() / 2;
+        }
+
+        const size_t kChunkSize = 4096;
+        size_t offset = 0;
+        // 按从pace_start起累计发送的字节数计算截止时间, 避免每个分块的等待时间被截断为0
+        Poco::Timestamp pace_start;
+        size_t pace_offset = 0;
+        while (offset < total) {
+            if (m_fault.m_is_stall && offset >= body.size() / 2) {
+                out.flush();
+                Poco::Thread::sleep(config.m_stall_ms);
+                m_fault.m_is_stall = false;
+                pace_start.update();
+                pace_offset = offset;
+            }
+
+            size_t len = MIN(kChunkSize, total - offset);
+            out.write(body.data() + offset, len);
+            offset += len;
+            if (config.m_bandwidth_bytes_per_s > 0) {
+                out.flush();
+                Poco::Timestamp::TimeDiff deadline_us = static_cast<Poco::Timestamp::TimeDiff>(
+                    (offset - pace_offset) * 1000000ULL / config.m_bandwidth_bytes_per_s);
+                Poco::Timestamp::TimeDiff elapsed_us = pace_start.elapsed();
+                if (deadline_us > elapsed_us) {
+                    usleep(static_cast<useconds_t>(deadline_us - elapsed_us));
+                }
+            }
+        }
+        out.flush();
+
+        if (m_fault.m_is_reset) {
+            throw MockConnectionResetException();
+        }
+    }
+
+    void handleFaultErrorRequest(Poco::Net::HTTPServerRequest& req,
+                                 Poco::Net::HTTPServerResponse& resp) {
+        // 有body的请求先读完, 免得client SIGPIPE
+        std::istream& is = req.stream();
+        std::fstream ofs("/dev/null");
+        Poco::StreamCopier::copyStream(is, ofs);
+
+        bool is_slow_down = MockFaultInjector::Instance().GetConfig().m_is_slow_down;
+        resp.setStatus(is_slow_down ? Poco::Net::HTTPResponse::HTTP_SERVICE_UNAVAILABLE
+                                    : Poco::Net::HTTPResponse::HTTP_INTERNAL_SERVER_ERROR);
+        resp.setContentType("application/xml");
+        resp.add("Server", kMockServerName);
+        resp.add("x-cos-request-id", kMockFaultReqId);
+        std::ostream& out = resp.send();
+        out << "<Error>\n"
+            << "<Code>" << (is_slow_down ? "SlowDown" : "InternalError") << "</Code>\n"
+            << "<Message>mock fault injected</Message>\n"
+            << "<Resource>" << req.getURI() << "</Resource>\n"
+            << "<RequestId>" << kMockFaultReqId << "</RequestId>\n"
+            << "<TraceId>mock_fault_trace_id</TraceId>\n"
+            << "</Error>";
+        out.flush();
+    }
 
     bool resolveHost(const std::string& host, std::string* region,
                      std::string* bucket_name, uint64_t* app_id) {
@@ -186,9 +570,27 @@ private:
 
     void handleHeadObjectRequest(Poco::Net::HTTPServerRequest& req,
                                  Poco::Net::HTTPServerResponse& resp) {
+        if (req.getURI().find(kMockMissingKeyword) != std::string::npos) {
+            resp.setStatus(Poco::Net::HTTPResponse::HTTP_NOT_FOUND);
+            resp.add("Server", kMockServerName);
+            resp.add("x-cos-request-id", kMockHeadReqId);
+            resp.setContentLength(0);
+            std::ostream& out = resp.send();
+            out.flush();
+            return;
+        }
+        std::string etag = kMockHeadETag;
+        if (req.getURI().find(kMockExistingKeyword) != std::string::npos) {
+            Poco::MD5Engine md5;
+            md5.update(MockGetObjectContent());
+            etag = Poco::DigestEngine::digestToHex(md5.digest());
+        }
+        if (sendNotModified(req, resp, etag)) {
+            return;
+        }
         resp.setStatus(Poco::Net::HTTPResponse::HTTP_OK);
         resp.setContentType(kMockHeadContentType);
-        resp.add("ETag", kMockHeadETag);
+        resp.add("ETag", "\"" + etag + "\"");
         resp.add("Server", kMockServerName);
         resp.add("Last-Modified", kMockLastModified);
         resp.add("x-cos-object-type", kMockObjectTypeNormal);
@@ -198,33 +600,77 @@ private:
         out.flush();
     }
 
+    // 与COS一样ETag带双引号, If-None-Match为带引号的etag(可有"W/"前缀)时返回304
+    bool sendNotModified(Poco::Net::HTTPServerRequest& req, Poco::Net::HTTPServerResponse& resp,
+                         const std::string& etag) {
+        if (!req.has("If-None-Match")) {
+            return false;
+        }
+        std::string if_none_match = req.get("If-None-Match");
+        if (StringUtil::StringStartsWith(if_none_match, "W/")) {
+            if_none_match.erase(0, 2);
+        }
+        if (if_none_match != "\"" + etag + "\"") {
+            return false;
+        }
+        resp.setStatus(Poco::Net::HTTPResponse::HTTP_NOT_MODIFIED);
+        resp.add("ETag", "\"" + etag + "\"");
+        resp.add("Server", kMockServerName);
+        resp.setContentLength(0);
+        std::ostream& out = resp.send();
+        out.flush();
+        return true;
+    }
+
     void handleGetObjectRequest(Poco::Net::HTTPServerRequest& req,
                                 Poco::Net::HTTPServerResponse& resp) {
+        std::string body = MockGetObjectContent();
+        std::string etag = kMockGetObjectETag;
+        if (req.getURI().find(kMockExistingKeyword) != std::string::npos) {
+            Poco::MD5Engine md5;
+            md5.update(body);
+            etag = Poco::DigestEngine::digestToHex(md5.digest());
+        }
+        if (sendNotModified(req, resp, etag)) {
+            return;
+        }
         resp.setStatus(Poco::Net::HTTPResponse::HTTP_OK);
+        // 支持"bytes=start-end"格式的Range
+        unsigned long start = 0;
+        unsigned long end = 0;
+        if (req.has("Range")
+            && sscanf(req.get("Range").c_str(), "bytes=%lu-%lu", &start, &end) == 2
+            && start <= end && start < body.size()) {
+            end = MIN(end, body.size() - 1);
+            body = body.substr(start, end - start + 1);
+            resp.setStatus(Poco::Net::HTTPResponse::HTTP_PARTIAL_CONTENT);
+        }
         resp.setContentType(kMockGetObjectContentType);
-        resp.add("ETag", kMockGetObjectETag);
+        resp.add("ETag", "\"" + etag + "\"");
         resp.add("Server", kMockServerName);
         resp.add("x-cos-storage-class", kStorageClassStandardIA);
         resp.add("x-cos-object-type", kMockObjectTypeNormal);
         resp.add("x-cos-request-id", kMockGetObjectReqId);
+        resp.setContentLength(body.size());
         std::ostream& out = resp.send();
-        for (int i = 0; i < 1024; ++i) {
-            std::string temp(1024, 'a');
-            out << temp;
-        }
-        out.flush();
+        sendBody(out, body);
+    }
+
+    // 读取请求体并返回其md5
+    static std::string ReceiveBodyMd5(Poco::Net::HTTPServerRequest& req) {
+        Poco::MD5Engine md5;
+        Poco::DigestOutputStream dos(md5);
+        Poco::StreamCopier::copyStream(req.stream(), dos);
+        dos.close();
+        return Poco::DigestEngine::digestToHex(md5.digest());
     }
 
     void handlePutObjectRequest(Poco::Net::HTTPServerRequest& req,
                                 Poco::Net::HTTPServerResponse& resp) {
-        // 象征性接收一下,免得client SIGPIPE
-        std::istream& is = req.stream();
-        std::fstream ofs("/dev/null");
-        Poco::StreamCopier::copyStream(is, ofs, req.getContentLength());
-
+        // 与COS一样以请求体的md5作为ETag, 供SDK校验上传的数据
         resp.setStatus(Poco::Net::HTTPResponse::HTTP_OK);
         resp.setContentType(kMockPutObjectContentType);
-        resp.add("ETag", kMockPutObjectETag);
+        resp.add("ETag", "\"" + ReceiveBodyMd5(req) + "\"");
         resp.add("Server", kMockServerName);
         std::ostream& out = resp.send();
         out.flush();
@@ -248,14 +694,9 @@ private:
 
     void handleUploadPartRequest(Poco::Net::HTTPServerRequest& req,
                                  Poco::Net::HTTPServerResponse& resp) {
-        // 象征性接收一下,免得client SIGPIPE
-        std::istream& is = req.stream();
-        std::fstream ofs("/dev/null");
-        Poco::StreamCopier::copyStream(is, ofs, req.getContentLength());
-
         resp.setStatus(Poco::Net::HTTPResponse::HTTP_OK);
         resp.setContentType(kMockUploadPartContentType);
-        resp.add("ETag", kMockUploadPartETag);
+        resp.add("ETag", "\"" + ReceiveBodyMd5(req) + "\"");
         resp.add("Server", kMockServerName);
         resp.add("x-cos-request-id", kMockUploadPartReqId);
         std::ostream& out = resp.send();
@@ -288,8 +729,207 @@ private:
         out.flush();
     }
 
+    // 按请求体中的Key逐个删除, 停顿一段时间以便观察并发度
+    void handleDeleteObjectsRequest(Poco::Net::HTTPServerRequest& req,
+                                    Poco::Net::HTTPServerResponse& resp) {
+        std::string body;
+        Poco::StreamCopier::copyToString(req.stream(), body);
+        bool is_quiet = body.find("<Quiet>true</Quiet>") != std::string::npos;
+
+        std::vector<std::string> keys;
+        size_t pos = body.find("<Key>");
+        while (pos != std::string::npos) {
+            size_t end = body.find("</Key>", pos);
+            std::string key = body.substr(pos + 5, end - pos - 5);
+            size_t amp = key.find("&amp;");
+            while (amp != std::string::npos) {
+                key.replace(amp, 5, "&");
+                amp = key.find("&amp;", amp + 1);
+            }
+            keys.push_back(key);
+            pos = body.find("<Key>", end);
+        }
+
+        MockDeleteRecorder::Instance().Begin(keys.size());
+        Poco::Thread::sleep(20);
+        std::vector<std::string> deleted_keys;
+        std::ostringstream result;
+        result << "<DeleteResult>\n";
+        for (size_t i = 0; i < keys.size(); ++i) {
+            if (keys[i].find(kMockDeleteFailKeyword) != std::string::npos) {
+                result << "<Error><Key>" << keys[i] << "</Key><Code>AccessDenied</Code>"
+                    << "<Message>Access Denied</Message></Error>\n";
+                continue;
+            }
+            deleted_keys.push_back(keys[i]);
+            if (!is_quiet) {
+                result << "<Deleted><Key>" << keys[i] << "</Key></Deleted>\n";
+            }
+        }
+        result << "</DeleteResult>";
+        MockDeleteRecorder::Instance().End(deleted_keys);
+
+        resp.setStatus(Poco::Net::HTTPResponse::HTTP_OK);
+        resp.setContentType(kMockCompleteContentType);
+        resp.add("Server", kMockServerName);
+        resp.add("x-cos-request-id", kMockDeleteObjectsReqId);
+        resp.setContentLength(result.str().size());
+        std::ostream& out = resp.send();
+        out << result.str();
+        out.flush();
+    }
+
+    static std::map<std::string, std::string> parseQuery(const std::string& uri) {
+        std::map<std::string, std::string> params;
+        size_t pos = uri.find('?');
+        while (pos != std::string::npos) {
+            size_t end = uri.find('&', pos + 1);
+            std::string part = uri.substr(pos + 1, end == std::string::npos
+                                          ? std::string::npos : end - pos - 1);
+            size_t eq = part.find('=');
+            std::string key, value;
+            Poco::URI::decode(part.substr(0, eq), key);
+            if (eq != std::string::npos) {
+                Poco::URI::decode(part.substr(eq + 1), value);
+            }
+            if (!key.empty()) {
+                params[key] = value;
+            }
+            pos = end;
+        }
+        return params;
+    }
+
+    // 按prefix/marker/delimiter/max-keys列出MockListKeys()
+    void handleListRequest(std::map<std::string, std::string>& params,
+                           Poco::Net::HTTPServerResponse& resp) {
+        const std::string& prefix = params["prefix"];
+        const std::string& marker = params["marker"];
+        const std::string& delimiter = params["delimiter"];
+        uint64_t max_keys = params.count("max-keys")
+            ? StringUtil::StringToUint64(params["max-keys"]) : 1000;
+
+        const std::vector<std::string>& keys = MockListKeys();
+        std::ostringstream contents;
+        std::ostringstream common_prefixes;
+        std::string last;
+        uint64_t count = 0;
+        bool is_truncated = false;
+        std::vector<std::string>::const_iterator itr
+            = std::upper_bound(keys.begin(), keys.end(), marker);
+        for (; itr != keys.end(); ++itr) {
+            const std::string& key = *itr;
+            if (!StringUtil::StringStartsWith(key, prefix)) {
+                continue;
+            }
+            std::string common_prefix;
+            if (!delimiter.empty()) {
+                size_t pos = key.find(delimiter, prefix.size());
+                if (pos != std::string::npos) {
+                    common_prefix = key.substr(0, pos + delimiter.size());
+                }
+            }
+            if (!common_prefix.empty() && (common_prefix == last || common_prefix <= marker)) {
+                continue;
+            }
+            if (count == max_keys) {
+                is_truncated = true;
+                break;
+            }
+            ++count;
+            if (!common_prefix.empty()) {
+                common_prefixes << "<CommonPrefixes><Prefix>" << common_prefix
+                    << "</Prefix></CommonPrefixes>\n";
+                last = common_prefix;
+            } else {
+                contents << "<Contents>\n"
+                    << "<Key>" << key << "</Key>\n"
+                    << "<LastModified>2017-06-23T12:33:26.000Z</LastModified>\n"
+                    << "<ETag>&quot;39bfb88c11c65ed6424d2e1cd4db1826&quot;</ETag>\n"
+                    << "<Size>" << (itr - keys.begin() + 1) << "</Size>\n"
+                    << "<Owner><ID>77777</ID></Owner>\n"
+                    << "<StorageClass>STANDARD</StorageClass>\n"
+                    << "</Contents>\n";
+                last = key;
+            }
+        }
+
+        std::ostringstream body;
+        body << "<ListBucketResult>\n"
+            << "<Name>bucket_test</Name>\n"
+            << "<Prefix>" << prefix << "</Prefix>\n"
+            << "<Marker>" << marker << "</Marker>\n"
+            << "<MaxKeys>" << max_keys << "</MaxKeys>\n"
+            << "<Delimiter>" << delimiter << "</Delimiter>\n"
+            << "<IsTruncated>" << (is_truncated ? "true" : "false") << "</IsTruncated>\n";
+        if (is_truncated) {
+            body << "<NextMarker>" << last << "</NextMarker>\n";
+        }
+        body << contents.str() << common_prefixes.str() << "</ListBucketResult>";
+
+        resp.setStatus(Poco::Net::HTTPResponse::HTTP_OK);
+        resp.setContentType(kMockCompleteContentType);
+        resp.add("Server", kMockServerName);
+        resp.add("x-cos-request-id", kMockListReqId);
+        resp.setContentLength(body.str().size());
+        std::ostream& out = resp.send();
+        sendBody(out, body.str());
+    }
+
+    // 一次列出MockDownloadKeys()中匹配prefix的key
+    void handleDownloadListRequest(std::map<std::string, std::string>& params,
+                                   Poco::Net::HTTPServerResponse& resp) {
+        const std::string& prefix = params["prefix"];
+        Poco::MD5Engine md5;
+        md5.update(MockGetObjectContent());
+        std::string etag = Poco::DigestEngine::digestToHex(md5.digest());
+
+        std::ostringstream body;
+        body << "<ListBucketResult>\n"
+            << "<Name>bucket_test</Name>\n"
+            << "<Prefix>" << prefix << "</Prefix>\n"
+            << "<Marker>" << params["marker"] << "</Marker>\n"
+            << "<MaxKeys>1000</MaxKeys>\n"
+            << "<IsTruncated>false</IsTruncated>\n";
+        const std::vector<std::string>& keys = MockDownloadKeys();
+        for (std::vector<std::string>::const_iterator itr = keys.begin();
+             itr != keys.end(); ++itr) {
+            if (!StringUtil::StringStartsWith(*itr, prefix)) {
+                continue;
+            }
+            bool is_dir = StringUtil::StringEndsWith(*itr, "/");
+            body << "<Contents>\n"
+                << "<Key>" << *itr << "</Key>\n"
+                << "<LastModified>2017-06-23T12:33:26.000Z</LastModified>\n"
+                << "<ETag>&quot;" << etag << "&quot;</ETag>\n"
+                << "<Size>" << (is_dir ? 0 : kMockGetObjectSize) << "</Size>\n"
+                << "<Owner><ID>77777</ID></Owner>\n"
+                << "<StorageClass>STANDARD</StorageClass>\n"
+                << "</Contents>\n";
+        }
+        body << "</ListBucketResult>";
+
+        resp.setStatus(Poco::Net::HTTPResponse::HTTP_OK);
+        resp.setContentType(kMockCompleteContentType);
+        resp.add("Server", kMockServerName);
+        resp.add("x-cos-request-id", kMockListReqId);
+        resp.setContentLength(body.str().size());
+        std::ostream& out = resp.send();
+        sendBody(out, body.str());
+    }
+
     void handleGetBucketRequest(Poco::Net::HTTPServerRequest& req,
                                 Poco::Net::HTTPServerResponse& resp) {
+        std::map<std::string, std::string> params = parseQuery(req.getURI());
+        if (StringUtil::StringStartsWith(params["prefix"], kMockListPrefix)) {
+            handleListRequest(params, resp);
+            return;
+        }
+        if (StringUtil::StringStartsWith(params["prefix"], kMockDownloadPrefix)) {
+            handleDownloadListRequest(params, resp);
+            return;
+        }
+
         resp.setStatus(Poco::Net::HTTPResponse::HTTP_OK);
         resp.setContentType(kMockCompleteContentType);
         resp.add("Server", kMockServerName);
@@ -384,6 +1024,9 @@ private:
         std::ostream& out = resp.send();
         out.flush();
     }
+
+private:
+    MockFaultDecision m_fault;
 };
 
 class MockRequestHandlerFactory : public Poco::Net::HTTPRequestHandlerFactory {
@@ -394,5 +1037,50 @@ public:
     }
 };
 
+/// \brief 在本地端口上启动mock server, 配合CosSysConfig::SetDestDomain使用
+class MockServer {
+public:
+    /// \param port 监听端口, 0表示由系统分配
+    /// \param keep_alive_timeout_in_ms 空闲长连接在服务端保持的时长, 0表示使用Poco的默认值
+    explicit MockServer(unsigned short port = 0, uint64_t keep_alive_timeout_in_ms = 0)
+        : m_socket(port), m_server(new MockRequestHandlerFactory(), m_socket,
+                                   NewParams(keep_alive_timeout_in_ms)) {
+    }
+
+    ~MockServer() {
+        Stop();
+    }
+
+    void Start() {
+        m_server.start();
+    }
+
+    void Stop() {
+        m_server.stopAll(true);
+    }
+
+    unsigned short GetPort() const {
+        return m_socket.address().port();
+    }
+
+    /// \brief 返回可用于SetDestDomain的地址, 如127.0.0.1:8080
+    std::string GetDestDomain() const {
+        return "127.0.0.1:" + StringUtil::IntToString(GetPort());
+    }
+
+private:
+    static Poco::Net::HTTPServerParams* NewParams(uint64_t keep_alive_timeout_in_ms) {
+        Poco::Net::HTTPServerParams* params = new Poco::Net::HTTPServerParams();
+        if (keep_alive_timeout_in_ms > 0) {
+            params->setKeepAliveTimeout(Poco::Timespan(0, keep_alive_timeout_in_ms * 1000));
+        }
+        return params;
+    }
+
+private:
+    Poco::Net::ServerSocket m_socket;
+    Poco::Net::HTTPServer m_server;
+};
+
 } // namespace qcloud_cos
 #endif
@@ -0,0 +1,1631 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: 基于本地mock server的故障注入测试, 无需访问真实的COS服务
+
+#include "gtest/gtest.h"
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <vector>
+
+#include "boost/bind.hpp"
+#include "boost/thread/thread.hpp"
+
+#include "cos_api.h"
+#include "cos_sys_config.h"
+#include "mock_server.h"
+#include "util/file_util.h"
+#include "util/http_sender.h"
+#include "util/http_session_pool.h"
+#include "util/rate_limiter.h"
+#include "util/request_scheduler.h"
+
+namespace qcloud_cos {
+
+class MockServerTest : public testing::Test {
+protected:
+    static void SetUpTestCase() {
+        m_server = new MockServer();
+        m_server->Start();
+        CosSysConfig::SetDestDomain(m_server->GetDestDomain());
+        m_config = new CosConfig(7777, "access_key_test", "secret_key_test", "cn-north");
+        // 故障注入用例默认关闭重试, 以便观察单次请求的结果
+        RetryPolicy no_retry;
+        no_retry.SetMaxRetryTimes(0);
+        m_config->SetRetryPolicy(no_retry);
+        m_client = new CosAPI(*m_config);
+    }
+
+    static void TearDownTestCase() {
+        MockFaultInjector::Instance().Reset();
+        CosSysConfig::SetDestDomain("");
+        delete m_client;
+        delete m_config;
+        delete m_server;
+    }
+
+    virtual void TearDown() {
+        MockFaultInjector::Instance().Reset();
+        MockDeleteRecorder::Instance().Reset();
+    }
+
+    // 返回本次请求的耗时, 单位毫秒
+    static uint64_t TimedHeadObject(CosResult* result) {
+        HeadObjectReq req(m_bucket_name, "object_test");
+        HeadObjectResp resp;
+        uint64_t start = HttpSender::GetTimeStampInUs();
+        *result = m_client->HeadObject(req, &resp);
+        return (HttpSender::GetTimeStampInUs() - start) / 1000;
+    }
+
+    static void GetObjectContent(CosAPI* client, const std::string& object_name,
+                                 std::string* content) {
+        std::ostringstream os;
+        GetObjectByStreamReq req(m_bucket_name, object_name, os);
+        GetObjectByStreamResp resp;
+        if (client->GetObject(req, &resp).IsSucc()) {
+            *content = os.str();
+        }
+    }
+
+    static void HeadObjectEtag(CosAPI* client, const std::string& object_name,
+                               std::string* etag) {
+        HeadObjectReq req(m_bucket_name, object_name);
+        HeadObjectResp resp;
+        if (client->HeadObject(req, &resp).IsSucc()) {
+            *etag = resp.GetEtag();
+        }
+    }
+
+    static void CancelAfter(SharedCancelToken cancel_token, unsigned delay_in_ms) {
+        usleep(delay_in_ms * 1000);
+        cancel_token->Cancel();
+    }
+
+    // 记录并发列出的结果, 收到m_stop_after条记录后要求停止
+    class CollectHandler : public ListObjectsHandler {
+    public:
+        CollectHandler() : m_stop_after(0) {}
+
+        virtual bool OnEntry(const BucketObjectEntry& entry) {
+            SimpleMutexLocker locker(&m_mutex);
+            m_keys.push_back(entry.m_key);
+            return m_stop_after == 0 || m_keys.size() < m_stop_after;
+        }
+
+        SimpleMutex m_mutex;
+        std::vector<std::string> m_keys;
+        size_t m_stop_after;
+    };
+
+    // 记录目录上传的回调次数和最大的已结束文件数
+    class UploadProgressHandler : public UploadDirectoryHandler {
+    public:
+        UploadProgressHandler() : m_calls(0), m_max_done(0), m_skipped(0) {}
+
+        virtual void OnFileDone(const std::string& /* local_path */,
+                                const std::string& /* object_name */,
+                                const CosResult& /* result */, bool is_skipped,
+                                const UploadDirectoryProgress& progress) {
+            SimpleMutexLocker locker(&m_mutex);
+            ++m_calls;
+            m_max_done = std::max(m_max_done, progress.m_done_count);
+            if (is_skipped) {
+                ++m_skipped;
+            }
+        }
+
+        SimpleMutex m_mutex;
+        uint64_t m_calls;
+        uint64_t m_max_done;
+        uint64_t m_skipped;
+    };
+
+    // 记录按前缀下载的回调次数和跳过的Object数
+    class DownloadProgressHandler : public DownloadPrefixHandler {
+    public:
+        DownloadProgressHandler() : m_calls(0), m_skipped(0), m_is_list_done(false) {}
+
+        virtual void OnObjectDone(const std::string& /* object_name */,
+                                  const std::string& /* local_path */,
+                                  const CosResult& /* result */, bool is_skipped,
+                                  const DownloadPrefixProgress& progress) {
+            SimpleMutexLocker locker(&m_mutex);
+            ++m_calls;
+            if (is_skipped) {
+                ++m_skipped;
+            }
+            m_is_list_done = progress.m_is_list_done;
+        }
+
+        SimpleMutex m_mutex;
+        uint64_t m_calls;
+        uint64_t m_skipped;
+        bool m_is_list_done;
+    };
+
+    static void WriteLocalFile(const std::string& path, const std::string& content) {
+        std::ofstream ofs(path.c_str(), std::ios::out | std::ios::binary);
+        ofs << content;
+    }
+
+    // 目录中名称含有下载临时文件后缀的文件数
+    static unsigned CountTempFiles(const std::string& dir) {
+        unsigned count = 0;
+        DIR* d = opendir(dir.c_str());
+        if (d == NULL) {
+            return 0;
+        }
+        struct dirent* ent = NULL;
+        while ((ent = readdir(d)) != NULL) {
+            if (std::string(ent->d_name).find(".cos_tmp") != std::string::npos) {
+                ++count;
+            }
+        }
+        closedir(d);
+        return count;
+    }
+
+protected:
+    static MockServer* m_server;
+    static CosConfig* m_config;
+    static CosAPI* m_client;
+    static std::string m_bucket_name;
+};
+
+MockServer* MockServerTest::m_server = NULL;
+CosConfig* MockServerTest::m_config = NULL;
+CosAPI* MockServerTest::m_client = NULL;
+std::string MockServerTest::m_bucket_name = "bucket_test-7777";
+
+TEST_F(MockServerTest, NoFaultTest) {
+    CosResult result;
+    TimedHeadObject(&result);
+    EXPECT_TRUE(result.IsSucc());
+    EXPECT_EQ(kMockHeadReqId, result.GetXCosRequestId());
+}
+
+TEST_F(MockServerTest, SlowDownBurstTest) {
+    MockFaultConfig config;
+    config.m_seed = 7;
+    config.m_error_ratio = 0.2;
+    config.m_error_burst_len = 3;
+    MockFaultInjector::Instance().SetConfig(config);
+
+    // 每次触发错误后连续3个请求都返回503, 连续失败的次数是3的倍数
+    const size_t kRequestNum = 60;
+    std::vector<bool> is_errors;
+    for (size_t i = 0; i < kRequestNum; ++i) {
+        CosResult result;
+        TimedHeadObject(&result);
+        if (!result.IsSucc()) {
+            EXPECT_EQ(503, result.GetHttpStatus());
+        }
+        is_errors.push_back(!result.IsSucc());
+    }
+    uint64_t error_num = 0;
+    uint64_t burst_num = 0;
+    size_t run_len = 0;
+    for (size_t i = 0; i <= kRequestNum; ++i) {
+        if (i < kRequestNum && is_errors[i]) {
+            ++run_len;
+            ++error_num;
+            continue;
+        }
+        // 最后一段可能被请求数截断
+        if (run_len > 0 && i < kRequestNum) {
+            EXPECT_EQ(0u, run_len % 3) << "burst ends at " << i;
+            ++burst_num;
+        }
+        run_len = 0;
+    }
+    EXPECT_GT(burst_num, 0u);
+    EXPECT_LT(error_num, static_cast<uint64_t>(kRequestNum));
+    EXPECT_EQ(error_num, MockFaultInjector::Instance().GetStat().m_errors);
+
+    // 503的错误码为SlowDown
+    config.m_error_ratio = 1.0;
+    MockFaultInjector::Instance().SetConfig(config);
+    std::ostringstream os;
+    GetObjectByStreamReq req(m_bucket_name, "object_test", os);
+    GetObjectByStreamResp resp;
+    CosResult result = m_client->GetObject(req, &resp);
+    EXPECT_FALSE(result.IsSucc());
+    EXPECT_EQ(503, result.GetHttpStatus());
+    EXPECT_EQ("SlowDown", result.GetErrorCode());
+}
+
+TEST_F(MockServerTest, InternalErrorTest) {
+    MockFaultConfig config;
+    config.m_error_ratio = 1.0;
+    config.m_is_slow_down = false;
+    MockFaultInjector::Instance().SetConfig(config);
+
+    CosResult result;
+    TimedHeadObject(&result);
+    EXPECT_FALSE(result.IsSucc());
+    EXPECT_EQ(500, result.GetHttpStatus());
+}
+
+TEST_F(MockServerTest, LatencyTest) {
+    MockFaultConfig config;
+    config.m_min_latency_ms = 100;
+    config.m_max_latency_ms = 150;
+    MockFaultInjector::Instance().SetConfig(config);
+
+    CosResult result;
+    uint64_t cost_ms = TimedHeadObject(&result);
+    EXPECT_TRUE(result.IsSucc());
+    EXPECT_GE(cost_ms, 100u);
+}
+
+TEST_F(MockServerTest, BandwidthLimitTest) {
+    MockFaultConfig config;
+    config.m_bandwidth_bytes_per_s = 4 * 1024 * 1024;
+    MockFaultInjector::Instance().SetConfig(config);
+
+    std::ostringstream os;
+    GetObjectByStreamReq req(m_bucket_name, "object_test", os);
+    GetObjectByStreamResp resp;
+    uint64_t start = HttpSender::GetTimeStampInUs();
+    CosResult result = m_client->GetObject(req, &resp);
+    uint64_t cost_ms = (HttpSender::GetTimeStampInUs() - start) / 1000;
+    EXPECT_TRUE(result.IsSucc());
+    EXPECT_EQ(kMockGetObjectSize, os.str().size());
+    // 1M数据按4M/s发送至少需要250ms
+    EXPECT_GE(cost_ms, 200u);
+}
+
+TEST_F(MockServerTest, ConnectionResetTest) {
+    MockFaultConfig config;
+    config.m_reset_ratio = 1.0;
+    MockFaultInjector::Instance().SetConfig(config);
+
+    std::ostringstream os;
+    GetObjectByStreamReq req(m_bucket_name, "object_test", os);
+    GetObjectByStreamResp resp;
+    CosResult result = m_client->GetObject(req, &resp);
+    // 连接在发送一半响应体后被断开, 无论请求是否返回失败, 都不可能拿到完整的body
+    EXPECT_LT(os.str().size(), kMockGetObjectSize);
+    EXPECT_EQ(1u, MockFaultInjector::Instance().GetStat().m_resets);
+}
+
+TEST_F(MockServerTest, StallTest) {
+    MockFaultConfig config;
+    config.m_stall_ratio = 1.0;
+    config.m_stall_ms = 1500;
+    MockFaultInjector::Instance().SetConfig(config);
+
+    std::ostringstream os;
+    GetObjectByStreamReq req(m_bucket_name, "object_test", os);
+    req.SetRecvTimeoutInms(300);
+    GetObjectByStreamResp resp;
+    CosResult result = m_client->GetObject(req, &resp);
+    EXPECT_FALSE(result.IsSucc());
+    EXPECT_EQ(-1, result.GetHttpStatus());
+}
+
+TEST_F(MockServerTest, RetrySlowDownTest) {
+    MockFaultConfig config;
+    config.m_error_ratio = 1.0;
+    config.m_max_errors = 2;
+    MockFaultInjector::Instance().SetConfig(config);
+
+    CosConfig retry_config(7777, "access_key_test", "secret_key_test", "cn-north");
+    RetryPolicy policy;
+    policy.SetBaseDelayInms(10);
+    retry_config.SetRetryPolicy(policy);
+    CosAPI client(retry_config);
+
+    HeadObjectReq req(m_bucket_name, "object_test");
+    HeadObjectResp resp;
+    CosResult result = client.HeadObject(req, &resp);
+    EXPECT_TRUE(result.IsSucc());
+    EXPECT_EQ(3u, MockFaultInjector::Instance().GetStat().m_requests);
+}
+
+TEST_F(MockServerTest, RetryStreamDownloadTest) {
+    MockFaultConfig config;
+    config.m_reset_ratio = 1.0;
+    config.m_max_resets = 1;
+    MockFaultInjector::Instance().SetConfig(config);
+
+    CosConfig retry_config(7777, "access_key_test", "secret_key_test", "cn-north");
+    RetryPolicy policy;
+    policy.SetBaseDelayInms(10);
+    retry_config.SetRetryPolicy(policy);
+    CosAPI client(retry_config);
+
+    // 第一次请求连接被重置后恢复正常, 重试时输出流需回退到起始位置
+    std::ostringstream os;
+    GetObjectByStreamReq req(m_bucket_name, "object_test", os);
+    GetObjectByStreamResp resp;
+    CosResult result = client.GetObject(req, &resp);
+    EXPECT_TRUE(result.IsSucc());
+    EXPECT_EQ(kMockGetObjectSize, os.str().size());
+    EXPECT_EQ(1u, MockFaultInjector::Instance().GetStat().m_resets);
+    EXPECT_EQ(2u, MockFaultInjector::Instance().GetStat().m_requests);
+}
+
+TEST_F(MockServerTest, StreamGetBucketTest) {
+    GetBucketReq req(m_bucket_name);
+    GetBucketResp resp;
+    CosResult result = m_client->GetBucket(req, &resp);
+    ASSERT_TRUE(result.IsSucc());
+    // 列表结果边接收边解析, 不保留原始响应体
+    EXPECT_TRUE(resp.GetBody().empty());
+    EXPECT_EQ("bucket_test", resp.GetName());
+    EXPECT_EQ(100u, resp.GetMaxKeys());
+    EXPECT_FALSE(resp.IsTruncated());
+
+    const std::vector<Content>& contents = resp.GetContents();
+    ASSERT_EQ(2u, contents.size());
+    EXPECT_EQ("sevenyoutest01", contents[0].m_key);
+    EXPECT_EQ(10485760u, contents[0].m_size);
+    EXPECT_EQ(1498221206u, contents[0].m_last_modified_time);
+    ASSERT_EQ(1u, contents[0].m_owner_ids.size());
+    EXPECT_EQ("77777", contents[0].m_owner_ids[0]);
+    EXPECT_EQ(4u, contents[1].m_size);
+}
+
+TEST_F(MockServerTest, BucketObjectIteratorTest) {
+    GetBucketReq req(m_bucket_name);
+    req.SetPrefix(kMockListPrefix);
+    req.SetMaxKeys(300);
+    SharedBucketObjectIterator iter = m_client->GetBucketObjectIterator(req);
+
+    const std::vector<std::string>& keys = MockListKeys();
+    BucketObjectEntry entry;
+    size_t count = 0;
+    while (iter->Next(&entry)) {
+        ASSERT_LT(count, keys.size());
+        EXPECT_FALSE(entry.m_is_common_prefix);
+        EXPECT_EQ(keys[count], entry.m_key);
+        EXPECT_EQ(count + 1, entry.m_size);
+        EXPECT_EQ("39bfb88c11c65ed6424d2e1cd4db1826", entry.m_etag);
+        ++count;
+    }
+    EXPECT_FALSE(iter->IsError());
+    EXPECT_EQ(keys.size(), count);
+    EXPECT_EQ(9u, iter->GetPageCount());
+}
+
+TEST_F(MockServerTest, BucketObjectIteratorDelimiterTest) {
+    GetBucketReq req(m_bucket_name);
+    req.SetPrefix(kMockListPrefix);
+    req.SetDelimiter("/");
+    req.SetMaxKeys(4);
+    // 不预取, 在Next()中同步翻页
+    SharedBucketObjectIterator iter = m_client->GetBucketObjectIterator(req, 0);
+
+    BucketObjectEntry entry;
+    std::vector<std::string> prefixes;
+    while (iter->Next(&entry)) {
+        EXPECT_TRUE(entry.m_is_common_prefix);
+        prefixes.push_back(entry.m_key);
+    }
+    EXPECT_FALSE(iter->IsError());
+    ASSERT_EQ(kMockListDirCount, prefixes.size());
+    EXPECT_EQ("list/d0/", prefixes[0]);
+    EXPECT_EQ("list/d9/", prefixes[9]);
+    EXPECT_EQ(3u, iter->GetPageCount());
+}
+
+TEST_F(MockServerTest, BucketObjectIteratorPrefetchTest) {
+    MockFaultConfig config;
+    config.m_min_latency_ms = 100;
+    config.m_max_latency_ms = 100;
+    MockFaultInjector::Instance().SetConfig(config);
+
+    GetBucketReq req(m_bucket_name);
+    req.SetPrefix(kMockListPrefix);
+    req.SetMaxKeys(kMockListKeysPerDir);
+    SharedBucketObjectIterator iter = m_client->GetBucketObjectIterator(req, 2);
+
+    // 每页处理100ms, 不预取时总耗时约为10 * (100 + 100)ms
+    uint64_t start = HttpSender::GetTimeStampInUs();
+    BucketObjectEntry entry;
+    size_t count = 0;
+    while (iter->Next(&entry)) {
+        if (++count % kMockListKeysPerDir == 0) {
+            usleep(100 * 1000);
+        }
+    }
+    uint64_t cost_ms = (HttpSender::GetTimeStampInUs() - start) / 1000;
+    EXPECT_FALSE(iter->IsError());
+    EXPECT_EQ(MockListKeys().size(), count);
+    EXPECT_LT(cost_ms, 1700u);
+}
+
+TEST_F(MockServerTest, BucketObjectIteratorRetryTest) {
+    MockFaultConfig config;
+    config.m_reset_ratio = 1.0;
+    config.m_max_resets = 1;
+    MockFaultInjector::Instance().SetConfig(config);
+
+    CosConfig retry_config(7777, "access_key_test", "secret_key_test", "cn-north");
+    RetryPolicy policy;
+    policy.SetBaseDelayInms(10);
+    retry_config.SetRetryPolicy(policy);
+    CosAPI client(retry_config);
+
+    // 第一页传输一半时连接被重置, 重试时丢弃已解析的部分
+    GetBucketReq req(m_bucket_name);
+    req.SetPrefix(kMockListPrefix);
+    SharedBucketObjectIterator iter = client.GetBucketObjectIterator(req);
+    BucketObjectEntry entry;
+    size_t count = 0;
+    while (iter->Next(&entry)) {
+        ++count;
+    }
+    EXPECT_FALSE(iter->IsError());
+    EXPECT_EQ(MockListKeys().size(), count);
+    EXPECT_EQ(1u, MockFaultInjector::Instance().GetStat().m_resets);
+}
+
+TEST_F(MockServerTest, BucketObjectIteratorDestroyTest) {
+    MockFaultConfig config;
+    config.m_min_latency_ms = 3000;
+    config.m_max_latency_ms = 3000;
+    MockFaultInjector::Instance().SetConfig(config);
+
+    // 析构时取消后台正在进行的请求
+    uint64_t start = HttpSender::GetTimeStampInUs();
+    {
+        GetBucketReq req(m_bucket_name);
+        req.SetPrefix(kMockListPrefix);
+        SharedBucketObjectIterator iter = m_client->GetBucketObjectIterator(req);
+        usleep(100 * 1000);
+    }
+    EXPECT_LT((HttpSender::GetTimeStampInUs() - start) / 1000, 1500u);
+}
+
+TEST_F(MockServerTest, ParallelListOrderedTest) {
+    ParallelListObjectsReq req(m_bucket_name);
+    req.SetPrefix(kMockListPrefix);
+    req.SetMaxKeys(100);
+    req.SetThreadNum(4);
+    CollectHandler handler;
+    ParallelListObjectsResp resp;
+    CosResult result = m_client->ParallelListObjects(req, &handler, &resp);
+    ASSERT_TRUE(result.IsSucc());
+    // 以"/"发现的10个目录作为边界, 共11个分片
+    EXPECT_EQ(kMockListDirCount + 1, resp.GetShardCount());
+    EXPECT_EQ(MockListKeys().size(), resp.GetEntryCount());
+    EXPECT_TRUE(MockListKeys() == handler.m_keys);
+}
+
+TEST_F(MockServerTest, ParallelListUnorderedTest) {
+    ParallelListObjectsReq req(m_bucket_name);
+    req.SetPrefix(kMockListPrefix);
+    req.SetDiscoverDelimiter("");
+    req.AddSplitPoint("list/d7/");
+    req.AddSplitPoint("list/d3/k00100");
+    req.SetOrdered(false);
+    CollectHandler handler;
+    ParallelListObjectsResp resp;
+    CosResult result = m_client->ParallelListObjects(req, &handler, &resp);
+    ASSERT_TRUE(result.IsSucc());
+    EXPECT_EQ(3u, resp.GetShardCount());
+    std::sort(handler.m_keys.begin(), handler.m_keys.end());
+    EXPECT_TRUE(MockListKeys() == handler.m_keys);
+}
+
+TEST_F(MockServerTest, ParallelListStopTest) {
+    ParallelListObjectsReq req(m_bucket_name);
+    req.SetPrefix(kMockListPrefix);
+    CollectHandler handler;
+    handler.m_stop_after = 100;
+    ParallelListObjectsResp resp;
+    CosResult result = m_client->ParallelListObjects(req, &handler, &resp);
+    EXPECT_TRUE(result.IsSucc());
+    ASSERT_EQ(100u, handler.m_keys.size());
+    EXPECT_EQ(MockListKeys()[99], handler.m_keys[99]);
+}
+
+TEST_F(MockServerTest, ParallelListScaleTest) {
+    MockFaultConfig config;
+    config.m_min_latency_ms = 50;
+    config.m_max_latency_ms = 50;
+    MockFaultInjector::Instance().SetConfig(config);
+
+    // 串行列出需要25页, 约1250ms; 分片后每个分片3页
+    ParallelListObjectsReq req(m_bucket_name);
+    req.SetPrefix(kMockListPrefix);
+    req.SetMaxKeys(100);
+    req.SetThreadNum(kMockListDirCount);
+    CollectHandler handler;
+    ParallelListObjectsResp resp;
+    uint64_t start = HttpSender::GetTimeStampInUs();
+    CosResult result = m_client->ParallelListObjects(req, &handler, &resp);
+    uint64_t cost_ms = (HttpSender::GetTimeStampInUs() - start) / 1000;
+    ASSERT_TRUE(result.IsSucc());
+    EXPECT_EQ(MockListKeys().size(), handler.m_keys.size());
+    EXPECT_LT(cost_ms, 800u);
+}
+
+TEST_F(MockServerTest, ParallelListErrorTest) {
+    MockFaultConfig config;
+    config.m_error_ratio = 1.0;
+    MockFaultInjector::Instance().SetConfig(config);
+
+    ParallelListObjectsReq req(m_bucket_name);
+    req.SetPrefix(kMockListPrefix);
+    CollectHandler handler;
+    ParallelListObjectsResp resp;
+    CosResult result = m_client->ParallelListObjects(req, &handler, &resp);
+    EXPECT_FALSE(result.IsSucc());
+    EXPECT_EQ(503, result.GetHttpStatus());
+}
+
+TEST_F(MockServerTest, BulkDeleteTest) {
+    MockDeleteRecorder::Instance().Reset();
+    BulkDeleteReq req(m_bucket_name);
+    req.SetThreadNum(4);
+    std::vector<std::string> expected;
+    for (unsigned i = 0; i < 2500; ++i) {
+        char key[32];
+        snprintf(key, sizeof(key), i % 1000 == 7 ? "bulk/fail%04u" : "bulk/a&b%04u", i);
+        req.AddObject(key);
+        if (i % 1000 != 7) {
+            expected.push_back(key);
+        }
+    }
+    BulkDeleteResp resp;
+    CosResult result = m_client->BulkDelete(req, &resp);
+    ASSERT_TRUE(result.IsSucc());
+    EXPECT_EQ(2497u, resp.GetDeletedCount());
+    EXPECT_EQ(3u, resp.GetBatchCount());
+    EXPECT_EQ(0u, resp.GetFailedBatchCount());
+    ASSERT_EQ(3u, resp.GetErrorInfos().size());
+    EXPECT_EQ("AccessDenied", resp.GetErrorInfos()[0].m_code);
+
+    MockDeleteStat stat = MockDeleteRecorder::Instance().GetStat();
+    EXPECT_EQ(3u, stat.m_requests);
+    EXPECT_EQ(1000u, stat.m_max_batch_size);
+    EXPECT_GT(stat.m_max_in_flight, 1u);
+    EXPECT_LE(stat.m_max_in_flight, 4u);
+    std::sort(stat.m_deleted_keys.begin(), stat.m_deleted_keys.end());
+    EXPECT_EQ(expected, stat.m_deleted_keys);
+}
+
+TEST_F(MockServerTest, BulkDeleteScalingTest) {
+    // 每个批次只复制本批的key, 耗时随key数线性增长
+    uint64_t cost_ms[2];
+    const unsigned key_nums[2] = {10000, 100000};
+    for (int round = 0; round < 2; ++round) {
+        MockDeleteRecorder::Instance().Reset();
+        BulkDeleteReq req(m_bucket_name);
+        req.SetThreadNum(8);
+        for (unsigned i = 0; i < key_nums[round]; ++i) {
+            char key[48];
+            snprintf(key, sizeof(key), "bulk/scaling_test_key_%08u", i);
+            req.AddObject(key);
+        }
+        BulkDeleteResp resp;
+        uint64_t start = HttpSender::GetTimeStampInUs();
+        CosResult result = m_client->BulkDelete(req, &resp);
+        cost_ms[round] = (HttpSender::GetTimeStampInUs() - start) / 1000;
+        ASSERT_TRUE(result.IsSucc());
+        EXPECT_EQ(key_nums[round], resp.GetDeletedCount());
+        EXPECT_EQ(key_nums[round] / 1000, resp.GetBatchCount());
+    }
+    // key数增加10倍, 线性时耗时约增加10倍, 每批复制全部key时约增加100倍
+    EXPECT_LT(cost_ms[1], cost_ms[0] * 30 + 500) << cost_ms[0] << " " << cost_ms[1];
+}
+
+TEST_F(MockServerTest, DeleteObjectsByPrefixTest) {
+    MockDeleteRecorder::Instance().Reset();
+    BulkDeleteReq req(m_bucket_name);
+    req.SetBatchSize(300);
+    req.SetThreadNum(3);
+    BulkDeleteResp resp;
+    CosResult result = m_client->DeleteObjectsByPrefix(req, kMockListPrefix, &resp);
+    ASSERT_TRUE(result.IsSucc());
+    EXPECT_EQ(MockListKeys().size(), resp.GetDeletedCount());
+    EXPECT_EQ(9u, resp.GetBatchCount());
+
+    MockDeleteStat stat = MockDeleteRecorder::Instance().GetStat();
+    EXPECT_EQ(300u, stat.m_max_batch_size);
+    EXPECT_LE(stat.m_max_in_flight, 3u);
+    std::sort(stat.m_deleted_keys.begin(), stat.m_deleted_keys.end());
+    EXPECT_EQ(MockListKeys(), stat.m_deleted_keys);
+
+    // 不允许以空前缀删除整个Bucket
+    result = m_client->DeleteObjectsByPrefix(req, "", &resp);
+    EXPECT_FALSE(result.IsSucc());
+}
+
+TEST_F(MockServerTest, BulkDeleteErrorTest) {
+    MockFaultConfig config;
+    config.m_error_ratio = 1.0;
+    MockFaultInjector::Instance().SetConfig(config);
+
+    // 第一个批次失败后不再发出新的批次
+    BulkDeleteReq req(m_bucket_name);
+    req.SetThreadNum(1);
+    for (unsigned i = 0; i < 2500; ++i) {
+        req.AddObject("bulk/" + StringUtil::IntToString(i));
+    }
+    BulkDeleteResp resp;
+    CosResult result = m_client->BulkDelete(req, &resp);
+    EXPECT_FALSE(result.IsSucc());
+    EXPECT_EQ(503, result.GetHttpStatus());
+    EXPECT_EQ(1u, resp.GetBatchCount());
+    EXPECT_EQ(1u, resp.GetFailedBatchCount());
+    EXPECT_EQ(0u, resp.GetDeletedCount());
+    EXPECT_EQ(1000u, resp.GetErrorInfos().size());
+}
+
+TEST_F(MockServerTest, BatchHeadObjectTest) {
+    BatchHeadObjectReq req(m_bucket_name);
+    req.SetThreadNum(8);
+    for (unsigned i = 0; i < 40; ++i) {
+        char key[32];
+        snprintf(key, sizeof(key), i % 4 == 3 ? "head/missing%02u" : "head/k%02u", i);
+        req.AddObject(key);
+    }
+    BatchHeadObjectResp resp;
+    CosResult result = m_client->BatchHeadObject(req, &resp);
+    ASSERT_TRUE(result.IsSucc());
+    const std::vector<HeadObjectResult>& results = resp.GetResults();
+    ASSERT_EQ(40u, results.size());
+    for (unsigned i = 0; i < 40; ++i) {
+        if (i % 4 == 3) {
+            EXPECT_FALSE(results[i].m_exists);
+            EXPECT_EQ(404, results[i].m_http_status);
+            EXPECT_FALSE(results[i].IsError());
+        } else {
+            EXPECT_TRUE(results[i].m_exists);
+            EXPECT_EQ(1048576u, results[i].m_size);
+            EXPECT_EQ(kMockHeadETag, results[i].m_etag);
+            EXPECT_EQ(1500712929u, results[i].m_last_modified_time);
+        }
+    }
+    EXPECT_EQ(0u, resp.GetCacheHitCount());
+}
+
+TEST_F(MockServerTest, BatchHeadObjectNegativeCacheTest) {
+    BatchHeadObjectReq req(m_bucket_name);
+    req.AddObject("head/cache_missing");
+    req.AddObject("head/cache_k");
+    req.SetNegativeCacheTtlInms(60000);
+    BatchHeadObjectResp resp;
+    ASSERT_TRUE(m_client->BatchHeadObject(req, &resp).IsSucc());
+    EXPECT_EQ(0u, resp.GetCacheHitCount());
+
+    // 第二次检查时不存在的Object不再发出请求
+    MockFaultInjector::Instance().Reset();
+    ASSERT_TRUE(m_client->BatchHeadObject(req, &resp).IsSucc());
+    EXPECT_EQ(1u, resp.GetCacheHitCount());
+    EXPECT_EQ(1u, MockFaultInjector::Instance().GetStat().m_requests);
+    EXPECT_FALSE(resp.GetResults()[0].m_exists);
+    EXPECT_EQ(0, resp.GetResults()[0].m_http_status);
+    EXPECT_TRUE(resp.GetResults()[1].m_exists);
+
+    // 写入后缓存失效
+    std::istringstream iss("content");
+    PutObjectByStreamReq put_req(m_bucket_name, "head/cache_missing", iss);
+    PutObjectByStreamResp put_resp;
+    m_client->PutObject(put_req, &put_resp);
+    ASSERT_TRUE(m_client->BatchHeadObject(req, &resp).IsSucc());
+    EXPECT_EQ(0u, resp.GetCacheHitCount());
+}
+
+TEST_F(MockServerTest, MetaCacheTest) {
+    CosConfig config(*m_config);
+    MetaCachePolicy policy;
+    policy.SetCapacity(100);
+    policy.SetTtlInms(100);
+    config.SetMetaCachePolicy(policy);
+    CosAPI client(config);
+
+    HeadObjectReq req(m_bucket_name, "meta/a");
+    HeadObjectResp resp;
+    ASSERT_TRUE(client.HeadObject(req, &resp).IsSucc());
+
+    // 有效期内不发出请求
+    MockFaultInjector::Instance().Reset();
+    HeadObjectResp cached_resp;
+    CosResult result = client.HeadObject(req, &cached_resp);
+    ASSERT_TRUE(result.IsSucc());
+    EXPECT_EQ(0u, MockFaultInjector::Instance().GetStat().m_requests);
+    EXPECT_EQ(kMockHeadETag, cached_resp.GetEtag());
+    EXPECT_EQ(1048576u, cached_resp.GetContentLength());
+
+    // 过期后服务端返回304, 继续使用缓存
+    usleep(150 * 1000);
+    result = client.HeadObject(req, &cached_resp);
+    ASSERT_TRUE(result.IsSucc());
+    EXPECT_EQ(200, result.GetHttpStatus());
+    EXPECT_EQ(1u, MockFaultInjector::Instance().GetStat().m_requests);
+    EXPECT_EQ(kMockHeadETag, cached_resp.GetEtag());
+
+    // 删除后缓存失效
+    DeleteObjectReq del_req(m_bucket_name, "meta/a");
+    DeleteObjectResp del_resp;
+    client.DeleteObject(del_req, &del_resp);
+    MockFaultInjector::Instance().Reset();
+    ASSERT_TRUE(client.HeadObject(req, &cached_resp).IsSucc());
+    EXPECT_EQ(1u, MockFaultInjector::Instance().GetStat().m_requests);
+
+    ObjectMetaCacheStat stat = client.GetObjectMetaCacheStat();
+    EXPECT_EQ(1u, stat.m_hits);
+    EXPECT_EQ(3u, stat.m_misses);
+    EXPECT_EQ(1u, stat.m_revalidations);
+    EXPECT_EQ(0u, m_client->GetObjectMetaCacheStat().m_hits);
+}
+
+// 与删除并发的HeadObject在删除前读到的元数据不留在缓存中
+TEST_F(MockServerTest, MetaCacheConcurrentWriteTest) {
+    CosConfig config(*m_config);
+    MetaCachePolicy policy;
+    policy.SetCapacity(100);
+    policy.SetTtlInms(60 * 1000);
+    config.SetMetaCachePolicy(policy);
+    CosAPI client(config);
+
+    // 只延迟第一个请求(HeadObject), 删除在其返回前完成
+    MockFaultConfig fault_config;
+    fault_config.m_tail_latency_ratio = 1.0;
+    fault_config.m_tail_latency_ms = 300;
+    fault_config.m_max_tail_latencies = 1;
+    MockFaultInjector::Instance().SetConfig(fault_config);
+    std::string etag;
+    boost::thread head_thread(boost::bind(&HeadObjectEtag, &client, "meta/race", &etag));
+    usleep(100 * 1000);
+    DeleteObjectReq del_req(m_bucket_name, "meta/race");
+    DeleteObjectResp del_resp;
+    client.DeleteObject(del_req, &del_resp);
+    head_thread.join();
+    EXPECT_EQ(kMockHeadETag, etag);
+
+    MockFaultInjector::Instance().Reset();
+    HeadObjectReq req(m_bucket_name, "meta/race");
+    HeadObjectResp resp;
+    ASSERT_TRUE(client.HeadObject(req, &resp).IsSucc());
+    EXPECT_EQ(1u, MockFaultInjector::Instance().GetStat().m_requests);
+    EXPECT_EQ(0u, client.GetObjectMetaCacheStat().m_hits);
+}
+
+TEST_F(MockServerTest, MetaCacheConditionalGetTest) {
+    CosConfig config(*m_config);
+    MetaCachePolicy policy;
+    policy.SetCapacity(100);
+    policy.SetTtlInms(60000);
+    config.SetMetaCachePolicy(policy);
+    CosAPI client(config);
+
+    std::ostringstream os;
+    GetObjectByStreamReq req(m_bucket_name, "meta/get", os);
+    GetObjectByStreamResp resp;
+    ASSERT_TRUE(client.GetObject(req, &resp).IsSucc());
+
+    // 携带一致的If-None-Match时直接返回304, 与RFC 7232一样ETag带引号
+    MockFaultInjector::Instance().Reset();
+    std::ostringstream cond_os;
+    GetObjectByStreamReq cond_req(m_bucket_name, "meta/get", cond_os);
+    cond_req.AddHeader("If-None-Match", "\"" + kMockGetObjectETag + "\"");
+    GetObjectByStreamResp cond_resp;
+    CosResult result = client.GetObject(cond_req, &cond_resp);
+    EXPECT_FALSE(result.IsSucc());
+    EXPECT_EQ(304, result.GetHttpStatus());
+    EXPECT_EQ(0u, MockFaultInjector::Instance().GetStat().m_requests);
+    EXPECT_EQ(kMockGetObjectETag, cond_resp.GetEtag());
+    EXPECT_TRUE(cond_os.str().empty());
+
+    // 弱校验前缀和多个ETag的列表同样命中缓存
+    GetObjectByStreamReq weak_req(m_bucket_name, "meta/get", cond_os);
+    weak_req.AddHeader("If-None-Match", "\"other\", W/\"" + kMockGetObjectETag + "\"");
+    GetObjectByStreamResp weak_resp;
+    EXPECT_EQ(304, client.GetObject(weak_req, &weak_resp).GetHttpStatus());
+    EXPECT_EQ(0u, MockFaultInjector::Instance().GetStat().m_requests);
+
+    // 不一致时发出请求
+    GetObjectByStreamReq mismatch_req(m_bucket_name, "meta/get", cond_os);
+    mismatch_req.AddHeader("If-None-Match", "\"other\"");
+    GetObjectByStreamResp mismatch_resp;
+    EXPECT_TRUE(client.GetObject(mismatch_req, &mismatch_resp).IsSucc());
+    EXPECT_EQ(1u, MockFaultInjector::Instance().GetStat().m_requests);
+    EXPECT_EQ(MockGetObjectContent(), cond_os.str());
+
+    // GET写入的元数据可供HeadObject使用
+    HeadObjectReq head_req(m_bucket_name, "meta/get");
+    HeadObjectResp head_resp;
+    ASSERT_TRUE(client.HeadObject(head_req, &head_resp).IsSucc());
+    EXPECT_EQ(1u, MockFaultInjector::Instance().GetStat().m_requests);
+    EXPECT_EQ(kMockGetObjectETag, head_resp.GetEtag());
+}
+
+TEST_F(MockServerTest, DiskCacheTest) {
+    char cache_dir[] = "/tmp/cos_mock_disk_cache_XXXXXX";
+    ASSERT_TRUE(mkdtemp(cache_dir) != NULL);
+    CosConfig config(*m_config);
+    DiskCachePolicy policy;
+    policy.SetCacheDir(cache_dir);
+    config.SetDiskCachePolicy(policy);
+    CosAPI client(config);
+
+    std::string content;
+    GetObjectContent(&client, "disk/a", &content);
+    ASSERT_EQ(MockGetObjectContent(), content);
+
+    // 再次读取时条件请求返回304, 从本地文件读取, 返回填充时的响应头
+    MockFaultInjector::Instance().Reset();
+    std::ostringstream revalidate_os;
+    GetObjectByStreamReq revalidate_req(m_bucket_name, "disk/a", revalidate_os);
+    GetObjectByStreamResp revalidate_resp;
+    ASSERT_TRUE(client.GetObject(revalidate_req, &revalidate_resp).IsSucc());
+    EXPECT_EQ(MockGetObjectContent(), revalidate_os.str());
+    EXPECT_EQ(1u, MockFaultInjector::Instance().GetStat().m_requests);
+    EXPECT_EQ(kMockGetObjectETag, revalidate_resp.GetEtag());
+    EXPECT_EQ(kMockGetObjectSize, revalidate_resp.GetContentLength());
+    EXPECT_EQ(kMockGetObjectContentType, revalidate_resp.GetContentType());
+    std::map<std::string, std::string> resp_headers = revalidate_resp.GetHeaders();
+    EXPECT_EQ(kStorageClassStandardIA, resp_headers["x-cos-storage-class"]);
+
+    // 并发读取同一个Object只下载一次
+    MockFaultConfig fault_config;
+    fault_config.m_min_latency_ms = 100;
+    MockFaultInjector::Instance().SetConfig(fault_config);
+    std::vector<std::string> contents(4);
+    boost::thread_group threads;
+    for (size_t i = 0; i < contents.size(); ++i) {
+        threads.create_thread(boost::bind(&GetObjectContent, &client, "disk/b", &contents[i]));
+    }
+    threads.join_all();
+    EXPECT_EQ(1u, MockFaultInjector::Instance().GetStat().m_requests);
+    for (size_t i = 0; i < contents.size(); ++i) {
+        EXPECT_EQ(MockGetObjectContent(), contents[i]);
+    }
+
+    DiskCacheStat stat = client.GetDiskCacheStat();
+    EXPECT_EQ(2u, stat.m_misses);
+    EXPECT_EQ(1u, stat.m_revalidations);
+    EXPECT_EQ(3u, stat.m_fill_waits);
+    EXPECT_EQ(2u, stat.m_entries);
+
+    // 新鲜期内不发出请求
+    policy.SetCacheDir(std::string(cache_dir) + "/fresh");
+    policy.SetFreshInms(60000);
+    config.SetDiskCachePolicy(policy);
+    CosAPI fresh_client(config);
+    GetObjectContent(&fresh_client, "disk/a", &content);
+    MockFaultInjector::Instance().Reset();
+    content.clear();
+    GetObjectContent(&fresh_client, "disk/a", &content);
+    EXPECT_EQ(MockGetObjectContent(), content);
+    EXPECT_EQ(0u, MockFaultInjector::Instance().GetStat().m_requests);
+    EXPECT_EQ(1u, fresh_client.GetDiskCacheStat().m_hits);
+
+    // 新鲜期内命中同样返回填充时的响应头
+    std::ostringstream hit_os;
+    GetObjectByStreamReq hit_req(m_bucket_name, "disk/a", hit_os);
+    GetObjectByStreamResp hit_resp;
+    ASSERT_TRUE(fresh_client.GetObject(hit_req, &hit_resp).IsSucc());
+    EXPECT_EQ(kMockGetObjectSize, hit_resp.GetContentLength());
+    EXPECT_EQ(kMockGetObjectContentType, hit_resp.GetContentType());
+    EXPECT_EQ(kMockGetObjectReqId, hit_resp.GetXCosRequestId());
+    resp_headers = hit_resp.GetHeaders();
+    EXPECT_EQ(kStorageClassStandardIA, resp_headers["x-cos-storage-class"]);
+
+    std::string cmd = std::string("rm -rf ") + cache_dir;
+    system(cmd.c_str());
+}
+
+TEST_F(MockServerTest, SingleFlightTest) {
+    CosConfig config(*m_config);
+    SingleFlightPolicy policy;
+    policy.SetEnable(true);
+    config.SetSingleFlightPolicy(policy);
+    CosAPI client(config);
+
+    // 同时发出的相同请求只发出一次
+    MockFaultConfig fault_config;
+    fault_config.m_min_latency_ms = 100;
+    MockFaultInjector::Instance().SetConfig(fault_config);
+    std::vector<std::string> etags(4);
+    std::vector<std::string> contents(4);
+    boost::thread_group threads;
+    for (size_t i = 0; i < etags.size(); ++i) {
+        threads.create_thread(boost::bind(&HeadObjectEtag, &client, "flight/a", &etags[i]));
+        threads.create_thread(boost::bind(&GetObjectContent, &client, "flight/a", &contents[i]));
+    }
+    threads.join_all();
+    EXPECT_EQ(2u, MockFaultInjector::Instance().GetStat().m_requests);
+    for (size_t i = 0; i < etags.size(); ++i) {
+        EXPECT_EQ(kMockHeadETag, etags[i]);
+        EXPECT_EQ(MockGetObjectContent(), contents[i]);
+    }
+    SingleFlightStat stat = client.GetSingleFlightStat();
+    EXPECT_EQ(2u, stat.m_leaders);
+    EXPECT_EQ(6u, stat.m_shared);
+
+    // 响应体超过暂存上限时等待方各自下载
+    policy.SetMaxSharedBytes(1024);
+    config.SetSingleFlightPolicy(policy);
+    CosAPI small_client(config);
+    MockFaultInjector::Instance().SetConfig(fault_config);
+    boost::thread_group small_threads;
+    for (size_t i = 0; i < contents.size(); ++i) {
+        contents[i].clear();
+        small_threads.create_thread(boost::bind(&GetObjectContent, &small_client, "flight/b",
+                                                &contents[i]));
+    }
+    small_threads.join_all();
+    EXPECT_EQ(contents.size(), MockFaultInjector::Instance().GetStat().m_requests);
+    for (size_t i = 0; i < contents.size(); ++i) {
+        EXPECT_EQ(MockGetObjectContent(), contents[i]);
+    }
+    // 发起方超过上限后放弃合并, 之后到达的请求可能成为新的发起方
+    SingleFlightStat small_stat = small_client.GetSingleFlightStat();
+    EXPECT_EQ(0u, small_stat.m_shared);
+    EXPECT_EQ(contents.size(), small_stat.m_leaders + small_stat.m_fallbacks);
+}
+
+TEST_F(MockServerTest, ClientSettingsTest) {
+    // 两个CosAPI使用不同的超时和域名, 互不影响
+    CosConfig fast_config(*m_config);
+    ClientSettings fast_settings;
+    fast_settings.SetRecvTimeoutInms(100);
+    fast_config.SetClientSettings(fast_settings);
+    CosAPI fast_client(fast_config);
+
+    CosConfig other_config(*m_config);
+    ClientSettings other_settings;
+    other_settings.SetConnTimeoutInms(200);
+    other_settings.SetDestDomain("127.0.0.1:1");
+    other_config.SetClientSettings(other_settings);
+    CosAPI other_client(other_config);
+
+    MockFaultConfig fault_config;
+    fault_config.m_min_latency_ms = 300;
+    MockFaultInjector::Instance().SetConfig(fault_config);
+    HeadObjectReq req(m_bucket_name, "settings/a");
+    HeadObjectResp resp;
+    EXPECT_FALSE(fast_client.HeadObject(req, &resp).IsSucc());
+    EXPECT_TRUE(m_client->HeadObject(req, &resp).IsSucc());
+
+    // 请求设置的超时优先于实例配置
+    HeadObjectReq slow_req(m_bucket_name, "settings/a");
+    slow_req.SetRecvTimeoutInms(5000);
+    EXPECT_TRUE(fast_client.HeadObject(slow_req, &resp).IsSucc());
+
+    MockFaultInjector::Instance().Reset();
+    EXPECT_FALSE(other_client.HeadObject(req, &resp).IsSucc());
+    EXPECT_EQ(0u, MockFaultInjector::Instance().GetStat().m_requests);
+    EXPECT_TRUE(m_client->HeadObject(req, &resp).IsSucc());
+    EXPECT_EQ(m_server->GetDestDomain(), CosSysConfig::GetDestDomain());
+}
+
+TEST_F(MockServerTest, KeepAliveReuseTest) {
+    CosSysConfig::SetKeepAlive(true);
+    HttpSessionPool::Instance().Clear();
+    HttpSessionPoolStat before = HttpSessionPool::Instance().GetStat();
+    for (unsigned i = 0; i < 5; ++i) {
+        CosResult result;
+        TimedHeadObject(&result);
+        EXPECT_TRUE(result.IsSucc());
+    }
+    HttpSessionPoolStat after = HttpSessionPool::Instance().GetStat();
+    CosSysConfig::SetKeepAlive(false);
+    HttpSessionPool::Instance().Clear();
+    EXPECT_EQ(before.m_created + 1, after.m_created);
+    EXPECT_EQ(before.m_reused + 4, after.m_reused);
+}
+
+TEST_F(MockServerTest, WarmUpTest) {
+    EXPECT_EQ(0u, m_client->WarmUp(m_bucket_name, 4));
+
+    CosSysConfig::SetKeepAlive(true);
+    HttpSessionPool::Instance().Clear();
+    HttpSessionPoolStat before = HttpSessionPool::Instance().GetStat();
+    EXPECT_EQ(4u, m_client->WarmUp(m_bucket_name, 4));
+    EXPECT_EQ(4u, HttpSessionPool::Instance().GetStat().m_idle);
+    for (unsigned i = 0; i < 4; ++i) {
+        CosResult result;
+        TimedHeadObject(&result);
+        EXPECT_TRUE(result.IsSucc());
+    }
+    HttpSessionPoolStat after = HttpSessionPool::Instance().GetStat();
+    CosSysConfig::SetKeepAlive(false);
+    HttpSessionPool::Instance().Clear();
+    EXPECT_EQ(before.m_warmed + 4, after.m_warmed);
+    EXPECT_EQ(before.m_created, after.m_created);
+    EXPECT_EQ(before.m_reused + 4, after.m_reused);
+}
+
+TEST_F(MockServerTest, KeepWarmTest) {
+    CosSysConfig::SetKeepAlive(true);
+    HttpSessionPool::Instance().Clear();
+    HttpSessionPool::Instance().SetKeepWarmIntervalInms(20);
+    m_client->KeepWarm(m_bucket_name, 3);
+    for (int i = 0; i < 100 && HttpSessionPool::Instance().GetStat().m_idle < 3; ++i) {
+        usleep(10 * 1000);
+    }
+    EXPECT_EQ(3u, HttpSessionPool::Instance().GetStat().m_idle);
+
+    // 取走的连接由后台线程补足
+    CosResult result;
+    TimedHeadObject(&result);
+    EXPECT_TRUE(result.IsSucc());
+    uint64_t warmed = HttpSessionPool::Instance().GetStat().m_warmed;
+    HttpSessionPool::Instance().Clear();
+    for (int i = 0; i < 100 && HttpSessionPool::Instance().GetStat().m_idle < 3; ++i) {
+        usleep(10 * 1000);
+    }
+    EXPECT_EQ(3u, HttpSessionPool::Instance().GetStat().m_idle);
+    EXPECT_LE(warmed + 3, HttpSessionPool::Instance().GetStat().m_warmed);
+
+    HttpSessionPool::Instance().StopKeepWarm();
+    HttpSessionPool::Instance().SetKeepWarmIntervalInms(kDefaultKeepWarmIntervalInms);
+    CosSysConfig::SetKeepAlive(false);
+    HttpSessionPool::Instance().Clear();
+}
+
+// 服务端关闭空闲长连接后, 复用该连接的POST在新连接上重新发送, 不需要SDK层的重试
+TEST_F(MockServerTest, StaleKeepAliveResendTest) {
+    MockServer server(0, 100);
+    server.Start();
+    CosSysConfig::SetDestDomain(server.GetDestDomain());
+    CosSysConfig::SetKeepAlive(true);
+    HttpSessionPool::Instance().Clear();
+    HttpSessionPoolStat before = HttpSessionPool::Instance().GetStat();
+
+    InitMultiUploadReq req(m_bucket_name, "object_test_multi");
+    InitMultiUploadResp resp;
+    EXPECT_TRUE(m_client->InitMultiUpload(req, &resp).IsSucc());
+    // 等待服务端关闭空闲连接, 连接仍留在客户端的连接池中
+    usleep(300 * 1000);
+    InitMultiUploadResp stale_resp;
+    CosResult result = m_client->InitMultiUpload(req, &stale_resp);
+    HttpSessionPoolStat after = HttpSessionPool::Instance().GetStat();
+
+    CosSysConfig::SetKeepAlive(false);
+    HttpSessionPool::Instance().Clear();
+    CosSysConfig::SetDestDomain(m_server->GetDestDomain());
+    EXPECT_TRUE(result.IsSucc()) << result.GetErrorInfo();
+    EXPECT_EQ(kMockUploadId, stale_resp.GetUploadId());
+    EXPECT_EQ(before.m_reused + 1, after.m_reused);
+    EXPECT_EQ(before.m_stale + 1, after.m_stale);
+}
+
+// 未开启全局长连接时BatchHeadObject的各请求仍然复用连接
+TEST_F(MockServerTest, BatchHeadObjectKeepAliveTest) {
+    HttpSessionPool::Instance().Clear();
+    HttpSessionPoolStat before = HttpSessionPool::Instance().GetStat();
+    BatchHeadObjectReq req(m_bucket_name);
+    req.SetThreadNum(2);
+    for (unsigned i = 0; i < 10; ++i) {
+        char key[32];
+        snprintf(key, sizeof(key), "head/k%02u", i);
+        req.AddObject(key);
+    }
+    BatchHeadObjectResp resp;
+    EXPECT_TRUE(m_client->BatchHeadObject(req, &resp).IsSucc());
+    HttpSessionPoolStat after = HttpSessionPool::Instance().GetStat();
+    HttpSessionPool::Instance().Clear();
+    EXPECT_LE(after.m_created - before.m_created, 2u);
+    EXPECT_LE(before.m_reused + 8, after.m_reused);
+}
+
+// 非TLS连接上文件通过sendfile发送, 服务端以请求体的md5作为ETag
+TEST_F(MockServerTest, UploadFileSendFileTest) {
+    std::string local_file = "./upload_sendfile_test.dat";
+    {
+        std::ofstream ofs(local_file.c_str(), std::ios::out | std::ios::binary);
+        for (unsigned i = 0; i < 2500 * 1024; ++i) {
+            ofs.put(static_cast<char>(i * 31 + i / 7));
+        }
+    }
+
+    PutObjectByFileReq req(m_bucket_name, "object_test", local_file);
+    req.SetIsCheckMd5(true);
+    PutObjectByFileResp resp;
+    CosResult result = m_client->PutObject(req, &resp);
+    EXPECT_TRUE(result.IsSucc());
+
+    // 按最小的1M分块, 最后一个分块不足1M
+    MultiUploadObjectReq multi_req(m_bucket_name, "object_test_multi", local_file);
+    multi_req.SetPartSize(1);
+    MultiUploadObjectResp multi_resp;
+    result = m_client->MultiUploadObject(multi_req, &multi_resp);
+    EXPECT_TRUE(result.IsSucc());
+    unlink(local_file.c_str());
+}
+
+// 开启下载MD5校验时边接收边计算MD5, 响应体完整写入输出流
+TEST_F(MockServerTest, CheckMd5DownloadTest) {
+    CosConfig config(*m_config);
+    ClientSettings settings;
+    settings.SetCheckMd5(true);
+    config.SetClientSettings(settings);
+    CosAPI client(config);
+
+    std::ostringstream os;
+    GetObjectByStreamReq req(m_bucket_name, "existing_object", os);
+    GetObjectByStreamResp resp;
+    CosResult result = client.GetObject(req, &resp);
+    ASSERT_TRUE(result.IsSucc());
+    EXPECT_EQ(MockGetObjectContent(), os.str());
+    EXPECT_EQ(1u, MockFaultInjector::Instance().GetStat().m_requests);
+
+    // ETag与响应体的MD5不一致时失败
+    std::ostringstream bad_os;
+    GetObjectByStreamReq bad_req(m_bucket_name, "object_test", bad_os);
+    GetObjectByStreamResp bad_resp;
+    EXPECT_FALSE(client.GetObject(bad_req, &bad_resp).IsSucc());
+}
+
+// 请求体超过阈值时先等待服务端的100 Continue再发送请求体
+TEST_F(MockServerTest, ExpectContinueTest) {
+    CosConfig config(*m_config);
+    ClientSettings settings;
+    settings.SetExpectContinueThreshold(1024);
+    config.SetClientSettings(settings);
+    CosAPI client(config);
+
+    std::string body(64 * 1024, 'x');
+    for (size_t i = 0; i < body.size(); ++i) {
+        body[i] = static_cast<char>(i * 13 + i / 5);
+    }
+    std::istringstream iss(body);
+    PutObjectByStreamReq req(m_bucket_name, "object_test", iss);
+    req.SetIsCheckMd5(true);
+    PutObjectByStreamResp resp;
+    EXPECT_TRUE(client.PutObject(req, &resp).IsSucc());
+
+    // 调用方显式设置的Expect头同样等待确认
+    std::istringstream small_iss(body.substr(0, 100));
+    PutObjectByStreamReq small_req(m_bucket_name, "object_test", small_iss);
+    small_req.SetExpect("100-continue");
+    small_req.SetIsCheckMd5(true);
+    EXPECT_TRUE(m_client->PutObject(small_req, &resp).IsSucc());
+}
+
+// 客户端限速: CosAPI实例级别限制上传, 请求级别限制下载, 分片下载的各分片共享请求的限速
+TEST_F(MockServerTest, RateLimitTest) {
+    CosConfig config(*m_config);
+    ClientSettings settings;
+    settings.SetUploadRateLimit(4 * 1024 * 1024);
+    config.SetClientSettings(settings);
+    CosAPI client(config);
+
+    std::string body(1024 * 1024, 'x');
+    std::istringstream iss(body);
+    PutObjectByStreamReq put_req(m_bucket_name, "object_test", iss);
+    put_req.SetTrafficLimit(8 * 1024 * 1024);
+    PutObjectByStreamResp put_resp;
+    uint64_t start = HttpSender::GetTimeStampInUs();
+    EXPECT_TRUE(client.PutObject(put_req, &put_resp).IsSucc());
+    uint64_t cost_ms = (HttpSender::GetTimeStampInUs() - start) / 1000;
+    EXPECT_GE(cost_ms, 200u);
+
+    std::ostringstream os;
+    GetObjectByStreamReq get_req(m_bucket_name, "object_test", os);
+    get_req.SetRateLimit(4 * 1024 * 1024);
+    GetObjectByStreamResp get_resp;
+    start = HttpSender::GetTimeStampInUs();
+    EXPECT_TRUE(m_client->GetObject(get_req, &get_resp).IsSucc());
+    cost_ms = (HttpSender::GetTimeStampInUs() - start) / 1000;
+    EXPECT_EQ(kMockGetObjectSize, os.str().size());
+    EXPECT_GE(cost_ms, 200u);
+
+    std::string local_file = "./rate_limit_test.dat";
+    MultiGetObjectReq multi_req(m_bucket_name, "object_test", local_file);
+    multi_req.SetSliceSize(256 * 1024);
+    multi_req.SetThreadPoolSize(4);
+    multi_req.SetRateLimit(4 * 1024 * 1024);
+    MultiGetObjectResp multi_resp;
+    start = HttpSender::GetTimeStampInUs();
+    EXPECT_TRUE(m_client->GetObject(multi_req, &multi_resp).IsSucc());
+    cost_ms = (HttpSender::GetTimeStampInUs() - start) / 1000;
+    EXPECT_GE(cost_ms, 200u);
+    unlink(local_file.c_str());
+}
+
+TEST_F(MockServerTest, RequestPriorityTest) {
+    RequestScheduler& scheduler = RequestScheduler::Instance();
+    scheduler.SetMaxConcurrency(2);
+    RequestSchedulerStat before = scheduler.GetStat();
+
+    // 并发上限小于分块线程数时, 分块请求排队获得许可, 下载结果不受影响
+    std::string local_file = "./request_priority_test.dat";
+    MultiGetObjectReq multi_req(m_bucket_name, "object_test", local_file);
+    multi_req.SetSliceSize(256 * 1024);
+    multi_req.SetThreadPoolSize(8);
+    multi_req.SetPriority(PRIORITY_BULK);
+    MultiGetObjectResp multi_resp;
+    EXPECT_TRUE(m_client->GetObject(multi_req, &multi_resp).IsSucc());
+    unlink(local_file.c_str());
+
+    HeadObjectReq head_req(m_bucket_name, "object_test");
+    head_req.SetPriority(PRIORITY_INTERACTIVE);
+    HeadObjectResp head_resp;
+    EXPECT_TRUE(m_client->HeadObject(head_req, &head_resp).IsSucc());
+    scheduler.SetMaxConcurrency(0);
+
+    RequestSchedulerStat after = scheduler.GetStat();
+    EXPECT_GT(after.m_admitted[PRIORITY_BULK], before.m_admitted[PRIORITY_BULK] + 1);
+    EXPECT_GT(after.m_admitted[PRIORITY_INTERACTIVE], before.m_admitted[PRIORITY_INTERACTIVE]);
+    EXPECT_EQ(before.m_running, after.m_running);
+}
+
+TEST_F(MockServerTest, UploadDirectoryTest) {
+    std::string local_dir = "./upload_dir_test";
+    mkdir(local_dir.c_str(), 0755);
+    mkdir((local_dir + "/sub").c_str(), 0755);
+    mkdir((local_dir + "/sub/deep").c_str(), 0755);
+    WriteLocalFile(local_dir + "/a.txt", std::string(100, 'a'));
+    WriteLocalFile(local_dir + "/sub/b.txt", std::string(200, 'b'));
+    WriteLocalFile(local_dir + "/sub/deep/missing_c.txt", "");
+    WriteLocalFile(local_dir + "/existing_d.dat", MockGetObjectContent());
+    WriteLocalFile(local_dir + "/sub/big.dat", std::string(2500 * 1024, 'x'));
+    // 指向目录的符号链接不进入, 避免循环
+    EXPECT_EQ(0, symlink("..", (local_dir + "/sub/loop").c_str()));
+    uint64_t total_bytes = 100 + 200 + kMockGetObjectSize + 2500 * 1024;
+
+    // big.dat超过阈值, 按1M分块上传
+    UploadDirectoryReq req(m_bucket_name, local_dir + "/", "dir/");
+    req.SetThreadNum(3);
+    req.SetMultipartThreshold(2 * 1024 * 1024);
+    req.SetPartSize(1024 * 1024);
+    req.SetPartThreadNum(2);
+    req.SetMemoryBudget(4 * 1024 * 1024);
+    // 加入延迟使请求重叠, 简单上传和分块共享ThreadNum个连接
+    MockFaultConfig latency_config;
+    latency_config.m_min_latency_ms = 20;
+    MockFaultInjector::Instance().SetConfig(latency_config);
+    UploadDirectoryResp resp;
+    UploadProgressHandler handler;
+    CosResult result = m_client->UploadDirectory(req, &handler, &resp);
+    EXPECT_LE(MockFaultInjector::Instance().GetStat().m_max_in_flight, 3u);
+    MockFaultInjector::Instance().Reset();
+    ASSERT_TRUE(result.IsSucc());
+    EXPECT_EQ(5u, resp.GetFileCount());
+    EXPECT_EQ(5u, resp.GetUploadedCount());
+    EXPECT_EQ(0u, resp.GetSkippedCount());
+    EXPECT_EQ(0u, resp.GetFailedCount());
+    EXPECT_EQ(total_bytes, resp.GetTotalBytes());
+    EXPECT_EQ(total_bytes, resp.GetUploadedBytes());
+    EXPECT_TRUE(resp.GetErrorInfos().empty());
+    EXPECT_EQ(5u, handler.m_calls);
+    EXPECT_EQ(5u, handler.m_max_done);
+
+    // 只有大小和MD5与远端一致的existing_d.dat被跳过
+    req.SetSkipExisting(true);
+    UploadDirectoryResp skip_resp;
+    UploadProgressHandler skip_handler;
+    result = m_client->UploadDirectory(req, &skip_handler, &skip_resp);
+    ASSERT_TRUE(result.IsSucc());
+    EXPECT_EQ(4u, skip_resp.GetUploadedCount());
+    EXPECT_EQ(1u, skip_resp.GetSkippedCount());
+    EXPECT_EQ(1u, skip_handler.m_skipped);
+    EXPECT_EQ(total_bytes - kMockGetObjectSize, skip_resp.GetUploadedBytes());
+
+    // 上传失败的文件记入错误信息, 不影响返回值
+    MockFaultConfig config;
+    config.m_error_ratio = 1.0;
+    MockFaultInjector::Instance().SetConfig(config);
+    UploadDirectoryReq fail_req(m_bucket_name, local_dir, "dir/");
+    UploadDirectoryResp fail_resp;
+    result = m_client->UploadDirectory(fail_req, &fail_resp);
+    EXPECT_TRUE(result.IsSucc());
+    EXPECT_EQ(5u, fail_resp.GetFailedCount());
+    ASSERT_EQ(5u, fail_resp.GetErrorInfos().size());
+    MockFaultInjector::Instance().Reset();
+
+    system(("rm -rf " + local_dir).c_str());
+
+    UploadDirectoryReq missing_req(m_bucket_name, local_dir, "dir/");
+    UploadDirectoryResp missing_resp;
+    EXPECT_FALSE(m_client->UploadDirectory(missing_req, &missing_resp).IsSucc());
+}
+
+TEST_F(MockServerTest, DownloadPrefixTest) {
+    std::string rel_path;
+    EXPECT_TRUE(PrefixDownloader::GetRelativePath("p/", "p/x/y", &rel_path));
+    EXPECT_EQ("x/y", rel_path);
+    EXPECT_TRUE(PrefixDownloader::GetRelativePath("p", "p/x/", &rel_path));
+    EXPECT_EQ("x", rel_path);
+    // 空段会与去掉空段后的Object映射到同一个本地路径
+    EXPECT_FALSE(PrefixDownloader::GetRelativePath("p/", "p//x/y", &rel_path));
+    EXPECT_FALSE(PrefixDownloader::GetRelativePath("p/", "p/x//y", &rel_path));
+    EXPECT_FALSE(PrefixDownloader::GetRelativePath("p", "p//x", &rel_path));
+    EXPECT_FALSE(PrefixDownloader::GetRelativePath("p/", "p/a/../b", &rel_path));
+    EXPECT_FALSE(PrefixDownloader::GetRelativePath("p/", "p/./b", &rel_path));
+    EXPECT_FALSE(PrefixDownloader::GetRelativePath("p/", "p/", &rel_path));
+
+    // 本地目录不存在时自动创建, x/../evil.dat无法映射到目录内, 记为失败
+    std::string local_dir = "./download_prefix_test/nested";
+    DownloadPrefixReq req(m_bucket_name, kMockDownloadPrefix, local_dir);
+    req.SetThreadNum(2);
+    req.SetMultiGetThreshold(512 * 1024);
+    req.SetSliceSize(256 * 1024);
+    req.SetSliceThreadNum(2);
+    req.SetMemoryBudget(1024 * 1024);
+    // 加入延迟使请求重叠, 分片下载的Object占满ThreadNum个连接
+    MockFaultConfig latency_config;
+    latency_config.m_min_latency_ms = 20;
+    MockFaultInjector::Instance().SetConfig(latency_config);
+    DownloadPrefixResp resp;
+    DownloadProgressHandler handler;
+    CosResult result = m_client->DownloadPrefix(req, &handler, &resp);
+    EXPECT_LE(MockFaultInjector::Instance().GetStat().m_max_in_flight, 2u);
+    MockFaultInjector::Instance().Reset();
+    ASSERT_TRUE(result.IsSucc());
+    EXPECT_EQ(4u, resp.GetObjectCount());
+    EXPECT_EQ(3u, resp.GetDownloadedCount());
+    EXPECT_EQ(0u, resp.GetSkippedCount());
+    EXPECT_EQ(1u, resp.GetFailedCount());
+    EXPECT_EQ(4 * kMockGetObjectSize, resp.GetTotalBytes());
+    EXPECT_EQ(3 * kMockGetObjectSize, resp.GetDownloadedBytes());
+    ASSERT_EQ(1u, resp.GetErrorInfos().size());
+    EXPECT_EQ("InvalidLocalPath", resp.GetErrorInfos()[0].m_code);
+    EXPECT_EQ(4u, handler.m_calls);
+    EXPECT_TRUE(handler.m_is_list_done);
+
+    std::string content = MockGetObjectContent();
+    const char* files[] = {"/a.dat", "/sub/b.dat", "/sub/deep/c.dat"};
+    for (size_t i = 0; i < sizeof(files) / sizeof(files[0]); ++i) {
+        std::string path = local_dir + files[i];
+        std::ifstream ifs(path.c_str(), std::ios::in | std::ios::binary);
+        std::string data((std::istreambuf_iterator<char>(ifs)),
+                         std::istreambuf_iterator<char>());
+        EXPECT_TRUE(data == content) << path;
+    }
+    EXPECT_EQ(0u, CountTempFiles(local_dir));
+    EXPECT_EQ(0u, CountTempFiles(local_dir + "/sub"));
+    EXPECT_EQ(0u, CountTempFiles(local_dir + "/sub/deep"));
+    EXPECT_NE(0, access("./download_prefix_test/evil.dat", F_OK));
+
+    // 大小和MD5与远端一致的文件被跳过, 被改动的文件重新下载
+    WriteLocalFile(local_dir + "/sub/b.dat", "changed");
+    req.SetSkipExisting(true);
+    DownloadPrefixResp skip_resp;
+    DownloadProgressHandler skip_handler;
+    result = m_client->DownloadPrefix(req, &skip_handler, &skip_resp);
+    ASSERT_TRUE(result.IsSucc());
+    EXPECT_EQ(1u, skip_resp.GetDownloadedCount());
+    EXPECT_EQ(2u, skip_resp.GetSkippedCount());
+    EXPECT_EQ(2u, skip_handler.m_skipped);
+    EXPECT_EQ(kMockGetObjectSize, skip_resp.GetDownloadedBytes());
+    EXPECT_EQ(kMockGetObjectSize, FileUtil::GetFileLen(local_dir + "/sub/b.dat"));
+
+    // 列出失败时返回失败
+    MockFaultConfig config;
+    config.m_error_ratio = 1.0;
+    MockFaultInjector::Instance().SetConfig(config);
+    DownloadPrefixReq fail_req(m_bucket_name, kMockDownloadPrefix + "sub/",
+                               "./download_prefix_test/fail");
+    DownloadPrefixResp fail_resp;
+    result = m_client->DownloadPrefix(fail_req, &fail_resp);
+    MockFaultInjector::Instance().Reset();
+    EXPECT_FALSE(result.IsSucc());
+    EXPECT_EQ(0u, fail_resp.GetDownloadedCount());
+
+    system("rm -rf ./download_prefix_test");
+}
+
+TEST_F(MockServerTest, RetryBudgetTest) {
+    MockFaultConfig config;
+    config.m_error_ratio = 1.0;
+    MockFaultInjector::Instance().SetConfig(config);
+
+    CosConfig retry_config(7777, "access_key_test", "secret_key_test", "cn-north");
+    RetryPolicy policy;
+    policy.SetBaseDelayInms(10);
+    policy.SetRetryBudget(1, 0);
+    retry_config.SetRetryPolicy(policy);
+    CosAPI client(retry_config);
+
+    // 预算只够重试一次
+    HeadObjectReq req(m_bucket_name, "object_test");
+    HeadObjectResp resp;
+    CosResult result = client.HeadObject(req, &resp);
+    EXPECT_FALSE(result.IsSucc());
+    EXPECT_EQ(503, result.GetHttpStatus());
+    EXPECT_EQ(2u, MockFaultInjector::Instance().GetStat().m_requests);
+}
+
+TEST_F(MockServerTest, HedgeHeadObjectTest) {
+    MockFaultConfig config;
+    config.m_tail_latency_ratio = 1.0;
+    config.m_tail_latency_ms = 2000;
+    config.m_max_tail_latencies = 1;
+    MockFaultInjector::Instance().SetConfig(config);
+
+    CosConfig hedge_config(7777, "access_key_test", "secret_key_test", "cn-north");
+    HedgePolicy policy;
+    policy.SetEnable(true);
+    policy.SetMinDelayInms(50);
+    policy.SetMaxDelayInms(50);
+    hedge_config.SetHedgePolicy(policy);
+    CosAPI client(hedge_config);
+
+    // 主请求命中长尾延迟, 对冲请求先返回
+    HeadObjectReq req(m_bucket_name, "object_test");
+    HeadObjectResp resp;
+    uint64_t start = HttpSender::GetTimeStampInUs();
+    CosResult result = client.HeadObject(req, &resp);
+    uint64_t cost_ms = (HttpSender::GetTimeStampInUs() - start) / 1000;
+    EXPECT_TRUE(result.IsSucc());
+    EXPECT_EQ(kMockHeadReqId, result.GetXCosRequestId());
+    EXPECT_EQ(kMockGetObjectSize, resp.GetContentLength());
+    EXPECT_LT(cost_ms, 1000u);
+    EXPECT_EQ(2u, MockFaultInjector::Instance().GetStat().m_requests);
+
+    // 没有长尾时只发出一个请求, HEAD响应的Content-Length不作为响应体长度校验
+    MockFaultInjector::Instance().Reset();
+    HeadObjectResp fast_resp;
+    result = client.HeadObject(req, &fast_resp);
+    ASSERT_TRUE(result.IsSucc());
+    EXPECT_EQ(kMockGetObjectSize, fast_resp.GetContentLength());
+    EXPECT_EQ(kMockLastModified, fast_resp.GetLastModified());
+    EXPECT_EQ(1u, MockFaultInjector::Instance().GetStat().m_requests);
+}
+
+TEST_F(MockServerTest, HedgeGetObjectTest) {
+    MockFaultConfig config;
+    config.m_tail_latency_ratio = 1.0;
+    config.m_tail_latency_ms = 2000;
+    config.m_max_tail_latencies = 1;
+    MockFaultInjector::Instance().SetConfig(config);
+
+    CosConfig hedge_config(7777, "access_key_test", "secret_key_test", "cn-north");
+    HedgePolicy policy;
+    policy.SetEnable(true);
+    policy.SetMinDelayInms(50);
+    policy.SetMaxDelayInms(50);
+    hedge_config.SetHedgePolicy(policy);
+    CosAPI client(hedge_config);
+
+    // 只有胜出的请求写入输出流
+    std::ostringstream os;
+    GetObjectByStreamReq req(m_bucket_name, "object_test", os);
+    GetObjectByStreamResp resp;
+    uint64_t start = HttpSender::GetTimeStampInUs();
+    CosResult result = client.GetObject(req, &resp);
+    uint64_t cost_ms = (HttpSender::GetTimeStampInUs() - start) / 1000;
+    EXPECT_TRUE(result.IsSucc());
+    EXPECT_EQ(kMockGetObjectSize, os.str().size());
+    EXPECT_LT(cost_ms, 1000u);
+
+    // 没有长尾延迟时不发出对冲请求
+    std::ostringstream os2;
+    GetObjectByStreamReq req2(m_bucket_name, "object_test", os2);
+    MockFaultInjector::Instance().Reset();
+    result = client.GetObject(req2, &resp);
+    EXPECT_TRUE(result.IsSucc());
+    EXPECT_EQ(1u, MockFaultInjector::Instance().GetStat().m_requests);
+
+    // 列出Object等其他GET请求即使命中长尾延迟也不对冲
+    config.m_tail_latency_ms = 300;
+    MockFaultInjector::Instance().SetConfig(config);
+    GetBucketReq list_req(m_bucket_name);
+    GetBucketResp list_resp;
+    EXPECT_TRUE(client.GetBucket(list_req, &list_resp).IsSucc());
+    EXPECT_EQ(1u, MockFaultInjector::Instance().GetStat().m_requests);
+}
+
+TEST_F(MockServerTest, StalledPartSpeculationTest) {
+    MockFaultConfig config;
+    config.m_stall_ratio = 1.0;
+    config.m_max_stalls = 1;
+    config.m_stall_ms = 5000;
+    MockFaultInjector::Instance().SetConfig(config);
+
+    CosConfig stall_config(7777, "access_key_test", "secret_key_test", "cn-north");
+    StallPolicy policy;
+    policy.SetMinRateBytesPerSec(1024 * 1024);
+    policy.SetGracePeriodInms(200);
+    stall_config.SetStallPolicy(policy);
+    CosAPI client(stall_config);
+
+    // 第一个分块发送一半后停顿, 推测任务在新连接上重新下载该分块
+    std::string local_file = "./mock_stall_part_test";
+    MultiGetObjectReq req(m_bucket_name, "object_test", local_file);
+    req.SetSliceSize(256 * 1024);
+    req.SetThreadPoolSize(4);
+    MultiGetObjectResp resp;
+    uint64_t start = HttpSender::GetTimeStampInUs();
+    CosResult result = client.GetObject(req, &resp);
+    uint64_t cost_ms = (HttpSender::GetTimeStampInUs() - start) / 1000;
+    EXPECT_TRUE(result.IsSucc());
+    EXPECT_LT(cost_ms, 3000u);
+    EXPECT_EQ(1u, MockFaultInjector::Instance().GetStat().m_stalls);
+
+    std::ifstream ifs(local_file.c_str(), std::ios::in | std::ios::binary);
+    std::string content((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+    ifs.close();
+    EXPECT_TRUE(content == MockGetObjectContent());
+    ::remove(local_file.c_str());
+}
+
+TEST_F(MockServerTest, TotalTimeoutTest) {
+    MockFaultConfig config;
+    config.m_bandwidth_bytes_per_s = 64 * 1024;
+    MockFaultInjector::Instance().SetConfig(config);
+
+    // 慢速传输中每次recv都不超时, 由截止时间结束请求
+    std::ostringstream os;
+    GetObjectByStreamReq req(m_bucket_name, "object_test", os);
+    req.SetTotalTimeoutInms(500);
+    GetObjectByStreamResp resp;
+    uint64_t start = HttpSender::GetTimeStampInUs();
+    CosResult result = m_client->GetObject(req, &resp);
+    uint64_t cost_ms = (HttpSender::GetTimeStampInUs() - start) / 1000;
+    EXPECT_FALSE(result.IsSucc());
+    EXPECT_EQ(kRequestDeadlineExceededErrMsg, result.GetErrorInfo());
+    EXPECT_LT(cost_ms, 1500u);
+}
+
+TEST_F(MockServerTest, CancelMultiGetObjectTest) {
+    MockFaultConfig config;
+    config.m_bandwidth_bytes_per_s = 64 * 1024;
+    MockFaultInjector::Instance().SetConfig(config);
+
+    std::string local_file = "./mock_cancel_test";
+    MultiGetObjectReq req(m_bucket_name, "object_test", local_file);
+    req.SetSliceSize(256 * 1024);
+    req.SetThreadPoolSize(4);
+    SharedCancelToken cancel_token(new CancelToken());
+    req.SetCancelToken(cancel_token);
+    MultiGetObjectResp resp;
+
+    // 其他线程取消后, 所有分块任务的连接立即关闭
+    boost::thread t(boost::bind(&MockServerTest::CancelAfter, cancel_token, 300));
+    uint64_t start = HttpSender::GetTimeStampInUs();
+    CosResult result = m_client->GetObject(req, &resp);
+    uint64_t cost_ms = (HttpSender::GetTimeStampInUs() - start) / 1000;
+    t.join();
+    EXPECT_FALSE(result.IsSucc());
+    EXPECT_EQ(kRequestCancelledErrMsg, result.GetErrorInfo());
+    EXPECT_LT(cost_ms, 1500u);
+    ::remove(local_file.c_str());
+}
+
+// 长尾延迟场景下的延迟分布, 供评估重试/对冲等策略使用
+TEST_F(MockServerTest, TailLatencyHarnessTest) {
+    MockFaultConfig config;
+    config.m_seed = 2017;
+    config.m_min_latency_ms = 1;
+    config.m_max_latency_ms = 5;
+    config.m_tail_latency_ratio = 0.1;
+    config.m_tail_latency_ms = 100;
+    MockFaultInjector::Instance().SetConfig(config);
+
+    const int kRequestNum = 100;
+    std::vector<uint64_t> costs;
+    for (int i = 0; i < kRequestNum; ++i) {
+        CosResult result;
+        costs.push_back(TimedHeadObject(&result));
+        EXPECT_TRUE(result.IsSucc());
+    }
+    std::sort(costs.begin(), costs.end());
+
+    uint64_t p50 = costs[kRequestNum / 2];
+    uint64_t p99 = costs[kRequestNum * 99 / 100];
+
+    // 固定种子下约10%的请求注入100ms的尾延迟, 只有这些请求超过100ms
+    MockFaultStat stat = MockFaultInjector::Instance().GetStat();
+    EXPECT_EQ(static_cast<uint64_t>(kRequestNum), stat.m_requests);
+    EXPECT_GT(stat.m_tail_latencies, 0u);
+    EXPECT_LT(stat.m_tail_latencies, static_cast<uint64_t>(kRequestNum / 2));
+    uint64_t slow_num = static_cast<uint64_t>(
+        costs.end() - std::lower_bound(costs.begin(), costs.end(), static_cast<uint64_t>(100)));
+    EXPECT_EQ(stat.m_tail_latencies, slow_num);
+    EXPECT_LT(p50, 50u);
+    EXPECT_GE(p99, 100u);
+}
+
+} // namespace qcloud_cos
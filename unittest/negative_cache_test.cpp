@@ -0,0 +1,55 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: 不存在缓存的单元测试
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include "util/negative_cache.h"
+
+namespace qcloud_cos {
+
+TEST(NegativeCacheTest, ExpireTest) {
+    NegativeCache cache;
+    cache.Add("bucket", "a", 50);
+    cache.Add("bucket", "b", 0);
+    EXPECT_TRUE(cache.Contains("bucket", "a"));
+    EXPECT_FALSE(cache.Contains("bucket", "b"));
+    EXPECT_FALSE(cache.Contains("other", "a"));
+
+    usleep(80 * 1000);
+    EXPECT_FALSE(cache.Contains("bucket", "a"));
+    EXPECT_EQ(0u, cache.Size());
+}
+
+TEST(NegativeCacheTest, InvalidateTest) {
+    NegativeCache cache;
+    cache.Add("bucket", "a", 60000);
+    cache.Add("bucket", "b", 60000);
+    cache.Invalidate("bucket", "a");
+    EXPECT_FALSE(cache.Contains("bucket", "a"));
+    EXPECT_TRUE(cache.Contains("bucket", "b"));
+
+    cache.Clear();
+    EXPECT_FALSE(cache.Contains("bucket", "b"));
+}
+
+TEST(NegativeCacheTest, CapacityTest) {
+    NegativeCache cache(10);
+    for (unsigned i = 0; i < 100; ++i) {
+        char key[16];
+        snprintf(key, sizeof(key), "k%03u", i);
+        cache.Add("bucket", key, 60000);
+        // 重复加入同一个key不应淘汰其它记录
+        cache.Add("bucket", "k000", 60000);
+    }
+    EXPECT_LE(cache.Size(), 10u);
+    EXPECT_TRUE(cache.Contains("bucket", "k099"));
+    EXPECT_TRUE(cache.Contains("bucket", "k000"));
+    EXPECT_FALSE(cache.Contains("bucket", "k050"));
+}
+
+} // namespace qcloud_cos
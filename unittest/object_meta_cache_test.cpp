@@ -0,0 +1,114 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: Object元数据缓存的单元测试
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include <map>
+#include <string>
+
+#include "util/object_meta_cache.h"
+
+namespace qcloud_cos {
+
+namespace {
+
+MetaCachePolicy MakePolicy(uint64_t capacity, uint64_t ttl_in_ms, unsigned shard_num) {
+    MetaCachePolicy policy;
+    policy.SetCapacity(capacity);
+    policy.SetTtlInms(ttl_in_ms);
+    policy.SetShardNum(shard_num);
+    return policy;
+}
+
+std::map<std::string, std::string> MakeHeaders(const std::string& etag) {
+    std::map<std::string, std::string> headers;
+    headers["ETag"] = etag;
+    headers["Content-Length"] = "1024";
+    return headers;
+}
+
+} // namespace
+
+TEST(ObjectMetaCacheTest, LookupTest) {
+    ObjectMetaCache cache(MakePolicy(100, 60000, 4));
+    std::map<std::string, std::string> headers;
+    std::string etag;
+    EXPECT_EQ(META_CACHE_MISS, cache.Lookup("bucket", "a", &headers, &etag));
+
+    cache.Put("bucket", "a", "etag_a", MakeHeaders("etag_a"));
+    EXPECT_EQ(META_CACHE_FRESH, cache.Lookup("bucket", "a", &headers, &etag));
+    EXPECT_EQ("etag_a", etag);
+    EXPECT_EQ("1024", headers["Content-Length"]);
+    EXPECT_EQ(META_CACHE_MISS, cache.Lookup("other", "a", &headers, &etag));
+
+    cache.Invalidate("bucket", "a");
+    EXPECT_EQ(META_CACHE_MISS, cache.Lookup("bucket", "a", &headers, &etag));
+
+    ObjectMetaCacheStat stat = cache.GetStat();
+    EXPECT_EQ(1u, stat.m_hits);
+    EXPECT_EQ(3u, stat.m_misses);
+    EXPECT_EQ(0u, stat.m_entries);
+}
+
+TEST(ObjectMetaCacheTest, RevalidateTest) {
+    ObjectMetaCache cache(MakePolicy(100, 50, 1));
+    std::map<std::string, std::string> headers;
+    std::string etag;
+    cache.Put("bucket", "a", "etag_a", MakeHeaders("etag_a"));
+    usleep(80 * 1000);
+    EXPECT_EQ(META_CACHE_STALE, cache.Lookup("bucket", "a", &headers, &etag));
+    EXPECT_EQ("etag_a", etag);
+
+    EXPECT_FALSE(cache.Revalidate("bucket", "a", "etag_b", &headers));
+    EXPECT_FALSE(cache.Revalidate("bucket", "a", "\"etag_a_2\"", &headers));
+    headers.clear();
+    // 请求的If-None-Match带引号或弱校验前缀, 缓存的ETag不带引号
+    EXPECT_TRUE(cache.Revalidate("bucket", "a", "\"etag_b\", W/\"etag_a\"", &headers));
+    EXPECT_EQ("etag_a", headers["ETag"]);
+    EXPECT_EQ(META_CACHE_FRESH, cache.Lookup("bucket", "a", &headers, &etag));
+
+    ObjectMetaCacheStat stat = cache.GetStat();
+    EXPECT_EQ(1u, stat.m_revalidations);
+    EXPECT_DOUBLE_EQ(1.0, stat.GetHitRate());
+}
+
+TEST(ObjectMetaCacheTest, LruEvictTest) {
+    ObjectMetaCache cache(MakePolicy(3, 60000, 1));
+    std::map<std::string, std::string> headers;
+    std::string etag;
+    cache.Put("bucket", "a", "1", MakeHeaders("1"));
+    cache.Put("bucket", "b", "2", MakeHeaders("2"));
+    cache.Put("bucket", "c", "3", MakeHeaders("3"));
+    // 访问a后b成为最久未使用的记录
+    EXPECT_EQ(META_CACHE_FRESH, cache.Lookup("bucket", "a", &headers, &etag));
+    cache.Put("bucket", "d", "4", MakeHeaders("4"));
+    EXPECT_EQ(META_CACHE_MISS, cache.Lookup("bucket", "b", &headers, &etag));
+    EXPECT_EQ(META_CACHE_FRESH, cache.Lookup("bucket", "a", &headers, &etag));
+    EXPECT_EQ(META_CACHE_FRESH, cache.Lookup("bucket", "d", &headers, &etag));
+
+    // 覆盖已有记录不淘汰其它记录
+    cache.Put("bucket", "d", "5", MakeHeaders("5"));
+    ObjectMetaCacheStat stat = cache.GetStat();
+    EXPECT_EQ(1u, stat.m_evictions);
+    EXPECT_EQ(3u, stat.m_entries);
+}
+
+TEST(ObjectMetaCacheTest, ShardCapacityTest) {
+    ObjectMetaCache cache(MakePolicy(64, 60000, 8));
+    for (unsigned i = 0; i < 1000; ++i) {
+        char key[16];
+        snprintf(key, sizeof(key), "k%04u", i);
+        cache.Put("bucket", key, key, MakeHeaders(key));
+    }
+    EXPECT_LE(cache.GetStat().m_entries, 64u);
+
+    cache.Clear();
+    EXPECT_EQ(0u, cache.GetStat().m_entries);
+}
+
+} // namespace qcloud_cos
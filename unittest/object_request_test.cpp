@@ -120,4 +120,35 @@ TEST(ObjectReqTest, NormalTest) {
     }
 }
 
+TEST(ObjectReqTest, DeleteObjectsBodyTest) {
+    DeleteObjectsReq req("ut_bucket_01");
+    req.AddObject("a&b<c>.txt");
+    req.AddObjectVersion("obj", "v1");
+    std::string body;
+    EXPECT_TRUE(req.GenerateRequestBody(&body));
+    EXPECT_EQ("<Delete><Quiet>false</Quiet>"
+              "<Object><Key>a&amp;b&lt;c&gt;.txt</Key></Object>"
+              "<Object><Key>obj</Key><VersionId>v1</VersionId></Object></Delete>", body);
+
+    BulkDeleteReq bulk_req("ut_bucket_01");
+    EXPECT_TRUE(bulk_req.IsQuiet());
+    EXPECT_EQ(kMaxDeleteObjectsBatchSize, bulk_req.GetBatchSize());
+    bulk_req.SetBatchSize(5000);
+    EXPECT_EQ(kMaxDeleteObjectsBatchSize, bulk_req.GetBatchSize());
+    bulk_req.SetBatchSize(0);
+    EXPECT_EQ(1u, bulk_req.GetBatchSize());
+
+    // 拆分批次时只复制设置, 不复制待删除的Object
+    bulk_req.AddHeader("x-cos-test", "1");
+    bulk_req.SetRecvTimeoutInms(1234);
+    bulk_req.AddObject("obj");
+    DeleteObjectsReq batch_req = bulk_req.CloneWithoutObjects();
+    EXPECT_TRUE(batch_req.GetObjectVersions().empty());
+    EXPECT_TRUE(batch_req.IsQuiet());
+    EXPECT_EQ("ut_bucket_01", batch_req.GetBucketName());
+    EXPECT_EQ("1", batch_req.GetHeader("x-cos-test"));
+    EXPECT_EQ(1234u, batch_req.GetRecvTimeoutInms());
+    EXPECT_EQ("POST", batch_req.GetMethod());
+}
+
 } // namespace qcloud_cos
@@ -0,0 +1,111 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: 分层令牌桶限速器的单元测试
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+
+#include "boost/bind.hpp"
+#include "boost/thread/thread.hpp"
+
+#include "util/cancel_token.h"
+#include "util/http_sender.h"
+#include "util/rate_limiter.h"
+
+namespace qcloud_cos {
+
+namespace {
+
+const size_t kChunkSize = 8 * 1024;
+
+// 分块申请bytes字节, 返回耗时, 单位:毫秒
+uint64_t AcquireInChunks(RateLimiter* limiter, uint64_t bytes) {
+    uint64_t start_us = HttpSender::GetTimeStampInUs();
+    for (uint64_t sent = 0; sent < bytes; sent += kChunkSize) {
+        limiter->Acquire(std::min<uint64_t>(kChunkSize, bytes - sent), NULL);
+    }
+    return (HttpSender::GetTimeStampInUs() - start_us) / 1000;
+}
+
+void AcquireAndRecord(RateLimiter* limiter, uint64_t bytes, uint64_t* end_us) {
+    AcquireInChunks(limiter, bytes);
+    *end_us = HttpSender::GetTimeStampInUs();
+}
+
+} // namespace
+
+TEST(RateLimiterTest, UnlimitedTest) {
+    RateLimiter limiter;
+    EXPECT_FALSE(limiter.IsLimited());
+    EXPECT_EQ(kRateLimitMaxChunkSize, limiter.GetChunkSize());
+    EXPECT_LT(AcquireInChunks(&limiter, 64 * 1024 * 1024), 100u);
+
+    RateLimiterStat stat = limiter.GetStat();
+    EXPECT_EQ(64u * 1024 * 1024, stat.m_bytes);
+    EXPECT_EQ(0u, stat.m_throttled_us);
+}
+
+TEST(RateLimiterTest, RateTest) {
+    RateLimiter limiter(1024 * 1024);
+    EXPECT_TRUE(limiter.IsLimited());
+    EXPECT_EQ(1024u * 1024 * kRateLimitBurstInms / 1000, limiter.GetChunkSize());
+
+    // 除去突发部分, 512KB在1MB/s下约需480ms
+    uint64_t cost_ms = AcquireInChunks(&limiter, 512 * 1024);
+    EXPECT_GE(cost_ms, 450u);
+    EXPECT_LT(cost_ms, 800u);
+    EXPECT_GT(limiter.GetStat().m_throttled_us, 0u);
+
+    // 修改速率后立即生效
+    limiter.SetRate(0);
+    EXPECT_LT(AcquireInChunks(&limiter, 8 * 1024 * 1024), 100u);
+}
+
+TEST(RateLimiterTest, HierarchyTest) {
+    SharedRateLimiter parent(new RateLimiter(1024 * 1024));
+    SharedRateLimiter child = RateLimiter::Create(0, parent);
+    EXPECT_TRUE(child->IsLimited());
+    EXPECT_EQ(parent->GetChunkSize(), child->GetChunkSize());
+
+    // 子限速器不限速时受父限速器限制
+    uint64_t cost_ms = AcquireInChunks(child.get(), 256 * 1024);
+    EXPECT_GE(cost_ms, 200u);
+
+    // 子限速器更严格时按子限速器的速率
+    SharedRateLimiter slow_child = RateLimiter::Create(512 * 1024, parent);
+    EXPECT_EQ(512u * 1024 * kRateLimitBurstInms / 1000, slow_child->GetChunkSize());
+    cost_ms = AcquireInChunks(slow_child.get(), 256 * 1024);
+    EXPECT_GE(cost_ms, 450u);
+    EXPECT_EQ(512u * 1024, parent->GetStat().m_bytes);
+}
+
+TEST(RateLimiterTest, FairnessTest) {
+    // 两个线程共享限速器, 按申请顺序轮流获得令牌, 应几乎同时完成
+    RateLimiter limiter(2 * 1024 * 1024);
+    uint64_t end_us[2] = {0, 0};
+    uint64_t start_us = HttpSender::GetTimeStampInUs();
+    boost::thread t1(boost::bind(&AcquireAndRecord, &limiter, 512 * 1024, &end_us[0]));
+    boost::thread t2(boost::bind(&AcquireAndRecord, &limiter, 512 * 1024, &end_us[1]));
+    t1.join();
+    t2.join();
+
+    uint64_t cost1_ms = (end_us[0] - start_us) / 1000;
+    uint64_t cost2_ms = (end_us[1] - start_us) / 1000;
+    EXPECT_GE(std::max(cost1_ms, cost2_ms), 450u);
+    EXPECT_GE(std::min(cost1_ms, cost2_ms) * 10, std::max(cost1_ms, cost2_ms) * 8);
+}
+
+TEST(RateLimiterTest, CancelTest) {
+    RateLimiter limiter(1024);
+    CancelToken cancel_token;
+    cancel_token.SetDeadlineInms(HttpSender::GetTimeStampInUs() / 1000 + 100);
+
+    // 1MB在1KB/s下需要等待很久, 超过截止时间后提前返回
+    uint64_t start_us = HttpSender::GetTimeStampInUs();
+    EXPECT_FALSE(limiter.Acquire(1024 * 1024, &cancel_token));
+    EXPECT_LT((HttpSender::GetTimeStampInUs() - start_us) / 1000, 500u);
+}
+
+} // namespace qcloud_cos
@@ -0,0 +1,155 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: 按优先级调度请求的单元测试
+
+#include "gtest/gtest.h"
+
+#include <unistd.h>
+
+#include <vector>
+
+#include "boost/bind.hpp"
+#include "boost/thread/mutex.hpp"
+#include "boost/thread/thread.hpp"
+
+#include "util/cancel_token.h"
+#include "util/http_sender.h"
+#include "util/request_scheduler.h"
+
+namespace qcloud_cos {
+
+namespace {
+
+struct GrantRecorder {
+    boost::mutex m_mutex;
+    std::vector<REQUEST_PRIORITY> m_order;
+};
+
+// 获得许可后记录优先级再归还, 并发上限为1时记录的顺序即分配许可的顺序
+void AcquireAndRecord(REQUEST_PRIORITY priority, GrantRecorder* recorder) {
+    RequestScheduler& scheduler = RequestScheduler::Instance();
+    if (!scheduler.Acquire(priority, NULL)) {
+        return;
+    }
+    {
+        boost::mutex::scoped_lock lock(recorder->m_mutex);
+        recorder->m_order.push_back(priority);
+    }
+    scheduler.Release();
+}
+
+void AcquireWithToken(CancelToken* cancel_token, bool* is_acquired) {
+    *is_acquired = RequestScheduler::Instance().Acquire(PRIORITY_BULK, cancel_token);
+    if (*is_acquired) {
+        RequestScheduler::Instance().Release();
+    }
+}
+
+// 等待排队的请求数达到waiting
+void WaitForWaiting(uint64_t waiting) {
+    for (int i = 0; i < 500 && RequestScheduler::Instance().GetStat().m_waiting < waiting; ++i) {
+        usleep(10 * 1000);
+    }
+    ASSERT_EQ(waiting, RequestScheduler::Instance().GetStat().m_waiting);
+}
+
+} // namespace
+
+TEST(RequestSchedulerTest, UnlimitedTest) {
+    RequestScheduler& scheduler = RequestScheduler::Instance();
+    scheduler.SetMaxConcurrency(0);
+    RequestSchedulerStat before = scheduler.GetStat();
+
+    // 不限制并发时直接放行, 只做统计
+    {
+        RequestSlot slot1(PRIORITY_BULK, NULL);
+        RequestSlot slot2(PRIORITY_BULK, NULL);
+        EXPECT_TRUE(slot1.IsAcquired());
+        EXPECT_TRUE(slot2.IsAcquired());
+        EXPECT_EQ(before.m_running + 2, scheduler.GetStat().m_running);
+    }
+
+    RequestSchedulerStat after = scheduler.GetStat();
+    EXPECT_EQ(before.m_running, after.m_running);
+    EXPECT_EQ(before.m_admitted[PRIORITY_BULK] + 2, after.m_admitted[PRIORITY_BULK]);
+    EXPECT_EQ(before.m_queued[PRIORITY_BULK], after.m_queued[PRIORITY_BULK]);
+}
+
+TEST(RequestSchedulerTest, WeightedFairTest) {
+    RequestScheduler& scheduler = RequestScheduler::Instance();
+    scheduler.SetMaxConcurrency(1);
+    GrantRecorder recorder;
+    boost::thread_group threads;
+    {
+        // 占住唯一的许可, 使所有请求都进入排队
+        RequestSlot holder(PRIORITY_NORMAL, NULL);
+        ASSERT_TRUE(holder.IsAcquired());
+        for (int i = 0; i < 32; ++i) {
+            threads.create_thread(boost::bind(&AcquireAndRecord, PRIORITY_INTERACTIVE, &recorder));
+        }
+        for (int i = 0; i < 4; ++i) {
+            threads.create_thread(boost::bind(&AcquireAndRecord, PRIORITY_BULK, &recorder));
+        }
+        WaitForWaiting(36);
+    }
+    threads.join_all();
+    scheduler.SetMaxConcurrency(0);
+
+    ASSERT_EQ(36u, recorder.m_order.size());
+    // 按16:1的权重, 每17个许可中批量请求获得1个: 交互请求占多数, 批量请求仍然推进
+    unsigned bulk_in_first_half = 0;
+    for (size_t i = 0; i < 18; ++i) {
+        if (recorder.m_order[i] == PRIORITY_BULK) {
+            ++bulk_in_first_half;
+        }
+    }
+    EXPECT_GE(bulk_in_first_half, 1u);
+    EXPECT_LE(bulk_in_first_half, 2u);
+    // 交互请求先于批量请求全部完成
+    EXPECT_EQ(PRIORITY_BULK, recorder.m_order.back());
+}
+
+TEST(RequestSchedulerTest, CancelTest) {
+    RequestScheduler& scheduler = RequestScheduler::Instance();
+    scheduler.SetMaxConcurrency(1);
+    CancelToken cancel_token;
+    bool is_acquired = true;
+    RequestSchedulerStat before = scheduler.GetStat();
+    {
+        RequestSlot holder(PRIORITY_NORMAL, NULL);
+        boost::thread t(boost::bind(&AcquireWithToken, &cancel_token, &is_acquired));
+        WaitForWaiting(1);
+
+        // 排队期间取消, 不需要等待许可归还
+        uint64_t start_us = HttpSender::GetTimeStampInUs();
+        cancel_token.Cancel();
+        t.join();
+        EXPECT_LT((HttpSender::GetTimeStampInUs() - start_us) / 1000, 500u);
+        EXPECT_FALSE(is_acquired);
+    }
+
+    RequestSchedulerStat after = scheduler.GetStat();
+    EXPECT_EQ(0u, after.m_waiting);
+    EXPECT_EQ(before.m_running, after.m_running);
+    EXPECT_EQ(before.m_admitted[PRIORITY_BULK], after.m_admitted[PRIORITY_BULK]);
+    scheduler.SetMaxConcurrency(0);
+}
+
+TEST(RequestSchedulerTest, RaiseConcurrencyTest) {
+    RequestScheduler& scheduler = RequestScheduler::Instance();
+    scheduler.SetMaxConcurrency(1);
+    CancelToken cancel_token;
+    bool is_acquired = false;
+    RequestSlot holder(PRIORITY_NORMAL, NULL);
+    boost::thread t(boost::bind(&AcquireWithToken, &cancel_token, &is_acquired));
+    WaitForWaiting(1);
+
+    // 取消并发限制后排队的请求立即获得许可
+    scheduler.SetMaxConcurrency(0);
+    t.join();
+    EXPECT_TRUE(is_acquired);
+    EXPECT_EQ(0u, scheduler.GetStat().m_waiting);
+}
+
+} // namespace qcloud_cos
@@ -0,0 +1,82 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: 重试策略的单元测试
+
+#include "gtest/gtest.h"
+
+#include <set>
+
+#include "util/retry_policy.h"
+
+namespace qcloud_cos {
+
+TEST(RetryPolicyTest, ClassifyErrorTest) {
+    EXPECT_EQ(RETRY_ERR_TIMEOUT, RetryPolicy::ClassifyError(-1, "TimeoutException:Timeout"));
+    EXPECT_EQ(RETRY_ERR_NETWORK, RetryPolicy::ClassifyError(-1, "Net Exception:Connection reset by peer"));
+    EXPECT_EQ(RETRY_ERR_NETWORK, RetryPolicy::ClassifyError(-1, "Exception:unknown"));
+    EXPECT_EQ(RETRY_ERR_SLOW_DOWN, RetryPolicy::ClassifyError(503, ""));
+    EXPECT_EQ(RETRY_ERR_SERVER, RetryPolicy::ClassifyError(500, ""));
+    EXPECT_EQ(RETRY_ERR_NONE, RetryPolicy::ClassifyError(200, ""));
+    EXPECT_EQ(RETRY_ERR_NONE, RetryPolicy::ClassifyError(403, ""));
+    EXPECT_EQ(RETRY_ERR_NONE, RetryPolicy::ClassifyError(404, ""));
+}
+
+TEST(RetryPolicyTest, IdempotentMethodTest) {
+    EXPECT_TRUE(RetryPolicy::IsIdempotentMethod("GET"));
+    EXPECT_TRUE(RetryPolicy::IsIdempotentMethod("HEAD"));
+    EXPECT_TRUE(RetryPolicy::IsIdempotentMethod("PUT"));
+    EXPECT_TRUE(RetryPolicy::IsIdempotentMethod("DELETE"));
+    EXPECT_FALSE(RetryPolicy::IsIdempotentMethod("POST"));
+}
+
+TEST(RetryPolicyTest, ShouldRetryTest) {
+    RetryPolicy policy;
+    policy.SetMaxRetryTimes(2);
+    policy.SetRetryBudget(0, 0);
+    EXPECT_TRUE(policy.ShouldRetry(1, RETRY_ERR_TIMEOUT));
+    EXPECT_TRUE(policy.ShouldRetry(2, RETRY_ERR_SERVER));
+    EXPECT_FALSE(policy.ShouldRetry(3, RETRY_ERR_SERVER));
+    EXPECT_FALSE(policy.ShouldRetry(1, RETRY_ERR_NONE));
+
+    policy.SetMaxRetryTimes(0);
+    EXPECT_FALSE(policy.ShouldRetry(1, RETRY_ERR_NETWORK));
+}
+
+TEST(RetryPolicyTest, BackoffTest) {
+    RetryPolicy policy;
+    policy.SetBaseDelayInms(100);
+    policy.SetMaxDelayInms(1000);
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_LE(policy.GetBackoffInms(1, RETRY_ERR_SERVER), 100u);
+        EXPECT_LE(policy.GetBackoffInms(3, RETRY_ERR_SERVER), 400u);
+        EXPECT_LE(policy.GetBackoffInms(1, RETRY_ERR_SLOW_DOWN), 200u);
+        EXPECT_LE(policy.GetBackoffInms(10, RETRY_ERR_SERVER), 1000u);
+    }
+
+    policy.SetBaseDelayInms(0);
+    EXPECT_EQ(0u, policy.GetBackoffInms(5, RETRY_ERR_SLOW_DOWN));
+
+    // 连续的退避取自同一个随机序列, 即使在同一时刻调用也不会相同
+    policy.SetBaseDelayInms(1000000);
+    policy.SetMaxDelayInms(1000000);
+    std::set<uint64_t> delays;
+    for (int i = 0; i < 20; ++i) {
+        delays.insert(policy.GetBackoffInms(1, RETRY_ERR_SERVER));
+    }
+    EXPECT_GT(delays.size(), 10u);
+}
+
+TEST(RetryPolicyTest, RetryBudgetTest) {
+    RetryPolicy policy;
+    policy.SetMaxRetryTimes(10);
+    policy.SetRetryBudget(2, 0);
+    // 拷贝之间共享预算
+    RetryPolicy copy = policy;
+    EXPECT_TRUE(policy.ShouldRetry(1, RETRY_ERR_SERVER));
+    EXPECT_TRUE(copy.ShouldRetry(1, RETRY_ERR_SERVER));
+    EXPECT_FALSE(policy.ShouldRetry(1, RETRY_ERR_SERVER));
+    EXPECT_FALSE(copy.ShouldRetry(2, RETRY_ERR_SERVER));
+}
+
+} // namespace qcloud_cos
@@ -0,0 +1,193 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: 相同读请求合并的单元测试
+
+#include "gtest/gtest.h"
+
+#include <unistd.h>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "boost/bind.hpp"
+#include "boost/thread/thread.hpp"
+
+#include "util/cancel_token.h"
+#include "util/http_sender.h"
+#include "util/single_flight.h"
+
+namespace qcloud_cos {
+
+namespace {
+
+// 发起方填写的结果为http_status, 等待方通过Wait读取
+void DoCall(SingleFlight* flight, int http_status, unsigned* call_times, int* got_status) {
+    SharedFlightCall call;
+    if (flight->Begin("key", &call)) {
+        usleep(50 * 1000);
+        __sync_fetch_and_add(call_times, 1);
+        call->m_result.SetHttpStatus(http_status);
+        call->m_is_shared = http_status > 0;
+        flight->End("key", call);
+        *got_status = http_status;
+        return;
+    }
+    if (flight->Wait(call, 0)) {
+        *got_status = call->m_result.GetHttpStatus();
+    }
+}
+
+} // namespace
+
+TEST(SingleFlightTest, MergeTest) {
+    SingleFlight flight;
+    unsigned call_times = 0;
+    std::vector<int> statuses(8, 0);
+    boost::thread_group threads;
+    for (size_t i = 0; i < statuses.size(); ++i) {
+        threads.create_thread(boost::bind(&DoCall, &flight, 200, &call_times, &statuses[i]));
+    }
+    threads.join_all();
+    EXPECT_EQ(1u, call_times);
+    for (size_t i = 0; i < statuses.size(); ++i) {
+        EXPECT_EQ(200, statuses[i]);
+    }
+    SingleFlightStat stat = flight.GetStat();
+    EXPECT_EQ(1u, stat.m_leaders);
+    EXPECT_EQ(7u, stat.m_shared);
+
+    // 请求结束后不再合并
+    SharedFlightCall call;
+    EXPECT_TRUE(flight.Begin("key", &call));
+    flight.End("key", call);
+}
+
+TEST(SingleFlightTest, FallbackTest) {
+    SingleFlight flight;
+    unsigned call_times = 0;
+    std::vector<int> statuses(4, 0);
+    boost::thread_group threads;
+    for (size_t i = 0; i < statuses.size(); ++i) {
+        threads.create_thread(boost::bind(&DoCall, &flight, -1, &call_times, &statuses[i]));
+    }
+    threads.join_all();
+    SingleFlightStat stat = flight.GetStat();
+    EXPECT_EQ(0u, stat.m_shared);
+    EXPECT_EQ(stat.m_leaders + stat.m_fallbacks, 4u);
+
+    // 等待超过deadline后返回false
+    SharedFlightCall leader;
+    ASSERT_TRUE(flight.Begin("slow", &leader));
+    SharedFlightCall follower;
+    ASSERT_FALSE(flight.Begin("slow", &follower));
+    uint64_t start_in_ms = HttpSender::GetTimeStampInUs() / 1000;
+    EXPECT_FALSE(flight.Wait(follower, start_in_ms + 50));
+    EXPECT_GE(HttpSender::GetTimeStampInUs() / 1000 - start_in_ms, 50u);
+    flight.End("slow", leader);
+}
+
+namespace {
+
+void AbandonLater(SingleFlight* flight, const SharedFlightCall& call) {
+    usleep(20 * 1000);
+    flight->Abandon("key", call);
+}
+
+void CancelLater(const SharedCancelToken& token) {
+    usleep(20 * 1000);
+    token->Cancel();
+}
+
+void SetFlag(bool* flag) {
+    *flag = true;
+}
+
+} // namespace
+
+TEST(SingleFlightTest, AbandonTest) {
+    SingleFlight flight;
+    SharedFlightCall leader;
+    ASSERT_TRUE(flight.Begin("key", &leader));
+    SharedFlightCall follower;
+    ASSERT_FALSE(flight.Begin("key", &follower));
+
+    // 发起方放弃后等待方不必等到End即返回
+    boost::thread abandon_thread(boost::bind(&AbandonLater, &flight, leader));
+    uint64_t start_in_ms = HttpSender::GetTimeStampInUs() / 1000;
+    EXPECT_FALSE(flight.Wait(follower, start_in_ms + 5000));
+    EXPECT_LT(HttpSender::GetTimeStampInUs() / 1000 - start_in_ms, 1000u);
+    abandon_thread.join();
+
+    // 放弃后的相同请求不再合并到原请求上
+    SharedFlightCall next;
+    EXPECT_TRUE(flight.Begin("key", &next));
+    flight.End("key", leader);
+    SharedFlightCall other;
+    EXPECT_FALSE(flight.Begin("key", &other));
+    flight.End("key", next);
+}
+
+TEST(SingleFlightTest, CancelWaitTest) {
+    SingleFlight flight;
+    SharedFlightCall leader;
+    ASSERT_TRUE(flight.Begin("key", &leader));
+    SharedFlightCall follower;
+    ASSERT_FALSE(flight.Begin("key", &follower));
+
+    SharedCancelToken token(new CancelToken());
+    boost::thread cancel_thread(boost::bind(&CancelLater, token));
+    uint64_t start_in_ms = HttpSender::GetTimeStampInUs() / 1000;
+    EXPECT_FALSE(flight.Wait(follower, 0, token));
+    EXPECT_LT(HttpSender::GetTimeStampInUs() / 1000 - start_in_ms, 1000u);
+    cancel_thread.join();
+    flight.End("key", leader);
+    EXPECT_EQ(1u, flight.GetStat().m_fallbacks);
+}
+
+TEST(SingleFlightTest, TeeStreamBufTest) {
+    std::ostringstream os;
+    {
+        TeeStreamBuf tee_buf(&os, 10);
+        std::ostream tee_os(&tee_buf);
+        std::streampos pos = tee_os.tellp();
+        tee_os << "hello";
+        tee_os.flush();
+        EXPECT_TRUE(tee_buf.IsComplete());
+        EXPECT_EQ("hello", tee_buf.GetBytes());
+
+        // 回退后重新写入
+        tee_os.seekp(pos);
+        tee_os << "world";
+        tee_os.flush();
+        EXPECT_EQ("world", tee_buf.GetBytes());
+        EXPECT_EQ("world", os.str());
+
+        tee_os << "0123456789";
+        tee_os.flush();
+        EXPECT_FALSE(tee_buf.IsComplete());
+        EXPECT_TRUE(tee_buf.GetBytes().empty());
+    }
+    EXPECT_EQ("world0123456789", os.str());
+
+    // 超过上限时回调一次, 回退到起点后重新暂存但仍记录曾经超过上限
+    std::ostringstream os2;
+    bool is_overflowed = false;
+    TeeStreamBuf tee_buf(&os2, 4, boost::bind(&SetFlag, &is_overflowed));
+    std::ostream tee_os(&tee_buf);
+    std::streampos pos = tee_os.tellp();
+    tee_os << "abc";
+    tee_os.flush();
+    EXPECT_FALSE(is_overflowed);
+    tee_os << "de";
+    tee_os.flush();
+    EXPECT_TRUE(is_overflowed);
+    tee_os.seekp(pos);
+    tee_os << "ab";
+    tee_os.flush();
+    EXPECT_TRUE(tee_buf.IsComplete());
+    EXPECT_TRUE(tee_buf.HasOverflowed());
+}
+
+} // namespace qcloud_cos
@@ -0,0 +1,93 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: 分块传输进度及低速检测的单元测试
+
+#include "gtest/gtest.h"
+
+#include <unistd.h>
+
+#include <istream>
+#include <ostream>
+#include <string>
+
+#include "util/stall_policy.h"
+#include "util/transfer_progress.h"
+
+namespace qcloud_cos {
+
+TEST(TransferProgressTest, MemoryInputBufTest) {
+    std::string data = "0123456789";
+    TransferProgress progress;
+    MemoryInputBuf buf(reinterpret_cast<const unsigned char*>(data.data()), data.size(), &progress);
+    std::istream is(&buf);
+
+    // HttpSender通过seek计算Content-Length
+    std::streampos pos = is.tellg();
+    is.seekg(0, std::ios::end);
+    EXPECT_EQ(10, static_cast<int>(is.tellg()));
+    is.seekg(pos);
+
+    char out[16] = {0};
+    is.read(out, 4);
+    EXPECT_EQ("0123", std::string(out, 4));
+    is.read(out, 16);
+    EXPECT_EQ(6, is.gcount());
+    EXPECT_EQ("456789", std::string(out, 6));
+    EXPECT_EQ(10u, progress.GetBytes());
+
+    // 重试时回退到起始位置
+    is.clear();
+    is.seekg(0);
+    is.read(out, 2);
+    EXPECT_EQ("01", std::string(out, 2));
+}
+
+TEST(TransferProgressTest, MemoryOutputBufTest) {
+    unsigned char data[8];
+    TransferProgress progress;
+    MemoryOutputBuf buf(data, sizeof(data), &progress);
+    std::ostream os(&buf);
+
+    os.write("abcde", 5);
+    EXPECT_TRUE(os.good());
+    EXPECT_EQ(5u, buf.GetSize());
+    EXPECT_EQ(5, static_cast<int>(os.tellp()));
+    EXPECT_EQ("abcde", std::string(reinterpret_cast<char*>(data), 5));
+
+    // 超出容量时写入失败
+    os.write("fghij", 5);
+    EXPECT_FALSE(os.good());
+    EXPECT_EQ(8u, buf.GetSize());
+    EXPECT_EQ(8u, progress.GetBytes());
+}
+
+TEST(TransferProgressTest, StallPolicyTest) {
+    StallPolicy policy;
+    TransferProgress progress;
+    EXPECT_FALSE(policy.IsEnable());
+
+    policy.SetMinRateBytesPerSec(1024 * 1024);
+    policy.SetGracePeriodInms(50);
+    EXPECT_TRUE(policy.IsEnable());
+
+    // 未开始执行的任务不判定为低速
+    EXPECT_FALSE(policy.IsStalled(progress));
+
+    progress.Start();
+    progress.AddBytes(1024);
+    EXPECT_FALSE(policy.IsStalled(progress));
+    usleep(100 * 1000);
+    EXPECT_TRUE(policy.IsStalled(progress));
+
+    progress.AddBytes(1024 * 1024);
+    EXPECT_FALSE(policy.IsStalled(progress));
+
+    progress.Reset();
+    progress.Start();
+    usleep(100 * 1000);
+    progress.Finish();
+    EXPECT_FALSE(policy.IsStalled(progress));
+}
+
+} // namespace qcloud_cos
@@ -0,0 +1,229 @@
+// Copyright (c) 2017, Tencent Inc.
+// All rights reserved.
+//
+// Description: 增量XML解析器及列表结果流式解析的单元测试
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "response/bucket_resp.h"
+#include "util/xml_sax_parser.h"
+
+namespace qcloud_cos {
+
+namespace {
+
+// 按"名称=文本"记录结束标签
+class RecordHandler : public XmlSaxHandler {
+public:
+    virtual void OnStartElement(const std::string& name) {
+        m_events.push_back("<" + name);
+    }
+
+    virtual void OnEndElement(const std::string& name, const std::string& text) {
+        m_events.push_back(name + "=" + text);
+    }
+
+    virtual void OnReset() {
+        m_events.clear();
+    }
+
+    std::vector<std::string> m_events;
+};
+
+const std::string kListBucketXml =
+    "<?xml version='1.0' encoding='utf-8' ?>\n"
+    "<ListBucketResult>\n"
+    "  <Name>bucket-1250000000</Name>\n"
+    "  <EncodingType>url</EncodingType>\n"
+    "  <Prefix>dir/</Prefix>\n"
+    "  <Marker/>\n"
+    "  <MaxKeys>2</MaxKeys>\n"
+    "  <Delimiter>/</Delimiter>\n"
+    "  <IsTruncated>true</IsTruncated>\n"
+    "  <NextMarker>dir/b&amp;c</NextMarker>\n"
+    "  <CommonPrefixes><Prefix>dir/sub/</Prefix></CommonPrefixes>\n"
+    "  <Contents>\n"
+    "    <Key>dir/a</Key>\n"
+    "    <LastModified>2017-06-23T12:33:27.000Z</LastModified>\n"
+    "    <ETag>&quot;ee8de918d05640145b18f70f4c3aa602&quot;</ETag>\n"
+    "    <Size>9</Size>\n"
+    "    <Owner><ID>1250000000</ID></Owner>\n"
+    "    <StorageClass>STANDARD</StorageClass>\n"
+    "  </Contents>\n"
+    "  <Contents>\n"
+    "    <Key>dir/b&amp;c</Key>\n"
+    "    <LastModified>2017-06-23T12:33:28.000Z</LastModified>\n"
+    "    <ETag>\"ee8de918d05640145b18f70f4c3aa602\"</ETag>\n"
+    "    <Size>10737418240</Size>\n"
+    "    <StorageClass>STANDARD_IA</StorageClass>\n"
+    "  </Contents>\n"
+    "</ListBucketResult>";
+
+} // namespace
+
+TEST(XmlSaxParserTest, ChunkedFeedTest) {
+    const std::string xml = "<?xml version=\"1.0\"?><!-- a > b --><Root a=\"x>y\">"
+        "<A>1 &lt; 2 &#x4e2d;&#25991;</A><B/><C><![CDATA[<raw> & ]]>tail</C></Root>";
+
+    // 整体输入和逐字节输入的结果一致
+    RecordHandler whole;
+    XmlSaxParser whole_parser(&whole);
+    EXPECT_TRUE(whole_parser.Feed(xml.data(), xml.size()));
+    EXPECT_TRUE(whole_parser.Finish());
+
+    RecordHandler bytes;
+    XmlSaxParser bytes_parser(&bytes);
+    for (size_t i = 0; i < xml.size(); ++i) {
+        EXPECT_TRUE(bytes_parser.Feed(xml.data() + i, 1));
+    }
+    EXPECT_TRUE(bytes_parser.Finish());
+    EXPECT_EQ(xml.size(), bytes_parser.GetFedBytes());
+
+    ASSERT_EQ(8u, whole.m_events.size());
+    EXPECT_EQ("<Root", whole.m_events[0]);
+    EXPECT_EQ("A=1 < 2 \xe4\xb8\xad\xe6\x96\x87", whole.m_events[2]);
+    EXPECT_EQ("B=", whole.m_events[4]);
+    EXPECT_EQ("C=<raw> & tail", whole.m_events[6]);
+    EXPECT_EQ("Root=", whole.m_events[7]);
+    EXPECT_EQ(whole.m_events, bytes.m_events);
+}
+
+TEST(XmlSaxParserTest, MalformedTest) {
+    RecordHandler handler;
+    {
+        XmlSaxParser parser(&handler);
+        std::string xml = "<A><B></A>";
+        EXPECT_FALSE(parser.Feed(xml.data(), xml.size()));
+        EXPECT_TRUE(parser.IsError());
+        EXPECT_FALSE(parser.Finish());
+    }
+    {
+        XmlSaxParser parser(&handler);
+        std::string xml = "<A>&unknown;</A>";
+        EXPECT_FALSE(parser.Feed(xml.data(), xml.size()));
+    }
+    {
+        XmlSaxParser parser(&handler);
+        std::string xml = "<A></A><B></B>";
+        EXPECT_FALSE(parser.Feed(xml.data(), xml.size()));
+    }
+    {
+        // 不完整的文档
+        XmlSaxParser parser(&handler);
+        std::string xml = "<A><B>text</B>";
+        EXPECT_TRUE(parser.Feed(xml.data(), xml.size()));
+        EXPECT_FALSE(parser.Finish());
+
+        // 重置后可以重新解析
+        parser.Reset();
+        EXPECT_TRUE(handler.m_events.empty());
+        xml = "<A/>";
+        EXPECT_TRUE(parser.Feed(xml.data(), xml.size()));
+        EXPECT_TRUE(parser.Finish());
+    }
+}
+
+TEST(XmlSaxParserTest, OutputBufTest) {
+    RecordHandler handler;
+    XmlSaxParser parser(&handler);
+    XmlSaxOutputBuf buf(&parser);
+    std::ostream os(&buf);
+
+    os << "<A><B>stale";
+    EXPECT_EQ(11, static_cast<int>(os.tellp()));
+
+    // 重试时回退到起始位置, 已解析的内容被丢弃
+    os.seekp(0);
+    EXPECT_TRUE(handler.m_events.empty());
+    os << "<A><B>1</B>" << '<' << "/A>";
+    os.flush();
+    EXPECT_TRUE(parser.Finish());
+    ASSERT_EQ(4u, handler.m_events.size());
+    EXPECT_EQ("B=1", handler.m_events[2]);
+}
+
+TEST(XmlSaxParserTest, GetBucketRespTest) {
+    GetBucketResp resp;
+    XmlSaxParser parser(&resp);
+    // 模拟分块到达的响应体
+    for (size_t i = 0; i < kListBucketXml.size(); i += 7) {
+        size_t len = std::min(static_cast<size_t>(7), kListBucketXml.size() - i);
+        ASSERT_TRUE(parser.Feed(kListBucketXml.data() + i, len));
+    }
+    ASSERT_TRUE(parser.Finish());
+
+    EXPECT_EQ("bucket-1250000000", resp.GetName());
+    EXPECT_EQ("url", resp.GetEncodingType());
+    EXPECT_EQ("dir/", resp.GetPrefix());
+    EXPECT_EQ("", resp.GetMarker());
+    EXPECT_EQ(2u, resp.GetMaxKeys());
+    EXPECT_EQ("/", resp.GetDelimiter());
+    EXPECT_TRUE(resp.IsTruncated());
+    EXPECT_EQ("dir/b&c", resp.GetNextMarker());
+    ASSERT_EQ(1u, resp.GetCommonPrefixes().size());
+    EXPECT_EQ("dir/sub/", resp.GetCommonPrefixes()[0]);
+
+    const std::vector<Content>& contents = resp.GetContents();
+    ASSERT_EQ(2u, contents.size());
+    EXPECT_EQ("dir/a", contents[0].m_key);
+    EXPECT_EQ("2017-06-23T12:33:27.000Z", contents[0].m_last_modified);
+    EXPECT_EQ(1498221207u, contents[0].m_last_modified_time);
+    EXPECT_EQ("ee8de918d05640145b18f70f4c3aa602", contents[0].m_etag);
+    EXPECT_EQ(9u, contents[0].m_size);
+    ASSERT_EQ(1u, contents[0].m_owner_ids.size());
+    EXPECT_EQ("1250000000", contents[0].m_owner_ids[0]);
+    EXPECT_EQ("dir/b&c", contents[1].m_key);
+    EXPECT_EQ(1498221208u, contents[1].m_last_modified_time);
+    EXPECT_EQ(10737418240ull, contents[1].m_size);
+    EXPECT_EQ("STANDARD_IA", contents[1].m_storage_class);
+
+    // 非流式接口的结果一致
+    GetBucketResp str_resp;
+    EXPECT_TRUE(str_resp.ParseFromXmlString(kListBucketXml));
+    EXPECT_EQ(2u, str_resp.GetContents().size());
+    EXPECT_EQ(10737418240ull, str_resp.GetContents()[1].m_size);
+
+    // 根节点错误
+    GetBucketResp bad_resp;
+    EXPECT_FALSE(bad_resp.ParseFromXmlString("<Error><Code>NoSuchBucket</Code></Error>"));
+}
+
+TEST(XmlSaxParserTest, GetBucketObjectVersionsRespTest) {
+    const std::string xml =
+        "<ListVersionsResult>"
+        "<Name>bucket-1250000000</Name><MaxKeys>1000</MaxKeys><IsTruncated>false</IsTruncated>"
+        "<Version><Key>a</Key><VersionId>v1</VersionId><IsLatest>true</IsLatest>"
+        "<LastModified>2017-06-23T12:33:27.000Z</LastModified><ETag>\"abc\"</ETag>"
+        "<Size>123</Size><StorageClass>STANDARD</StorageClass>"
+        "<Owner><DisplayName>owner</DisplayName><ID>1</ID></Owner></Version>"
+        "<DeleteMarker><Key>b</Key><VersionId>v2</VersionId><IsLatest>false</IsLatest>"
+        "</DeleteMarker>"
+        "</ListVersionsResult>";
+
+    GetBucketObjectVersionsResp resp;
+    ASSERT_TRUE(resp.ParseFromXmlString(xml));
+    EXPECT_EQ("bucket-1250000000", resp.GetBucketName());
+    EXPECT_EQ(1000u, resp.GetMaxKeys());
+    EXPECT_FALSE(resp.IsTruncated());
+
+    const std::vector<COSVersionSummary>& summaries = resp.GetVersionSummary();
+    ASSERT_EQ(2u, summaries.size());
+    EXPECT_FALSE(summaries[0].m_is_delete_marker);
+    EXPECT_EQ("a", summaries[0].m_key);
+    EXPECT_TRUE(summaries[0].m_is_latest);
+    EXPECT_EQ(1498221207u, summaries[0].m_last_modified_time);
+    EXPECT_EQ("abc", summaries[0].m_etag);
+    EXPECT_EQ(123u, summaries[0].m_size);
+    EXPECT_EQ("owner", summaries[0].m_owner.m_display_name);
+    EXPECT_EQ("1", summaries[0].m_owner.m_id);
+    EXPECT_TRUE(summaries[1].m_is_delete_marker);
+    EXPECT_EQ("v2", summaries[1].m_version_id);
+    EXPECT_FALSE(summaries[1].m_is_latest);
+}
+
+} // namespace qcloud_cos